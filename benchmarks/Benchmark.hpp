@@ -0,0 +1,31 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace Benchmark
+{
+    // Calls function once and prints how many operations per second it got through,
+    // the function itself is expected to perform the given number of operations.
+    template <typename Function>
+    double Measure(char const* name, uint64_t operations, Function function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double perSecond = operations / elapsed.count();
+        printf("%-40s %12.0f ops/s (%.3f s)\n", name, perSecond, elapsed.count());
+        return perSecond;
+    }
+}
+
+// Each file in the benchmarks directory provides one of these
+void RunInterpreterBenchmarks();
+void RunConditionBenchmarks();
+void RunExecutionBenchmarks();
+void RunDecompressionBenchmarks();
+
+#endif
@@ -0,0 +1,86 @@
+#include "Benchmark.hpp"
+
+#include "CPU/CPU.hpp"
+
+#include <vector>
+
+namespace
+{
+    uint64_t const Iterations = 400000;
+
+    // The switch CPU::ConditionPasses used before the lookup table
+    bool ConditionPassesSwitch(InstructionCondition condition, ProgramStatusRegisters const& status)
+    {
+        switch (condition)
+        {
+            case InstructionCondition::Equal:
+                return status.Flags.Z;
+            case InstructionCondition::NotEqual:
+                return !status.Flags.Z;
+            case InstructionCondition::CarrySet:
+                return status.Flags.C;
+            case InstructionCondition::CarryCleared:
+                return !status.Flags.C;
+            case InstructionCondition::Negative:
+                return status.Flags.N;
+            case InstructionCondition::PositiveOrZero:
+                return !status.Flags.N;
+            case InstructionCondition::Overflow:
+                return status.Flags.V;
+            case InstructionCondition::NotOverflow:
+                return !status.Flags.V;
+            case InstructionCondition::UnsignedHigher:
+                return status.Flags.C && !status.Flags.Z;
+            case InstructionCondition::UnsignedLowerOrSame:
+                return !status.Flags.C || status.Flags.Z;
+            case InstructionCondition::GreaterEqual:
+                return status.Flags.N == status.Flags.V;
+            case InstructionCondition::LessThan:
+                return status.Flags.N != status.Flags.V;
+            case InstructionCondition::GreaterThan:
+                return !status.Flags.Z && status.Flags.N == status.Flags.V;
+            case InstructionCondition::LessOrEqual:
+                return status.Flags.Z || status.Flags.N != status.Flags.V;
+            default:
+                return true;
+        }
+    }
+}
+
+void RunConditionBenchmarks()
+{
+    // Every condition paired with every flags combination, shuffled so the branch predictor can't learn the pattern
+    std::vector<std::pair<InstructionCondition, ProgramStatusRegisters>> checks;
+    uint32_t seed = 0x2545F491;
+
+    for (uint32_t i = 0; i < 16 * 16; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        ProgramStatusRegisters status;
+        status.Full = ((seed >> 16) & 0xF) << 28;
+        checks.push_back(std::make_pair(InstructionCondition(i % 16), status));
+    }
+
+    uint64_t operations = Iterations * checks.size();
+    uint64_t passedSwitch = 0;
+    uint64_t passedTable = 0;
+
+    double before = Benchmark::Measure("Conditions (switch)", operations, [&]()
+    {
+        for (uint64_t i = 0; i < Iterations; ++i)
+            for (auto const& check : checks)
+                passedSwitch += ConditionPassesSwitch(check.first, check.second);
+    });
+
+    double after = Benchmark::Measure("Conditions (lookup table)", operations, [&]()
+    {
+        for (uint64_t i = 0; i < Iterations; ++i)
+            for (auto const& check : checks)
+                passedTable += ConditionTable::Passes(check.first, check.second.Full >> 28);
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup", after / before);
+
+    if (passedSwitch != passedTable)
+        printf("The lookup table disagrees with the switch!\n");
+}
@@ -0,0 +1,120 @@
+#include "Benchmark.hpp"
+
+#include "CPU/CPU.hpp"
+
+namespace
+{
+    uint32_t const Iterations = 250000;
+    uint32_t const Frames = 60;
+
+    // A tight loop of 4 instructions in IWRAM, r0 counts the iterations
+    void LoadLoop(CPU& cpu)
+    {
+        uint32_t const program[] =
+        {
+            0xE2800001, // loop: ADD r0, r0, #1
+            0xE0833000, // ADD r3, r3, r0
+            0xE0244003, // EOR r4, r4, r3
+            0xEAFFFFFB  // B loop
+        };
+
+        for (uint32_t i = 0; i < 4; ++i)
+            cpu.GetMemory()->WriteUInt32(0x03000000 + i * 4, program[i]);
+
+        cpu.GetRegister(0) = 0;
+        cpu.GetRegister(PC) = 0x03000000;
+    }
+
+    // Waits for the start of each VBlank by polling VCOUNT, r2 counts the frames
+    void LoadVBlankWait(CPU& cpu)
+    {
+        uint32_t const program[] =
+        {
+            0xE1D100B0, // loop: LDRH r0, [r1]
+            0xE35000A0, // CMP r0, #160
+            0x1AFFFFFC, // BNE loop
+            0xE2822001, // ADD r2, r2, #1
+            0xE1D100B0, // wait: LDRH r0, [r1]
+            0xE35000A0, // CMP r0, #160
+            0x0AFFFFFC, // BEQ wait
+            0xEAFFFFF7  // B loop
+        };
+
+        for (uint32_t i = 0; i < 8; ++i)
+            cpu.GetMemory()->WriteUInt32(0x03000000 + i * 4, program[i]);
+
+        cpu.GetRegister(1) = 0x04000006; // VCOUNT
+        cpu.GetRegister(2) = 0;
+        cpu.GetRegister(PC) = 0x03000000;
+    }
+}
+
+void RunExecutionBenchmarks()
+{
+    CPU interpreter(CPUExecutionMode::Interpreter);
+    LoadLoop(interpreter);
+
+    double before = Benchmark::Measure("Interpreter, one instruction per step", uint64_t(Iterations) * 4, [&]()
+    {
+        while (uint32_t(interpreter.GetRegister(0)) < Iterations)
+            interpreter.Step();
+    });
+
+    CPU batched(CPUExecutionMode::Interpreter);
+    LoadLoop(batched);
+
+    double until = Benchmark::Measure("Interpreter, until the next event", uint64_t(Iterations) * 4, [&]()
+    {
+        while (uint32_t(batched.GetRegister(0)) < Iterations)
+            batched.StepUntilEvent();
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup", until / before);
+
+    CPU cached(CPUExecutionMode::CachedInterpreter);
+    LoadLoop(cached);
+
+    double after = Benchmark::Measure("Cached interpreter, one block per step", uint64_t(Iterations) * 4, [&]()
+    {
+        while (uint32_t(cached.GetRegister(0)) < Iterations)
+            cached.StepBlock();
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup over one instruction per step", after / before);
+
+    // Emulated frames of a game that does nothing but wait for VBlank
+    CPU polling(CPUExecutionMode::Interpreter);
+    polling.GetIdleLoopDetector()->SetEnabled(false);
+    LoadVBlankWait(polling);
+
+    double busy = Benchmark::Measure("Interpreter, polling VCOUNT (frames)", Frames, [&]()
+    {
+        while (uint32_t(polling.GetRegister(2)) < Frames)
+            polling.StepUntilEvent();
+    });
+
+    CPU skipping(CPUExecutionMode::Interpreter);
+    LoadVBlankWait(skipping);
+
+    double idle = Benchmark::Measure("Interpreter, idle loops skipped (frames)", Frames, [&]()
+    {
+        while (uint32_t(skipping.GetRegister(2)) < Frames)
+            skipping.StepUntilEvent();
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup", idle / busy);
+
+    if (!JIT::IsSupported())
+        return;
+
+    CPU jit(CPUExecutionMode::JIT);
+    LoadLoop(jit);
+
+    double compiled = Benchmark::Measure("JIT, until the next event", uint64_t(Iterations) * 4, [&]()
+    {
+        while (uint32_t(jit.GetRegister(0)) < Iterations)
+            jit.StepJIT();
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup over the cached interpreter", compiled / after);
+}
@@ -0,0 +1,258 @@
+#include "Benchmark.hpp"
+
+#include "CPU/CPU.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    uint32_t const PayloadSize = 0x10000;
+    uint32_t const InterpretedRuns = 10;
+    uint32_t const NativeRuns = 200;
+
+    uint32_t const SourceAddress = 0x02000000;
+    uint32_t const WramAddress = 0x02020000;
+    uint32_t const VramAddress = 0x06000000;
+    uint32_t const CodeAddress = 0x03000000;
+    uint32_t const DoneAddress = CodeAddress + 27 * 4;
+
+    // The LZ77 loop of a BIOS, decompresses r0 to r1 a byte at a time
+    uint32_t const Decompressor[] =
+    {
+        0xE4902004, // LDR r2, [r0], #4
+        0xE1A02422, // MOV r2, r2, LSR #8
+        0xE0812002, // ADD r2, r1, r2
+        0xE4D03001, // flags: LDRB r3, [r0], #1
+        0xE3A04008, // MOV r4, #8
+        0xE3130080, // block: TST r3, #0x80
+        0x1A000002, // BNE reference
+        0xE4D05001, // LDRB r5, [r0], #1
+        0xE4C15001, // STRB r5, [r1], #1
+        0xEA00000A, // B next
+        0xE4D05001, // reference: LDRB r5, [r0], #1
+        0xE4D06001, // LDRB r6, [r0], #1
+        0xE205700F, // AND r7, r5, #0xF
+        0xE1866407, // ORR r6, r6, r7, LSL #8
+        0xE2866001, // ADD r6, r6, #1
+        0xE1A05225, // MOV r5, r5, LSR #4
+        0xE2855003, // ADD r5, r5, #3
+        0xE7517006, // copy: LDRB r7, [r1, -r6]
+        0xE4C17001, // STRB r7, [r1], #1
+        0xE2555001, // SUBS r5, r5, #1
+        0x1AFFFFFB, // BNE copy
+        0xE1510002, // next: CMP r1, r2
+        0x2A000003, // BCS done
+        0xE1A03083, // MOV r3, r3, LSL #1
+        0xE2544001, // SUBS r4, r4, #1
+        0x1AFFFFEA, // BNE block
+        0xEAFFFFE7, // B flags
+        0xEAFFFFFE  // done: B .
+    };
+
+    // Looks like tile data, 32 byte tiles that either repeat an earlier one or are runs of a few values with some noise
+    std::vector<uint8_t> CreatePayload()
+    {
+        std::vector<uint8_t> payload(PayloadSize);
+        uint32_t seed = 12345;
+
+        for (uint32_t tile = 0; tile < PayloadSize; tile += 32)
+        {
+            seed = seed * 1103515245 + 12345;
+            uint32_t earlier = ((seed >> 16) & 0x1F) * 32 + 32;
+
+            if (tile >= earlier && (seed & 0x10000000))
+            {
+                std::copy(payload.begin() + (tile - earlier), payload.begin() + (tile - earlier + 32), payload.begin() + tile);
+                continue;
+            }
+
+            for (uint32_t i = tile; i < tile + 32; ++i)
+            {
+                seed = seed * 1103515245 + 12345;
+                uint32_t random = seed >> 16;
+
+                if (i == tile || (random & 0x7) == 0)
+                    payload[i] = uint8_t(random >> 8);
+                else
+                    payload[i] = payload[i - 1];
+            }
+        }
+
+        return payload;
+    }
+
+    // Greedy LZ77, references never go back a single byte so the data can go to VRAM
+    std::vector<uint8_t> CompressLZ77(std::vector<uint8_t> const& data)
+    {
+        std::vector<uint8_t> output = { 0x10, uint8_t(data.size()), uint8_t(data.size() >> 8), uint8_t(data.size() >> 16) };
+        uint32_t position = 0;
+
+        while (position < data.size())
+        {
+            std::size_t flags = output.size();
+            output.push_back(0);
+
+            for (uint32_t block = 0; block < 8 && position < data.size(); ++block)
+            {
+                uint32_t bestLength = 0;
+                uint32_t bestDistance = 0;
+                uint32_t maximum = std::min<uint32_t>(18, uint32_t(data.size()) - position);
+
+                for (uint32_t distance = 2; distance <= std::min<uint32_t>(position, 0x400) && bestLength < maximum; ++distance)
+                {
+                    uint32_t length = 0;
+
+                    while (length < maximum && data[position + length] == data[position + length - distance])
+                        ++length;
+
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = distance;
+                    }
+                }
+
+                if (bestLength < 3)
+                {
+                    output.push_back(data[position++]);
+                    continue;
+                }
+
+                output[flags] |= 0x80 >> block;
+                output.push_back(uint8_t(((bestLength - 3) << 4) | ((bestDistance - 1) >> 8)));
+                output.push_back(uint8_t(bestDistance - 1));
+                position += bestLength;
+            }
+        }
+
+        return output;
+    }
+
+    std::vector<uint8_t> CompressRunLength(std::vector<uint8_t> const& data)
+    {
+        std::vector<uint8_t> output = { 0x30, uint8_t(data.size()), uint8_t(data.size() >> 8), uint8_t(data.size() >> 16) };
+        uint32_t position = 0;
+
+        while (position < data.size())
+        {
+            uint32_t run = 1;
+
+            while (run < 130 && position + run < data.size() && data[position + run] == data[position])
+                ++run;
+
+            if (run >= 3)
+            {
+                output.push_back(uint8_t(0x80 | (run - 3)));
+                output.push_back(data[position]);
+                position += run;
+                continue;
+            }
+
+            // Literal bytes up to the next run
+            uint32_t length = 0;
+
+            while (length < 128 && position + length < data.size() &&
+                   !(position + length + 2 < data.size() && data[position + length] == data[position + length + 1] &&
+                     data[position + length] == data[position + length + 2]))
+                ++length;
+
+            length = std::max<uint32_t>(length, 1);
+            output.push_back(uint8_t(length - 1));
+            output.insert(output.end(), data.begin() + position, data.begin() + position + length);
+            position += length;
+        }
+
+        return output;
+    }
+
+    void Load(CPU& cpu, std::vector<uint8_t> const& compressed)
+    {
+        for (uint32_t i = 0; i < compressed.size(); ++i)
+            cpu.GetMemory()->WriteUInt8(SourceAddress + i, compressed[i]);
+
+        for (uint32_t i = 0; i < sizeof(Decompressor) / sizeof(uint32_t); ++i)
+            cpu.GetMemory()->WriteUInt32(CodeAddress + i * 4, Decompressor[i]);
+
+        cpu.SetCurrentStatusRegister(uint32_t(CPUMode::System));
+    }
+
+    void CallNative(CPU& cpu, BIOSFunction function, uint32_t destination)
+    {
+        cpu.GetRegister(0) = SourceAddress;
+        cpu.GetRegister(1) = destination;
+        cpu.GetHLEBIOS()->Call(uint8_t(function));
+    }
+
+    bool Matches(CPU& cpu, uint32_t address, std::vector<uint8_t> const& payload)
+    {
+        for (uint32_t i = 0; i < payload.size(); ++i)
+        {
+            if (cpu.GetMemory()->ReadUInt8(address + i) != payload[i])
+                return false;
+        }
+
+        return true;
+    }
+}
+
+void RunDecompressionBenchmarks()
+{
+    std::vector<uint8_t> payload = CreatePayload();
+    std::vector<uint8_t> lz77 = CompressLZ77(payload);
+    std::vector<uint8_t> runLength = CompressRunLength(payload);
+
+    printf("Payload of %u bytes, %u bytes with LZ77 and %u with RL\n", PayloadSize, uint32_t(lz77.size()), uint32_t(runLength.size()));
+
+    CPU interpreter(CPUExecutionMode::Interpreter);
+    Load(interpreter, lz77);
+
+    double interpreted = Benchmark::Measure("LZ77, interpreted (bytes)", uint64_t(PayloadSize) * InterpretedRuns, [&]()
+    {
+        for (uint32_t i = 0; i < InterpretedRuns; ++i)
+        {
+            interpreter.GetRegister(0) = SourceAddress;
+            interpreter.GetRegister(1) = WramAddress;
+            interpreter.GetRegister(PC) = CodeAddress;
+
+            while (uint32_t(interpreter.GetRegister(PC)) != DoneAddress)
+                interpreter.StepUntilEvent();
+        }
+    });
+
+    if (!Matches(interpreter, WramAddress, payload))
+        printf("The interpreted LZ77 output is wrong\n");
+
+    CPU native(CPUExecutionMode::Interpreter);
+    Load(native, lz77);
+
+    double wram = Benchmark::Measure("LZ77, native to WRAM (bytes)", uint64_t(PayloadSize) * NativeRuns, [&]()
+    {
+        for (uint32_t i = 0; i < NativeRuns; ++i)
+            CallNative(native, BIOSFunction::LZ77UnCompWram, WramAddress);
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup", wram / interpreted);
+
+    double vram = Benchmark::Measure("LZ77, native to VRAM (bytes)", uint64_t(PayloadSize) * NativeRuns, [&]()
+    {
+        for (uint32_t i = 0; i < NativeRuns; ++i)
+            CallNative(native, BIOSFunction::LZ77UnCompVram, VramAddress);
+    });
+
+    printf("%-40s %12.2fx\n", "Speedup", vram / interpreted);
+
+    if (!Matches(native, WramAddress, payload) || !Matches(native, VramAddress, payload))
+        printf("The native LZ77 output is wrong\n");
+
+    Load(native, runLength);
+
+    Benchmark::Measure("RL, native to VRAM (bytes)", uint64_t(PayloadSize) * NativeRuns, [&]()
+    {
+        for (uint32_t i = 0; i < NativeRuns; ++i)
+            CallNative(native, BIOSFunction::RLUnCompVram, VramAddress);
+    });
+
+    if (!Matches(native, VramAddress, payload))
+        printf("The native RL output is wrong\n");
+}
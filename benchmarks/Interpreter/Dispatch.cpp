@@ -0,0 +1,100 @@
+#include "Benchmark.hpp"
+
+#include "CPU/CPU.hpp"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    uint64_t const Iterations = 2000000;
+
+    // The way the interpreter used to dispatch instructions, kept around to compare against
+    class MapDispatch
+    {
+    public:
+        MapDispatch(Interpreter* interpreter)
+        {
+            auto dataProcessing = std::bind(&Interpreter::HandleARMDataProcessingInstruction, interpreter, std::placeholders::_1);
+            for (ARM::ARMOpcodes opcode : { ARM::AND, ARM::EOR, ARM::SUB, ARM::RSB, ARM::ADD, ARM::ADC, ARM::SBC, ARM::RSC,
+                ARM::TST, ARM::TEQ, ARM::CMP, ARM::CMN, ARM::ORR, ARM::MOV, ARM::BIC, ARM::MVN })
+                _armHandlers[opcode] = dataProcessing;
+
+            _thumbHandlers[Thumb::ADD_2] = std::bind(&Interpreter::HandleThumbAddCmpMovSubImmediateInstruction, interpreter, std::placeholders::_1);
+            _thumbHandlers[Thumb::CMP_1] = std::bind(&Interpreter::HandleThumbAddCmpMovSubImmediateInstruction, interpreter, std::placeholders::_1);
+            _thumbHandlers[Thumb::ADD_3] = std::bind(&Interpreter::HandleThumbAddSubImmRegInstruction, interpreter, std::placeholders::_1);
+            _thumbHandlers[Thumb::LSL_1] = std::bind(&Interpreter::HandleThumbImmediateShiftInstruction, interpreter, std::placeholders::_1);
+            for (Thumb::ThumbOpcodes opcode : { Thumb::AND, Thumb::EOR, Thumb::MUL })
+                _thumbHandlers[opcode] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, interpreter, std::placeholders::_1);
+        }
+
+        void RunInstruction(DecodedInstruction const& instruction)
+        {
+            if (instruction.GetInstructionSet() == InstructionSet::ARM)
+            {
+                auto handler = _armHandlers.find(ARM::ARMOpcodes(instruction.GetOpcode()));
+                if (handler != _armHandlers.end())
+                    handler->second(instruction);
+            }
+            else
+            {
+                auto handler = _thumbHandlers.find(Thumb::ThumbOpcodes(instruction.GetOpcode()));
+                if (handler != _thumbHandlers.end())
+                    handler->second(instruction);
+            }
+        }
+
+    private:
+        std::unordered_map<ARM::ARMOpcodes, std::function<void(DecodedInstruction const&)>, std::hash<int>> _armHandlers;
+        std::unordered_map<Thumb::ThumbOpcodes, std::function<void(DecodedInstruction const&)>, std::hash<int>> _thumbHandlers;
+    };
+
+    // Register only instructions, so the dispatch is a big part of the time spent on each one
+    std::vector<DecodedInstruction> DecodeWorkload(Decoder& decoder, InstructionSet set)
+    {
+        std::vector<DecodedInstruction> workload;
+
+        if (set == InstructionSet::ARM)
+        {
+            for (uint32_t opcode : { 0xE0811002, 0xE2833001, 0xE0244005, 0xE1550006, 0xE1A07008, 0xE0098009, 0xE1822003, 0xE0400001 })
+                workload.push_back(decoder.DecodeARM(opcode));
+        }
+        else
+        {
+            for (uint16_t opcode : { 0x1888, 0x3001, 0x400C, 0x4048, 0x2A05, 0x0049, 0x4341, 0x3101 })
+                workload.push_back(decoder.DecodeThumb(opcode));
+        }
+
+        return workload;
+    }
+
+    template <typename Dispatcher>
+    void RunWorkload(Dispatcher& dispatcher, std::vector<DecodedInstruction> const& workload)
+    {
+        for (uint64_t i = 0; i < Iterations; ++i)
+            for (DecodedInstruction const& instruction : workload)
+                dispatcher.RunInstruction(instruction);
+    }
+}
+
+void RunInterpreterBenchmarks()
+{
+    CPU cpu(CPUExecutionMode::Interpreter);
+    Interpreter interpreter(&cpu);
+    MapDispatch mapDispatch(&interpreter);
+
+    for (InstructionSet set : { InstructionSet::ARM, InstructionSet::Thumb })
+    {
+        std::vector<DecodedInstruction> workload = DecodeWorkload(*cpu.GetDecoder(), set);
+        uint64_t operations = Iterations * workload.size();
+        bool arm = set == InstructionSet::ARM;
+
+        double before = Benchmark::Measure(arm ? "ARM dispatch (unordered_map)" : "Thumb dispatch (unordered_map)", operations,
+            [&]() { RunWorkload(mapDispatch, workload); });
+        double after = Benchmark::Measure(arm ? "ARM dispatch (handler table)" : "Thumb dispatch (handler table)", operations,
+            [&]() { RunWorkload(interpreter, workload); });
+
+        printf("%-40s %12.2fx\n", "Speedup", after / before);
+    }
+}
@@ -0,0 +1,10 @@
+#include "Benchmark.hpp"
+
+int main()
+{
+    RunInterpreterBenchmarks();
+    RunConditionBenchmarks();
+    RunExecutionBenchmarks();
+    RunDecompressionBenchmarks();
+    return 0;
+}
@@ -2,25 +2,47 @@
 #include "Memory/Memory.hpp"
 #include "Common/MathHelper.hpp"
 
+#include <algorithm>
 #include <iostream>
 
-CPU::CPU(CPUExecutionMode mode) : _mode(mode), _runState(CPURunState::Stopped), 
-_decoder(new Decoder())
+CPU::CPU(CPUExecutionMode mode, MemoryArenaPages pages) : _mode(mode), _runState(CPURunState::Stopped), _wakeState(CPURunState::Stopped), 
+_decoder(new Decoder()), _arena(new MemoryArena(pages))
 {
+    if (_mode == CPUExecutionMode::JIT && !JIT::IsSupported())
+        _mode = CPUExecutionMode::CachedInterpreter;
+
     Reset();
 }
 
 void CPU::Reset()
 {
     Stop();
+    _interruptWait = false;
+
+    _arena->Clear();
+
+    // The peripherals schedule their first events from here
+    _cycles = 0;
 
+    _scheduler = std::unique_ptr<Scheduler>(new Scheduler());
     _interpreter = std::unique_ptr<Interpreter>(new Interpreter(this));
     _memory = std::unique_ptr<MMU>(new MMU(this));
+    // The peripherals register their handlers with the I/O registers and the scheduler
+    _io = std::unique_ptr<IORegisters>(new IORegisters(this));
     _gpu = std::unique_ptr<GPU>(new GPU(this));
     _dma = std::unique_ptr<DMA>(new DMA(this));
+    _timers = std::unique_ptr<Timers>(new Timers(this));
+    _instructionCache = std::unique_ptr<InstructionCache>(new InstructionCache(this));
+    _blockCache = std::unique_ptr<BlockCache>(new BlockCache(this));
+    _idleLoops = std::unique_ptr<IdleLoopDetector>(new IdleLoopDetector(this));
+    _hle = std::unique_ptr<HLEBIOS>(new HLEBIOS(this));
+
+    if (_mode == CPUExecutionMode::JIT)
+        _jit = std::unique_ptr<JIT>(new JIT(this));
 
     // Zero-out all the registers
     _state.Registers = { };
+    _state.Registers_usr = { };
     _state.Registers_FIQ = { };
     _state.Registers_svc = { };
     _state.Registers_abt = { };
@@ -29,12 +51,32 @@ void CPU::Reset()
 
     _state.CPSR.Full = 0;
 
+    for (ProgramStatusRegisters& saved : _state.SPSR)
+        saved.Full = 0;
+
+    _state.PendingFlags = LazyFlags();
+
     // The GBA boots in System mode
     SetCurrentCPUMode(CPUMode::System);
 
     GetRegister(PC) = 0x8000000; // Default entry point
 
-    _cycles = 0;
+    // Changing the interrupt enables may let a pending interrupt through
+    _scheduler->RegisterHandler(EventType::Interrupt, [](uint64_t) { });
+
+    for (uint32_t address : { InterruptEnableRegister, InterruptMasterEnableRegister })
+    {
+        _io->RegisterWriteHandler(address, [this](uint16_t, uint16_t)
+        {
+            _scheduler->Schedule(EventType::Interrupt, _cycles);
+        });
+    }
+
+    // Writing HALTCNT halts the CPU, bit 7 asks for the Stop mode which is treated the same
+    _io->RegisterWriteHandler(PowerDownControlRegister, [this](uint16_t, uint16_t)
+    {
+        Halt();
+    });
 }
 
 void CPU::Run()
@@ -43,62 +85,143 @@ void CPU::Run()
     if (_runState == CPURunState::Running)
         return;
 
-    _runState = CPURunState::Running;
+    // A halted CPU keeps sleeping until an interrupt
+    if (IsHalted())
+        _wakeState = CPURunState::Running;
+    else
+        _runState = CPURunState::Running;
 
     // Loop until something stops the CPU
-    while (_runState == CPURunState::Running)
-        Step();
+    while (_runState == CPURunState::Running || IsHalted())
+    {
+        if (_mode == CPUExecutionMode::JIT)
+            StepJIT();
+        else if (_mode == CPUExecutionMode::CachedInterpreter)
+            StepBlock();
+        else
+            StepUntilEvent();
+    }
 }
 
-bool CPU::ConditionPasses(InstructionCondition condition)
+void CPU::Halt()
 {
-    switch (condition)
+    _wakeState = _runState.exchange(CPURunState::Halted);
+
+    // The compiled code stops right after the instruction that halted
+    if (_jit)
+        _jit->StopBlock();
+}
+
+void CPU::Wake()
+{
+    CPURunState halted = CPURunState::Halted;
+    _runState.compare_exchange_strong(halted, _wakeState);
+}
+
+bool CPU::GetCarryFlag() const
+{
+    LazyFlags const& flags = _state.PendingFlags;
+
+    switch (flags.Pending)
     {
-        case InstructionCondition::Equal:
-            return _state.CPSR.Flags.Z;
-        case InstructionCondition::NotEqual:
-            return !_state.CPSR.Flags.Z;
-        case InstructionCondition::CarrySet:
-            return _state.CPSR.Flags.C;
-        case InstructionCondition::CarryCleared:
-            return !_state.CPSR.Flags.C;
-        case InstructionCondition::Negative:
-            return _state.CPSR.Flags.N;
-        case InstructionCondition::PositiveOrZero:
-            return !_state.CPSR.Flags.N;
-        case InstructionCondition::Overflow:
-            return _state.CPSR.Flags.V;
-        case InstructionCondition::NotOverflow:
-            return !_state.CPSR.Flags.V;
-        case InstructionCondition::UnsignedHigher:
-            return _state.CPSR.Flags.C && !_state.CPSR.Flags.Z;
-        case InstructionCondition::UnsignedLowerOrSame:
-            return !_state.CPSR.Flags.C || _state.CPSR.Flags.Z;
-        case InstructionCondition::GreaterEqual:
-            return _state.CPSR.Flags.N == _state.CPSR.Flags.V;
-        case InstructionCondition::LessThan:
-            return _state.CPSR.Flags.N != _state.CPSR.Flags.V;
-        case InstructionCondition::GreaterThan:
-            return !_state.CPSR.Flags.Z && _state.CPSR.Flags.N == _state.CPSR.Flags.V;
-        case InstructionCondition::LessOrEqual:
-            return _state.CPSR.Flags.Z || _state.CPSR.Flags.N != _state.CPSR.Flags.V;
-        case InstructionCondition::Always:
-        case InstructionCondition::Unused:
+        case LazyFlags::Logical:
+            return flags.Carry;
+        case LazyFlags::Addition:
+            return ((uint64_t(flags.First) + flags.Second + flags.Carry) >> 32) != 0;
+        case LazyFlags::Subtraction:
+            return uint64_t(flags.First) >= uint64_t(flags.Second) + (flags.Carry ? 0 : 1);
+        case LazyFlags::None:
         default:
-            return true;
+            break;
     }
 
-    return false;
+    return _state.CPSR.Flags.C;
+}
+
+void CPU::ComputePendingFlags()
+{
+    LazyFlags& flags = _state.PendingFlags;
+
+    _state.CPSR.Flags.N = MathHelper::CheckBit(flags.Result, 31);
+    _state.CPSR.Flags.Z = flags.Result == 0;
+    _state.CPSR.Flags.C = GetCarryFlag();
+
+    if (flags.Pending == LazyFlags::Addition)
+        _state.CPSR.Flags.V = (((flags.First ^ flags.Result) & (flags.Second ^ flags.Result)) >> 31) != 0;
+    else if (flags.Pending == LazyFlags::Subtraction)
+        _state.CPSR.Flags.V = (((flags.First ^ flags.Second) & (flags.First ^ flags.Result)) >> 31) != 0;
+
+    flags.Pending = LazyFlags::None;
 }
 
 void CPU::LoadROM(GBAHeader& header, FILE* rom, FILE* bios)
 {
     _memory->LoadROM(header, rom, bios);
+
+    if (!bios)
+    {
+        _hle->SetEnabled(true);
+        _hle->Boot();
+    }
+}
+
+void CPU::SetCurrentCPUMode(CPUMode mode)
+{
+    SwapRegisterBanks(GetCurrentCPUMode(), mode);
+    _state.CPSR.Flags.M = uint8_t(mode);
+}
+
+void CPU::SetCurrentStatusRegister(uint32_t value)
+{
+    // The flags are overwritten as well, so anything pending is dropped
+    _state.PendingFlags.Pending = LazyFlags::None;
+
+    SwapRegisterBanks(GetCurrentCPUMode(), CPUMode(value & 0x1F));
+    _state.CPSR.Full = value;
+}
+
+GeneralPurposeRegister* CPU::GetRegisterBank(CPUMode mode)
+{
+    switch (mode)
+    {
+        case CPUMode::FIQ:
+            return &_state.Registers_FIQ[5];
+        case CPUMode::Supervisor:
+            return _state.Registers_svc.data();
+        case CPUMode::Abort:
+            return _state.Registers_abt.data();
+        case CPUMode::IRQ:
+            return _state.Registers_IRQ.data();
+        case CPUMode::Undefined:
+            return _state.Registers_und.data();
+        default:
+            break;
+    }
+
+    // User and System mode use the same registers
+    return &_state.Registers_usr[5];
 }
 
-GeneralPurposeRegister& CPU::GetRegister(uint8_t reg)
+void CPU::SwapRegisterBanks(CPUMode current, CPUMode next)
 {
-    return GetRegisterForMode(GetCurrentCPUMode(), reg);
+    GeneralPurposeRegister* currentBank = GetRegisterBank(current);
+    GeneralPurposeRegister* nextBank = GetRegisterBank(next);
+
+    if (currentBank == nextBank)
+        return;
+
+    // R8 through R12 are only banked in FIQ mode
+    if (current == CPUMode::FIQ || next == CPUMode::FIQ)
+    {
+        GeneralPurposeRegister* saved = current == CPUMode::FIQ ? _state.Registers_FIQ.data() : _state.Registers_usr.data();
+        GeneralPurposeRegister* loaded = next == CPUMode::FIQ ? _state.Registers_FIQ.data() : _state.Registers_usr.data();
+
+        std::copy(&_state.Registers[8], &_state.Registers[13], saved);
+        std::copy(loaded, loaded + 5, &_state.Registers[8]);
+    }
+
+    std::copy(&_state.Registers[SP], &_state.Registers[PC], currentBank);
+    std::copy(nextBank, nextBank + 2, &_state.Registers[SP]);
 }
 
 ProgramStatusRegisters& CPU::GetSavedStatusRegister()
@@ -123,7 +246,7 @@ ProgramStatusRegisters& CPU::GetSavedStatusRegister()
     return _state.SPSR[0];
 }
 
-void CPU::ExecuteInstructionCallback(InstructionCallbackTypes type, std::shared_ptr<Instruction> instruction)
+void CPU::ExecuteInstructionCallback(InstructionCallbackTypes type, DecodedInstruction const& instruction)
 {
     auto handler = _instructionCallbacks.find(type);
     
@@ -136,164 +259,345 @@ GeneralPurposeRegister& CPU::GetRegisterForMode(CPUMode mode, uint8_t reg)
     Utilities::Assert(reg <= PC, "Trying to access invalid register");
 
     // R0 through R7, and R15 are shared across all modes
-    // User mode and System mode use the same registers
-    if (reg <= 7 || reg == PC || mode == CPUMode::User || mode == CPUMode::System)
+    if (reg <= 7 || reg == PC || GetRegisterBank(mode) == GetRegisterBank(GetCurrentCPUMode()))
         return _state.Registers[reg];
 
-    // FIQ mode uses R8_fiq through R14_fiq
-    if (mode == CPUMode::FIQ)
-        return _state.Registers_FIQ[reg - 8];
-
-    // R8 through R12 are shared in the other modes
+    // R8 through R12 are only banked in FIQ mode
     if (reg <= 12)
+    {
+        if (mode == CPUMode::FIQ)
+            return _state.Registers_FIQ[reg - 8];
+
+        if (GetCurrentCPUMode() == CPUMode::FIQ)
+            return _state.Registers_usr[reg - 8];
+
         return _state.Registers[reg];
+    }
 
     // Registers R13 and R14 are specific to each mode
-    if (mode == CPUMode::Supervisor)
-        return _state.Registers_svc[reg - 13];
-    else if (mode == CPUMode::Abort)
-        return _state.Registers_abt[reg - 13];
-    else if (mode == CPUMode::IRQ)
-        return _state.Registers_IRQ[reg - 13];
-    else if (mode == CPUMode::Undefined)
-        return _state.Registers_und[reg - 13];
-
-    Utilities::Assert(false, "Unknown CPU mode registers");
-    return _state.Registers[reg];
+    return GetRegisterBank(mode)[reg - 13];
 }
 
 void CPU::Step()
 {
-    // Update the DMA channels
-    _dma->Step();
+    if (IsHalted())
+    {
+        SkipHalt();
+        return;
+    }
 
-    std::shared_ptr<Instruction> instruction;
+    ExecuteInstruction();
+    RunEvents();
+}
 
-    if (GetCurrentInstructionSet() == InstructionSet::ARM)
+void CPU::StepUntilEvent()
+{
+    if (IsHalted())
     {
-        uint32_t opcode = _memory->ReadUInt32(GetRegister(PC)); // Read the opcode from memory, 4 bytes in ARM mode
+        SkipHalt();
+        return;
+    }
 
-        GetRegister(PC) += 4; // Increment the PC 4 bytes
+    // Nothing but the instructions themselves happens before the next event, they may schedule an earlier one
+    while (_cycles < _scheduler->GetNextEventTime())
+    {
+        uint64_t previous = _cycles;
+        uint32_t address = GetRegister(PC);
+
+        ExecuteInstruction();
 
-        // Extract the instruction from it
-        instruction = _decoder->DecodeARM(opcode);
+        // Unknown instructions don't take any time
+        if (_cycles == previous || IsHalted())
+            break;
+
+        // A jump back may close a loop that waits for the next event
+        if (GetRegister(PC) <= address)
+            _cycles += _idleLoops->Check(address, GetRegister(PC), _cycles, _scheduler->GetNextEventTime());
     }
-    else
+
+    RunEvents();
+}
+
+void CPU::StepInstructions(uint32_t cycles)
+{
+    uint64_t target = _cycles + cycles;
+
+    while (_cycles < target)
     {
-        uint16_t opcode = _memory->ReadUInt16(GetRegister(PC)); // Read the opcode from memory, 2 bytes in Thumb mode
+        // The time of a halted CPU goes by all the same
+        if (IsHalted())
+        {
+            _cycles = target;
+            break;
+        }
 
-        GetRegister(PC) += 2; // Increment the PC 2 bytes
+        uint64_t previous = _cycles;
 
-        // Extract the instruction from it
-        instruction = _decoder->DecodeThumb(opcode);
+        ExecuteInstruction();
+
+        // Unknown instructions don't take any time
+        if (_cycles == previous)
+            break;
     }
 
+    RunEvents();
+}
+
+void CPU::RunEvents()
+{
+    if (_scheduler->IsDue(_cycles))
+        _scheduler->RunEvents(_cycles);
+
+    // Any enabled interrupt wakes a halted CPU up, even if IME or the CPSR keep it from being taken
+    if (IsHalted() && (_io->Get(InterruptEnableRegister) & _io->Get(InterruptRequestFlags)))
+        Wake();
+
+    // The interrupts are also checked when no event is due, an instruction may have cleared the I bit of the CPSR
+    ProcessInterrupts();
+}
+
+void CPU::SkipHalt()
+{
+    // Nothing runs until an interrupt, and only the events can request one
+    uint64_t next = _scheduler->GetNextEventTime();
+
+    if (next != uint64_t(Scheduler::NO_EVENT) && next > _cycles)
+        _cycles = next;
+
+    RunEvents();
+}
+
+void CPU::ExecuteInstruction()
+{
+    // Fetch the decoded instruction, the cache only reads and decodes the opcode the first time it runs from this address
+    DecodedInstruction instruction = _instructionCache->Fetch(GetCurrentInstructionSet(), GetRegister(PC));
+
+    // Increment the PC 4 bytes in ARM mode and 2 bytes in Thumb mode
+    GetRegister(PC) += GetCurrentInstructionSet() == InstructionSet::ARM ? 4 : 2;
+
     ExecuteInstructionCallback(InstructionCallbackTypes::InstructionDecoded, instruction);
 
-    if (instruction)
+    if (instruction.IsValid())
     {
         _interpreter->RunInstruction(instruction);
-        _cycles += instruction->GetTiming();
+        _cycles += instruction.GetTiming();
         ExecuteInstructionCallback(InstructionCallbackTypes::InstructionExecuted, instruction);
     }
     else
         std::cout << "Unknown Instruction" << std::endl;
+}
 
-    // Update the GPU
-    GetGPU()->Step(_cycles);
-    // Check for interrupts on every loop
-    ProcessInterrupts();
+void CPU::StepBlock()
+{
+    if (IsHalted())
+    {
+        SkipHalt();
+        return;
+    }
+
+    uint32_t start = GetRegister(PC);
+    Block* block = _blockCache->Lookup(GetCurrentInstructionSet(), start);
+
+    if (!block)
+    {
+        Step();
+        return;
+    }
+
+    uint32_t size = block->Set == InstructionSet::ARM ? 4 : 2;
+
+    // Look the callbacks up once for the whole block
+    auto decoded = _instructionCallbacks.find(InstructionCallbackTypes::InstructionDecoded);
+    auto executed = _instructionCallbacks.find(InstructionCallbackTypes::InstructionExecuted);
+    bool notifyDecoded = decoded != _instructionCallbacks.end();
+    bool notifyExecuted = executed != _instructionCallbacks.end();
+
+    // Only the last instruction of a block can change the PC, so the PC is simply advanced before each one.
+    // The time goes by after each one like in CPU::Step, the I/O registers see the current time
+    for (std::size_t i = 0; i < block->Instructions.size(); ++i)
+    {
+        Block::Entry const& entry = block->Instructions[i];
+
+        GetRegister(PC) += size;
+
+        if (notifyDecoded)
+            decoded->second(entry.Instruction);
+
+        if (entry.Handler != nullptr)
+            (_interpreter.get()->*entry.Handler)(entry.Instruction);
+
+        _cycles += entry.Instruction.GetTiming();
+
+        if (notifyExecuted)
+            executed->second(entry.Instruction);
+
+        // A store overwrote the code of this block, the rest of it has to be fetched again.
+        // A halted CPU doesn't run the rest of the block either, nor does one with an event due, like an immediate DMA
+        if (!block->Valid || IsHalted() || _scheduler->IsDue(_cycles))
+        {
+            block = nullptr;
+            break;
+        }
+    }
+
+    if (block)
+    {
+        // Only the last instruction can jump back to the start of a loop. The block may have been built from another mirror
+        uint32_t last = start + uint32_t(block->Instructions.size() - 1) * size;
+
+        if (GetRegister(PC) <= last)
+            _cycles += _idleLoops->Check(last, GetRegister(PC), _cycles, _scheduler->GetNextEventTime());
+    }
+
+    // Let the peripherals catch up with the block and check for interrupts
+    RunEvents();
+}
+
+void CPU::StepJIT()
+{
+    if (IsHalted())
+    {
+        SkipHalt();
+        return;
+    }
+
+    // The compiled code runs until the next event is due
+    uint64_t next = _scheduler->GetNextEventTime();
+    uint32_t slice = uint32_t(std::min<uint64_t>(next > _cycles ? next - _cycles : 1, JIT::MAX_TIME_SLICE));
+
+    // Code that can't be compiled runs one instruction at a time, the compiled code adds its cycles itself
+    if (_jit->Run(slice) == 0)
+        ExecuteInstruction();
+
+    RunEvents();
 }
 
 bool CPU::IsInterruptEnabled(InterruptTypes type)
 {
     // All interrupts are disabled when an IRQ is being handled
-    if (GetCurrentStatusFlags().I)
+    if (_state.CPSR.Flags.I)
         return false;
 
-    uint32_t masterEnable = GetMemory()->ReadUInt32(InterruptMasterEnableRegister);
+    uint16_t masterEnable = _io->Get(InterruptMasterEnableRegister);
     
     // If the Interrupt Master Enable Register says interrupts are disabled, then don't try to check any further
     if (!MathHelper::CheckBit(masterEnable, 0))
         return false;
 
-    uint16_t interrupts = GetMemory()->ReadUInt16(InterruptEnableRegister);
+    uint16_t interrupts = _io->Get(InterruptEnableRegister);
     
     // Check if the specified type of interrupt is disabled in the Interrupt Enable Register
     return MathHelper::CheckBit(interrupts, uint8_t(type));
 }
 
-void CPU::TriggerInterrupt(InterruptTypes type)
+void CPU::EnterException(CPUMode mode, uint32_t vector, uint32_t returnAddress)
 {
-    std::swap(GetRegisterForMode(CPUMode::IRQ, SP), GetRegister(SP));
-    std::swap(GetRegisterForMode(CPUMode::IRQ, LR), GetRegister(LR));
+    uint32_t status = GetCurrentStatusRegister().Full;
+
+    // This swaps in R13 and R14 of the mode
+    SetCurrentCPUMode(mode);
+
+    // Save the CPSR into the SPSR of the mode
+    GetSavedStatusRegister().Full = status;
+    GetRegister(LR) = returnAddress;
 
-    // Save the CPSR into SPSR_irq
-    _state.SPSR[2] = GetCurrentStatusRegister();
-    
     // Disable interrupts
     GetCurrentStatusFlags().I = 1;
 
-    // Setup the return address
-    GetRegisterForMode(CPUMode::IRQ, LR) = PC + (GetCurrentInstructionSet() == InstructionSet::ARM ? 4 : 2);
-
-    // Set IRQ mode
-    SetCurrentCPUMode(CPUMode::IRQ);
-    
     // Switch to ARM mode
     SetInstructionSet(InstructionSet::ARM);
 
-    // Jump to the BIOS IRQ handler
-    GetRegister(PC) = 0x18;
+    GetRegister(PC) = vector;
 }
 
-void CPU::RequestInterrupt(InterruptTypes type)
+void CPU::TriggerInterrupt(InterruptTypes /*type*/)
 {
-    if (!IsInterruptEnabled(type))
-        return;
+    // Jump to the BIOS IRQ handler. It returns with SUBS PC, LR, #4 so the return address is the next instruction + 4,
+    // in both ARM and Thumb state
+    EnterException(CPUMode::IRQ, 0x18, GetRegister(PC) + 4);
+}
 
+void CPU::RequestInterrupt(InterruptTypes type)
+{
     // Write the interrupt to the Interrupt Request Flags, they will be processed on the next tick
-    uint16_t interruptRequests = GetMemory()->ReadUInt16(InterruptRequestFlags);
-    interruptRequests |= (1 << uint8_t(type));
-    GetMemory()->WriteUInt16(InterruptRequestFlags, interruptRequests);
+    // The guest can only clear the flags, the hardware sets them directly. The flag is set even if the interrupt is disabled
+    _io->Set(InterruptRequestFlags, _io->Get(InterruptRequestFlags) | (1 << uint8_t(type)));
+    _scheduler->Schedule(EventType::Interrupt, _cycles);
 }
 
 void CPU::ProcessInterrupts()
 {
-    // All interrupts are disabled when an IRQ is being handled
-    if (GetCurrentStatusFlags().I)
+    // All interrupts are disabled when an IRQ is being handled, or by the Interrupt Master Enable Register
+    if (_state.CPSR.Flags.I || !MathHelper::CheckBit(_io->Get(InterruptMasterEnableRegister), 0))
         return;
 
-    // Check the interrupt flags and service the requested interrupts
-    uint16_t interruptRequests = GetMemory()->ReadUInt16(InterruptRequestFlags);
-    
-    // Only one interrupt is triggered at a time
-    if (MathHelper::CheckBit(interruptRequests, 0))
-        TriggerInterrupt(InterruptTypes::VBlank);
-    else if (MathHelper::CheckBit(interruptRequests, 1))
-        TriggerInterrupt(InterruptTypes::HBlank);
-    else if (MathHelper::CheckBit(interruptRequests, 2))
-        TriggerInterrupt(InterruptTypes::VCounterMatch);
-    else if (MathHelper::CheckBit(interruptRequests, 3))
-        TriggerInterrupt(InterruptTypes::Timer0Overflow);
-    else if (MathHelper::CheckBit(interruptRequests, 4))
-        TriggerInterrupt(InterruptTypes::Timer1Overflow);
-    else if (MathHelper::CheckBit(interruptRequests, 5))
-        TriggerInterrupt(InterruptTypes::Timer2Overflow);
-    else if (MathHelper::CheckBit(interruptRequests, 6))
-        TriggerInterrupt(InterruptTypes::Timer3Overflow);
-    else if (MathHelper::CheckBit(interruptRequests, 7))
-        TriggerInterrupt(InterruptTypes::SerialCommunication);
-    else if (MathHelper::CheckBit(interruptRequests, 8))
-        TriggerInterrupt(InterruptTypes::DMA0);
-    else if (MathHelper::CheckBit(interruptRequests, 9))
-        TriggerInterrupt(InterruptTypes::DMA1);
-    else if (MathHelper::CheckBit(interruptRequests, 10))
-        TriggerInterrupt(InterruptTypes::DMA2);
-    else if (MathHelper::CheckBit(interruptRequests, 11))
-        TriggerInterrupt(InterruptTypes::DMA3);
-    else if (MathHelper::CheckBit(interruptRequests, 12))
-        TriggerInterrupt(InterruptTypes::KeyPad);
-    else if (MathHelper::CheckBit(interruptRequests, 13))
-        TriggerInterrupt(InterruptTypes::GamePak);
+    // Check the interrupt flags and service the requested interrupts that are enabled
+    uint16_t interruptRequests = _io->Get(InterruptRequestFlags) & _io->Get(InterruptEnableRegister);
+
+    if (!interruptRequests)
+        return;
+
+    // Only one interrupt is triggered at a time, the lowest one first
+    for (uint8_t i = uint8_t(InterruptTypes::VBlank); i <= uint8_t(InterruptTypes::GamePak); ++i)
+    {
+        if (MathHelper::CheckBit(interruptRequests, i))
+        {
+            TriggerInterrupt(InterruptTypes(i));
+            return;
+        }
+    }
+}
+
+void CPU::SoftwareInterrupt(uint8_t function)
+{
+    switch (BIOSFunction(function))
+    {
+        case BIOSFunction::Halt:
+        case BIOSFunction::Stop: // Nothing but an interrupt can wake the CPU up either way
+            Halt();
+            return;
+        case BIOSFunction::IntrWait:
+            InterruptWait(GetRegister(0) != 0, uint16_t(GetRegister(1)));
+            return;
+        case BIOSFunction::VBlankIntrWait:
+            GetRegister(0) = 1;
+            GetRegister(1) = 1;
+            InterruptWait(true, 1);
+            return;
+        default:
+            break;
+    }
+
+    if (_hle->IsEnabled() && _hle->Call(function))
+        return;
+
+    // Run the BIOS code, it returns with MOVS PC, LR
+    EnterException(CPUMode::Supervisor, 0x08, GetRegister(PC));
+}
+
+void CPU::InterruptWait(bool discard, uint16_t flags)
+{
+    // The BIOS enables the interrupts, the IRQ handler of the game acknowledges them in BIOSInterruptFlags
+    _memory->WriteUInt16(InterruptMasterEnableRegister, 1);
+
+    uint16_t acknowledged = _memory->ReadUInt16(BIOSInterruptFlags);
+
+    // The old flags are only discarded the first time around, not when the SWI runs again after an interrupt
+    if (discard && !_interruptWait)
+        acknowledged &= ~flags;
+
+    _interruptWait = false;
+
+    if (acknowledged & flags)
+    {
+        _memory->WriteUInt16(BIOSInterruptFlags, acknowledged & ~flags);
+        return;
+    }
+
+    _memory->WriteUInt16(BIOSInterruptFlags, acknowledged);
+
+    // The interrupt returns to the SWI, which checks the flags again
+    GetRegister(PC) -= GetCurrentInstructionSet() == InstructionSet::ARM ? 4 : 2;
+    _interruptWait = true;
+    Halt();
 }
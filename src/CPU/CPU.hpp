@@ -1,11 +1,20 @@
 #ifndef CPU_HPP
 #define CPU_HPP
 
+#include "CPU/ConditionTable.hpp"
+#include "CPU/IdleLoopDetector.hpp"
 #include "Decoder/Decoder.hpp"
+#include "Decoder/InstructionCache.hpp"
 #include "Interpreter/Interpreter.hpp"
+#include "Interpreter/BlockCache.hpp"
+#include "JIT/JIT.hpp"
 #include "Memory/Memory.hpp"
 #include "GPU/GPU.hpp"
 #include "DMA/DMA.hpp"
+#include "HLE/HLEBIOS.hpp"
+#include "IO/IORegisters.hpp"
+#include "Scheduler/Scheduler.hpp"
+#include "Timers/Timers.hpp"
 
 #include <atomic>
 #include <cstdio>
@@ -14,13 +23,15 @@
 #include <memory>
 #include <functional>
 #include <bitset>
+#include <unordered_map>
 
 struct GBAHeader;
 
 enum class CPUExecutionMode
 {
     Interpreter,
-    JIT
+    CachedInterpreter, // Runs basic blocks of pre-decoded instructions, the peripherals only catch up between blocks. A block ends early once an event is due
+    JIT // Compiles the basic blocks to native code, falls back to the cached interpreter where that is not supported. No instruction callbacks
 };
 
 enum class CPUMode
@@ -38,7 +49,8 @@ enum class CPURunState
 {
     Running,
     Stepping,
-    Stopped
+    Stopped,
+    Halted // Sleeps until an interrupt is requested, then goes back to the previous state
 };
 
 #pragma pack(push, 1)
@@ -111,12 +123,33 @@ class GeneralPurposeRegister;
 #define InterruptRequestFlags 0x4000202 
 #define InterruptEnableRegister 0x4000200 
 #define InterruptMasterEnableRegister 0x4000208
+#define PowerDownControlRegister 0x4000300
+#define BIOSInterruptFlags 0x3007FF8 // Where the IRQ handler of the game acknowledges the interrupts for IntrWait
+
+// The last flag setting operation, N Z C and V are only computed from it when something reads them
+struct LazyFlags
+{
+    enum Operation : uint8_t
+    {
+        None,        // The flags in the CPSR are up to date
+        Logical,     // N and Z come from Result, C from Carry and V is left untouched
+        Addition,    // Result = First + Second + Carry
+        Subtraction  // Result = First - Second - NOT(Carry)
+    };
+
+    uint32_t First;
+    uint32_t Second;
+    uint32_t Result;
+    bool Carry;
+    Operation Pending;
+};
 
 struct CPUState
 {
-    std::array<GeneralPurposeRegister, 16> Registers;
+    std::array<GeneralPurposeRegister, 16> Registers; // The registers of the current mode
 
-    // Banked registers
+    // Banked registers, the copy belonging to the current mode is stale until the mode changes again
+    std::array<GeneralPurposeRegister, 7> Registers_usr; // Contains R8-R14 for the User and System modes
     std::array<GeneralPurposeRegister, 7> Registers_FIQ; // Contains R8-R14 for the FIQ mode
     std::array<GeneralPurposeRegister, 2> Registers_svc; // Contains R13-R14 for the Supervisor mode
     std::array<GeneralPurposeRegister, 2> Registers_abt; // Contains R13-R14 for the Abort mode
@@ -125,6 +158,8 @@ struct CPUState
 
     ProgramStatusRegisters CPSR; // Current Program Status Register
     ProgramStatusRegisters SPSR[5]; // Saved Program Status Register, there is one per mode except in System/User mode
+
+    LazyFlags PendingFlags; // Not yet applied to the CPSR
 };
 
 enum class InterruptTypes
@@ -148,62 +183,174 @@ enum class InterruptTypes
 class CPU final
 {
 public:
-    CPU(CPUExecutionMode mode);
+    CPU(CPUExecutionMode mode, MemoryArenaPages pages = MemoryArenaPages::Normal);
 
+    // Without a BIOS file the BIOS calls are emulated
     void LoadROM(GBAHeader& header, FILE* rom, FILE* bios);
     void Reset();
+    // Stopping a halted CPU wakes it up
     void Stop() { _runState = CPURunState::Stopped; }
     void Resume() { _runState = CPURunState::Running; }
     void Run();
 
-    bool ConditionPasses(InstructionCondition condition);
+    // Halts the CPU until an enabled interrupt is requested, the time goes straight to the next event meanwhile
+    void Halt();
+    void Wake();
+    bool IsHalted() const { return _runState == CPURunState::Halted; }
+
+    bool ConditionPasses(InstructionCondition condition)
+    {
+        // Most instructions are unconditional, don't bother computing the flags for those
+        if (condition >= InstructionCondition::Always)
+            return true;
+
+        MaterializeFlags();
+        return ConditionTable::Passes(condition, GetConditionFlags());
+    }
+
+    // The NZCV flags as a nibble, N being the highest bit. Doesn't apply the pending flags
+    uint32_t GetConditionFlags() const { return _state.CPSR.Full >> 28; }
 
-    GeneralPurposeRegister& GetRegister(uint8_t reg);
+    // The banked registers of the current mode are swapped in when the mode changes, so this is a plain array access
+    GeneralPurposeRegister& GetRegister(uint8_t reg) { return _state.Registers[reg]; }
     GeneralPurposeRegister& GetRegisterForMode(CPUMode mode, uint8_t reg);
 
     InstructionSet GetCurrentInstructionSet() const { return InstructionSet(_state.CPSR.Flags.T); }
     void SetInstructionSet(InstructionSet set) { _state.CPSR.Flags.T = uint8_t(set); }
     void ToggleInstructionSet() { _state.CPSR.Flags.T ^= 1; }
 
-    ProgramStatusRegisters::FlagsStruct& GetCurrentStatusFlags() { return _state.CPSR.Flags; }
+    // These apply any pending flags first, don't keep the returned references around across instructions
+    ProgramStatusRegisters::FlagsStruct& GetCurrentStatusFlags() { MaterializeFlags(); return _state.CPSR.Flags; }
 
-    ProgramStatusRegisters& GetCurrentStatusRegister() { return _state.CPSR; }
+    // Don't change the mode bits through GetCurrentStatusRegister, SetCurrentStatusRegister also swaps the banked registers
+    ProgramStatusRegisters& GetCurrentStatusRegister() { MaterializeFlags(); return _state.CPSR; }
+    void SetCurrentStatusRegister(uint32_t value);
     ProgramStatusRegisters& GetSavedStatusRegister();
 
     CPUMode GetCurrentCPUMode() const { return CPUMode(_state.CPSR.Flags.M); }
     bool IsInPrivilegedMode() const { return GetCurrentCPUMode() != CPUMode::User; }
-    void SetCurrentCPUMode(CPUMode mode) { _state.CPSR.Flags.M = uint8_t(mode); }
+    void SetCurrentCPUMode(CPUMode mode);
+
+    // Flag setting instructions record their operation with these instead of writing N Z C V right away
+    void SetLogicalFlags(uint32_t result, bool carry)
+    {
+        // Logical operations keep the V flag, so it has to be computed before a pending arithmetic operation is replaced
+        if (_state.PendingFlags.Pending > LazyFlags::Logical)
+            ComputePendingFlags();
+
+        _state.PendingFlags.Result = result;
+        _state.PendingFlags.Carry = carry;
+        _state.PendingFlags.Pending = LazyFlags::Logical;
+    }
+
+    void SetArithmeticFlags(LazyFlags::Operation operation, uint32_t first, uint32_t second, bool carry, uint32_t result)
+    {
+        _state.PendingFlags.First = first;
+        _state.PendingFlags.Second = second;
+        _state.PendingFlags.Result = result;
+        _state.PendingFlags.Carry = carry;
+        _state.PendingFlags.Pending = operation;
+    }
+
+    // Computes only the C flag, without applying the pending operation
+    bool GetCarryFlag() const;
+
+    void MaterializeFlags()
+    {
+        if (_state.PendingFlags.Pending != LazyFlags::None)
+            ComputePendingFlags();
+    }
 
     bool IsInterruptEnabled(InterruptTypes type);
+    // Sets the flag in IF, the interrupt is only taken once IE, IME and the CPSR allow it
     void RequestInterrupt(InterruptTypes type);
 
+    // Runs the BIOS function of a SWI, the PC points to the next instruction
+    void SoftwareInterrupt(uint8_t function);
+
     std::unique_ptr<MMU>& GetMemory() { return _memory; }
+    std::unique_ptr<MemoryArena>& GetMemoryArena() { return _arena; }
+    std::unique_ptr<IORegisters>& GetIO() { return _io; }
     std::unique_ptr<GPU>& GetGPU() { return _gpu; }
-
-    void RegisterInstructionCallback(InstructionCallbackTypes type, std::function<void(std::shared_ptr<Instruction>)> callback) { _instructionCallbacks[type] = callback; }
-    void ExecuteInstructionCallback(InstructionCallbackTypes type, std::shared_ptr<Instruction> instruction);
-
+    std::unique_ptr<DMA>& GetDMA() { return _dma; }
+    std::unique_ptr<Timers>& GetTimers() { return _timers; }
+    std::unique_ptr<Scheduler>& GetScheduler() { return _scheduler; }
+    std::unique_ptr<IdleLoopDetector>& GetIdleLoopDetector() { return _idleLoops; }
+    std::unique_ptr<HLEBIOS>& GetHLEBIOS() { return _hle; }
+    std::unique_ptr<Decoder>& GetDecoder() { return _decoder; }
+    std::unique_ptr<InstructionCache>& GetInstructionCache() { return _instructionCache; }
+    std::unique_ptr<BlockCache>& GetBlockCache() { return _blockCache; }
+    std::unique_ptr<Interpreter>& GetInterpreter() { return _interpreter; }
+    std::unique_ptr<JIT>& GetJIT() { return _jit; } // Only created in the JIT execution mode
+
+    // The raw register file, for the generated code
+    CPUState& GetState() { return _state; }
+
+    void RegisterInstructionCallback(InstructionCallbackTypes type, std::function<void(DecodedInstruction const&)> callback) { _instructionCallbacks[type] = callback; }
+    void ExecuteInstructionCallback(InstructionCallbackTypes type, DecodedInstruction const& instruction);
+
+    // Runs a single instruction
     void Step();
+    // Runs single instructions until the next event is due, this is how the interpreter runs
+    void StepUntilEvent();
+    // Runs the basic block at the PC, falls back to Step for code that can't be cached
+    void StepBlock();
+    // Runs compiled code until the next event, falls back to a single instruction for code that can't be compiled
+    void StepJIT();
+    // Runs single instructions until at least the given number of cycles went by, the peripherals only catch up at the end like with StepBlock
+    void StepInstructions(uint32_t cycles);
+
+    uint64_t GetCycles() const { return _cycles; }
+    // Time the CPU can't run for, while the DMA has the bus
+    void AddCycles(uint32_t cycles) { _cycles += cycles; }
 
 private:
+    // Fetches, executes and times the instruction at the PC, without updating the peripherals
+    void ExecuteInstruction();
+    // Runs the events that are due and delivers the pending interrupts
+    void RunEvents();
+    // Lets the time of a halted CPU go by until the next event
+    void SkipHalt();
+    // Waits for one of the interrupts in flags to be acknowledged in BIOSInterruptFlags, like the BIOS does
+    void InterruptWait(bool discard, uint16_t flags);
+
+    void ComputePendingFlags();
+
+    // Returns the R13-R14 storage of the mode
+    GeneralPurposeRegister* GetRegisterBank(CPUMode mode);
+    void SwapRegisterBanks(CPUMode current, CPUMode next);
+
+    // Saves the CPSR into the SPSR of the mode and jumps to the vector in ARM state with the IRQs disabled
+    void EnterException(CPUMode mode, uint32_t vector, uint32_t returnAddress);
     void TriggerInterrupt(InterruptTypes type);
     void ProcessInterrupts();
 
-    uint32_t _cycles;
+    uint64_t _cycles;
 
     CPUExecutionMode _mode;
     CPUState _state;
 
     std::atomic<CPURunState> _runState;
+    CPURunState _wakeState; // The state a halted CPU goes back to
+    bool _interruptWait; // An IntrWait is halted, it runs again once the interrupt returns
     std::unique_ptr<Interpreter> _interpreter;
     std::unique_ptr<Decoder> _decoder;
+    std::unique_ptr<InstructionCache> _instructionCache;
+    std::unique_ptr<BlockCache> _blockCache;
+    std::unique_ptr<JIT> _jit;
+    std::unique_ptr<MemoryArena> _arena; // Outlives resets, only its contents are cleared
     std::unique_ptr<MMU> _memory;
+    std::unique_ptr<IORegisters> _io;
     std::unique_ptr<GPU> _gpu;
     std::unique_ptr<DMA> _dma;
-    // std::shared_ptr<Instruction> _nextInstruction; // Used by prefetching
+    std::unique_ptr<Timers> _timers;
+    std::unique_ptr<Scheduler> _scheduler;
+    std::unique_ptr<IdleLoopDetector> _idleLoops;
+    std::unique_ptr<HLEBIOS> _hle;
+    // DecodedInstruction _nextInstruction; // Used by prefetching
 
     // Callbacks are used to inform the UI about stuff that happens in the emulator
-    std::unordered_map<InstructionCallbackTypes, std::function<void(std::shared_ptr<Instruction>)>> _instructionCallbacks;
+    std::unordered_map<InstructionCallbackTypes, std::function<void(DecodedInstruction const&)>> _instructionCallbacks;
 };
 
 #endif
@@ -0,0 +1,54 @@
+#ifndef CONDITION_TABLE_HPP
+#define CONDITION_TABLE_HPP
+
+#include "Common/Instructions/ARMInstruction.hpp"
+#include "Common/Utilities.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Every condition code evaluated ahead of time for each of the 16 possible values of the NZCV flags.
+// The NZCV nibble is just the top 4 bits of the CPSR, so checking a condition is a shift and a lookup.
+namespace ConditionTable
+{
+    // N is bit 3 of the nibble, Z bit 2, C bit 1 and V bit 0
+    inline constexpr bool Evaluate(uint32_t condition, uint32_t nzcv)
+    {
+        return condition == uint32_t(InstructionCondition::Equal) ? (nzcv & 4) != 0 :
+            condition == uint32_t(InstructionCondition::NotEqual) ? (nzcv & 4) == 0 :
+            condition == uint32_t(InstructionCondition::CarrySet) ? (nzcv & 2) != 0 :
+            condition == uint32_t(InstructionCondition::CarryCleared) ? (nzcv & 2) == 0 :
+            condition == uint32_t(InstructionCondition::Negative) ? (nzcv & 8) != 0 :
+            condition == uint32_t(InstructionCondition::PositiveOrZero) ? (nzcv & 8) == 0 :
+            condition == uint32_t(InstructionCondition::Overflow) ? (nzcv & 1) != 0 :
+            condition == uint32_t(InstructionCondition::NotOverflow) ? (nzcv & 1) == 0 :
+            condition == uint32_t(InstructionCondition::UnsignedHigher) ? (nzcv & 6) == 2 :
+            condition == uint32_t(InstructionCondition::UnsignedLowerOrSame) ? (nzcv & 6) != 2 :
+            condition == uint32_t(InstructionCondition::GreaterEqual) ? ((nzcv >> 3) & 1) == (nzcv & 1) :
+            condition == uint32_t(InstructionCondition::LessThan) ? ((nzcv >> 3) & 1) != (nzcv & 1) :
+            condition == uint32_t(InstructionCondition::GreaterThan) ? (nzcv & 4) == 0 && ((nzcv >> 3) & 1) == (nzcv & 1) :
+            condition == uint32_t(InstructionCondition::LessOrEqual) ? (nzcv & 4) != 0 || ((nzcv >> 3) & 1) != (nzcv & 1) :
+            true; // Always, and the unused condition which we also treat as always
+    }
+
+    // Bit n of the mask tells whether the condition passes when the NZCV nibble is n
+    inline constexpr uint16_t MakeMask(uint32_t condition, uint32_t nzcv = 0)
+    {
+        return nzcv == 16 ? 0 : uint16_t((Evaluate(condition, nzcv) ? (1 << nzcv) : 0) | MakeMask(condition, nzcv + 1));
+    }
+
+    template <std::size_t... Conditions>
+    inline constexpr std::array<uint16_t, 16> MakeTable(Utilities::IndexSequence<Conditions...>)
+    {
+        return std::array<uint16_t, 16> {{ MakeMask(Conditions)... }};
+    }
+
+    constexpr std::array<uint16_t, 16> Masks = MakeTable(Utilities::MakeIndexSequence<16>::Type());
+
+    inline bool Passes(InstructionCondition condition, uint32_t nzcv)
+    {
+        return ((Masks[uint8_t(condition)] >> nzcv) & 1) != 0;
+    }
+}
+
+#endif
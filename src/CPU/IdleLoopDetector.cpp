@@ -0,0 +1,107 @@
+#include "IdleLoopDetector.hpp"
+#include "CPU/CPU.hpp"
+
+IdleLoopDetector::IdleLoopDetector(CPU* cpu) : _cpu(cpu), _enabled(true), _valid(false), _branch(0), _target(0), _time(0),
+_writes(0), _reads(0), _timedReads(0), _events(0), _changes(0)
+{
+}
+
+uint64_t IdleLoopDetector::Check(uint32_t branch, uint32_t target, uint64_t now, uint64_t deadline)
+{
+    if (!_enabled || branch - target > MAX_LOOP_SIZE)
+        return 0;
+
+    // Another loop, or the first time around this one
+    if (!_valid || branch != _branch || target != _target)
+    {
+        _changes = 0;
+        Start(branch, target, now);
+        return 0;
+    }
+
+    uint64_t events = _cpu->GetScheduler()->GetEventsRun();
+
+    // A loop that keeps computing something, like a delay loop, isn't going to wait for anything before the next event
+    if (_changes >= BUSY_ITERATIONS && events == _events)
+        return 0;
+
+    std::unique_ptr<IORegisters>& io = _cpu->GetIO();
+
+    bool unchanged = events == _events && _cpu->GetMemory()->GetWriteCount() == _writes &&
+        io->GetTimedReadCount() == _timedReads && GetRegisters() == _registers;
+
+    if (!unchanged)
+    {
+        // The first iterations after an event still see its effects
+        _changes = events == _events ? _changes + 1 : 0;
+        Start(branch, target, now);
+        return 0;
+    }
+
+    // Nothing the loop reads can change before the next event, every iteration until then is the same as this one
+    uint64_t iteration = now - _time;
+    uint64_t skip = 0;
+
+    if (iteration && deadline > now)
+        skip = (deadline - now) / iteration * iteration;
+
+    if (skip)
+    {
+        if (io->GetReadCount() != _reads)
+            ++_statistics.PollingLoops;
+        else
+            ++_statistics.SpinLoops;
+
+        _statistics.SkippedCycles += skip;
+    }
+
+    Start(branch, target, now + skip);
+    return skip;
+}
+
+void IdleLoopDetector::Start(uint32_t branch, uint32_t target, uint64_t now)
+{
+    std::unique_ptr<IORegisters>& io = _cpu->GetIO();
+
+    _valid = true;
+    _branch = branch;
+    _target = target;
+    _time = now;
+    _writes = _cpu->GetMemory()->GetWriteCount();
+    _reads = io->GetReadCount();
+    _timedReads = io->GetTimedReadCount();
+    _events = _cpu->GetScheduler()->GetEventsRun();
+    _registers = GetRegisters();
+}
+
+IdleLoopDetector::RegisterSnapshot IdleLoopDetector::GetRegisters() const
+{
+    // The flags are applied first, the pending operation that produced them may differ between iterations
+    _cpu->MaterializeFlags();
+
+    CPUState const& state = _cpu->GetState();
+    RegisterSnapshot registers;
+    std::size_t i = 0;
+
+    for (GeneralPurposeRegister const& reg : state.Registers)
+        registers[i++] = reg.Value;
+    for (GeneralPurposeRegister const& reg : state.Registers_usr)
+        registers[i++] = reg.Value;
+    for (GeneralPurposeRegister const& reg : state.Registers_FIQ)
+        registers[i++] = reg.Value;
+    for (GeneralPurposeRegister const& reg : state.Registers_svc)
+        registers[i++] = reg.Value;
+    for (GeneralPurposeRegister const& reg : state.Registers_abt)
+        registers[i++] = reg.Value;
+    for (GeneralPurposeRegister const& reg : state.Registers_IRQ)
+        registers[i++] = reg.Value;
+    for (GeneralPurposeRegister const& reg : state.Registers_und)
+        registers[i++] = reg.Value;
+
+    registers[i++] = state.CPSR.Full;
+
+    for (ProgramStatusRegisters const& status : state.SPSR)
+        registers[i++] = status.Full;
+
+    return registers;
+}
@@ -0,0 +1,71 @@
+#ifndef IDLE_LOOP_DETECTOR_HPP
+#define IDLE_LOOP_DETECTOR_HPP
+
+#include <array>
+#include <cstdint>
+
+class CPU;
+
+struct IdleLoopStatistics
+{
+    uint64_t SpinLoops = 0;     // Fast-forwards of loops that only read memory
+    uint64_t PollingLoops = 0;  // Fast-forwards of loops that read the I/O registers, like VCOUNT or IF
+    uint64_t SkippedCycles = 0; // Emulated time that went by without running the loops
+};
+
+// Finds short loops that can't leave until an event changes something, like the ones waiting for VCOUNT or for an
+// interrupt flag, and skips the iterations left until the next event.
+// A loop is idle when every register of the CPU is the same every time it jumps back to its start, while nothing was
+// written, no event ran and no register that changes on its own, like a timer counter, was read. Only whole
+// iterations are skipped, so the CPU ends up in exactly the state it would have reached by running them.
+class IdleLoopDetector final
+{
+public:
+    enum IdleLoopLimits
+    {
+        MAX_LOOP_SIZE = 0x40, // Bytes between the start of the loop and the branch back
+        BUSY_ITERATIONS = 4 // Iterations in a row that changed something before a loop is left alone until the next event
+    };
+
+    IdleLoopDetector(CPU* cpu);
+
+    // Called when the CPU jumped from branch back to target, now being the time after the jump.
+    // Returns the cycles to skip, a whole number of iterations that doesn't go past the deadline
+    uint64_t Check(uint32_t branch, uint32_t target, uint64_t now, uint64_t deadline);
+
+    void SetEnabled(bool enabled) { _enabled = enabled; _valid = false; }
+    bool IsEnabled() const { return _enabled; }
+
+    IdleLoopStatistics const& GetStatistics() const { return _statistics; }
+
+private:
+    enum IdleLoopData
+    {
+        NUM_SNAPSHOT_REGISTERS = 16 + 7 + 7 + 2 * 4 + 1 + 5 // Every register, banked ones included, and the status registers
+    };
+
+    typedef std::array<uint32_t, NUM_SNAPSHOT_REGISTERS> RegisterSnapshot;
+
+    // Records the state at the start of an iteration
+    void Start(uint32_t branch, uint32_t target, uint64_t now);
+    RegisterSnapshot GetRegisters() const;
+
+    CPU* _cpu;
+    bool _enabled;
+
+    // The loop being watched, and the state at the start of its last iteration
+    bool _valid;
+    uint32_t _branch;
+    uint32_t _target;
+    uint64_t _time;
+    uint64_t _writes;
+    uint64_t _reads;
+    uint64_t _timedReads;
+    uint64_t _events;
+    uint32_t _changes; // Iterations in a row that weren't idle, since the last event
+    RegisterSnapshot _registers;
+
+    IdleLoopStatistics _statistics;
+};
+
+#endif
@@ -0,0 +1,361 @@
+#include "LockstepRunner.hpp"
+#include "Common/GBA.hpp"
+
+#include <sstream>
+
+namespace
+{
+    struct ComparedRegion
+    {
+        char const* Name;
+        uint32_t Address;
+        uint32_t Size;
+    };
+
+    // The BIOS and the ROM are never written, and reading the BIOS depends on the PC
+    ComparedRegion const ComparedRegions[] =
+    {
+        { "EWRAM", 0x02000000, 0x40000 },
+        { "IWRAM", 0x03000000, 0x8000 },
+        { "I/O registers", 0x04000000, 0x400 },
+        { "Palette RAM", 0x05000000, 0x400 },
+        { "VRAM", 0x06000000, 0x18000 },
+        { "OAM", 0x07000000, 0x400 },
+        { "SRAM", 0x0E000000, 0x10000 }
+    };
+
+    struct BankedMode
+    {
+        char const* Name;
+        CPUMode Mode;
+        uint8_t FirstRegister; // R8-R12 are only banked in FIQ mode
+    };
+
+    BankedMode const BankedModes[] =
+    {
+        { "usr", CPUMode::User, 8 },
+        { "fiq", CPUMode::FIQ, 8 },
+        { "svc", CPUMode::Supervisor, 13 },
+        { "abt", CPUMode::Abort, 13 },
+        { "irq", CPUMode::IRQ, 13 },
+        { "und", CPUMode::Undefined, 13 }
+    };
+
+    void WriteHex(std::ostream& stream, uint32_t value)
+    {
+        stream << "0x" << std::hex << std::uppercase << value << std::dec;
+    }
+}
+
+std::string LockstepDivergence::ToString() const
+{
+    std::stringstream stream;
+
+    stream << "The engines diverged after step " << Step << ", the last match was before step " << IntervalStart << std::endl;
+
+    if (Located)
+        stream << "First differing instruction: ";
+    else
+        stream << "No instruction changed the differing state in the reference, the interval started at: ";
+
+    WriteHex(stream, Address);
+    stream << " (" << (Instruction.GetInstructionSet() == InstructionSet::ARM ? "ARM" : "Thumb") << ") ";
+    stream << (Instruction.IsValid() ? Instruction.ToString() : "unknown") << std::endl;
+
+    stream << Differences;
+    return stream.str();
+}
+
+LockstepRunner::LockstepRunner(CPUExecutionMode mode, uint32_t interval) : _mode(mode), _interval(interval ? interval : 1), _compareMemory(true),
+_reference(new CPU(CPUExecutionMode::Interpreter)), _tested(new CPU(mode)), _steps(0), _checkpointStep(0), _decodedAddress(0), _diverged(false)
+{
+    // Record what the reference runs so a divergence can be traced back to an instruction
+    _reference->RegisterInstructionCallback(InstructionCallbackTypes::InstructionDecoded, [this](DecodedInstruction const& instruction)
+    {
+        // The PC was already advanced
+        _decodedAddress = _reference->GetRegister(PC) - (instruction.GetInstructionSet() == InstructionSet::ARM ? 4 : 2);
+    });
+
+    _reference->RegisterInstructionCallback(InstructionCallbackTypes::InstructionExecuted, [this](DecodedInstruction const& instruction)
+    {
+        TraceEntry entry = { _decodedAddress, instruction, GetRegisters(*_reference) };
+        _trace.push_back(entry);
+    });
+
+    Checkpoint();
+}
+
+void LockstepRunner::LoadROM(GBAHeader& header, FILE* rom, FILE* bios)
+{
+    // Both CPUs read the files from where the caller left them
+    long romPosition = ftell(rom);
+    long biosPosition = bios ? ftell(bios) : 0;
+
+    _reference->LoadROM(header, rom, bios);
+
+    fseek(rom, romPosition, SEEK_SET);
+
+    if (bios)
+        fseek(bios, biosPosition, SEEK_SET);
+
+    _tested->LoadROM(header, rom, bios);
+
+    Checkpoint();
+}
+
+void LockstepRunner::Setup(std::function<void(CPU&)> const& setup)
+{
+    setup(*_reference);
+    setup(*_tested);
+
+    Checkpoint();
+}
+
+bool LockstepRunner::Step()
+{
+    if (_diverged)
+        return false;
+
+    uint64_t start = _tested->GetCycles();
+
+    if (_tested->GetJIT())
+        _tested->StepJIT();
+    else if (_mode == CPUExecutionMode::CachedInterpreter)
+        _tested->StepBlock();
+    else
+        _tested->Step();
+
+    uint32_t cycles = uint32_t(_tested->GetCycles() - start);
+
+    // Unknown instructions don't take any time but still move the PC
+    if (cycles == 0)
+        _reference->Step();
+    else
+        _reference->StepInstructions(cycles);
+
+    ++_steps;
+
+    if (_steps % _interval == 0)
+        return Check();
+
+    return true;
+}
+
+bool LockstepRunner::Run(uint64_t steps)
+{
+    for (uint64_t i = 0; i < steps; ++i)
+        if (!Step())
+            return false;
+
+    // Don't leave the last partial interval unchecked
+    if (_steps % _interval != 0)
+        return Check();
+
+    return true;
+}
+
+bool LockstepRunner::Check()
+{
+    if (_diverged)
+        return false;
+
+    std::stringstream differences;
+
+    RegisterSnapshot reference = GetRegisters(*_reference);
+    RegisterSnapshot tested = GetRegisters(*_tested);
+    std::bitset<NUM_COMPARED_REGISTERS> registers;
+
+    for (uint8_t i = 0; i < NUM_COMPARED_REGISTERS; ++i)
+    {
+        if (reference[i] == tested[i])
+            continue;
+
+        registers.set(i);
+
+        if (i == CPSR_INDEX)
+            differences << "CPSR: ";
+        else
+            differences << "R" << uint32_t(i) << ": ";
+
+        WriteHex(differences, reference[i]);
+        differences << " != ";
+        WriteHex(differences, tested[i]);
+        differences << std::endl;
+    }
+
+    // Differences that can't be traced back to an instruction
+    bool others = false;
+
+    CPUState& referenceState = _reference->GetState();
+    CPUState& testedState = _tested->GetState();
+
+    for (uint8_t i = 0; i < 5; ++i)
+    {
+        if (referenceState.SPSR[i].Full != testedState.SPSR[i].Full)
+        {
+            others = true;
+            differences << "SPSR " << uint32_t(i) << ": ";
+            WriteHex(differences, referenceState.SPSR[i].Full);
+            differences << " != ";
+            WriteHex(differences, testedState.SPSR[i].Full);
+            differences << std::endl;
+        }
+    }
+
+    // The registers of the current mode were already compared, the banked copies of the other modes are still left
+    if (_reference->GetCurrentCPUMode() == _tested->GetCurrentCPUMode())
+    {
+        CPUMode current = _reference->GetCurrentCPUMode();
+
+        for (BankedMode const& mode : BankedModes)
+        {
+            if (mode.Mode == current || (mode.Mode == CPUMode::User && current == CPUMode::System))
+                continue;
+
+            for (uint8_t reg = mode.FirstRegister; reg <= LR; ++reg)
+            {
+                uint32_t expected = _reference->GetRegisterForMode(mode.Mode, reg);
+                uint32_t actual = _tested->GetRegisterForMode(mode.Mode, reg);
+
+                if (expected == actual)
+                    continue;
+
+                others = true;
+                differences << "R" << uint32_t(reg) << "_" << mode.Name << ": ";
+                WriteHex(differences, expected);
+                differences << " != ";
+                WriteHex(differences, actual);
+                differences << std::endl;
+            }
+        }
+    }
+
+    if (_reference->GetCycles() != _tested->GetCycles())
+    {
+        differences << "Cycles: " << _reference->GetCycles() << " != " << _tested->GetCycles() << std::endl;
+        others = true;
+    }
+
+    bool memory = false;
+
+    if (_compareMemory)
+    {
+        for (ComparedRegion const& region : ComparedRegions)
+        {
+            if (ChecksumMemory(*_reference, region.Address, region.Size) != ChecksumMemory(*_tested, region.Address, region.Size))
+            {
+                memory = true;
+                differences << region.Name << " contents differ" << std::endl;
+            }
+        }
+    }
+
+    if (registers.none() && !others && !memory)
+    {
+        Checkpoint();
+        return true;
+    }
+
+    _diverged = true;
+    _divergence.Step = _steps;
+    _divergence.IntervalStart = _checkpointStep;
+    _divergence.Differences = differences.str();
+
+    Locate(registers, memory);
+    return false;
+}
+
+void LockstepRunner::Checkpoint()
+{
+    _checkpoint = GetRegisters(*_reference);
+    _checkpointStep = _steps;
+    _trace.clear();
+}
+
+void LockstepRunner::Locate(std::bitset<NUM_COMPARED_REGISTERS> const& registers, bool memory)
+{
+    _divergence.Located = false;
+    _divergence.Address = _checkpoint[PC];
+    _divergence.Instruction = DecodedInstruction();
+
+    if (_trace.empty())
+        return;
+
+    // Without a better candidate, blame the start of the interval
+    _divergence.Address = _trace.front().Address;
+    _divergence.Instruction = _trace.front().Instruction;
+
+    RegisterSnapshot const* previous = &_checkpoint;
+
+    for (TraceEntry const& entry : _trace)
+    {
+        bool blamed = memory && WritesMemory(entry.Instruction);
+
+        for (uint8_t i = 0; i < NUM_COMPARED_REGISTERS && !blamed; ++i)
+        {
+            if (!registers[i])
+                continue;
+
+            // The PC changes on every instruction, only a jump can be blamed for it
+            if (i == PC)
+                blamed = entry.Registers[PC] != entry.Address + (entry.Instruction.GetInstructionSet() == InstructionSet::ARM ? 4 : 2);
+            else
+                blamed = entry.Registers[i] != (*previous)[i];
+        }
+
+        if (blamed)
+        {
+            _divergence.Located = true;
+            _divergence.Address = entry.Address;
+            _divergence.Instruction = entry.Instruction;
+            return;
+        }
+
+        previous = &entry.Registers;
+    }
+}
+
+LockstepRunner::RegisterSnapshot LockstepRunner::GetRegisters(CPU& cpu)
+{
+    RegisterSnapshot registers;
+
+    for (uint8_t i = 0; i <= PC; ++i)
+        registers[i] = cpu.GetRegister(i);
+
+    registers[CPSR_INDEX] = cpu.GetCurrentStatusRegister().Full;
+    return registers;
+}
+
+uint32_t LockstepRunner::ChecksumMemory(CPU& cpu, uint32_t address, uint32_t size)
+{
+    // FNV-1a over the words of the region
+    uint32_t hash = 2166136261u;
+
+    for (uint32_t offset = 0; offset < size; offset += 4)
+    {
+        hash ^= cpu.GetMemory()->ReadUInt32(address + offset);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+bool LockstepRunner::WritesMemory(DecodedInstruction const& instruction)
+{
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ARMLoadStore:
+        case InstructionHandler::ARMMiscellaneousLoadStore:
+        case InstructionHandler::ARMLoadStoreMultiple:
+        case InstructionHandler::ThumbStackOperation:
+        case InstructionHandler::ThumbLoadStoreRegisterOffset:
+        case InstructionHandler::ThumbLoadStoreImmediateOffset:
+        case InstructionHandler::ThumbLoadStoreStack:
+        case InstructionHandler::ThumbLoadStoreMultiple:
+            return !instruction.IsLoad();
+        default:
+            break;
+    }
+
+    return false;
+}
@@ -0,0 +1,100 @@
+#ifndef LOCKSTEP_RUNNER_HPP
+#define LOCKSTEP_RUNNER_HPP
+
+#include "CPU/CPU.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct GBAHeader;
+
+// Where the tested execution engine stopped agreeing with the interpreter
+struct LockstepDivergence
+{
+    uint64_t Step;             // Step of the tested engine after which the states differed
+    uint64_t IntervalStart;    // First step since the last comparison that matched
+    bool Located;              // Whether an instruction could be blamed, otherwise it is just the first one of the interval
+    uint32_t Address;
+    DecodedInstruction Instruction;
+    std::string Differences;   // One line per register, memory region or counter that differs
+
+    std::string ToString() const;
+};
+
+// Runs a CPU with another execution engine in lockstep with the interpreter and compares both after every few steps.
+// The interpreter catches up with exactly the cycles each step of the tested engine took, so the peripherals see the same times on both.
+class LockstepRunner final
+{
+public:
+    // Interval is the number of steps of the tested engine between two comparisons
+    LockstepRunner(CPUExecutionMode mode, uint32_t interval);
+
+    void LoadROM(GBAHeader& header, FILE* rom, FILE* bios);
+    // Runs the same code on both CPUs, to load a program or set registers up
+    void Setup(std::function<void(CPU&)> const& setup);
+
+    // These return false once the CPUs diverged
+    bool Step();
+    bool Run(uint64_t steps);
+    // Compares both CPUs right now, no matter where the interval is
+    bool Check();
+
+    bool HasDiverged() const { return _diverged; }
+    LockstepDivergence const& GetDivergence() const { return _divergence; }
+    uint64_t GetSteps() const { return _steps; }
+
+    // Comparing the memory is much slower than comparing the registers, it is on by default
+    void SetCompareMemory(bool compare) { _compareMemory = compare; }
+
+    std::unique_ptr<CPU>& GetReference() { return _reference; }
+    std::unique_ptr<CPU>& GetTested() { return _tested; }
+
+private:
+    enum LockstepRegisters
+    {
+        CPSR_INDEX = 16,
+        NUM_COMPARED_REGISTERS = 17 // R0-R15 of the current mode and the CPSR
+    };
+
+    typedef std::array<uint32_t, NUM_COMPARED_REGISTERS> RegisterSnapshot;
+
+    struct TraceEntry
+    {
+        uint32_t Address;
+        DecodedInstruction Instruction;
+        RegisterSnapshot Registers; // After the instruction ran
+    };
+
+    static RegisterSnapshot GetRegisters(CPU& cpu);
+    static uint32_t ChecksumMemory(CPU& cpu, uint32_t address, uint32_t size);
+    static bool WritesMemory(DecodedInstruction const& instruction);
+
+    void Checkpoint();
+    void Locate(std::bitset<NUM_COMPARED_REGISTERS> const& registers, bool memory);
+
+    CPUExecutionMode _mode;
+    uint32_t _interval;
+    bool _compareMemory;
+
+    std::unique_ptr<CPU> _reference; // Always the interpreter
+    std::unique_ptr<CPU> _tested;
+
+    uint64_t _steps;
+    uint64_t _checkpointStep;
+    RegisterSnapshot _checkpoint; // Registers of the reference at the last comparison that matched
+
+    // Every instruction the reference ran since the last comparison
+    std::vector<TraceEntry> _trace;
+    uint32_t _decodedAddress;
+
+    bool _diverged;
+    LockstepDivergence _divergence;
+};
+
+#endif
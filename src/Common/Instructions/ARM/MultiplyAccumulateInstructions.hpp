@@ -20,7 +20,7 @@ namespace ARM
         bool IsSigned() const { return GetOpcode() == ARMOpcodes::SMLAL || GetOpcode() == ARMOpcodes::SMULL; }
         bool Accumulate() const { return MathHelper::CheckBit(_instruction, 21); }
         
-        bool IsLong() const { return GetOpcode() > ARMOpcodes::MLA; }
+        bool IsLong() const { return MathHelper::CheckBit(_instruction, 23); }
 
         uint8_t GetDestinationRegisterHigh() const { return MathHelper::GetBits(_instruction, 16, 4); }
         uint8_t GetDestinationRegisterLow() const { return MathHelper::GetBits(_instruction, 12, 4); }
@@ -0,0 +1,10 @@
+#include "SoftwareInterruptInstruction.hpp"
+#include <sstream>
+#include <string>
+
+std::string ARM::SoftwareInterruptInstruction::ToString() const
+{
+    std::stringstream stream;
+    stream << "SWI #0x" << std::hex << std::uppercase << GetComment();
+    return stream.str();
+}
@@ -0,0 +1,24 @@
+#ifndef ARM_SWI_INSTR_H
+#define ARM_SWI_INSTR_H
+
+#include "Common/Instructions/ARMInstruction.hpp"
+
+#include "Common/MathHelper.hpp"
+
+namespace ARM
+{
+    class SoftwareInterruptInstruction : public ARMInstruction
+    {
+    public:
+        SoftwareInterruptInstruction(uint32_t instruction) : ARMInstruction(instruction) { }
+
+        // Ignored by the CPU, the BIOS takes the number of the function from bits 16-23
+        uint32_t GetComment() const { return MathHelper::GetBits(_instruction, 0, 24); }
+
+        uint32_t GetOpcode() const override { return ARMOpcodes::SWI; }
+        bool IsImmediate() const override { return true; }
+
+        std::string ToString() const override;
+    };
+}
+#endif
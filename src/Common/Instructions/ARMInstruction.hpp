@@ -3,7 +3,7 @@
 
 #include "Instruction.hpp"
 
-enum class InstructionCondition
+enum class InstructionCondition : uint8_t
 {
     Equal, // EQ
     NotEqual, // NE
@@ -25,7 +25,7 @@ enum class InstructionCondition
 
 namespace ARM
 {
-    enum class ShiftType
+    enum class ShiftType : uint8_t
     {
         LSL,
         LSR,
@@ -33,6 +33,27 @@ namespace ARM
         ROR
     };
 
+    // Bits 21-24 of a data processing instruction
+    enum class DataProcessingOperation : uint8_t
+    {
+        AND,
+        EOR,
+        SUB,
+        RSB,
+        ADD,
+        ADC,
+        SBC,
+        RSC,
+        TST,
+        TEQ,
+        CMP,
+        CMN,
+        ORR,
+        MOV,
+        BIC,
+        MVN
+    };
+
     enum ARMOpcodes
     {
         ADC,
@@ -84,7 +105,9 @@ namespace ARM
         TEQ,
         TST,
         UMLAL,
-        UMULL
+        UMULL,
+
+        OPCODE_COUNT
     };
     
     std::string ToString(uint32_t opcode);
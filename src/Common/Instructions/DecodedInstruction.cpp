@@ -0,0 +1,79 @@
+#include "DecodedInstruction.hpp"
+
+#include "ARM/BranchInstructions.hpp"
+#include "ARM/DataProcessingInstructions.hpp"
+#include "ARM/PSRTransferInstructions.hpp"
+#include "ARM/MultiplyAccumulateInstructions.hpp"
+#include "ARM/LoadStoreInstructions.hpp"
+#include "ARM/SoftwareInterruptInstruction.hpp"
+
+#include "Thumb/DataProcessingInstructions.hpp"
+#include "Thumb/BranchExchangeInstruction.hpp"
+#include "Thumb/LoadStoreInstructions.hpp"
+#include "Thumb/MiscInstructions.hpp"
+
+std::string DecodedInstruction::ToString() const
+{
+    // The instruction classes already know how to print themselves, this is not a hot path so we just build one
+    switch (Format)
+    {
+        case InstructionFormat::ARMBranch:
+            return ARM::BranchInstruction(Encoding).ToString();
+        case InstructionFormat::ARMBranchLinkExchangeImmediate:
+            return ARM::BranchLinkExchangeImmediateInstruction(Encoding).ToString();
+        case InstructionFormat::ARMBranchLinkExchangeRegister:
+            return ARM::BranchLinkExchangeRegisterInstruction(Encoding).ToString();
+        case InstructionFormat::ARMDataProcessing:
+            return ARM::DataProcessingInstruction(Encoding).ToString();
+        case InstructionFormat::ARMMovePSRToRegister:
+            return ARM::MovePSRToRegisterInstruction(Encoding).ToString();
+        case InstructionFormat::ARMMoveRegisterToPSRImmediate:
+            return ARM::MoveRegisterToPSRImmediateInstruction(Encoding).ToString();
+        case InstructionFormat::ARMMoveRegisterToPSRRegister:
+            return ARM::MoveRegisterToPSRRegisterInstruction(Encoding).ToString();
+        case InstructionFormat::ARMMultiplyAccumulate:
+            return ARM::MultiplyAccumulateInstruction(Encoding).ToString();
+        case InstructionFormat::ARMLoadStore:
+            return ARM::LoadStoreInstruction(Encoding).ToString();
+        case InstructionFormat::ARMMiscellaneousLoadStore:
+            return ARM::MiscellaneousLoadStoreInstruction(Encoding).ToString();
+        case InstructionFormat::ARMSoftwareInterrupt:
+            return ARM::SoftwareInterruptInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbImmediateShift:
+            return Thumb::ImmediateShiftInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbAddSub:
+            return Thumb::AddSubInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbAddSubCmpMovImmediate:
+            return Thumb::AddSubCmpMovImmInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbDataProcessing:
+            return Thumb::DataProcessingInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbSpecialDataProcessing:
+            return Thumb::SpecialDataProcessingInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbBranchExchange:
+            return Thumb::BranchExchangeInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbLoadFromLiteralPool:
+            return Thumb::LoadFromLiteralStoreInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbLoadStoreRegisterOffset:
+            return Thumb::LoadStoreRegisterOffsetInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbLoadStoreImmediate:
+            return Thumb::LoadStoreImmediateInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbLoadStoreStack:
+            return Thumb::LoadStoreStackInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbStackOperation:
+            return Thumb::StackOperation(Encoding).ToString();
+        case InstructionFormat::ThumbLoadStoreMultiple:
+            return Thumb::LoadStoreMultipleInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbConditionalBranch:
+            return Thumb::BranchInstruction(Encoding, true).ToString();
+        case InstructionFormat::ThumbUnconditionalBranch:
+            return Thumb::BranchInstruction(Encoding, false).ToString();
+        case InstructionFormat::ThumbLongBranchLink:
+            return Thumb::LongBranchLinkInstruction(Encoding).ToString();
+        case InstructionFormat::ThumbSoftwareInterrupt:
+            return Thumb::SoftwareInterruptInstruction(Encoding).ToString();
+        default:
+            break;
+    }
+
+    return "Unknown";
+}
@@ -0,0 +1,183 @@
+#ifndef DECODEDINSTRUCTION_HPP
+#define DECODEDINSTRUCTION_HPP
+
+#include "ARMInstruction.hpp"
+#include "ThumbInstruction.hpp"
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// The encoding classes the decoder can tell apart, each one matches one of the instruction classes in Common/Instructions
+enum class InstructionFormat : uint8_t
+{
+    Unknown = 0,
+
+    // ARM
+    ARMBranch,
+    ARMBranchLinkExchangeImmediate,
+    ARMBranchLinkExchangeRegister,
+    ARMDataProcessing,
+    ARMMovePSRToRegister,
+    ARMMoveRegisterToPSRImmediate,
+    ARMMoveRegisterToPSRRegister,
+    ARMMultiplyAccumulate,
+    ARMLoadStore,
+    ARMMiscellaneousLoadStore,
+    ARMSoftwareInterrupt,
+
+    // Thumb
+    ThumbImmediateShift,
+    ThumbAddSub,
+    ThumbAddSubCmpMovImmediate,
+    ThumbDataProcessing,
+    ThumbSpecialDataProcessing,
+    ThumbBranchExchange,
+    ThumbLoadFromLiteralPool,
+    ThumbLoadStoreRegisterOffset,
+    ThumbLoadStoreImmediate,
+    ThumbLoadStoreStack,
+    ThumbStackOperation,
+    ThumbLoadStoreMultiple,
+    ThumbConditionalBranch,
+    ThumbUnconditionalBranch,
+    ThumbLongBranchLink,
+    ThumbSoftwareInterrupt,
+
+    Count
+};
+
+// The interpreter routine that executes an instruction, chosen by the decoder
+enum class InstructionHandler : uint8_t
+{
+    None = 0,
+
+    // ARM
+    ARMBranch,
+    ARMDataProcessing,
+    ARMLoadStore,
+    ARMMiscellaneousLoadStore,
+    ARMPSROperation,
+    ARMMultiply,
+    ARMLoadStoreMultiple,
+    ARMSoftwareInterrupt,
+
+    // Thumb
+    ThumbStackOperation,
+    ThumbImmediateShift,
+    ThumbAddSubImmReg,
+    ThumbAddCmpMovSubImmediate,
+    ThumbDataProcessing,
+    ThumbSpecialDataProcessing,
+    ThumbBranchExchange,
+    ThumbBranchLink,
+    ThumbBranch,
+    ThumbLiteralPoolLoad,
+    ThumbLoadStoreRegisterOffset,
+    ThumbLoadStoreImmediateOffset,
+    ThumbLoadStoreStack,
+    ThumbLoadStoreMultiple,
+    ThumbSoftwareInterrupt,
+
+    Count
+};
+
+// How the second operand of an ARM data processing instruction is built
+enum class OperandForm : uint8_t
+{
+    Immediate,      // Rotated 8 bit immediate
+    ImmediateShift, // Register shifted by an immediate amount
+    RegisterShift   // Register shifted by the value of Rs
+};
+
+namespace ARM
+{
+    enum DataProcessingVariants
+    {
+        DATA_PROCESSING_VARIANTS = 16 * 3 * 4 * 2 // Operation, operand form, shift type and S bit
+    };
+
+    // Identifies the specialized interpreter handler for a data processing instruction
+    inline constexpr uint16_t GetDataProcessingVariant(DataProcessingOperation operation, OperandForm form, ShiftType shift, bool setConditionCodes)
+    {
+        return uint16_t((((uint32_t(operation) * 3 + uint32_t(form)) * 4 + uint32_t(shift)) << 1) | (setConditionCodes ? 1 : 0));
+    }
+
+    // Split a data processing variant back into its parts, the inverse of GetDataProcessingVariant
+    inline constexpr DataProcessingOperation GetVariantOperation(std::size_t variant) { return DataProcessingOperation((variant >> 3) / 3); }
+    inline constexpr OperandForm GetVariantForm(std::size_t variant) { return OperandForm((variant >> 3) % 3); }
+    inline constexpr bool GetVariantSetConditionCodes(std::size_t variant) { return (variant & 1) != 0; }
+
+    // Immediate operands are always rotated, so the other shift types just share the ROR handler
+    inline constexpr ShiftType GetVariantShift(std::size_t variant)
+    {
+        return GetVariantForm(variant) == OperandForm::Immediate ? ShiftType::ROR : ShiftType((variant >> 1) & 3);
+    }
+}
+
+// A decoded instruction with all its operands already extracted from the encoding.
+// It is a plain value so it can be copied around and cached without any allocations.
+struct DecodedInstruction
+{
+    enum Flag : uint16_t
+    {
+        IMMEDIATE = 1 << 0,            // The operand (or offset) is an immediate value
+        SET_CONDITION_CODES = 1 << 1,  // S bit
+        LINK = 1 << 2,                 // Branches that save the return address, and the second half of a Thumb BL
+        PRE_INDEXED = 1 << 3,          // P bit
+        BASE_ADDED = 1 << 4,           // U bit
+        WRITE_BACK = 1 << 5,           // The base register is updated
+        LOAD = 1 << 6,                 // L bit
+        BYTE = 1 << 7,                 // B bit
+        SIGNED = 1 << 8,               // Signed multiplies
+        SHIFT_BY_REGISTER = 1 << 9,    // The shift amount is held in Rs
+        ACCUMULATE = 1 << 10,          // A bit
+        LONG = 1 << 11,                // 64 bit multiplies
+        SAVED_PSR = 1 << 12            // The PSR transfer works on the SPSR
+    };
+
+    uint32_t Encoding;         // The raw opcode
+    uint32_t Immediate;        // Immediate operand, offset, registers list or SWI comment, already shifted and sign extended
+    uint16_t Flags;
+    InstructionFormat Format;
+    uint8_t Opcode;            // ARM::ARMOpcodes or Thumb::ThumbOpcodes
+    InstructionHandler Handler;
+    InstructionCondition Condition;
+    uint8_t Rd;                // Destination register (RdHi for long multiplies)
+    uint8_t Rn;                // First operand or base register (RdLo / accumulator for multiplies, fields mask for MSR)
+    uint8_t Rm;                // Second operand, index or source register
+    uint8_t Rs;                // Register holding the shift amount or the multiplier
+    ARM::ShiftType Shift;
+    uint8_t ShiftAmount;       // Shift applied to Rm, or the rotation of an ARM data processing immediate
+    uint8_t Timing;
+    uint16_t Variant;          // Specialized handler chosen by the decoder, see ARM::GetDataProcessingVariant
+
+    bool IsValid() const { return Format != InstructionFormat::Unknown; }
+    InstructionSet GetInstructionSet() const { return Format >= InstructionFormat::ThumbImmediateShift ? InstructionSet::Thumb : InstructionSet::ARM; }
+    uint32_t GetOpcode() const { return Opcode; }
+    uint32_t GetTiming() const { return Timing; }
+
+    bool HasFlag(Flag flag) const { return (Flags & flag) != 0; }
+    bool IsImmediate() const { return HasFlag(IMMEDIATE); }
+    bool SetConditionCodes() const { return HasFlag(SET_CONDITION_CODES); }
+    bool Link() const { return HasFlag(LINK); }
+    bool IsPreIndexed() const { return HasFlag(PRE_INDEXED); }
+    bool IsBaseAdded() const { return HasFlag(BASE_ADDED); }
+    bool WriteBack() const { return HasFlag(WRITE_BACK); }
+    bool IsLoad() const { return HasFlag(LOAD); }
+    bool IsByte() const { return HasFlag(BYTE); }
+    bool IsSigned() const { return HasFlag(SIGNED); }
+    bool ShiftByRegister() const { return HasFlag(SHIFT_BY_REGISTER); }
+    bool Accumulate() const { return HasFlag(ACCUMULATE); }
+    bool IsLong() const { return HasFlag(LONG); }
+    bool UsesSavedPSR() const { return HasFlag(SAVED_PSR); }
+
+    // Disassembles the instruction, only meant for debugging
+    std::string ToString() const;
+};
+
+static_assert(std::is_trivial<DecodedInstruction>::value, "DecodedInstruction must stay a plain value");
+static_assert(sizeof(DecodedInstruction) == 24, "DecodedInstruction must keep a fixed size");
+
+#endif
@@ -31,3 +31,10 @@ uint32_t Thumb::StackOperation::GetOpcode() const
 {
     return IsPopOperand() ? ThumbOpcodes::POP : ThumbOpcodes::PUSH;
 }
+
+std::string Thumb::SoftwareInterruptInstruction::ToString() const
+{
+    std::stringstream stream;
+    stream << "SWI #0x" << std::hex << std::uppercase << GetComment();
+    return stream.str();
+}
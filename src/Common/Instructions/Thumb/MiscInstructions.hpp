@@ -17,6 +17,19 @@ namespace Thumb
         bool IsPopOperand() const { return MathHelper::CheckBit(_instruction, 11); }
         uint32_t GetRegisterMask() const { return MathHelper::GetBits(_instruction, 0, 9); }
     };
+
+    class SoftwareInterruptInstruction : public ThumbInstruction
+    {
+    public:
+        SoftwareInterruptInstruction(uint16_t op) : ThumbInstruction(op) { }
+
+        uint32_t GetOpcode() const override { return ThumbOpcodes::SWI; }
+        std::string ToString() const override;
+        bool IsImmediate() const override { return true; }
+
+        // The number of the BIOS function
+        uint32_t GetComment() const { return MathHelper::GetBits(_instruction, 0, 8); }
+    };
 }
 
 #endif // THUMB_MISC_INSTR_H
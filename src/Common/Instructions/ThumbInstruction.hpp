@@ -85,7 +85,9 @@ namespace Thumb
         SXTH,
         TST,
         UXTB,
-        UXTH
+        UXTH,
+
+        OPCODE_COUNT
     };
     
     std::string ToString(uint32_t opcode);
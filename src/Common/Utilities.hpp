@@ -2,13 +2,45 @@
 #define UTILITIES_HPP
 
 #include <cstdint>
-#include <limits>
+#include <cstddef>
 
 // #undef _GLIBCXX_HAVE_BROKEN_VSWPRINTF
 
 namespace Utilities
 {
     void Assert(bool condition, const char* message);
+
+    // C++11 replacement for std::index_sequence, used to generate lookup tables at compile time.
+    // The sequence is built by halves so the template depth stays logarithmic even for thousands of entries.
+    template <std::size_t... Indices>
+    struct IndexSequence { };
+
+    template <typename First, typename Second>
+    struct ConcatenateIndexSequence;
+
+    template <std::size_t... First, std::size_t... Second>
+    struct ConcatenateIndexSequence<IndexSequence<First...>, IndexSequence<Second...>>
+    {
+        typedef IndexSequence<First..., (sizeof...(First) + Second)...> Type;
+    };
+
+    template <std::size_t Count>
+    struct MakeIndexSequence
+    {
+        typedef typename ConcatenateIndexSequence<typename MakeIndexSequence<Count / 2>::Type, typename MakeIndexSequence<Count - Count / 2>::Type>::Type Type;
+    };
+
+    template <>
+    struct MakeIndexSequence<0>
+    {
+        typedef IndexSequence<> Type;
+    };
+
+    template <>
+    struct MakeIndexSequence<1>
+    {
+        typedef IndexSequence<0> Type;
+    };
 }
 
 class GeneralPurposeRegister
@@ -58,10 +90,9 @@ public:
         }
     };
 
+    // Nothing but the value, the registers live in flat arrays that are read and written on every instruction.
+    // The flag-setting instructions compute the condition flags themselves.
     uint32_t Value = 0;
-    bool Carry = false;
-    bool Overflow = false;
-    bool Borrow = false;
 
     operator uint32_t() const { return Value; }
 
@@ -86,21 +117,9 @@ public:
         return *this;
     }
 
-    GeneralPurposeRegister& operator = (const uint64_t& val)
-    {
-        Borrow = false;
-        Carry = false;
-        Overflow = val > std::numeric_limits<int32_t>::max();
-        Value = uint32_t(val);
-        return *this;
-    }
-
-    GeneralPurposeRegister& operator = (const GeneralPurposeRegister& other)
+    GeneralPurposeRegister& operator = (uint32_t val)
     {
-        Value = other.Value;
-        Carry = other.Carry;
-        Overflow = other.Overflow;
-        Borrow = other.Borrow;
+        Value = val;
         return *this;
     }
 
@@ -113,30 +132,12 @@ public:
     // Arithmetic operators
     GeneralPurposeRegister& operator += (uint32_t const& other)
     {
-        int64_t dirtySum = (int64_t(Value) + other);
-
-        Borrow = false;
-
-        // Returns 1 if the addition specified as its parameter caused a carry
-        // (true result is bigger than 2^32−1, where the operands are treated
-        //  as unsigned integers), and returns 0 in all other cases.
-        Carry = dirtySum > 0x80000000;
-
-        // Returns 1 if the addition specified as its parameter caused a 32-bit
-        // signed overflow. Addition generates an overflow if both operands have
-        // the same sign (bit[31]), and the sign of the result is different to
-        // the sign of both operands.
-        Overflow = dirtySum > std::numeric_limits<uint32_t>::max();
-
         Value += other;
         return *this;
     }
 
     GeneralPurposeRegister& operator -= (uint32_t const& other)
     {
-        Carry = false;
-        Borrow = Value < other;
-        Overflow = (uint64_t(Value) - other) < std::numeric_limits<uint32_t>::min();
         Value -= other;
         return *this;
     }
@@ -192,6 +193,8 @@ public:
     }
 };
 
+static_assert(sizeof(GeneralPurposeRegister) == sizeof(uint32_t), "GeneralPurposeRegister must stay a plain 32-bit value");
+
 inline GeneralPurposeRegister operator + (GeneralPurposeRegister const& left, GeneralPurposeRegister const& right)
 {
     GeneralPurposeRegister reg = left;
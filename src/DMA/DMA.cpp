@@ -1,48 +1,173 @@
 #include "DMA.hpp"
 #include "CPU/CPU.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // How the address moves after each unit, the source can't reload so its last setting increments too
+    int32_t GetStep(uint16_t control, uint32_t unit)
+    {
+        switch (control)
+        {
+            case DMA::Decrement:
+                return -int32_t(unit);
+            case DMA::Fixed:
+                return 0;
+            default:
+                return int32_t(unit);
+        }
+    }
+
+    // The cycles of a sequential access to each region, for 16 and 32 bit units. EWRAM, the palette and VRAM have a
+    // 16 bit bus, the Game Pak runs with the wait states WAITCNT starts with
+    uint32_t GetAccessCycles(uint32_t address, uint32_t unit)
+    {
+        switch (address >> 24)
+        {
+            case 0x02:
+                return unit == 4 ? 6 : 3;
+            case 0x05:
+            case 0x06:
+                return unit == 4 ? 2 : 1;
+            case 0x08:
+            case 0x09:
+            case 0x0A:
+            case 0x0B:
+            case 0x0C:
+            case 0x0D:
+                return unit == 4 ? 6 : 3;
+            case 0x0E:
+            case 0x0F:
+                return 5;
+            default:
+                return 1;
+        }
+    }
+
+    // The source address is 27 bits for channel 0, the destination address is 27 bits for channels 0-2. The others are 28 bits
+    uint32_t GetSourceMask(DMA::Channel channel)
+    {
+        return channel == DMA::DMA0 ? 0x7FFFFFF : 0xFFFFFFF;
+    }
+
+    uint32_t GetDestinationMask(DMA::Channel channel)
+    {
+        return channel == DMA::DMA3 ? 0xFFFFFFF : 0x7FFFFFF;
+    }
+
+    bool IsGamePak(uint32_t address)
+    {
+        return (address >> 24) >= 0x08 && (address >> 24) <= 0x0D;
+    }
+}
+
+DMA::DMA(CPU* cpu) : _cpu(cpu), _controls(), _pending(0), _channels()
+{
+    for (uint8_t channel = 0; channel <= 3; ++channel)
+    {
+        _cpu->GetIO()->RegisterWriteHandler(GetDMAControlAddress(Channel(channel)), [this, channel](uint16_t previous, uint16_t value)
+        {
+            WriteControl(Channel(channel), DMAControl(previous), DMAControl(value));
+        });
+    }
+
+    _cpu->GetScheduler()->RegisterHandler(EventType::DMA, [this](uint64_t) { Step(); });
+}
+
 void DMA::Step()
 {
-    // Check for pending transfers
     for (uint8_t channel = 0; channel <= 3; ++channel)
     {
-        DMAControl control = DMAControl(_cpu->GetMemory()->ReadUInt16(GetDMAControlAddress(Channel(channel))));
-        
-        // Ignore disabled channels
-        if (!control.Data.Enabled)
+        if (!(_pending & (1 << channel)))
             continue;
 
-        if (control.Data.StartTiming == StartType::Immediately)
-            InitiateTransfer(Channel(channel), control);
+        _pending &= ~(1 << channel);
+        InitiateTransfer(Channel(channel), DMAControl(_controls[channel]));
     }
 }
 
-void DMA::InitiateTransfer(Channel channel, DMAControl control)
+void DMA::WriteControl(Channel channel, DMAControl previous, DMAControl value)
 {
-    uint32_t sourceAddress = _cpu->GetMemory()->ReadUInt32(GetDMASourceAddress(channel));
-    uint32_t destinationAddress = _cpu->GetMemory()->ReadUInt32(GetDMADestinationAddress(channel));
+    _controls[channel] = value.Full;
 
-    // The source/destination address is 27 bits for channel 0 and 28 bits for channels 1-3
-    if (channel == Channel::DMA0)
+    // The channel reads its registers when it gets enabled, a transfer that repeats keeps going from where it stopped
+    if (value.Data.Enabled && !previous.Data.Enabled)
     {
-        sourceAddress &= 0x7FFFFFF;
-        destinationAddress &= 0x7FFFFFF;
+        LoadAddresses(channel);
+        LoadCount(channel);
     }
-    else
+
+    // A transfer only starts when the channel gets enabled, right after the instruction that enabled it.
+    // The cached interpreter and the JIT leave their block for it
+    if (value.Data.Enabled && !previous.Data.Enabled && value.Data.StartTiming == StartType::Immediately)
     {
-        sourceAddress &= 0xFFFFFFF;
-        destinationAddress &= 0xFFFFFFF;
+        _pending |= 1 << channel;
+        _cpu->GetScheduler()->Schedule(EventType::DMA, _cpu->GetCycles());
     }
+    else if (!value.Data.Enabled)
+        _pending &= ~(1 << channel);
+}
+
+void DMA::LoadAddresses(Channel channel)
+{
+    std::unique_ptr<IORegisters>& io = _cpu->GetIO();
+
+    // The addresses are write only, the hardware still sees them
+    _channels[channel].Source = io->Get32(GetDMASourceAddress(channel)) & GetSourceMask(channel);
+    _channels[channel].Destination = io->Get32(GetDMADestinationAddress(channel)) & GetDestinationMask(channel);
+}
+
+void DMA::LoadCount(Channel channel)
+{
+    // The count is 14 bits for channels 0-2 and 16 bits for channel 3, 0 is the largest transfer
+    uint32_t mask = channel == Channel::DMA3 ? 0xFFFF : 0x3FFF;
+    uint32_t count = _cpu->GetIO()->Get(GetDMACountAddress(channel)) & mask;
+
+    _channels[channel].Count = count ? count : mask + 1;
+}
 
-    // The DMA transfer size is only 14 bits
-    uint16_t size = _cpu->GetMemory()->ReadUInt16(GetDMACountAddress(channel)) & 0x3FFF;
+void DMA::InitiateTransfer(Channel channel, DMAControl control)
+{
+    ChannelState& state = _channels[channel];
+
+    // The units are aligned, the addresses keep their low bits for the next transfer anyway
+    uint32_t unit = control.Data.TransferType ? 4 : 2;
+    uint32_t source = state.Source & ~(unit - 1);
+    uint32_t destination = state.Destination & ~(unit - 1);
+
+    int32_t sourceStep = GetStep(control.Data.SourceAddressControl, unit);
+    int32_t destinationStep = GetStep(control.Data.DestinationAddressControl, unit);
+
+    if (TransferFast(source, destination, state.Count, unit, sourceStep, destinationStep))
+        ++_statistics.FastTransfers;
+    else
+        TransferSlow(source, destination, state.Count, unit, sourceStep, destinationStep);
+
+    state.Source = source + uint32_t(sourceStep) * state.Count;
+    state.Destination = destination + uint32_t(destinationStep) * state.Count;
+
+    // The CPU waits for the transfer to finish
+    uint32_t cycles = GetTransferCycles(source, destination, state.Count, unit);
+    _cpu->AddCycles(cycles);
 
+    ++_statistics.Transfers;
+    _statistics.Cycles += cycles;
+
+    if (control.Data.Repeat)
+    {
+        LoadCount(channel);
 
-    // If we are not supposed to repeat the transfer, disable it when finished
-    if (!control.Data.Repeat)
+        if (control.Data.DestinationAddressControl == AddressControl::IncrementReload)
+            state.Destination = _cpu->GetIO()->Get32(GetDMADestinationAddress(channel)) & GetDestinationMask(channel);
+    }
+    else
     {
+        // If we are not supposed to repeat the transfer, disable it when finished
         control.Data.Enabled = 0;
-        _cpu->GetMemory()->WriteUInt16(GetDMAControlAddress(channel), control.Full);
+        _cpu->GetIO()->Set(GetDMAControlAddress(channel), control.Full);
+        _controls[channel] = control.Full;
     }
 
     // Request an interrupt at the end of the transfer if needed
@@ -50,21 +175,88 @@ void DMA::InitiateTransfer(Channel channel, DMAControl control)
         _cpu->RequestInterrupt(InterruptTypes(uint8_t(InterruptTypes::DMA0) + channel));
 }
 
+bool DMA::TransferFast(uint32_t source, uint32_t destination, uint32_t count, uint32_t unit, int32_t sourceStep, int32_t destinationStep)
+{
+    if (destinationStep != int32_t(unit) || (sourceStep != int32_t(unit) && sourceStep != 0))
+        return false;
+
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    uint32_t size = count * unit;
+    uint32_t read = sourceStep ? size : unit;
+
+    uint8_t* output = memory->GetWritePointer(destination, size);
+    uint8_t const* input = memory->GetReadPointer(source, read);
+
+    if (!output || !input)
+        return false;
+
+    // The units are copied in order, a destination that overlaps the source after its start sees the units that were
+    // already copied. memmove only gets the other overlaps right
+    if (input < output + size && output < input + read && (!sourceStep || input < output))
+        return false;
+
+    if (sourceStep)
+        memmove(output, input, size);
+    else if (!memcmp(input, input + 1, unit - 1))
+        memset(output, input[0], size);
+    else
+    {
+        // Fills with the unit, doubling what was already filled each time
+        memcpy(output, input, unit);
+
+        for (uint32_t filled = unit; filled < size; filled *= 2)
+            memcpy(output + filled, output, std::min(filled, size - filled));
+    }
+
+    memory->NotifyWrite(destination, size);
+    return true;
+}
+
+void DMA::TransferSlow(uint32_t source, uint32_t destination, uint32_t count, uint32_t unit, int32_t sourceStep, int32_t destinationStep)
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (unit == 4)
+            memory->WriteUInt32(destination, memory->ReadUInt32(source));
+        else
+            memory->WriteUInt16(destination, memory->ReadUInt16(source));
+
+        source += sourceStep;
+        destination += destinationStep;
+    }
+}
+
+uint32_t DMA::GetTransferCycles(uint32_t source, uint32_t destination, uint32_t count, uint32_t unit)
+{
+    // A read and a write for each unit, and 2 internal cycles. The first access to the Game Pak isn't sequential, it takes 2 more
+    uint32_t cycles = count * (GetAccessCycles(source, unit) + GetAccessCycles(destination, unit)) + 2;
+
+    if (IsGamePak(source))
+        cycles += 2;
+
+    if (IsGamePak(destination))
+        cycles += 2;
+
+    return cycles;
+}
+
 void DMA::ProcessInterrupt(InterruptTypes type)
 {
     // Check if any enabled DMA transfer channel is scheduled to run when this interrupt is triggered
 
     for (uint8_t channel = 0; channel <= 3; ++channel)
     {
-        DMAControl control = DMAControl(_cpu->GetMemory()->ReadUInt16(GetDMAControlAddress(Channel(channel))));
+        DMAControl control = DMAControl(_controls[channel]);
 
         // Ignore disabled channels
         if (!control.Data.Enabled)
             continue;
 
-        if (control.Data.StartTiming == StartType::VBlank && type == InterruptTypes::VBlank ||
-            control.Data.StartTiming == StartType::HBlank && type == InterruptTypes::HBlank)
+        if ((control.Data.StartTiming == StartType::VBlank && type == InterruptTypes::VBlank) ||
+            (control.Data.StartTiming == StartType::HBlank && type == InterruptTypes::HBlank))
             InitiateTransfer(Channel(channel), control);
     }
 }
-
@@ -16,15 +16,15 @@ union DMAControl
 {
     struct
     {
-        uint8_t Enabled : 1;
-        uint8_t IRQ : 1;
-        uint8_t StartTiming : 2;
-        uint8_t GamePakDRQ : 1;
-        uint8_t TransferType : 1;
-        uint8_t Repeat : 1;
-        uint8_t SourceAddressControl : 2;
-        uint8_t DestinationAddressControl : 2;
-        uint8_t Unused : 5;
+        uint16_t Unused : 5;
+        uint16_t DestinationAddressControl : 2;
+        uint16_t SourceAddressControl : 2;
+        uint16_t Repeat : 1;
+        uint16_t TransferType : 1;
+        uint16_t GamePakDRQ : 1;
+        uint16_t StartTiming : 2;
+        uint16_t IRQ : 1;
+        uint16_t Enabled : 1;
     } Data;
 
     uint16_t Full;
@@ -33,6 +33,13 @@ union DMAControl
 };
 #pragma pack(pop)
 
+struct DMAStatistics
+{
+    uint64_t Transfers = 0;     // Every transfer that ran
+    uint64_t FastTransfers = 0; // The ones that were a single copy or fill of the memory
+    uint64_t Cycles = 0;        // The CPU was stalled for
+};
+
 class DMA
 {
 public:
@@ -52,14 +59,44 @@ public:
         DMA3
     };
 
-    DMA(CPU* cpu) : _cpu(cpu) { }
+    enum AddressControl
+    {
+        Increment,
+        Decrement,
+        Fixed,
+        IncrementReload // The destination goes back to the value of the register when the transfer repeats
+    };
+
+    DMA(CPU* cpu);
 
+    // Runs the transfers that were started by writing their control register, the scheduler calls this once one was
     void Step();
     void ProcessInterrupt(InterruptTypes type);
 
+    DMAStatistics const& GetStatistics() const { return _statistics; }
 
 private:
+    // The internal registers of a channel, loaded from the I/O registers when it gets enabled
+    struct ChannelState
+    {
+        uint32_t Source;
+        uint32_t Destination;
+        uint32_t Count;
+    };
+
     void InitiateTransfer(Channel channel, DMAControl control);
+    void WriteControl(Channel channel, DMAControl previous, DMAControl value);
+
+    void LoadAddresses(Channel channel);
+    void LoadCount(Channel channel);
+
+    // Copies or fills the memory at once when both sides are plain memory and the destination increments, returns
+    // whether it could. Anything else is transferred a unit at a time
+    bool TransferFast(uint32_t source, uint32_t destination, uint32_t count, uint32_t unit, int32_t sourceStep, int32_t destinationStep);
+    void TransferSlow(uint32_t source, uint32_t destination, uint32_t count, uint32_t unit, int32_t sourceStep, int32_t destinationStep);
+
+    // The cycles a transfer keeps the CPU off the bus, with the default wait states of the Game Pak
+    static uint32_t GetTransferCycles(uint32_t source, uint32_t destination, uint32_t count, uint32_t unit);
 
     // Helper functions
     static uint32_t GetDMAControlAddress(Channel channel) { return DMA0CNT_H + uint8_t(channel) * 0xC; }
@@ -68,5 +105,9 @@ private:
     static uint32_t GetDMADestinationAddress(Channel channel) { return DMA0DAD + uint8_t(channel) * 0xC; }
 
     CPU* _cpu;
+    uint16_t _controls[4]; // Copies of DMAxCNT_H, kept up to date by the write handlers
+    uint8_t _pending;      // One bit for each channel with an immediate transfer to run
+    ChannelState _channels[4];
+    DMAStatistics _statistics;
 };
 #endif
\ No newline at end of file
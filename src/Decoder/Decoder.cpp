@@ -1,9 +1,12 @@
 #include "Decoder.hpp"
+#include "DecoderTables.hpp"
+
 #include "Common/Instructions/ARM/BranchInstructions.hpp"
 #include "Common/Instructions/ARM/DataProcessingInstructions.hpp"
 #include "Common/Instructions/ARM/PSRTransferInstructions.hpp"
 #include "Common/Instructions/ARM/MultiplyAccumulateInstructions.hpp"
 #include "Common/Instructions/ARM/LoadStoreInstructions.hpp"
+#include "Common/Instructions/ARM/SoftwareInterruptInstruction.hpp"
 
 #include "Common/Instructions/Thumb/DataProcessingInstructions.hpp"
 #include "Common/Instructions/Thumb/BranchExchangeInstruction.hpp"
@@ -12,128 +15,498 @@
 
 #include "Common/MathHelper.hpp"
 
-using std::shared_ptr;
-
-Decoder::Decoder()
+namespace
 {
+    // The instruction classes are only used here to pull the operands out of the opcode,
+    // everything else in the emulator works with the resulting DecodedInstruction.
+    DecodedInstruction Unknown(uint32_t opcode)
+    {
+        DecodedInstruction decoded = DecodedInstruction();
+        decoded.Encoding = opcode;
+        decoded.Format = InstructionFormat::Unknown;
+        decoded.Handler = InstructionHandler::None;
+        decoded.Condition = InstructionCondition::Always;
+        return decoded;
+    }
 
-}
+    DecodedInstruction Describe(Instruction const& instruction, uint32_t opcode, InstructionFormat format, InstructionHandler handler)
+    {
+        DecodedInstruction decoded = Unknown(opcode);
+        decoded.Format = format;
+        decoded.Handler = handler;
+        decoded.Opcode = instruction.GetOpcode();
+        decoded.Timing = instruction.GetTiming();
+        return decoded;
+    }
 
-shared_ptr<Instruction> Decoder::DecodeARM(uint32_t opcode)
-{
-    // Check for BLX and BX
-    if (MathHelper::CheckBits(opcode, 8, 20, 0x12FFF))
-        return shared_ptr<Instruction>(new ARM::BranchLinkExchangeRegisterInstruction(opcode));
+    DecodedInstruction Describe(ARMInstruction const& instruction, uint32_t opcode, InstructionFormat format, InstructionHandler handler)
+    {
+        DecodedInstruction decoded = Describe(static_cast<Instruction const&>(instruction), opcode, format, handler);
+        decoded.Condition = instruction.GetCondition();
+        return decoded;
+    }
 
-    // Now check for B, BL and BLX_IMM
-    if (MathHelper::CheckBits(opcode, 25, 3, 0x5))
+    void SetFlag(DecodedInstruction& decoded, DecodedInstruction::Flag flag, bool set)
     {
-        if (MathHelper::CheckBits(opcode, 27, 4, 0xF))
-            return shared_ptr<Instruction>(new ARM::BranchLinkExchangeImmediateInstruction(opcode));
+        if (set)
+            decoded.Flags |= flag;
+    }
 
-        return shared_ptr<Instruction>(new ARM::BranchInstruction(opcode));
+    DecodedInstruction Extract(ARM::BranchInstruction const& branch, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(branch, opcode, InstructionFormat::ARMBranch, InstructionHandler::ARMBranch);
+        // The offset is a signed 24 bits value, shifted left by 2
+        decoded.Immediate = MathHelper::IntegerSignExtend<26, 32>(branch.GetSignedOffset());
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        SetFlag(decoded, DecodedInstruction::LINK, branch.Link());
+        return decoded;
     }
 
-    // PSR Transfer instructions
-    // We have to check for these before we check for data processing instructions because these are a special case of the dataproc ones.
-    if (MathHelper::CheckBits(opcode, 23, 5, 0x2) && MathHelper::CheckBits(opcode, 16, 6, 0xF) && MathHelper::CheckBits(opcode, 0, 12, 0)) // MRS Instruction
-        return shared_ptr<Instruction>(new ARM::MovePSRToRegisterInstruction(opcode));
+    DecodedInstruction Extract(ARM::BranchLinkExchangeImmediateInstruction const& branch, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(branch, opcode, InstructionFormat::ARMBranchLinkExchangeImmediate, InstructionHandler::ARMBranch);
+        // The second bit of the offset is set to the value of the H bit
+        decoded.Immediate = MathHelper::IntegerSignExtend<26, 32>(branch.GetSignedOffset()) + (branch.GetSecondBit() << 1);
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        SetFlag(decoded, DecodedInstruction::LINK, true);
+        return decoded;
+    }
 
-    if (MathHelper::CheckBits(opcode, 20, 2, 0x2) && MathHelper::CheckBits(opcode, 12, 4, 0xF))
+    DecodedInstruction Extract(ARM::BranchLinkExchangeRegisterInstruction const& branch, uint32_t opcode)
     {
-        if (MathHelper::CheckBits(opcode, 23, 5, 0x6)) // MSR_IMM
-            return shared_ptr<Instruction>(new ARM::MoveRegisterToPSRImmediateInstruction(opcode));
+        DecodedInstruction decoded = Describe(branch, opcode, InstructionFormat::ARMBranchLinkExchangeRegister, InstructionHandler::ARMBranch);
+        decoded.Rm = branch.GetRegister();
+        SetFlag(decoded, DecodedInstruction::LINK, branch.Link());
+        return decoded;
+    }
 
-        if (MathHelper::CheckBits(opcode, 4, 8, 0)) // MSR_REG
-            return shared_ptr<Instruction>(new ARM::MoveRegisterToPSRRegisterInstruction(opcode));
+    DecodedInstruction Extract(ARM::DataProcessingInstruction const& dataproc, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(dataproc, opcode, InstructionFormat::ARMDataProcessing, InstructionHandler::ARMDataProcessing);
+        decoded.Rd = dataproc.GetDestinationRegister();
+        decoded.Rn = dataproc.GetFirstOperand();
+        decoded.Shift = dataproc.GetShiftType();
+        SetFlag(decoded, DecodedInstruction::SET_CONDITION_CODES, dataproc.SetConditionCodes());
+
+        if (dataproc.IsImmediate())
+        {
+            SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+            decoded.Immediate = dataproc.GetShiftImmediate() ? dataproc.GetShiftedSecondOperandImmediate() : dataproc.GetSecondOperand();
+            decoded.ShiftAmount = dataproc.GetShiftImmediate() << 1;
+        }
+        else
+        {
+            decoded.Rm = dataproc.GetSecondOperand();
+
+            if (dataproc.ShiftByRegister())
+            {
+                SetFlag(decoded, DecodedInstruction::SHIFT_BY_REGISTER, true);
+                decoded.Rs = dataproc.GetShiftRegisterOrImmediate();
+            }
+            else
+                decoded.ShiftAmount = dataproc.GetShiftRegisterOrImmediate();
+        }
+
+        OperandForm form = dataproc.IsImmediate() ? OperandForm::Immediate : (decoded.ShiftByRegister() ? OperandForm::RegisterShift : OperandForm::ImmediateShift);
+        decoded.Variant = ARM::GetDataProcessingVariant(ARM::DataProcessingOperation(MathHelper::GetBits(opcode, 21, 4)), form, decoded.Shift, decoded.SetConditionCodes());
+        return decoded;
     }
 
-    if (MathHelper::CheckBits(opcode, 25, 3, 0) && MathHelper::CheckBit(opcode, 7) && MathHelper::CheckBit(opcode, 4))
-        return shared_ptr<Instruction>(new ARM::MiscellaneousLoadStoreInstruction(opcode));
+    DecodedInstruction Extract(ARM::MovePSRToRegisterInstruction const& mrs, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(mrs, opcode, InstructionFormat::ARMMovePSRToRegister, InstructionHandler::ARMPSROperation);
+        decoded.Rd = mrs.GetDestinationRegister();
+        SetFlag(decoded, DecodedInstruction::SAVED_PSR, mrs.GetPSRType() == ARM::PSRType::SPSR);
+        return decoded;
+    }
 
-    // Check for data processing instructions
-    if (MathHelper::CheckBits(opcode, 26, 2, 0))
-        return shared_ptr<Instruction>(new ARM::DataProcessingInstruction(opcode));
+    DecodedInstruction Extract(ARM::MoveRegisterToPSRImmediateInstruction const& msr, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(msr, opcode, InstructionFormat::ARMMoveRegisterToPSRImmediate, InstructionHandler::ARMPSROperation);
+        decoded.Rn = msr.GetFieldsMask();
+        // GetImmediateShift already returns the rotation in bits (rotate_imm * 2)
+        decoded.ShiftAmount = msr.GetImmediateShift() >> 1;
+        decoded.Immediate = decoded.ShiftAmount ? MathHelper::RotateRight(uint32_t(msr.GetImmediateValue()), decoded.ShiftAmount) : msr.GetImmediateValue();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        SetFlag(decoded, DecodedInstruction::SAVED_PSR, msr.GetPSRType() == ARM::PSRType::SPSR);
+        return decoded;
+    }
 
-    // Check for multiply / multiply accumulate instructions
-    if (MathHelper::CheckBits(opcode, 24, 4, 0) && MathHelper::CheckBits(opcode, 4, 4, 9))
-        return shared_ptr<Instruction>(new ARM::MultiplyAccumulateInstruction(opcode));
+    DecodedInstruction Extract(ARM::MoveRegisterToPSRRegisterInstruction const& msr, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(msr, opcode, InstructionFormat::ARMMoveRegisterToPSRRegister, InstructionHandler::ARMPSROperation);
+        decoded.Rn = msr.GetFieldsMask();
+        decoded.Rm = msr.GetSourceRegister();
+        SetFlag(decoded, DecodedInstruction::SAVED_PSR, msr.GetPSRType() == ARM::PSRType::SPSR);
+        return decoded;
+    }
 
-    // We group the LDR/STR and LDM/STM instructions in a single class
-    if (MathHelper::CheckBits(opcode, 26, 2, 1) || MathHelper::CheckBits(opcode, 26, 2, 2))
-        return shared_ptr<Instruction>(new ARM::LoadStoreInstruction(opcode));
-    if (MathHelper::CheckBits(opcode, 25, 3, 4)) // LDM/STR
-        return shared_ptr<Instruction>(new ARM::LoadStoreInstruction(opcode));
+    DecodedInstruction Extract(ARM::MultiplyAccumulateInstruction const& mul, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(mul, opcode, InstructionFormat::ARMMultiplyAccumulate, InstructionHandler::ARMMultiply);
+        decoded.Rd = mul.GetDestinationRegisterHigh();
+        decoded.Rn = mul.GetDestinationRegisterLow(); // Also the accumulate register of MLA
+        decoded.Rm = mul.GetFirstOperand();
+        decoded.Rs = mul.GetSecondOperand();
+        SetFlag(decoded, DecodedInstruction::SET_CONDITION_CODES, mul.SetConditionCodes());
+        SetFlag(decoded, DecodedInstruction::ACCUMULATE, mul.Accumulate());
+        SetFlag(decoded, DecodedInstruction::LONG, mul.IsLong());
+        SetFlag(decoded, DecodedInstruction::SIGNED, mul.IsSigned());
+        return decoded;
+    }
 
-    return shared_ptr<Instruction>(nullptr);
-}
+    DecodedInstruction Extract(ARM::LoadStoreInstruction const& loadStore, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(loadStore, opcode, InstructionFormat::ARMLoadStore,
+            loadStore.IsMultiple() ? InstructionHandler::ARMLoadStoreMultiple : InstructionHandler::ARMLoadStore);
+        decoded.Rd = loadStore.GetRegister();
+        decoded.Rn = loadStore.GetBaseRegister();
+        SetFlag(decoded, DecodedInstruction::LOAD, loadStore.IsLoad());
+        SetFlag(decoded, DecodedInstruction::PRE_INDEXED, loadStore.IsPreIndexed());
+        SetFlag(decoded, DecodedInstruction::BASE_ADDED, loadStore.IsBaseAdded());
+
+        if (loadStore.IsMultiple())
+        {
+            // LDM/STM only write back when the W bit is set
+            decoded.Immediate = loadStore.GetRegistersList();
+            SetFlag(decoded, DecodedInstruction::WRITE_BACK, MathHelper::CheckBit(opcode, 21));
+            return decoded;
+        }
+
+        SetFlag(decoded, DecodedInstruction::BYTE, loadStore.IsUnsignedByte());
+        SetFlag(decoded, DecodedInstruction::WRITE_BACK, loadStore.WriteBack());
+
+        if (loadStore.IsImmediate())
+        {
+            SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+            decoded.Immediate = loadStore.GetImmediateOffset();
+        }
+        else
+        {
+            decoded.Rm = loadStore.GetIndexRegister();
+            decoded.Shift = loadStore.GetShiftType();
+            decoded.ShiftAmount = loadStore.GetShiftImmediate();
+        }
+
+        return decoded;
+    }
 
-shared_ptr<Instruction> Decoder::DecodeThumb(uint16_t opcode)
-{
-    if (MathHelper::GetBits(opcode, 13, 3) == 0) // 000 (LSR, LSL, ASR, ADD SUB REG)
+    DecodedInstruction Extract(ARM::MiscellaneousLoadStoreInstruction const& loadStore, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(loadStore, opcode, InstructionFormat::ARMMiscellaneousLoadStore, InstructionHandler::ARMMiscellaneousLoadStore);
+        decoded.Rd = loadStore.GetRegister();
+        decoded.Rn = loadStore.GetBaseRegister();
+        SetFlag(decoded, DecodedInstruction::LOAD, MathHelper::CheckBit(opcode, 20));
+        SetFlag(decoded, DecodedInstruction::SIGNED, MathHelper::CheckBit(opcode, 6));
+        SetFlag(decoded, DecodedInstruction::PRE_INDEXED, loadStore.IsPreIndexed());
+        SetFlag(decoded, DecodedInstruction::BASE_ADDED, loadStore.IsBaseAdded());
+        // Post-indexed transfers always write back
+        SetFlag(decoded, DecodedInstruction::WRITE_BACK, !loadStore.IsPreIndexed() || MathHelper::CheckBit(opcode, 21));
+
+        if (loadStore.IsImmediate())
+        {
+            SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+            decoded.Immediate = loadStore.GetImmediateOffset();
+        }
+        else
+            decoded.Rm = MathHelper::GetBits(opcode, 0, 4);
+
+        return decoded;
+    }
+
+    DecodedInstruction Extract(Thumb::ImmediateShiftInstruction const& shift, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(shift, opcode, InstructionFormat::ThumbImmediateShift, InstructionHandler::ThumbImmediateShift);
+        decoded.Rd = shift.GetDestinationRegister();
+        decoded.Rm = shift.GetSourceRegister();
+        decoded.Immediate = shift.GetOffset();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        return decoded;
+    }
+
+    DecodedInstruction Extract(Thumb::AddSubInstruction const& addSub, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(addSub, opcode, InstructionFormat::ThumbAddSub, InstructionHandler::ThumbAddSubImmReg);
+        decoded.Rd = addSub.GetDestinationRegister();
+        decoded.Rn = addSub.GetSourceRegister();
+
+        if (addSub.IsImmediate())
+        {
+            SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+            decoded.Immediate = addSub.GetThirdOperand();
+        }
+        else
+            decoded.Rm = addSub.GetThirdOperand();
+
+        return decoded;
+    }
+
+    DecodedInstruction Extract(Thumb::AddSubCmpMovImmInstruction const& instruction, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(instruction, opcode, InstructionFormat::ThumbAddSubCmpMovImmediate, InstructionHandler::ThumbAddCmpMovSubImmediate);
+        decoded.Rd = instruction.GetDestinationRegister();
+        decoded.Immediate = instruction.GetImmediate();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        return decoded;
+    }
+
+    DecodedInstruction Extract(Thumb::DataProcessingInstruction const& dataproc, uint32_t opcode)
     {
-        if (MathHelper::GetBits(opcode, 11, 2) <= 2)
-            return shared_ptr<Instruction>(new Thumb::ImmediateShiftInstruction(opcode));
-        return shared_ptr<Instruction>(new Thumb::AddSubInstruction(opcode));
+        DecodedInstruction decoded = Describe(dataproc, opcode, InstructionFormat::ThumbDataProcessing, InstructionHandler::ThumbDataProcessing);
+        decoded.Rd = dataproc.GetFirstOperand();
+        decoded.Rm = dataproc.GetSecondOperand();
+        return decoded;
     }
 
-    if (MathHelper::GetBits(opcode, 13, 3) == 1) // ADD SUB CMP MOV IMM
-        return shared_ptr<Instruction>(new Thumb::AddSubCmpMovImmInstruction(opcode));
+    DecodedInstruction Extract(Thumb::SpecialDataProcessingInstruction const& dataproc, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(dataproc, opcode, InstructionFormat::ThumbSpecialDataProcessing, InstructionHandler::ThumbSpecialDataProcessing);
+        decoded.Rd = dataproc.GetDestinationRegister();
+        decoded.Rm = dataproc.GetFirstDataRegister();
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 10, 6) == 16) // DataProc
-        return shared_ptr<Instruction>(new Thumb::DataProcessingInstruction(opcode));
+    DecodedInstruction Extract(Thumb::BranchExchangeInstruction const& branch, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(branch, opcode, InstructionFormat::ThumbBranchExchange, InstructionHandler::ThumbBranchExchange);
+        decoded.Rm = branch.GetTargetAddressRegister();
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 10, 6) == 17) // SpecialDataProc and Branch
+    DecodedInstruction Extract(Thumb::LoadFromLiteralStoreInstruction const& load, uint32_t opcode)
     {
-        if (MathHelper::GetBits(opcode, 8, 2) == 3)
-            return shared_ptr<Instruction>(new Thumb::BranchExchangeInstruction(opcode));
+        DecodedInstruction decoded = Describe(load, opcode, InstructionFormat::ThumbLoadFromLiteralPool, InstructionHandler::ThumbLiteralPoolLoad);
+        decoded.Rd = load.GetDestinationRegister();
+        decoded.Immediate = load.GetImmediate();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        SetFlag(decoded, DecodedInstruction::LOAD, true);
+        return decoded;
+    }
 
-        return shared_ptr<Instruction>(new Thumb::SpecialDataProcessingInstruction(opcode));
+    DecodedInstruction Extract(Thumb::LoadStoreRegisterOffsetInstruction const& loadStore, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(loadStore, opcode, InstructionFormat::ThumbLoadStoreRegisterOffset, InstructionHandler::ThumbLoadStoreRegisterOffset);
+        decoded.Rd = loadStore.GetDestinationRegister();
+        decoded.Rn = loadStore.GetFirstOperand();
+        decoded.Rm = loadStore.GetSecondOperand();
+        SetFlag(decoded, DecodedInstruction::LOAD, loadStore.IsLoad());
+        return decoded;
     }
 
-    if (MathHelper::GetBits(opcode, 11, 5) == 9) // LDR literal store
-        return shared_ptr<Instruction>(new Thumb::LoadFromLiteralStoreInstruction(opcode));
+    DecodedInstruction Extract(Thumb::LoadStoreImmediateInstruction const& loadStore, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(loadStore, opcode, InstructionFormat::ThumbLoadStoreImmediate, InstructionHandler::ThumbLoadStoreImmediateOffset);
+        decoded.Rd = loadStore.GetDestinationRegister();
+        decoded.Rn = loadStore.GetBaseAddressRegister();
+        decoded.Immediate = loadStore.GetImmediate();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        SetFlag(decoded, DecodedInstruction::LOAD, loadStore.IsLoad());
+        SetFlag(decoded, DecodedInstruction::BYTE, loadStore.IsByte());
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 12, 4) == 5) // Load/Store Register
-        return shared_ptr<Instruction>(new Thumb::LoadStoreRegisterOffsetInstruction(opcode));
+    DecodedInstruction Extract(Thumb::LoadStoreStackInstruction const& loadStore, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(loadStore, opcode, InstructionFormat::ThumbLoadStoreStack, InstructionHandler::ThumbLoadStoreStack);
+        decoded.Rd = loadStore.GetDestinationRegister();
+        decoded.Rn = 13; // SP
+        decoded.Immediate = loadStore.GetRelativeOffset();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        SetFlag(decoded, DecodedInstruction::LOAD, loadStore.IsLoadOperation());
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 13, 3) == 3 // Load/Store Word/Byte Immediate
-        || MathHelper::GetBits(opcode, 12, 4) == 8) // Load Store Halfword Immediate
-        return shared_ptr<Instruction>(new Thumb::LoadStoreImmediateInstruction(opcode));
+    DecodedInstruction Extract(Thumb::StackOperation const& stack, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(stack, opcode, InstructionFormat::ThumbStackOperation, InstructionHandler::ThumbStackOperation);
+        decoded.Rn = 13; // SP
+        decoded.Immediate = stack.GetRegisterMask(); // Bit 8 is LR for PUSH and PC for POP
+        SetFlag(decoded, DecodedInstruction::LOAD, stack.IsPopOperand());
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 12, 4) == 9) // Load/Store to/from stack
-        return shared_ptr<Instruction>(new Thumb::LoadStoreStackInstruction(opcode));
+    DecodedInstruction Extract(Thumb::LoadStoreMultipleInstruction const& loadStore, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(loadStore, opcode, InstructionFormat::ThumbLoadStoreMultiple, InstructionHandler::ThumbLoadStoreMultiple);
+        decoded.Rn = loadStore.GetRegister();
+        decoded.Immediate = loadStore.GetRegisterList();
+        SetFlag(decoded, DecodedInstruction::LOAD, loadStore.IsLoad());
+        SetFlag(decoded, DecodedInstruction::WRITE_BACK, true);
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 12, 4) == 11) // Misc.
+    DecodedInstruction Extract(Thumb::BranchInstruction const& branch, uint32_t opcode)
     {
-        if (MathHelper::GetBits(opcode, 8, 4) == 0) // Adjust stack pointer
-            return shared_ptr<Instruction>(nullptr); // NYI
+        DecodedInstruction decoded = Describe(branch, opcode,
+            branch.IsConditionalBranch() ? InstructionFormat::ThumbConditionalBranch : InstructionFormat::ThumbUnconditionalBranch, InstructionHandler::ThumbBranch);
 
-        if (MathHelper::GetBits(opcode, 9, 2) == 2) // Push/pop registers list
-            return shared_ptr<Instruction>(new Thumb::StackOperation(opcode));
+        if (branch.IsConditionalBranch())
+            decoded.Condition = InstructionCondition(branch.GetCondition());
+
+        decoded.Immediate = branch.GetBranchOffset();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        return decoded;
     }
 
-    if (MathHelper::GetBits(opcode, 12, 4) == 12) // Load/Store Multiple
-        return shared_ptr<Instruction>(new Thumb::LoadStoreMultipleInstruction(opcode));
+    DecodedInstruction Extract(Thumb::LongBranchLinkInstruction const& branch, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(branch, opcode, InstructionFormat::ThumbLongBranchLink, InstructionHandler::ThumbBranchLink);
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+
+        // The first half carries the signed high part of the offset, the second half the low part and performs the call
+        if (branch.IsTriggeringSubroutineCall())
+        {
+            SetFlag(decoded, DecodedInstruction::LINK, true);
+            decoded.Immediate = branch.GetOffset() << 1;
+        }
+        else
+            decoded.Immediate = MathHelper::IntegerSignExtend<11, 32>(branch.GetOffset()) << 12;
+
+        return decoded;
+    }
 
-    if (MathHelper::GetBits(opcode, 12, 4) == 13) // Conditional Branch, Undefined and Soft. int.
+    DecodedInstruction Extract(ARM::SoftwareInterruptInstruction const& swi, uint32_t opcode)
     {
-        if (MathHelper::GetBits(opcode, 8, 4) == 14) // Undefined Instruction
-            return shared_ptr<Instruction>(nullptr); // NYI
+        DecodedInstruction decoded = Describe(swi, opcode, InstructionFormat::ARMSoftwareInterrupt, InstructionHandler::ARMSoftwareInterrupt);
+        decoded.Immediate = swi.GetComment();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        return decoded;
+    }
 
-        if (MathHelper::GetBits(opcode, 8, 4) == 15) // Software Interrupt
-            return shared_ptr<Instruction>(nullptr); // NYI
+    DecodedInstruction Extract(Thumb::SoftwareInterruptInstruction const& swi, uint32_t opcode)
+    {
+        DecodedInstruction decoded = Describe(swi, opcode, InstructionFormat::ThumbSoftwareInterrupt, InstructionHandler::ThumbSoftwareInterrupt);
+        decoded.Immediate = swi.GetComment();
+        SetFlag(decoded, DecodedInstruction::IMMEDIATE, true);
+        return decoded;
+    }
 
-        // Conditional Branch
-        return shared_ptr<Instruction>(new Thumb::BranchInstruction(opcode, true));
+    // Picks between the candidate and the fallback format of a table entry by testing the bits that are not part of the index
+    InstructionFormat Refine(DecoderTables::ARMEntry const& entry, uint32_t opcode)
+    {
+        switch (entry.Check)
+        {
+            case DecoderTables::ARMCheck::None:
+                return entry.Format;
+            case DecoderTables::ARMCheck::BranchExchange:
+                if (MathHelper::CheckBits(opcode, 8, 12, 0xFFF))
+                    return entry.Format;
+                break;
+            case DecoderTables::ARMCheck::BranchExchangeOrMSR:
+                if (MathHelper::CheckBits(opcode, 8, 12, 0xFFF))
+                    return entry.Format;
+                if (MathHelper::CheckBits(opcode, 8, 8, 0xF0))
+                    return InstructionFormat::ARMMoveRegisterToPSRRegister;
+                break;
+            case DecoderTables::ARMCheck::MovePSRToRegister:
+                if (MathHelper::CheckBits(opcode, 16, 4, 0xF) && MathHelper::CheckBits(opcode, 8, 4, 0) && MathHelper::CheckBits(opcode, 0, 4, 0))
+                    return entry.Format;
+                break;
+            case DecoderTables::ARMCheck::MoveRegisterToPSR:
+                if (MathHelper::CheckBits(opcode, 8, 8, 0xF0))
+                    return entry.Format;
+                break;
+            case DecoderTables::ARMCheck::MoveImmediateToPSR:
+                if (MathHelper::CheckBits(opcode, 12, 4, 0xF))
+                    return entry.Format;
+                break;
+            case DecoderTables::ARMCheck::Unconditional:
+                if (MathHelper::CheckBits(opcode, 28, 4, 0xF))
+                    return entry.Format;
+                break;
+        }
+
+        return entry.Fallback;
+    }
+}
+
+Decoder::Decoder()
+{
+
+}
+
+InstructionFormat Decoder::ClassifyARM(uint32_t opcode)
+{
+    return Refine(DecoderTables::ARMTable[DecoderTables::ARMIndex(opcode)], opcode);
+}
+
+InstructionFormat Decoder::ClassifyThumb(uint16_t opcode)
+{
+    return DecoderTables::ThumbTable[DecoderTables::ThumbIndex(opcode)];
+}
+
+DecodedInstruction Decoder::DecodeARM(uint32_t opcode)
+{
+    switch (ClassifyARM(opcode))
+    {
+        case InstructionFormat::ARMBranch:
+            return Extract(ARM::BranchInstruction(opcode), opcode);
+        case InstructionFormat::ARMBranchLinkExchangeImmediate:
+            return Extract(ARM::BranchLinkExchangeImmediateInstruction(opcode), opcode);
+        case InstructionFormat::ARMBranchLinkExchangeRegister:
+            return Extract(ARM::BranchLinkExchangeRegisterInstruction(opcode), opcode);
+        case InstructionFormat::ARMDataProcessing:
+            return Extract(ARM::DataProcessingInstruction(opcode), opcode);
+        case InstructionFormat::ARMMovePSRToRegister:
+            return Extract(ARM::MovePSRToRegisterInstruction(opcode), opcode);
+        case InstructionFormat::ARMMoveRegisterToPSRImmediate:
+            return Extract(ARM::MoveRegisterToPSRImmediateInstruction(opcode), opcode);
+        case InstructionFormat::ARMMoveRegisterToPSRRegister:
+            return Extract(ARM::MoveRegisterToPSRRegisterInstruction(opcode), opcode);
+        case InstructionFormat::ARMMultiplyAccumulate:
+            return Extract(ARM::MultiplyAccumulateInstruction(opcode), opcode);
+        case InstructionFormat::ARMLoadStore: // Also LDM/STM
+            return Extract(ARM::LoadStoreInstruction(opcode), opcode);
+        case InstructionFormat::ARMMiscellaneousLoadStore:
+            return Extract(ARM::MiscellaneousLoadStoreInstruction(opcode), opcode);
+        case InstructionFormat::ARMSoftwareInterrupt:
+            return Extract(ARM::SoftwareInterruptInstruction(opcode), opcode);
+        default:
+            break;
     }
 
-    if (MathHelper::GetBits(opcode, 11, 5) == 28) // Unconditional Branch
-        return shared_ptr<Instruction>(new Thumb::BranchInstruction(opcode, false));
+    return Unknown(opcode);
+}
 
-    if (MathHelper::GetBits(opcode, 11, 5) == 30 || // BL prefix
-        MathHelper::GetBits(opcode, 11, 5) == 31)   // BL suffix
-        return shared_ptr<Instruction>(new Thumb::LongBranchLinkInstruction(opcode));
+DecodedInstruction Decoder::DecodeThumb(uint16_t opcode)
+{
+    switch (ClassifyThumb(opcode))
+    {
+        case InstructionFormat::ThumbImmediateShift:
+            return Extract(Thumb::ImmediateShiftInstruction(opcode), opcode);
+        case InstructionFormat::ThumbAddSub:
+            return Extract(Thumb::AddSubInstruction(opcode), opcode);
+        case InstructionFormat::ThumbAddSubCmpMovImmediate:
+            return Extract(Thumb::AddSubCmpMovImmInstruction(opcode), opcode);
+        case InstructionFormat::ThumbDataProcessing:
+            return Extract(Thumb::DataProcessingInstruction(opcode), opcode);
+        case InstructionFormat::ThumbSpecialDataProcessing:
+            return Extract(Thumb::SpecialDataProcessingInstruction(opcode), opcode);
+        case InstructionFormat::ThumbBranchExchange:
+            return Extract(Thumb::BranchExchangeInstruction(opcode), opcode);
+        case InstructionFormat::ThumbLoadFromLiteralPool:
+            return Extract(Thumb::LoadFromLiteralStoreInstruction(opcode), opcode);
+        case InstructionFormat::ThumbLoadStoreRegisterOffset:
+            return Extract(Thumb::LoadStoreRegisterOffsetInstruction(opcode), opcode);
+        case InstructionFormat::ThumbLoadStoreImmediate:
+            return Extract(Thumb::LoadStoreImmediateInstruction(opcode), opcode);
+        case InstructionFormat::ThumbLoadStoreStack:
+            return Extract(Thumb::LoadStoreStackInstruction(opcode), opcode);
+        case InstructionFormat::ThumbStackOperation:
+            return Extract(Thumb::StackOperation(opcode), opcode);
+        case InstructionFormat::ThumbLoadStoreMultiple:
+            return Extract(Thumb::LoadStoreMultipleInstruction(opcode), opcode);
+        case InstructionFormat::ThumbConditionalBranch:
+            return Extract(Thumb::BranchInstruction(opcode, true), opcode);
+        case InstructionFormat::ThumbUnconditionalBranch:
+            return Extract(Thumb::BranchInstruction(opcode, false), opcode);
+        case InstructionFormat::ThumbLongBranchLink:
+            return Extract(Thumb::LongBranchLinkInstruction(opcode), opcode);
+        case InstructionFormat::ThumbSoftwareInterrupt:
+            return Extract(Thumb::SoftwareInterruptInstruction(opcode), opcode);
+        default:
+            break;
+    }
 
-    return shared_ptr<Instruction>(nullptr);
+    return Unknown(opcode);
 }
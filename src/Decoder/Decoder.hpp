@@ -1,9 +1,8 @@
 #ifndef DECODER_HPP
 #define DECODER_HPP
 
-#include "Common/Instructions/Instruction.hpp"
+#include "Common/Instructions/DecodedInstruction.hpp"
 
-#include <memory>
 #include <cstdint>
 
 class Decoder final
@@ -11,8 +10,13 @@ class Decoder final
 public:
     Decoder();
 
-    std::shared_ptr<Instruction> DecodeARM(uint32_t opcode);
-    std::shared_ptr<Instruction> DecodeThumb(uint16_t opcode);
+    // Both return an instruction with Format == InstructionFormat::Unknown if the opcode is not recognized
+    DecodedInstruction DecodeARM(uint32_t opcode);
+    DecodedInstruction DecodeThumb(uint16_t opcode);
+
+    // Only looks the format up in the decoding tables, without extracting any operands
+    static InstructionFormat ClassifyARM(uint32_t opcode);
+    static InstructionFormat ClassifyThumb(uint16_t opcode);
 };
 
-#endif
\ No newline at end of file
+#endif
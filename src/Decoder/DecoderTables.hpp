@@ -0,0 +1,135 @@
+#ifndef DECODER_TABLES_HPP
+#define DECODER_TABLES_HPP
+
+#include "Common/Instructions/DecodedInstruction.hpp"
+#include "Common/Utilities.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Lookup tables that classify an opcode with a single indexed load.
+// They are generated at compile time from the same rules the decoder used to test one after the other.
+namespace DecoderTables
+{
+    enum ARMTableData
+    {
+        ARM_TABLE_SIZE = 4096, // Indexed by bits 27-20 and 7-4 of the opcode
+        THUMB_TABLE_SIZE = 1024 // Indexed by bits 15-6 of the opcode
+    };
+
+    // A few ARM encodings also depend on bits that are not part of the index,
+    // these entries tell the decoder which extra bits to test before choosing between Format and Fallback.
+    enum class ARMCheck : uint8_t
+    {
+        None,
+        BranchExchange,         // Bits 8-19 must be 0xFFF
+        BranchExchangeOrMSR,    // BX/BLX as above, otherwise MSR (register) if bits 8-15 are 0xF0
+        MovePSRToRegister,      // Bits 16-19 must be 0xF, bits 8-11 and 0-3 must be 0
+        MoveRegisterToPSR,      // Bits 12-15 must be 0xF, and bits 8-11 must be 0 for the register form
+        MoveImmediateToPSR,     // Bits 12-15 must be 0xF
+        Unconditional           // The condition must be 0b1111
+    };
+
+    struct ARMEntry
+    {
+        InstructionFormat Format;
+        InstructionFormat Fallback;
+        ARMCheck Check;
+    };
+
+    inline constexpr uint32_t ARMIndex(uint32_t opcode)
+    {
+        return ((opcode >> 16) & 0xFF0) | ((opcode >> 4) & 0xF);
+    }
+
+    inline constexpr uint32_t ThumbIndex(uint16_t opcode)
+    {
+        return opcode >> 6;
+    }
+
+    // In the ARM classifiers, high holds bits 27-20 of the opcode and low holds bits 7-4
+
+    // The format of an ARM opcode when none of the checks on the bits outside of the index pass
+    inline constexpr InstructionFormat ClassifyARMFallback(uint32_t high, uint32_t low)
+    {
+        return (high >> 5) == 0x5 ? InstructionFormat::ARMBranch :
+            // Multiplies share their encoding space with the miscellaneous load/stores, so they must be checked first
+            ((high >> 4) == 0 && low == 0x9) ? InstructionFormat::ARMMultiplyAccumulate :
+            // The S and H bits can't both be 0, that encoding is used by SWP / SWPB (NYI)
+            ((high >> 5) == 0 && (low & 0x9) == 0x9) ? ((low & 0x6) == 0 ? InstructionFormat::Unknown : InstructionFormat::ARMMiscellaneousLoadStore) :
+            (high >> 6) == 0 ? InstructionFormat::ARMDataProcessing :
+            (high >> 6) == 1 ? InstructionFormat::ARMLoadStore :
+            (high >> 5) == 0x4 ? InstructionFormat::ARMLoadStore : // LDM/STM
+            (high >> 4) == 0xF ? InstructionFormat::ARMSoftwareInterrupt :
+            InstructionFormat::Unknown;
+    }
+
+    inline constexpr ARMCheck ClassifyARMCheck(uint32_t high, uint32_t low)
+    {
+        return high == 0x12 ? (low == 0 ? ARMCheck::BranchExchangeOrMSR : ARMCheck::BranchExchange) :
+            (high >> 5) == 0x5 ? ARMCheck::Unconditional :
+            ((high == 0x10 || high == 0x14) && low == 0) ? ARMCheck::MovePSRToRegister :
+            (high == 0x16 && low == 0) ? ARMCheck::MoveRegisterToPSR :
+            (high == 0x32 || high == 0x36) ? ARMCheck::MoveImmediateToPSR :
+            ARMCheck::None;
+    }
+
+    inline constexpr InstructionFormat ClassifyARMCandidate(ARMCheck check, uint32_t high, uint32_t low)
+    {
+        return check == ARMCheck::BranchExchange || check == ARMCheck::BranchExchangeOrMSR ? InstructionFormat::ARMBranchLinkExchangeRegister :
+            check == ARMCheck::Unconditional ? InstructionFormat::ARMBranchLinkExchangeImmediate :
+            check == ARMCheck::MovePSRToRegister ? InstructionFormat::ARMMovePSRToRegister :
+            check == ARMCheck::MoveRegisterToPSR ? InstructionFormat::ARMMoveRegisterToPSRRegister :
+            check == ARMCheck::MoveImmediateToPSR ? InstructionFormat::ARMMoveRegisterToPSRImmediate :
+            ClassifyARMFallback(high, low);
+    }
+
+    inline constexpr ARMEntry ClassifyARM(uint32_t index)
+    {
+        return ARMEntry
+        {
+            ClassifyARMCandidate(ClassifyARMCheck(index >> 4, index & 0xF), index >> 4, index & 0xF),
+            ClassifyARMFallback(index >> 4, index & 0xF),
+            ClassifyARMCheck(index >> 4, index & 0xF)
+        };
+    }
+
+    // Index holds bits 15-6 of the opcode
+    inline constexpr InstructionFormat ClassifyThumb(uint32_t index)
+    {
+        return (index >> 7) == 0 ? ((index >> 5) <= 2 ? InstructionFormat::ThumbImmediateShift : InstructionFormat::ThumbAddSub) : // LSL, LSR, ASR, ADD SUB REG
+            (index >> 7) == 1 ? InstructionFormat::ThumbAddSubCmpMovImmediate :
+            (index >> 4) == 16 ? InstructionFormat::ThumbDataProcessing :
+            (index >> 4) == 17 ? (((index >> 2) & 3) == 3 ? InstructionFormat::ThumbBranchExchange : InstructionFormat::ThumbSpecialDataProcessing) :
+            (index >> 5) == 9 ? InstructionFormat::ThumbLoadFromLiteralPool :
+            (index >> 6) == 5 ? InstructionFormat::ThumbLoadStoreRegisterOffset :
+            ((index >> 7) == 3 || (index >> 6) == 8) ? InstructionFormat::ThumbLoadStoreImmediate :
+            (index >> 6) == 9 ? InstructionFormat::ThumbLoadStoreStack :
+            // Adjusting the stack pointer is NYI
+            (index >> 6) == 11 ? ((((index >> 2) & 0xF) != 0 && ((index >> 3) & 3) == 2) ? InstructionFormat::ThumbStackOperation : InstructionFormat::Unknown) :
+            (index >> 6) == 12 ? InstructionFormat::ThumbLoadStoreMultiple :
+            // The condition 14 is undefined, 15 is a software interrupt
+            (index >> 6) == 13 ? (((index >> 2) & 0xF) == 15 ? InstructionFormat::ThumbSoftwareInterrupt :
+                ((index >> 2) & 0xF) == 14 ? InstructionFormat::Unknown : InstructionFormat::ThumbConditionalBranch) :
+            (index >> 5) == 28 ? InstructionFormat::ThumbUnconditionalBranch :
+            (index >> 5) >= 30 ? InstructionFormat::ThumbLongBranchLink : // BL prefix and suffix
+            InstructionFormat::Unknown;
+    }
+
+    template <std::size_t... Indices>
+    inline constexpr std::array<ARMEntry, ARM_TABLE_SIZE> MakeARMTable(Utilities::IndexSequence<Indices...>)
+    {
+        return std::array<ARMEntry, ARM_TABLE_SIZE> {{ ClassifyARM(Indices)... }};
+    }
+
+    template <std::size_t... Indices>
+    inline constexpr std::array<InstructionFormat, THUMB_TABLE_SIZE> MakeThumbTable(Utilities::IndexSequence<Indices...>)
+    {
+        return std::array<InstructionFormat, THUMB_TABLE_SIZE> {{ ClassifyThumb(Indices)... }};
+    }
+
+    constexpr std::array<ARMEntry, ARM_TABLE_SIZE> ARMTable = MakeARMTable(Utilities::MakeIndexSequence<ARM_TABLE_SIZE>::Type());
+    constexpr std::array<InstructionFormat, THUMB_TABLE_SIZE> ThumbTable = MakeThumbTable(Utilities::MakeIndexSequence<THUMB_TABLE_SIZE>::Type());
+}
+
+#endif
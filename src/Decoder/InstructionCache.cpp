@@ -0,0 +1,139 @@
+#include "InstructionCache.hpp"
+#include "Decoder.hpp"
+#include "CPU/CPU.hpp"
+#include "Memory/Memory.hpp"
+
+#include <algorithm>
+
+InstructionCache::InstructionCache(CPU* cpu) : _cpu(cpu)
+{
+}
+
+bool InstructionCache::IsCacheable(uint32_t address)
+{
+    switch ((address & 0x0F000000) >> 24)
+    {
+        case 0x2: // On-Board WRAM
+        case 0x3: // On-Chip WRAM
+        case 0x8: // Game Pak, State 0
+        case 0x9:
+        case 0xA: // Game Pak, State 1
+        case 0xB:
+        case 0xC: // Game Pak, State 2
+        case 0xD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+InstructionCache::Page* InstructionCache::GetPage(uint32_t address, bool create)
+{
+    std::vector<std::unique_ptr<Page>>& region = _regions[(address & 0x0F000000) >> 24];
+
+    if (region.empty())
+    {
+        if (!create)
+            return nullptr;
+
+        region.resize(PAGES_PER_REGION);
+    }
+
+    std::unique_ptr<Page>& page = region[(address & 0x00FFFFFF) >> PAGE_SHIFT];
+
+    if (!page && create)
+        page = std::unique_ptr<Page>(new Page());
+
+    return page.get();
+}
+
+DecodedInstruction InstructionCache::Fetch(InstructionSet set, uint32_t address)
+{
+    if (!IsCacheable(address))
+    {
+        // Code running from the BIOS or other regions is decoded every time
+        if (set == InstructionSet::ARM)
+            return _cpu->GetDecoder()->DecodeARM(_cpu->GetMemory()->ReadUInt32(address));
+
+        return _cpu->GetDecoder()->DecodeThumb(_cpu->GetMemory()->ReadUInt16(address));
+    }
+
+    // The mirrors of the work RAMs share their decoded instructions
+    Page* page = GetPage(MMU::GetCanonicalAddress(address), true);
+    uint32_t offset = address & (PAGE_SIZE - 1);
+
+    DecodedInstruction& entry = set == InstructionSet::ARM ? page->ARM[offset >> 2] : page->Thumb[offset >> 1];
+
+    if (entry.IsValid())
+    {
+        ++_statistics.Hits;
+        return entry;
+    }
+
+    ++_statistics.Misses;
+
+    if (set == InstructionSet::ARM)
+        entry = _cpu->GetDecoder()->DecodeARM(_cpu->GetMemory()->ReadUInt32(address));
+    else
+        entry = _cpu->GetDecoder()->DecodeThumb(_cpu->GetMemory()->ReadUInt16(address));
+
+    return entry;
+}
+
+void InstructionCache::Invalidate(uint32_t address)
+{
+    address = MMU::GetCanonicalAddress(address);
+    Page* page = GetPage(address, false);
+
+    if (!page)
+        return;
+
+    uint32_t offset = address & (PAGE_SIZE - 1);
+
+    // A write to any byte of an instruction makes its decoded form stale, in both instruction sets
+    DecodedInstruction& arm = page->ARM[offset >> 2];
+    DecodedInstruction& thumb = page->Thumb[offset >> 1];
+
+    if (arm.IsValid() || thumb.IsValid())
+    {
+        ++_statistics.Invalidations;
+
+        // The basic blocks are built from the cached instructions, so only writes to cached code can make them stale
+        _cpu->GetBlockCache()->Invalidate(address);
+
+        if (_cpu->GetJIT())
+            _cpu->GetJIT()->Invalidate(address);
+    }
+
+    arm.Format = InstructionFormat::Unknown;
+    thumb.Format = InstructionFormat::Unknown;
+}
+
+void InstructionCache::Invalidate(uint32_t address, uint32_t size)
+{
+    address = MMU::GetCanonicalAddress(address);
+    uint32_t end = address + size;
+
+    // Only the pages that hold decoded instructions have anything to invalidate
+    for (uint32_t current = address & ~1; current < end; current = (current | (PAGE_SIZE - 1)) + 1)
+    {
+        if (!GetPage(current, false))
+            continue;
+
+        uint32_t pageEnd = std::min(end, (current | (PAGE_SIZE - 1)) + 1);
+
+        for (uint32_t halfword = current; halfword < pageEnd; halfword += 2)
+            Invalidate(halfword);
+    }
+}
+
+void InstructionCache::Flush()
+{
+    for (auto& region : _regions)
+        region.clear();
+
+    _cpu->GetBlockCache()->Flush();
+
+    if (_cpu->GetJIT())
+        _cpu->GetJIT()->Flush();
+}
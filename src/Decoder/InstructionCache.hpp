@@ -0,0 +1,65 @@
+#ifndef INSTRUCTION_CACHE_HPP
+#define INSTRUCTION_CACHE_HPP
+
+#include "Common/Instructions/DecodedInstruction.hpp"
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class CPU;
+
+struct InstructionCacheStatistics
+{
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t Invalidations = 0;
+};
+
+// Keeps the decoded form of every instruction fetched from the Game Pak ROM, IWRAM and EWRAM,
+// indexed by its address and instruction set, so that code that runs in a loop is only decoded once.
+// The MMU must call Invalidate for every write to these regions so that self-modifying code keeps working,
+// the BlockCache of the cached interpreter is invalidated from here as well.
+class InstructionCache final
+{
+public:
+    InstructionCache(CPU* cpu);
+
+    // Returns the instruction at the specified address, reading and decoding it only if it is not cached yet
+    DecodedInstruction Fetch(InstructionSet set, uint32_t address);
+
+    void Invalidate(uint32_t address);
+    // Invalidates every halfword of the range, for bulk writes
+    void Invalidate(uint32_t address, uint32_t size);
+    void Flush();
+
+    static bool IsCacheable(uint32_t address);
+
+    InstructionCacheStatistics const& GetStatistics() const { return _statistics; }
+
+private:
+    enum CacheData
+    {
+        PAGE_SHIFT = 12,
+        PAGE_SIZE = 1 << PAGE_SHIFT, // 4 KBytes
+        PAGES_PER_REGION = 0x1000000 >> PAGE_SHIFT,
+        NUM_REGIONS = 0x10
+    };
+
+    // Every page holds the ARM and Thumb views of the same 4 KBytes of memory, empty slots have an Unknown format
+    struct Page
+    {
+        std::array<DecodedInstruction, PAGE_SIZE / 4> ARM;
+        std::array<DecodedInstruction, PAGE_SIZE / 2> Thumb;
+    };
+
+    Page* GetPage(uint32_t address, bool create);
+
+    CPU* _cpu;
+    // The pages are grouped by memory region (bits 24-27 of the address), a region's table is only allocated once code runs from it
+    std::array<std::vector<std::unique_ptr<Page>>, NUM_REGIONS> _regions;
+    InstructionCacheStatistics _statistics;
+};
+
+#endif
@@ -6,6 +6,23 @@
 // http://www.cs.rit.edu/~tjh8300/CowBite/CowBiteSpec.htm
 // http://problemkaputt.de/gbatek.htm
 
+GPU::GPU(CPU* cpu) : _cpu(cpu), _adapter(nullptr)
+{
+    std::unique_ptr<MemoryArena>& arena = _cpu->GetMemoryArena();
+
+    _vram = arena->Get(MemoryRegion::VRAM);
+    _oam = arena->Get(MemoryRegion::OAM);
+    _obj = arena->Get(MemoryRegion::Palette);
+    _io = arena->Get(MemoryRegion::IO);
+
+    // Each line is drawn, then followed by its HBlank
+    std::unique_ptr<Scheduler>& scheduler = _cpu->GetScheduler();
+
+    scheduler->RegisterHandler(EventType::HBlank, [this](uint64_t time) { StartHBlank(time); });
+    scheduler->RegisterHandler(EventType::HBlankEnd, [this](uint64_t time) { EndHBlank(time); });
+    scheduler->Schedule(EventType::HBlank, _cpu->GetCycles() + HDRAW_LENGTH);
+}
+
 void GPU::ExtractColorValues(uint16_t input, uint8_t& red, uint8_t& green, uint8_t& blue)
 {
     // F E D C  B A 9 8  7 6 5 4  3 2 1 0
@@ -15,78 +32,32 @@ void GPU::ExtractColorValues(uint16_t input, uint8_t& red, uint8_t& green, uint8
     red = input & 0x1F;
 }
 
-bool GPU::ReadBit(uint32_t offset, uint8_t bitIndex)
+uint8_t GPU::ReadRegister8(uint32_t address)
 {
-    uint8_t rebasedOffset = bitIndex / 8;
-    return ReadUInt8(offset + rebasedOffset) & (1 << (bitIndex % 8));
+    return _io[address & (IO_SIZE - 1)];
 }
 
-uint8_t GPU::ReadUInt8(uint32_t offset)
+uint16_t GPU::ReadRegister16(uint32_t address)
 {
-    switch (offset >> 24)
-    {
-        case 0x05: // BG/OBJ Palette RAM
-            // This is mirrored every 0x400 bytes.
-            return _obj[(offset & 0xFFF) % 0x400];
-        case 0x06: // VRAM
-            // Bytes 0x06010000 - 0x06017FFF is mirrored from 0x06018000 - 0x0601FFFF.
-            // The entire region from 0x06000000 - 0x06020000 is in turn mirrored every
-            // 0x20000 bytes from 0x06000000 - 0x06FFFFFF.
-            //! TODO: Doublecheck this, this may crash if reading after 0x06018000.
-            return _vram[(offset & 0xFFFFF) % 0x20000];
-        case 0x07: // OAM
-            // This is mirrored every 0x400 bytes.
-            return _oam[(offset & 0xFFF) % 0x400];
-        default:
-            return _cpu->GetMemory()->ReadUInt8(offset);
-    }
+    uint16_t value;
+    memcpy(&value, &_io[address & (IO_SIZE - 2)], sizeof(value));
+    return value;
 }
 
-uint16_t GPU::ReadUInt16(uint32_t offset)
-{
-    return (ReadUInt8(offset) << 8) | ReadUInt8(offset + 1);
-}
-
-uint32_t GPU::ReadUInt32(uint32_t offset)
-{
-    return (ReadUInt16(offset) << 16) | ReadUInt16(offset + 2);
-}
-
-void GPU::WriteUInt8(uint32_t offset, uint8_t value)
+bool GPU::ReadBit(uint32_t offset, uint8_t bitIndex)
 {
-    switch (offset >> 24)
-    {
-        case 0x05: // BG/OBJ Palette RAM
-            // This is mirrored every 0x400 bytes.
-            _obj[(offset & 0xFFF) % 0x400] = value;
-            break;
-        case 0x06: // VRAM
-            // Bytes 0x06010000 - 0x06017FFF is mirrored from 0x06018000 - 0x0601FFFF.
-            // The entire region from 0x06000000 - 0x06020000 is in turn mirrored every
-            // 0x20000 bytes from 0x06000000 - 0x06FFFFFF.
-            //! TODO: Doublecheck this, this may crash if reading after 0x06018000.
-            _vram[(offset & 0xFFFFF) % 0x20000] = value;
-            break;
-        case 0x07: // OAM
-            // This is mirrored every 0x400 bytes.
-            _oam[(offset & 0xFFF) % 0x400] = value;
-            break;
-        default:
-            _cpu->GetMemory()->WriteUInt8(offset, value);
-            break;
-    }
+    uint8_t rebasedOffset = bitIndex / 8;
+    return ReadRegister8(offset + rebasedOffset) & (1 << (bitIndex % 8));
 }
 
-void GPU::WriteUInt32(uint32_t offset, uint32_t value)
+void GPU::WriteRegister8(uint32_t address, uint8_t value)
 {
-    WriteUInt16(offset, (value >> 16) & 0xFFFF);
-    WriteUInt16(offset + 2, value & 0xFFFF);
+    _io[address & (IO_SIZE - 1)] = value;
 }
 
-void GPU::WriteUInt16(uint32_t offset, uint16_t value)
+void GPU::WriteRegister16(uint32_t address, uint16_t value)
 {
-    WriteUInt8(offset, (value >> 8) & 0xFF);
-    WriteUInt8(offset + 1, value & 0xFF);
+    memcpy(&_io[address & (IO_SIZE - 2)], &value, sizeof(value));
 }
 
 /*
@@ -94,18 +65,16 @@ void GPU::WriteUInt16(uint32_t offset, uint16_t value)
  */
 void GPU::WriteBit(uint32_t offset, uint8_t bitIndex, bool isSet)
 {
-    /*uint8_t rebasedOffset = bitIndex / 8;
+    uint8_t rebasedOffset = bitIndex / 8;
     uint8_t bitValue = (1 << (bitIndex % 8));
 
     if (isSet)
-        _ioram[offset % 0x400 + rebasedOffset] |= bitValue;
+        _io[(offset + rebasedOffset) & (IO_SIZE - 1)] |= bitValue;
     else
-        _ioram[offset % 0x400 + rebasedOffset] &= ~bitValue;*/
+        _io[(offset + rebasedOffset) & (IO_SIZE - 1)] &= ~bitValue;
 }
 
 // GPU logic
-void GPU::Step(uint32_t cycles)
-{
 /*
  * The LCD has a refresh rate of about 59.73 hz, with each refresh consisting
  * of a vertical draw period (when the GBA is drawing the screen) followed
@@ -119,85 +88,94 @@ void GPU::Step(uint32_t cycles)
  * next frame. Waiting for this register to reach 160 is one way to synchronize
  * a program to 60Hz.
  */
-    if (_nextEvent <= cycles)
+void GPU::StartHBlank(uint64_t time)
+{
+    // Set HBlank
+    WriteBit(DISPSTAT, 1, true);
+    // Trigger the interrupt if it's enabled in the DISPSTAT
+    if (ReadBit(DISPSTAT, 4))
+        _cpu->RequestInterrupt(InterruptTypes::HBlank);
+
+    // HBlank DMA transfers only happen on the visible lines
+    if (GetCurrentLine() < VERTICAL_PIXELS)
+        _cpu->GetDMA()->ProcessInterrupt(InterruptTypes::HBlank);
+
+    _cpu->GetScheduler()->Schedule(EventType::HBlankEnd, time + HBLANK_LENGTH);
+}
+
+void GPU::EndHBlank(uint64_t time)
+{
+    // End the HBlank
+    WriteBit(DISPSTAT, 1, false);
+    _cpu->GetScheduler()->Schedule(EventType::HBlank, time + HDRAW_LENGTH);
+    
+    uint8_t line = GetCurrentLine() + 1;
+    WriteRegister8(VCOUNT, line);
+
+    switch (line)
     {
-        if (InHBlank())
-        {
-            // End the HBlank
-            WriteBit(DISPSTAT, 1, false);
-            _nextEvent = _nextHBlank;
-            
-            uint8_t line = GetCurrentLine() + 1;
-            WriteUInt8(VCOUNT, line);
-
-            switch (line)
-            {
-                case VERTICAL_PIXELS:
-                    // Start the VBlank
-                    WriteBit(DISPSTAT, 0, true);
-                    // Request the interrupt if it's enabled in DISPSTAT
-                    if (ReadBit(DISPSTAT, 3))
-                        _cpu->RequestInterrupt(InterruptTypes::VBlank);
-
-                    _adapter->EndFrame();
-                    break;
-                case VERTICAL_TOTAL_PIXELS - 1:
-                    // End the VBlank
-                    WriteBit(DISPSTAT, 0, false);
-                    break;
-                case VERTICAL_TOTAL_PIXELS:
-                    // Reset the VCOUNT and start again
-                    WriteUInt8(VCOUNT, 0);
-                    break;
-            }
-
-            if (line == ReadUInt8(DISPSTAT + 1))
-            {
-                // Checking bits 8-15 of u16 DISPSTAT against VCOUNT
-                // If they are equal, V-COUNTER (#2) of DISPSTAT is set, and
-                // if #5 is set, an IRQ is requested.
-                WriteBit(DISPSTAT, 2, true);
-                if (ReadBit(DISPSTAT, 5))
-                    _cpu->RequestInterrupt(InterruptTypes::VCounterMatch);
-            }
-
-            if (line < VERTICAL_PIXELS)
-                DrawHorizontal(line);
-        }
-        else
-        {
-            // Set HBlank
-            WriteBit(DISPSTAT, 1, true);
-            // Trigger the interrupt if it's enabled in the DISPSTAT
-            if (ReadBit(DISPSTAT, 4))
-                _cpu->RequestInterrupt(InterruptTypes::HBlank);
-
-            _lastHBlank = _nextHBlank;
-            _nextEvent = _lastHBlank + HBLANK_LENGTH;
-            _nextHBlank = _nextEvent + HDRAW_LENGTH;
-        }
+        case VERTICAL_PIXELS:
+            // Start the VBlank
+            WriteBit(DISPSTAT, 0, true);
+            // Request the interrupt if it's enabled in DISPSTAT
+            if (ReadBit(DISPSTAT, 3))
+                _cpu->RequestInterrupt(InterruptTypes::VBlank);
+
+            _cpu->GetDMA()->ProcessInterrupt(InterruptTypes::VBlank);
+
+            if (_adapter)
+                _adapter->EndFrame();
+            break;
+        case VERTICAL_TOTAL_PIXELS - 1:
+            // End the VBlank
+            WriteBit(DISPSTAT, 0, false);
+            break;
+        case VERTICAL_TOTAL_PIXELS:
+            // Reset the VCOUNT and start again
+            line = 0;
+            WriteRegister8(VCOUNT, line);
+            break;
     }
+
+    if (line == ReadRegister8(DISPSTAT + 1))
+    {
+        // Checking bits 8-15 of u16 DISPSTAT against VCOUNT
+        // If they are equal, V-COUNTER (#2) of DISPSTAT is set, and
+        // if #5 is set, an IRQ is requested.
+        WriteBit(DISPSTAT, 2, true);
+        if (ReadBit(DISPSTAT, 5))
+            _cpu->RequestInterrupt(InterruptTypes::VCounterMatch);
+    }
+    else
+        WriteBit(DISPSTAT, 2, false);
+
+    if (line < VERTICAL_PIXELS)
+        DrawHorizontal(line);
 }
 
 VideoMode GPU::GetVideoMode()
 {
     // Bits 0-2 of DISPCNT tell us what video mode to use
-    return VideoMode(MathHelper::GetBits(_cpu->GetMemory()->ReadUInt16(DISPCNT), 0, 3));
+    return VideoMode(MathHelper::GetBits(ReadRegister16(DISPCNT), 0, 3));
 }
 
 bool GPU::IsBackgroundActive(uint8_t bg)
 {
     // Bits 8-11 of DISPCNT tell us what Backgrounds are displayed
-    return MathHelper::CheckBit(_cpu->GetMemory()->ReadUInt16(DISPCNT), std::min(11, 8 + bg));
+    return MathHelper::CheckBit(ReadRegister16(DISPCNT), std::min(11, 8 + bg));
 }
 
 void GPU::DrawHorizontal(uint8_t currentLine)
 {
+    // Nothing to draw on when running headless
+    if (!_adapter)
+        return;
+
     // Video Mode 3 uses raw pixel data, so just copy it over from VRAM to the output screen array
     if (GetVideoMode() == VideoMode::MODE_3)
     {
-        // Copy the corresponding line
-        memcpy(&_adapter->GetDataArray()[currentLine * 240], &_vram[currentLine * 240], sizeof(uint16_t) * 160);
+        // Copy the corresponding line, VRAM holds the pixels in the same 16 bit little endian format
+        memcpy(&_adapter->GetDataArray()[currentLine * HORIZONTAL_PIXELS], &_vram[currentLine * HORIZONTAL_PIXELS * sizeof(uint16_t)], sizeof(uint16_t) * HORIZONTAL_PIXELS);
     }   
     
     _adapter->DrawHorizontal(currentLine);
@@ -215,5 +193,5 @@ bool GPU::InVBlank()
 
 uint8_t GPU::GetCurrentLine()
 {
-    return ReadUInt8(VCOUNT);
+    return ReadRegister8(VCOUNT);
 }
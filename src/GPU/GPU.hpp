@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "LCD.hpp"
+#include "Memory/MemoryArena.hpp"
 #include "Common/Utilities.hpp"
 
 class CPU;
@@ -49,29 +50,21 @@ enum VideoData
 class GPU final
 {
     public:
-        GPU(CPU* cpu) : _cpu(cpu), _adapter(nullptr), _nextEvent(HDRAW_LENGTH), _lastHBlank(0), _nextHBlank(HDRAW_LENGTH)
-        {
-            memset(_vram, 0, sizeof(_vram) / sizeof(uint8_t));
-            memset(_oam, 0, sizeof(_oam) / sizeof(uint8_t));
-            memset(_obj, 0, sizeof(_obj) / sizeof(uint8_t));
-        }
+        GPU(CPU* cpu);
 
         /*
-         * @description Main loop logic
+         * @description Main loop logic, run by the scheduler at the start and the end of each HBlank
          */
-        void Step(uint32_t cycles);
+        void StartHBlank(uint64_t time);
+        void EndHBlank(uint64_t time);
         
-        int32_t ReadInt32(uint32_t offset) { return int32_t(ReadUInt32(offset)); }
-        uint32_t ReadUInt32(uint32_t offset);
-        int16_t ReadInt16(uint32_t offset) { return int16_t(ReadUInt16(offset)); }
-        uint16_t ReadUInt16(uint32_t offset);
-        int8_t ReadInt8(uint32_t offset) { return int8_t(ReadUInt8(offset)); }
-        uint8_t ReadUInt8(uint32_t offset);
+        // The LCD registers, read and written straight in the I/O memory without going through the bus
+        uint8_t ReadRegister8(uint32_t address);
+        uint16_t ReadRegister16(uint32_t address);
         bool ReadBit(uint32_t offset, uint8_t bitIndex);
 
-        void WriteUInt8(uint32_t offset, uint8_t value);
-        void WriteUInt16(uint32_t offset, uint16_t value);
-        void WriteUInt32(uint32_t offset, uint32_t value);
+        void WriteRegister8(uint32_t address, uint8_t value);
+        void WriteRegister16(uint32_t address, uint16_t value);
         void WriteBit(uint32_t offset, uint8_t bitIndex, bool isSet);
         
         /**
@@ -81,6 +74,12 @@ class GPU final
 
         void SetLCDAdapter(std::shared_ptr<LCDAdapter> adapter) { _adapter = adapter; }
 
+        // The video memory, owned by the memory arena of the CPU. The page table of the MMU points at the same bytes,
+        // so the bus and the renderer both access it in place. The sizes are VRAM_SIZE, OAM_SIZE and PALETTE_SIZE.
+        uint8_t* GetVRAM() { return _vram; }
+        uint8_t* GetOAM() { return _oam; }
+        uint8_t* GetPaletteRAM() { return _obj; }
+
         bool InHBlank();
         bool InVBlank();
         uint8_t GetCurrentLine();
@@ -91,13 +90,11 @@ class GPU final
         void DrawHorizontal(uint8_t line);
 
     private:
-        uint32_t _nextEvent;
-        uint32_t _lastHBlank;
-        uint32_t _nextHBlank;
         CPU* _cpu;
-        uint8_t _vram[0x18000]; // VRAM (96KB)
-        uint8_t _oam[0x400];    // OAM (1KB)
-        uint8_t _obj[0x400];    // BG/OBJ Palette (1KB)
+        uint8_t* _vram; // VRAM (96KB)
+        uint8_t* _oam;  // OAM (1KB)
+        uint8_t* _obj;  // BG/OBJ Palette (1KB)
+        uint8_t* _io;   // Memory mapped registers, the LCD ones are at the start
         std::shared_ptr<LCDAdapter> _adapter;
 };
 
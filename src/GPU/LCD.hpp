@@ -8,7 +8,7 @@ class LCDAdapter
 public:
     virtual ~LCDAdapter() { }
 
-    uint8_t* GetDataArray() { return pixelData; }
+    uint16_t* GetDataArray() { return pixelData; }
     virtual void DrawHorizontal(uint8_t line) = 0;
     virtual void EndFrame() = 0;
 
@@ -0,0 +1,661 @@
+#include "HLEBIOS.hpp"
+#include "CPU/CPU.hpp"
+#include "Common/MathHelper.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// http://problemkaputt.de/gbatek.htm#biosfunctions
+
+namespace
+{
+    // The exception vectors of the BIOS, only the IRQ handler does anything
+    uint32_t const Vectors[] =
+    {
+        0xEAFFFFFE, // Reset: B .
+        0xE1B0F00E, // Undefined: MOVS pc, lr
+        0xE1B0F00E, // SWI: MOVS pc, lr, the calls that aren't emulated return right away
+        0xE25EF004, // Prefetch abort: SUBS pc, lr, #4
+        0xE25EF008, // Data abort: SUBS pc, lr, #8
+        0xEAFFFFFE, // Reserved: B .
+        0xEA000042, // IRQ: B 0x128
+        0xE25EF004  // FIQ: SUBS pc, lr, #4
+    };
+
+    // The IRQ handler of the BIOS, calls the one of the game at 03007FFC
+    uint32_t const InterruptHandler[] =
+    {
+        0xE92D500F, // STMFD sp!, {r0-r3, r12, lr}
+        0xE3A00301, // MOV r0, #0x04000000
+        0xE28FE000, // ADD lr, pc, #0
+        0xE510F004, // LDR pc, [r0, #-4]
+        0xE8BD500F, // LDMFD sp!, {r0-r3, r12, lr}
+        0xE25EF004  // SUBS pc, lr, #4
+    };
+
+    enum BIOSLayout
+    {
+        INTERRUPT_HANDLER_ADDRESS = 0x128,
+        SUPERVISOR_STACK = 0x03007FE0,
+        INTERRUPT_STACK = 0x03007FA0,
+        SYSTEM_STACK = 0x03007F00
+    };
+
+    enum CompressionType
+    {
+        LZ77 = 1,
+        Huffman = 2,
+        RunLength = 3
+    };
+
+    enum CompressionLimits
+    {
+        MAX_HUFFMAN_TREE_SIZE = 0x1FF,
+        SOURCE_CHUNK_SIZE = 0x400
+    };
+
+    // Reads the compressed data a byte at a time. Plain memory is read through a host pointer a chunk at a time,
+    // the rest goes through the bus
+    class SourceReader
+    {
+    public:
+        SourceReader(MMU* memory, uint32_t address) : _memory(memory), _address(address), _chunk(nullptr), _remaining(0)
+        {
+        }
+
+        uint8_t ReadByte()
+        {
+            if (!_remaining && !NextChunk())
+                return _memory->ReadUInt8(_address++);
+
+            --_remaining;
+            ++_address;
+            return *_chunk++;
+        }
+
+        // Reads a little endian word, it doesn't have to be aligned
+        uint32_t ReadWord()
+        {
+            uint32_t value = ReadByte();
+            value |= ReadByte() << 8;
+            value |= ReadByte() << 16;
+            return value | (uint32_t(ReadByte()) << 24);
+        }
+
+        void Read(uint8_t* output, uint32_t size)
+        {
+            while (size)
+            {
+                if (!_remaining && !NextChunk())
+                {
+                    *output++ = _memory->ReadUInt8(_address++);
+                    --size;
+                    continue;
+                }
+
+                uint32_t count = std::min(size, _remaining);
+                memcpy(output, _chunk, count);
+
+                output += count;
+                size -= count;
+                _chunk += count;
+                _remaining -= count;
+                _address += count;
+            }
+        }
+
+    private:
+        bool NextChunk()
+        {
+            uint32_t size = SOURCE_CHUNK_SIZE - (_address & (SOURCE_CHUNK_SIZE - 1));
+            _chunk = _memory->GetReadPointer(_address, size);
+            _remaining = _chunk ? size : 0;
+            return _chunk != nullptr;
+        }
+
+        MMU* _memory;
+        uint32_t _address;
+        uint8_t const* _chunk;
+        uint32_t _remaining;
+    };
+
+    // The 32 bit multiplication of the BIOS code, it wraps around
+    int32_t Multiply(int32_t first, int32_t second)
+    {
+        return int32_t(uint32_t(first) * uint32_t(second));
+    }
+
+    // The polynomial the BIOS approximates the arc tangent of a 1.1.14 value with, the result goes from -0x4000 to 0x4000 for -pi/2 to pi/2
+    int32_t ArcTanPolynomial(int32_t value)
+    {
+        int32_t square = -(Multiply(value, value) >> 14);
+        int32_t result = ((Multiply(0xA9, square) >> 14) + 0x390);
+
+        for (int32_t coefficient : { 0x91C, 0xFB6, 0x16AA, 0x2081, 0x3651, 0xA2F9 })
+            result = (Multiply(result, square) >> 14) + coefficient;
+
+        return Multiply(value, result) >> 16;
+    }
+
+    // The sine table of the BIOS, a full turn in 256 steps as 1.1.14 values rounded towards 0
+    struct SineTable
+    {
+        int16_t Values[256];
+
+        SineTable()
+        {
+            double const pi = std::atan(1.0) * 4;
+
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                // The epsilon keeps the exact values like sin(pi/2) from being rounded down
+                double value = std::sin(i * pi / 128) * 0x4000;
+                Values[i] = int16_t(value < 0 ? std::ceil(value - 1e-6) : std::floor(value + 1e-6));
+            }
+        }
+    };
+
+    int32_t Sine(uint8_t angle)
+    {
+        static SineTable const table;
+        return table.Values[angle];
+    }
+
+    int32_t Cosine(uint8_t angle)
+    {
+        return Sine(uint8_t(angle + 0x40));
+    }
+}
+
+HLEBIOS::HLEBIOS(CPU* cpu) : _cpu(cpu), _enabled(false)
+{
+}
+
+bool HLEBIOS::Call(uint8_t function)
+{
+    // The decompressors leave the formats they don't know to the BIOS
+    bool emulated = true;
+
+    switch (BIOSFunction(function))
+    {
+        case BIOSFunction::Div:
+            Div(false);
+            break;
+        case BIOSFunction::DivArm:
+            Div(true);
+            break;
+        case BIOSFunction::Sqrt:
+            Sqrt();
+            break;
+        case BIOSFunction::ArcTan:
+            ArcTan();
+            break;
+        case BIOSFunction::ArcTan2:
+            ArcTan2();
+            break;
+        case BIOSFunction::CpuSet:
+            CpuSet();
+            break;
+        case BIOSFunction::CpuFastSet:
+            CpuFastSet();
+            break;
+        case BIOSFunction::BgAffineSet:
+            BgAffineSet();
+            break;
+        case BIOSFunction::ObjAffineSet:
+            ObjAffineSet();
+            break;
+        case BIOSFunction::LZ77UnCompWram:
+        case BIOSFunction::LZ77UnCompVram:
+            emulated = LZ77UnComp(BIOSFunction(function) == BIOSFunction::LZ77UnCompVram);
+            break;
+        case BIOSFunction::RLUnCompWram:
+        case BIOSFunction::RLUnCompVram:
+            emulated = RLUnComp(BIOSFunction(function) == BIOSFunction::RLUnCompVram);
+            break;
+        case BIOSFunction::HuffUnComp:
+            emulated = HuffUnComp();
+            break;
+        default:
+            emulated = false;
+            break;
+    }
+
+    if (!emulated)
+    {
+        _statistics.Fallbacks++;
+        return false;
+    }
+
+    _statistics.Calls++;
+    return true;
+}
+
+void HLEBIOS::Boot()
+{
+    uint8_t* bios = _cpu->GetMemoryArena()->Get(MemoryRegion::BIOS);
+
+    memcpy(bios, Vectors, sizeof(Vectors));
+    memcpy(&bios[INTERRUPT_HANDLER_ADDRESS], InterruptHandler, sizeof(InterruptHandler));
+
+    _cpu->GetRegisterForMode(CPUMode::Supervisor, SP) = SUPERVISOR_STACK;
+    _cpu->GetRegisterForMode(CPUMode::IRQ, SP) = INTERRUPT_STACK;
+    _cpu->GetRegisterForMode(CPUMode::System, SP) = SYSTEM_STACK;
+}
+
+void HLEBIOS::Div(bool swapped)
+{
+    // DivArm takes the operands the other way around
+    int32_t numerator = int32_t(_cpu->GetRegister(swapped ? 1 : 0));
+    int32_t denominator = int32_t(_cpu->GetRegister(swapped ? 0 : 1));
+
+    // The BIOS never returns from a division by zero, leave something that makes sense instead
+    if (denominator == 0)
+    {
+        _cpu->GetRegister(0) = uint32_t(numerator < 0 ? -1 : 1);
+        _cpu->GetRegister(1) = uint32_t(numerator);
+        _cpu->GetRegister(3) = 1;
+        return;
+    }
+
+    // 0x80000000 / -1 overflows back to 0x80000000
+    int64_t quotient = int64_t(numerator) / denominator;
+    int64_t remainder = int64_t(numerator) % denominator;
+
+    _cpu->GetRegister(0) = uint32_t(quotient);
+    _cpu->GetRegister(1) = uint32_t(remainder);
+    _cpu->GetRegister(3) = uint32_t(quotient < 0 ? -quotient : quotient);
+}
+
+void HLEBIOS::Sqrt()
+{
+    uint32_t value = _cpu->GetRegister(0);
+    uint32_t root = uint32_t(std::sqrt(double(value)));
+
+    // A double has enough precision for any 32 bit value, this is only a safety net
+    while (uint64_t(root) * root > value)
+        --root;
+
+    while (uint64_t(root + 1) * (root + 1) <= value)
+        ++root;
+
+    _cpu->GetRegister(0) = root;
+}
+
+void HLEBIOS::ArcTan()
+{
+    _cpu->GetRegister(0) = uint32_t(ArcTanPolynomial(int32_t(_cpu->GetRegister(0))));
+}
+
+void HLEBIOS::ArcTan2()
+{
+    int32_t x = int32_t(_cpu->GetRegister(0));
+    int32_t y = int32_t(_cpu->GetRegister(1));
+    int32_t angle;
+
+    // The BIOS reduces the angle to the first octant, a full turn is 0x10000
+    if (y == 0)
+        angle = x >= 0 ? 0 : 0x8000;
+    else if (x == 0)
+        angle = y >= 0 ? 0x4000 : 0xC000;
+    else if (y >= 0)
+    {
+        if (x >= 0 && x >= y)
+            angle = ArcTanPolynomial(Multiply(y, 0x4000) / x);
+        else if (x < 0 && -x >= y)
+            angle = ArcTanPolynomial(Multiply(y, 0x4000) / x) + 0x8000;
+        else
+            angle = 0x4000 - ArcTanPolynomial(Multiply(x, 0x4000) / y);
+    }
+    else
+    {
+        if (x <= 0 && -x > -y)
+            angle = ArcTanPolynomial(Multiply(y, 0x4000) / x) + 0x8000;
+        else if (x > 0 && x >= -y)
+            angle = ArcTanPolynomial(Multiply(y, 0x4000) / x) + 0x10000;
+        else
+            angle = 0xC000 - ArcTanPolynomial(Multiply(x, 0x4000) / y);
+    }
+
+    _cpu->GetRegister(0) = uint32_t(angle) & 0xFFFF;
+}
+
+void HLEBIOS::CpuSet()
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    uint32_t source = _cpu->GetRegister(0);
+    uint32_t destination = _cpu->GetRegister(1);
+    uint32_t control = _cpu->GetRegister(2);
+
+    uint32_t count = control & 0x1FFFFF;
+    bool fill = MathHelper::CheckBit(control, 24);
+
+    if (MathHelper::CheckBit(control, 26))
+    {
+        source &= ~3;
+        destination &= ~3;
+
+        for (uint32_t i = 0; i < count; ++i)
+            memory->WriteUInt32(destination + i * 4, memory->ReadUInt32(fill ? source : source + i * 4));
+    }
+    else
+    {
+        source &= ~1;
+        destination &= ~1;
+
+        for (uint32_t i = 0; i < count; ++i)
+            memory->WriteUInt16(destination + i * 2, memory->ReadUInt16(fill ? source : source + i * 2));
+    }
+}
+
+void HLEBIOS::CpuFastSet()
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    uint32_t source = _cpu->GetRegister(0) & ~3;
+    uint32_t destination = _cpu->GetRegister(1) & ~3;
+    uint32_t control = _cpu->GetRegister(2);
+
+    // Always words, in blocks of 8
+    uint32_t count = ((control & 0x1FFFFF) + 7) & ~7;
+    bool fill = MathHelper::CheckBit(control, 24);
+
+    for (uint32_t i = 0; i < count; ++i)
+        memory->WriteUInt32(destination + i * 4, memory->ReadUInt32(fill ? source : source + i * 4));
+}
+
+void HLEBIOS::BgAffineSet()
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    uint32_t source = _cpu->GetRegister(0);
+    uint32_t destination = _cpu->GetRegister(1);
+    uint32_t count = _cpu->GetRegister(2);
+
+    for (uint32_t i = 0; i < count; ++i, source += 20, destination += 16)
+    {
+        // The origin in the background is 24.8 fixed point, the scales 8.8 and the angle is in the upper byte
+        int32_t originX = int32_t(memory->ReadUInt32(source));
+        int32_t originY = int32_t(memory->ReadUInt32(source + 4));
+        int32_t displayX = int16_t(memory->ReadUInt16(source + 8));
+        int32_t displayY = int16_t(memory->ReadUInt16(source + 10));
+        int32_t scaleX = int16_t(memory->ReadUInt16(source + 12));
+        int32_t scaleY = int16_t(memory->ReadUInt16(source + 14));
+        uint8_t angle = uint8_t(memory->ReadUInt16(source + 16) >> 8);
+
+        int32_t pa = (scaleX * Cosine(angle)) >> 14;
+        int32_t pb = -((scaleX * Sine(angle)) >> 14);
+        int32_t pc = (scaleY * Sine(angle)) >> 14;
+        int32_t pd = (scaleY * Cosine(angle)) >> 14;
+
+        memory->WriteUInt16(destination, uint16_t(pa));
+        memory->WriteUInt16(destination + 2, uint16_t(pb));
+        memory->WriteUInt16(destination + 4, uint16_t(pc));
+        memory->WriteUInt16(destination + 6, uint16_t(pd));
+
+        // The display center maps to the origin
+        memory->WriteUInt32(destination + 8, uint32_t(originX - pa * displayX - pb * displayY));
+        memory->WriteUInt32(destination + 12, uint32_t(originY - pc * displayX - pd * displayY));
+    }
+}
+
+void HLEBIOS::ObjAffineSet()
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    uint32_t source = _cpu->GetRegister(0);
+    uint32_t destination = _cpu->GetRegister(1);
+    uint32_t count = _cpu->GetRegister(2);
+    uint32_t stride = _cpu->GetRegister(3); // 2 for a plain array, 8 to write into OAM
+
+    for (uint32_t i = 0; i < count; ++i, source += 8)
+    {
+        int32_t scaleX = int16_t(memory->ReadUInt16(source));
+        int32_t scaleY = int16_t(memory->ReadUInt16(source + 2));
+        uint8_t angle = uint8_t(memory->ReadUInt16(source + 4) >> 8);
+
+        int32_t parameters[] =
+        {
+            (scaleX * Cosine(angle)) >> 14,
+            -((scaleX * Sine(angle)) >> 14),
+            (scaleY * Sine(angle)) >> 14,
+            (scaleY * Cosine(angle)) >> 14
+        };
+
+        for (int32_t parameter : parameters)
+        {
+            memory->WriteUInt16(destination, uint16_t(parameter));
+            destination += stride;
+        }
+    }
+}
+
+bool HLEBIOS::LZ77UnComp(bool vram)
+{
+    SourceReader source(_cpu->GetMemory().get(), _cpu->GetRegister(0));
+    uint32_t destination = _cpu->GetRegister(1);
+    uint32_t header = source.ReadWord();
+
+    if (((header >> 4) & 0xF) != LZ77)
+        return false;
+
+    // VRAM is written a halfword at a time, a last odd byte is never written
+    uint32_t size = vram ? (header >> 8) & ~1 : header >> 8;
+    uint8_t* output = BeginOutput(destination, size);
+
+    // The original value of the last even byte, in VRAM it is only written along with the odd byte after it
+    uint8_t unwritten = 0;
+    uint32_t position = 0;
+
+    while (position < size)
+    {
+        // Each bit of the flags tells whether the next block is a byte or a reference, the highest bit first
+        uint8_t flags = source.ReadByte();
+
+        for (uint8_t block = 0; block < 8 && position < size; ++block, flags <<= 1)
+        {
+            if (!(flags & 0x80))
+            {
+                if (!(position & 1))
+                    unwritten = output[position];
+
+                output[position++] = source.ReadByte();
+                continue;
+            }
+
+            uint8_t first = source.ReadByte();
+            uint8_t second = source.ReadByte();
+
+            uint32_t length = std::min<uint32_t>((first >> 4) + 3, size - position);
+            uint32_t distance = (((first & 0xF) << 8) | second) + 1;
+            uint32_t end = position + length;
+
+            if (distance > position || (vram && distance == 1))
+            {
+                for (; position < end; ++position)
+                {
+                    uint8_t value;
+
+                    // Broken data can point before the start, the BIOS reads whatever was there
+                    if (distance > position)
+                        value = _cpu->GetMemory()->ReadUInt8(destination + position - distance);
+                    // In VRAM the previous byte is still waiting for its pair
+                    else if (distance == 1 && (position & 1))
+                        value = unwritten;
+                    else
+                        value = output[position - distance];
+
+                    if (!(position & 1))
+                        unwritten = output[position];
+
+                    output[position] = value;
+                }
+
+                continue;
+            }
+
+            if (!((end - 1) & 1))
+                unwritten = output[end - 1];
+
+            // When the reference overlaps the bytes it writes, its first distance bytes repeat. Copy them a block at a time
+            while (position < end)
+            {
+                uint32_t count = std::min(distance, end - position);
+                memcpy(&output[position], &output[position - distance], count);
+                position += count;
+            }
+        }
+    }
+
+    EndOutput(destination, size, vram);
+    return true;
+}
+
+bool HLEBIOS::RLUnComp(bool vram)
+{
+    SourceReader source(_cpu->GetMemory().get(), _cpu->GetRegister(0));
+    uint32_t destination = _cpu->GetRegister(1);
+    uint32_t header = source.ReadWord();
+
+    if (((header >> 4) & 0xF) != RunLength)
+        return false;
+
+    uint32_t size = vram ? (header >> 8) & ~1 : header >> 8;
+    uint8_t* output = BeginOutput(destination, size);
+    uint32_t position = 0;
+
+    while (position < size)
+    {
+        // The highest bit tells whether a single byte is repeated or the bytes follow as they are
+        uint8_t flags = source.ReadByte();
+
+        if (flags & 0x80)
+        {
+            uint32_t length = std::min<uint32_t>((flags & 0x7F) + 3, size - position);
+            memset(&output[position], source.ReadByte(), length);
+            position += length;
+        }
+        else
+        {
+            uint32_t length = std::min<uint32_t>((flags & 0x7F) + 1, size - position);
+            source.Read(&output[position], length);
+            position += length;
+        }
+    }
+
+    EndOutput(destination, size, vram);
+    return true;
+}
+
+bool HLEBIOS::HuffUnComp()
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    uint32_t address = _cpu->GetRegister(0) & ~3;
+    uint32_t destination = _cpu->GetRegister(1) & ~3;
+    uint32_t header = memory->ReadUInt32(address);
+
+    // Only 1, 2, 4 and 8 bit data fill the words evenly
+    uint32_t bits = header & 0xF;
+
+    if (((header >> 4) & 0xF) != Huffman || (bits != 1 && bits != 2 && bits != 4 && bits != 8))
+        return false;
+
+    // Whole words are written
+    uint32_t size = ((header >> 8) + 3) & ~3;
+
+    // The tree follows the header, its size is given in halfwords minus one. The root is its first node.
+    // It is looked up for every bit, so it is copied once. The nodes are indexed from the word before the root
+    uint32_t treeSize = (uint32_t(memory->ReadUInt8(address + 4)) << 1) + 1;
+    uint8_t tree[MAX_HUFFMAN_TREE_SIZE + 1];
+
+    for (uint32_t i = 0; i < treeSize; ++i)
+        tree[i + 1] = memory->ReadUInt8(address + 5 + i);
+
+    SourceReader source(memory.get(), address + 5 + treeSize);
+    uint8_t* output = BeginOutput(destination, size);
+
+    uint32_t node = 1;
+    uint32_t word = 0;
+    uint32_t filled = 0;
+    uint32_t written = 0;
+
+    while (written < size)
+    {
+        // The bits are read from 32 bit words, the highest bit first
+        uint32_t bitstream = source.ReadWord();
+
+        for (uint32_t i = 0; i < 32 && written < size; ++i, bitstream <<= 1)
+        {
+            // The children of a node are next to each other, bits 0-5 give their offset.
+            // Bit 7 says the left one is data, bit 6 the right one
+            uint8_t current = tree[node];
+            bool right = (bitstream & 0x80000000) != 0;
+            bool data = MathHelper::CheckBit(current, right ? 6 : 7);
+
+            node = (node & ~1) + (current & 0x3F) * 2 + 2 + (right ? 1 : 0);
+
+            // Broken trees can point outside of it
+            if (node > treeSize)
+                node = treeSize;
+
+            if (!data)
+                continue;
+
+            word |= (tree[node] & ((1 << bits) - 1)) << filled;
+            filled += bits;
+            node = 1;
+
+            if (filled == 32)
+            {
+                memcpy(&output[written], &word, sizeof(word));
+                written += 4;
+                word = 0;
+                filled = 0;
+            }
+        }
+    }
+
+    EndOutput(destination, size, true);
+    return true;
+}
+
+uint8_t* HLEBIOS::BeginOutput(uint32_t address, uint32_t size)
+{
+    uint8_t* output = _cpu->GetMemory()->GetWritePointer(address, size);
+
+    if (output)
+        return output;
+
+    // The destination isn't plain memory, the data goes through the bus at the end. It starts out like the memory it replaces
+    _buffer.resize(size);
+
+    for (uint32_t i = 0; i < size; ++i)
+        _buffer[i] = _cpu->GetMemory()->ReadUInt8(address + i);
+
+    return _buffer.data();
+}
+
+void HLEBIOS::EndOutput(uint32_t address, uint32_t size, bool halfwords)
+{
+    std::unique_ptr<MMU>& memory = _cpu->GetMemory();
+
+    if (memory->GetWritePointer(address, size))
+    {
+        memory->NotifyWrite(address, size);
+        return;
+    }
+
+    if (halfwords)
+    {
+        for (uint32_t i = 0; i + 1 < size; i += 2)
+            memory->WriteUInt16(address + i, uint16_t(_buffer[i] | (_buffer[i + 1] << 8)));
+    }
+    else
+    {
+        for (uint32_t i = 0; i < size; ++i)
+            memory->WriteUInt8(address + i, _buffer[i]);
+    }
+}
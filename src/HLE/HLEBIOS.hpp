@@ -0,0 +1,86 @@
+#ifndef HLE_BIOS_HPP
+#define HLE_BIOS_HPP
+
+#include <cstdint>
+#include <vector>
+
+class CPU;
+
+// The BIOS calls, numbered like the comment of the SWI
+enum class BIOSFunction : uint8_t
+{
+    SoftReset = 0x00,
+    RegisterRamReset = 0x01,
+    Halt = 0x02,
+    Stop = 0x03,
+    IntrWait = 0x04,
+    VBlankIntrWait = 0x05,
+    Div = 0x06,
+    DivArm = 0x07,
+    Sqrt = 0x08,
+    ArcTan = 0x09,
+    ArcTan2 = 0x0A,
+    CpuSet = 0x0B,
+    CpuFastSet = 0x0C,
+    GetBiosChecksum = 0x0D,
+    BgAffineSet = 0x0E,
+    ObjAffineSet = 0x0F,
+    BitUnPack = 0x10,
+    LZ77UnCompWram = 0x11,
+    LZ77UnCompVram = 0x12,
+    HuffUnComp = 0x13,
+    RLUnCompWram = 0x14,
+    RLUnCompVram = 0x15
+};
+
+struct HLEBIOSStatistics
+{
+    uint64_t Calls = 0;     // Run natively
+    uint64_t Fallbacks = 0; // Left to the BIOS code
+};
+
+// Runs the most used BIOS calls natively instead of interpreting the code of the BIOS.
+// Without a BIOS file this is the only way to run them, a few stubs then take the place of the BIOS so the interrupts
+// still reach the handler of the game.
+class HLEBIOS final
+{
+public:
+    HLEBIOS(CPU* cpu);
+
+    // Runs the function if it is emulated and returns whether it was, the PC already points after the SWI
+    bool Call(uint8_t function);
+
+    // Writes the exception vectors and the IRQ handler in place of the BIOS code, and sets up the stacks like its boot code
+    void Boot();
+
+    void SetEnabled(bool enabled) { _enabled = enabled; }
+    bool IsEnabled() const { return _enabled; }
+
+    HLEBIOSStatistics const& GetStatistics() const { return _statistics; }
+
+private:
+    void Div(bool swapped);
+    void Sqrt();
+    void ArcTan();
+    void ArcTan2();
+    void CpuSet();
+    void CpuFastSet();
+    void BgAffineSet();
+    void ObjAffineSet();
+    // The decompressors return false for the formats they don't handle
+    bool LZ77UnComp(bool vram);
+    bool RLUnComp(bool vram);
+    bool HuffUnComp();
+
+    // The memory the decompressors write size bytes to. Plain memory is written directly, anything else is buffered
+    uint8_t* BeginOutput(uint32_t address, uint32_t size);
+    // Lets the MMU know about the direct writes or writes the buffer through the bus, VRAM can only be written 16 bits at a time
+    void EndOutput(uint32_t address, uint32_t size, bool halfwords);
+
+    CPU* _cpu;
+    bool _enabled;
+    std::vector<uint8_t> _buffer;
+    HLEBIOSStatistics _statistics;
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "IORegisters.hpp"
+#include "CPU/CPU.hpp"
+
+#include <cstring>
+
+// http://problemkaputt.de/gbatek.htm#gbaiomap
+
+namespace
+{
+    struct IORegisterDefinition
+    {
+        uint32_t Address;
+        uint16_t Count; // Number of consecutive halfwords that behave the same
+        IORegister Register;
+    };
+
+    // Anything that isn't listed can be read and written freely
+    IORegisterDefinition const Definitions[] =
+    {
+        // LCD
+        { 0x04000000, 1, { 0xFFFF, 0xFFF7, false, false } }, // DISPCNT, the CGB mode bit can only be set by the BIOS
+        { 0x04000004, 1, { 0xFF3F, 0xFF38, false, false } }, // DISPSTAT, the blanking and match flags are set by the GPU
+        { 0x04000006, 1, { 0x00FF, 0x0000, false, false } }, // VCOUNT
+        { 0x04000008, 2, { 0xDFFF, 0xDFFF, false, false } }, // BG0CNT - BG1CNT
+        { 0x0400000C, 2, { 0xFFFF, 0xFFFF, false, false } }, // BG2CNT - BG3CNT
+        { 0x04000010, 8, { 0x0000, 0x01FF, false, false } }, // BG0HOFS - BG3VOFS
+        { 0x04000020, 16, { 0x0000, 0xFFFF, false, false } }, // BG2PA - BG3Y
+        { 0x04000040, 4, { 0x0000, 0xFFFF, false, false } }, // WIN0H - WIN1V
+        { 0x04000048, 2, { 0x3F3F, 0x3F3F, false, false } }, // WININ, WINOUT
+        { 0x0400004C, 1, { 0x0000, 0xFFFF, false, false } }, // MOSAIC
+        { 0x04000050, 1, { 0x3FFF, 0x3FFF, false, false } }, // BLDCNT
+        { 0x04000052, 1, { 0x1F1F, 0x1F1F, false, false } }, // BLDALPHA
+        { 0x04000054, 1, { 0x0000, 0x001F, false, false } }, // BLDY
+
+        // DMA, the addresses and counts can't be read back
+        { 0x040000B0, 5, { 0x0000, 0xFFFF, false, false } }, // DMA0SAD - DMA0CNT_L
+        { 0x040000BA, 1, { 0xF7E0, 0xF7E0, false, false } }, // DMA0CNT_H
+        { 0x040000BC, 5, { 0x0000, 0xFFFF, false, false } }, // DMA1SAD - DMA1CNT_L
+        { 0x040000C6, 1, { 0xF7E0, 0xF7E0, false, false } }, // DMA1CNT_H
+        { 0x040000C8, 5, { 0x0000, 0xFFFF, false, false } }, // DMA2SAD - DMA2CNT_L
+        { 0x040000D2, 1, { 0xF7E0, 0xF7E0, false, false } }, // DMA2CNT_H
+        { 0x040000D4, 5, { 0x0000, 0xFFFF, false, false } }, // DMA3SAD - DMA3CNT_L
+        { 0x040000DE, 1, { 0xFFE0, 0xFFE0, false, false } }, // DMA3CNT_H, only DMA3 has the Game Pak DRQ
+
+        // Timers
+        { 0x04000102, 1, { 0x00C7, 0x00C7, false, false } }, // TM0CNT_H
+        { 0x04000106, 1, { 0x00C7, 0x00C7, false, false } }, // TM1CNT_H
+        { 0x0400010A, 1, { 0x00C7, 0x00C7, false, false } }, // TM2CNT_H
+        { 0x0400010E, 1, { 0x00C7, 0x00C7, false, false } }, // TM3CNT_H
+
+        // Keypad
+        { 0x04000130, 1, { 0x03FF, 0x0000, false, false } }, // KEYINPUT
+        { 0x04000132, 1, { 0xC3FF, 0xC3FF, false, false } }, // KEYCNT
+
+        // Interrupts, waitstates and power down
+        { 0x04000200, 1, { 0x3FFF, 0x3FFF, false, false } }, // IE
+        { 0x04000202, 1, { 0x3FFF, 0x3FFF, true, false } },  // IF
+        { 0x04000204, 1, { 0xDFFF, 0x5FFF, false, false } }, // WAITCNT, the Game Pak type bit is read only
+        { 0x04000206, 1, { 0x0000, 0x0000, false, false } },
+        { 0x04000208, 1, { 0x0001, 0x0001, false, false } }, // IME
+        { 0x0400020A, 1, { 0x0000, 0x0000, false, false } },
+        { 0x04000300, 1, { 0x0001, 0xFF01, false, true } }   // POSTFLG, HALTCNT can only be written
+    };
+
+    uint32_t GetIndex(uint32_t address)
+    {
+        return (address & (IO_SIZE - 1)) >> 1;
+    }
+}
+
+IORegisters::IORegisters(CPU* cpu) : _io(cpu->GetMemoryArena()->Get(MemoryRegion::IO)), _reads(0), _timedReads(0)
+{
+    IORegister plain = { 0xFFFF, 0xFFFF, false, false };
+
+    for (IORegister& reg : _registers)
+        reg = plain;
+
+    for (IORegisterDefinition const& definition : Definitions)
+        for (uint16_t i = 0; i < definition.Count; ++i)
+            _registers[GetIndex(definition.Address) + i] = definition.Register;
+
+    Reset();
+}
+
+void IORegisters::Reset()
+{
+    memset(_io, 0, IO_SIZE);
+
+    // No key is pressed
+    Set(0x04000130, 0x03FF);
+}
+
+template <typename T>
+T IORegisters::Read(uint32_t address)
+{
+    T value = 0;
+
+    // Byte reads take their half of the halfword
+    if (sizeof(T) == 1)
+        return T(ReadHalfword(address & ~1) >> ((address & 1) * 8));
+
+    for (uint32_t i = 0; i < sizeof(T); i += 2)
+        value |= T(ReadHalfword(address + i)) << (i * 8);
+
+    return value;
+}
+
+template <typename T>
+void IORegisters::Write(uint32_t address, T value)
+{
+    if (sizeof(T) == 1)
+    {
+        uint8_t shift = (address & 1) * 8;
+        WriteHalfword(address & ~1, uint16_t(value << shift), uint16_t(0xFF << shift));
+        return;
+    }
+
+    // Words are written one halfword at a time, the lower one first
+    for (uint32_t i = 0; i < sizeof(T); i += 2)
+        WriteHalfword(address + i, uint16_t(value >> (i * 8)), 0xFFFF);
+}
+
+template uint8_t IORegisters::Read<uint8_t>(uint32_t address);
+template uint16_t IORegisters::Read<uint16_t>(uint32_t address);
+template uint32_t IORegisters::Read<uint32_t>(uint32_t address);
+template void IORegisters::Write<uint8_t>(uint32_t address, uint8_t value);
+template void IORegisters::Write<uint16_t>(uint32_t address, uint16_t value);
+template void IORegisters::Write<uint32_t>(uint32_t address, uint32_t value);
+
+uint16_t IORegisters::ReadHalfword(uint32_t address)
+{
+    uint32_t index = GetIndex(address);
+    ++_reads;
+
+    if (_readHandlers[index])
+    {
+        ++_timedReads;
+        return _readHandlers[index]() & _registers[index].ReadMask;
+    }
+
+    return Get(address) & _registers[index].ReadMask;
+}
+
+void IORegisters::WriteHalfword(uint32_t address, uint16_t value, uint16_t bytes)
+{
+    uint32_t index = GetIndex(address);
+    IORegister const& reg = _registers[index];
+
+    uint16_t previous = Get(address);
+    uint16_t mask = reg.WriteMask & bytes;
+    uint16_t current;
+
+    if (reg.Acknowledge)
+        current = previous & ~(value & mask);
+    else
+        current = (previous & ~mask) | (value & mask);
+
+    if (reg.Strobe && (mask & ~reg.ReadMask))
+    {
+        Set(address, current & reg.ReadMask);
+
+        if (_handlers[index])
+            _handlers[index](previous, current);
+
+        return;
+    }
+
+    if (current == previous)
+        return;
+
+    Set(address, current);
+
+    if (_handlers[index])
+        _handlers[index](previous, current);
+}
+
+uint16_t IORegisters::Get(uint32_t address) const
+{
+    uint16_t value;
+    memcpy(&value, &_io[address & (IO_SIZE - 2)], sizeof(value));
+    return value;
+}
+
+uint32_t IORegisters::Get32(uint32_t address) const
+{
+    return Get(address) | (uint32_t(Get(address + 2)) << 16);
+}
+
+void IORegisters::Set(uint32_t address, uint16_t value)
+{
+    memcpy(&_io[address & (IO_SIZE - 2)], &value, sizeof(value));
+}
+
+void IORegisters::RegisterWriteHandler(uint32_t address, WriteHandler const& handler)
+{
+    _handlers[GetIndex(address)] = handler;
+}
+
+void IORegisters::RegisterReadHandler(uint32_t address, ReadHandler const& handler)
+{
+    _readHandlers[GetIndex(address)] = handler;
+}
@@ -0,0 +1,71 @@
+#ifndef IO_REGISTERS_HPP
+#define IO_REGISTERS_HPP
+
+#include "Memory/MemoryArena.hpp"
+
+#include <cstdint>
+#include <functional>
+
+class CPU;
+
+// How the guest sees one halfword of the I/O registers
+struct IORegister
+{
+    uint16_t ReadMask;  // Write only and unused bits read as 0
+    uint16_t WriteMask; // Read only bits keep their value
+    bool Acknowledge;   // Writing 1 to a bit clears it instead of setting it, like in IF
+    bool Strobe;        // Writing the write only bits runs the handler every time and doesn't keep them, like in HALTCNT
+};
+
+// The memory mapped registers at 04000000. The values live in the I/O region of the memory arena, the guest accesses
+// them through the masks of each register while the hardware reads and sets them directly.
+// Peripherals register a handler for the registers they care about, it runs after a write from the guest changed them.
+// Registers whose value depends on the time, like the timer counters, have a read handler instead of a stored value.
+class IORegisters final
+{
+public:
+    typedef std::function<void(uint16_t previous, uint16_t value)> WriteHandler;
+    typedef std::function<uint16_t()> ReadHandler;
+
+    IORegisters(CPU* cpu);
+
+    // Clears every register and sets the ones that don't start at 0
+    void Reset();
+
+    // Accesses from the guest, through the bus
+    template <typename T>
+    T Read(uint32_t address);
+    template <typename T>
+    void Write(uint32_t address, T value);
+
+    // Accesses from the hardware, without masks or handlers
+    uint16_t Get(uint32_t address) const;
+    uint32_t Get32(uint32_t address) const;
+    void Set(uint32_t address, uint16_t value);
+
+    void RegisterWriteHandler(uint32_t address, WriteHandler const& handler);
+    void RegisterReadHandler(uint32_t address, ReadHandler const& handler);
+
+    // Halfwords the guest read so far, and how many of them came from a read handler
+    uint64_t GetReadCount() const { return _reads; }
+    uint64_t GetTimedReadCount() const { return _timedReads; }
+
+private:
+    enum IORegisterCount
+    {
+        NUM_REGISTERS = IO_SIZE / 2
+    };
+
+    uint16_t ReadHalfword(uint32_t address);
+    // Only the bits of the bytes in bytes are written
+    void WriteHalfword(uint32_t address, uint16_t value, uint16_t bytes);
+
+    uint8_t* _io;
+    IORegister _registers[NUM_REGISTERS];
+    WriteHandler _handlers[NUM_REGISTERS];
+    ReadHandler _readHandlers[NUM_REGISTERS];
+    uint64_t _reads;
+    uint64_t _timedReads;
+};
+
+#endif
@@ -2,43 +2,142 @@
 
 #include "CPU/CPU.hpp"
 
-#include "Common/Instructions/ARMInstruction.hpp"
-#include "Common/Instructions/ARM/BranchInstructions.hpp"
-#include "Common/Instructions/ARM/DataProcessingInstructions.hpp"
-#include "Common/Instructions/ARM/LoadStoreInstructions.hpp"
-#include "Common/Instructions/ARM/PSRTransferInstructions.hpp"
-#include "Common/Instructions/ARM/MultiplyAccumulateInstructions.hpp"
-
 #include "Common/MathHelper.hpp"
 #include "Common/Utilities.hpp"
 
-void Interpreter::HandleARMBranchInstruction(std::shared_ptr<ARMInstruction> instruction)
+namespace
 {
-    if (!_cpu->ConditionPasses(instruction->GetCondition()))
+    // Builds the second operand of a data processing instruction, carry holds the current C flag on entry and the shifter carry out on return
+    template <OperandForm Form, ARM::ShiftType Shift>
+    uint32_t GetShifterOperand(CPU* cpu, DecodedInstruction const& instruction, bool& carry)
+    {
+        if (Form == OperandForm::Immediate)
+        {
+            // Rotated immediates set the carry to their highest bit
+            if (instruction.ShiftAmount)
+                carry = MathHelper::CheckBit(instruction.Immediate, 31);
+
+            return instruction.Immediate;
+        }
+
+        uint32_t value = cpu->GetRegister(instruction.Rm);
+
+        // Account for CPU prefetch, the code expects the PC to be at <CurrentInstruction> + 8, but we're currently at <CurrentInstruction> + 4
+        if (instruction.Rm == PC)
+            value += 4;
+
+        if (Form == OperandForm::ImmediateShift)
+        {
+            uint32_t amount = instruction.ShiftAmount;
+
+            switch (Shift)
+            {
+                case ARM::ShiftType::LSL:
+                    if (amount == 0)
+                        return value;
+                    carry = MathHelper::CheckBit(value, 32 - amount);
+                    return value << amount;
+                case ARM::ShiftType::LSR:
+                    // An amount of 0 encodes LSR #32
+                    if (amount == 0)
+                    {
+                        carry = MathHelper::CheckBit(value, 31);
+                        return 0;
+                    }
+                    carry = MathHelper::CheckBit(value, amount - 1);
+                    return value >> amount;
+                case ARM::ShiftType::ASR:
+                    // An amount of 0 encodes ASR #32
+                    if (amount == 0)
+                    {
+                        carry = MathHelper::CheckBit(value, 31);
+                        return carry ? 0xFFFFFFFF : 0;
+                    }
+                    carry = MathHelper::CheckBit(value, amount - 1);
+                    return uint32_t(int32_t(value) >> amount);
+                case ARM::ShiftType::ROR:
+                    // An amount of 0 encodes RRX
+                    if (amount == 0)
+                    {
+                        uint32_t result = (uint32_t(carry) << 31) | (value >> 1);
+                        carry = MathHelper::CheckBit(value, 0);
+                        return result;
+                    }
+                    carry = MathHelper::CheckBit(value, amount - 1);
+                    return MathHelper::RotateRight(value, amount);
+            }
+        }
+
+        // Only the lower 8 bits of Rs are used
+        uint32_t amount = (cpu->GetRegister(instruction.Rs) + (instruction.Rs == PC ? 4 : 0)) & 0xFF;
+        if (amount == 0)
+            return value;
+
+        switch (Shift)
+        {
+            case ARM::ShiftType::LSL:
+                if (amount > 32)
+                {
+                    carry = false;
+                    return 0;
+                }
+                carry = MathHelper::CheckBit(value, 32 - amount);
+                return amount == 32 ? 0 : value << amount;
+            case ARM::ShiftType::LSR:
+                if (amount > 32)
+                {
+                    carry = false;
+                    return 0;
+                }
+                carry = MathHelper::CheckBit(value, amount - 1);
+                return amount == 32 ? 0 : value >> amount;
+            case ARM::ShiftType::ASR:
+                if (amount >= 32)
+                {
+                    carry = MathHelper::CheckBit(value, 31);
+                    return carry ? 0xFFFFFFFF : 0;
+                }
+                carry = MathHelper::CheckBit(value, amount - 1);
+                return uint32_t(int32_t(value) >> amount);
+            case ARM::ShiftType::ROR:
+                amount &= 0x1F;
+                if (amount == 0)
+                {
+                    carry = MathHelper::CheckBit(value, 31);
+                    return value;
+                }
+                carry = MathHelper::CheckBit(value, amount - 1);
+                return MathHelper::RotateRight(value, amount);
+        }
+
+        return value;
+    }
+}
+
+void Interpreter::HandleARMBranchInstruction(DecodedInstruction const& instruction)
+{
+    if (!_cpu->ConditionPasses(instruction.Condition))
         return;
 
-    if (instruction->GetOpcode() == ARM::ARMOpcodes::BLX || instruction->GetOpcode() == ARM::ARMOpcodes::BX)
+    if (instruction.GetOpcode() == ARM::ARMOpcodes::BLX || instruction.GetOpcode() == ARM::ARMOpcodes::BX)
     {
         // Save the return address, only the BLX instruction does this
-        if (instruction->GetOpcode() == ARM::ARMOpcodes::BLX)
+        if (instruction.GetOpcode() == ARM::ARMOpcodes::BLX)
             _cpu->GetRegister(LR) = _cpu->GetRegister(PC);
 
-        if (instruction->IsImmediate())
+        if (instruction.IsImmediate())
         {
-            auto branch = std::static_pointer_cast<ARM::BranchLinkExchangeImmediateInstruction>(instruction);
-            // The second bit of the signed offset is set to the value specified in the opcode (GetSecondBit())
+            // The second bit of the signed offset was already set by the decoder to the value specified in the opcode
             // The 4 is due to the CPU pipeline, the prefetch has already happened so PC should be at <CurrentInstruction> + 8, however we are only at <CurrentInstruction> + 4
-            _cpu->GetRegister(PC) += 4 + branch->GetSignedOffset() + (branch->GetSecondBit() << 1);
+            _cpu->GetRegister(PC) += 4 + instruction.Immediate;
 
             // This version of BLX always switches to Thumb mode
             _cpu->SetInstructionSet(InstructionSet::Thumb);
         }
         else
         {
-            auto branch = std::static_pointer_cast<ARM::BranchLinkExchangeRegisterInstruction>(instruction);
-
             // The value of the T bit will be that of the first bit of the value stored in the specified register
-            uint32_t reg = _cpu->GetRegister(branch->GetRegister());
+            uint32_t reg = _cpu->GetRegister(instruction.Rm);
             bool thumb = MathHelper::CheckBit(reg, 0);
 
             // The branch location is stored in a register, with the first bit set to 0
@@ -50,207 +149,177 @@ void Interpreter::HandleARMBranchInstruction(std::shared_ptr<ARMInstruction> ins
         return;
     }
 
-    auto branch = std::static_pointer_cast<ARM::BranchInstruction>(instruction);
-
-    if (branch->Link())
+    if (instruction.Link())
         _cpu->GetRegister(LR) = _cpu->GetRegister(PC);
 
     // We have to add 4 because the CPU pipeline prefetches the next opcode.
-    _cpu->GetRegister(PC) += branch->GetSignedOffset() + 4;
+    _cpu->GetRegister(PC) += instruction.Immediate + 4;
 }
 
-
-void Interpreter::HandleARMDataProcessingInstruction(std::shared_ptr<ARMInstruction> instruction)
+void Interpreter::HandleARMSoftwareInterruptInstruction(DecodedInstruction const& instruction)
 {
-    if (!_cpu->ConditionPasses(instruction->GetCondition()))
+    if (!_cpu->ConditionPasses(instruction.Condition))
         return;
 
-    auto dataproc = std::static_pointer_cast<ARM::DataProcessingInstruction>(instruction);
+    // The BIOS reads the function number from the upper byte of the comment
+    _cpu->SoftwareInterrupt(uint8_t(instruction.Immediate >> 16));
+}
 
-    int64_t firstOperand = _cpu->GetRegister(dataproc->GetFirstOperand());
+template <std::size_t... Variants>
+std::array<Interpreter::HandlerFunction, ARM::DATA_PROCESSING_VARIANTS> Interpreter::MakeDataProcessingHandlers(Utilities::IndexSequence<Variants...>)
+{
+    return std::array<HandlerFunction, ARM::DATA_PROCESSING_VARIANTS> {{
+        &Interpreter::HandleARMDataProcessing<ARM::GetVariantOperation(Variants), ARM::GetVariantForm(Variants), ARM::GetVariantShift(Variants), ARM::GetVariantSetConditionCodes(Variants)>...
+    }};
+}
 
-    // Account for CPU prefetch, the code expects the PC to be at <CurrentInstruction> + 8, but we're currently at <CurrentInstruction> + 4
-    if (dataproc->GetFirstOperand() == PC)
-        firstOperand += 4;
+std::array<Interpreter::HandlerFunction, ARM::DATA_PROCESSING_VARIANTS> const Interpreter::DataProcessingHandlers =
+    Interpreter::MakeDataProcessingHandlers(Utilities::MakeIndexSequence<ARM::DATA_PROCESSING_VARIANTS>::Type());
 
-    // Use int64_t so that we can check for overflow later
-    int64_t secondOperand = 0;
-    int64_t result = 0;
+void Interpreter::HandleARMDataProcessingInstruction(DecodedInstruction const& instruction)
+{
+    (this->*DataProcessingHandlers[instruction.Variant])(instruction);
+}
 
-    // Default to the previous Carry value
-    bool carryOut = _cpu->GetCurrentStatusFlags().C;
+template <ARM::DataProcessingOperation Operation, OperandForm Form, ARM::ShiftType Shift, bool SetConditionCodes>
+void Interpreter::HandleARMDataProcessing(DecodedInstruction const& instruction)
+{
+    if (!_cpu->ConditionPasses(instruction.Condition))
+        return;
 
-    if (dataproc->IsImmediate())
-        secondOperand = dataproc->GetShiftedSecondOperandImmediate();
-    else
-    {
-        int32_t registerValue = _cpu->GetRegister(dataproc->GetSecondOperand());
+    uint32_t firstOperand = _cpu->GetRegister(instruction.Rn);
 
-        if (dataproc->GetSecondOperand() == PC)
-            registerValue += 4;
+    // Account for CPU prefetch, the code expects the PC to be at <CurrentInstruction> + 8, but we're currently at <CurrentInstruction> + 4
+    if (instruction.Rn == PC)
+        firstOperand += 4;
 
-        // If the instruction must shift the second operand by a register value, then only the lower 8 bits of that register are used.
-        uint8_t shiftValue = dataproc->ShiftByRegister() ? ((_cpu->GetRegister(dataproc->GetShiftRegisterOrImmediate()) + (dataproc->GetShiftRegisterOrImmediate() == PC ? 4 : 0)) & 0xFF) : dataproc->GetShiftRegisterOrImmediate();
+    // The carry is only needed to set the flags, for the carry based operations and for RRX
+    bool const needsCarry = SetConditionCodes || Operation == ARM::DataProcessingOperation::ADC || Operation == ARM::DataProcessingOperation::SBC ||
+        Operation == ARM::DataProcessingOperation::RSC || (Form == OperandForm::ImmediateShift && Shift == ARM::ShiftType::ROR);
 
-        switch (dataproc->GetShiftType())
-        {
-            case ARM::ShiftType::LSL:
-                secondOperand = registerValue << shiftValue;
-                if (shiftValue)
-                    carryOut = MathHelper::CheckBit(registerValue, 32 - shiftValue);
-                break;
-            case ARM::ShiftType::ASR:
-                // Handle a special case for the ASR shifter as defined in the ARM Reference Manual
-                if ((!dataproc->ShiftByRegister() && shiftValue == 0) || (dataproc->ShiftByRegister() && shiftValue >= 32))
-                {
-                    carryOut = MathHelper::CheckBit(registerValue, 31);
-                    if (carryOut)
-                        secondOperand = 0xFFFFFFFF;
-                    else
-                        secondOperand = 0;
-                    break;
-                }
-                // No break
-            case ARM::ShiftType::LSR:
-                if (shiftValue)
-                    carryOut = MathHelper::CheckBit(registerValue, shiftValue - 1);
-                else if (!dataproc->ShiftByRegister())
-                    carryOut = MathHelper::CheckBit(registerValue, 31);
+    bool carryIn = needsCarry ? _cpu->GetCarryFlag() : false;
 
-                secondOperand = registerValue >> shiftValue;
-                break;
-            case ARM::ShiftType::ROR:
-                if (shiftValue || dataproc->ShiftByRegister())
-                {
-                    secondOperand = MathHelper::RotateRight(registerValue, shiftValue);
-                    if (dataproc->ShiftByRegister())
-                    {
-                        if (MathHelper::CheckBits(shiftValue, 0, 4, 0))
-                            carryOut = MathHelper::CheckBit(registerValue, 31);
-                        else
-                            carryOut = MathHelper::CheckBit(registerValue, (shiftValue & 0xF) - 1);
-                    }
-                    else
-                        carryOut = MathHelper::CheckBit(registerValue, shiftValue - 1);
-                }
-                else if (!shiftValue)
-                {
-                    // A 0 shiftValue specifies a RRX shift
-                    secondOperand = (_cpu->GetCurrentStatusFlags().C << 31) | (registerValue >> 1);
-                    carryOut = MathHelper::CheckBit(registerValue, 0);
-                }
-                break;
-        }
-    }
+    // The logical operations set the carry from the shifter
+    bool shifterCarry = carryIn;
+    uint32_t secondOperand = GetShifterOperand<Form, Shift>(_cpu, instruction, shifterCarry);
+    uint32_t result = 0;
 
-    switch (dataproc->GetOpcode())
+    switch (Operation)
     {
-        case ARM::ARMOpcodes::AND:
-        case ARM::ARMOpcodes::TST:
+        case ARM::DataProcessingOperation::AND:
+        case ARM::DataProcessingOperation::TST:
             result = firstOperand & secondOperand;
             break;
-        case ARM::ARMOpcodes::EOR:
-        case ARM::ARMOpcodes::TEQ:
+        case ARM::DataProcessingOperation::EOR:
+        case ARM::DataProcessingOperation::TEQ:
             result = firstOperand ^ secondOperand;
             break;
-        case ARM::ARMOpcodes::SUB:
-        case ARM::ARMOpcodes::CMP:
-            result = firstOperand - secondOperand;
+        case ARM::DataProcessingOperation::ORR:
+            result = firstOperand | secondOperand;
             break;
-        case ARM::ARMOpcodes::RSB: // Reversed Subtract
-            result = secondOperand - firstOperand;
+        case ARM::DataProcessingOperation::MOV:
+            result = secondOperand;
             break;
-        case ARM::ARMOpcodes::ADD:
-        case ARM::ARMOpcodes::CMN:
-            result = firstOperand + secondOperand;
+        case ARM::DataProcessingOperation::BIC:
+            result = firstOperand & ~secondOperand;
             break;
-        case ARM::ARMOpcodes::ADC: // Add with carry
-            result = firstOperand + secondOperand + _cpu->GetCurrentStatusFlags().C;
+        case ARM::DataProcessingOperation::MVN:
+            result = ~secondOperand;
             break;
-        case ARM::ARMOpcodes::SBC: // Sub with carry
-            result = firstOperand - secondOperand + _cpu->GetCurrentStatusFlags().C - 1;
+        case ARM::DataProcessingOperation::ADD:
+        case ARM::DataProcessingOperation::CMN:
+            result = firstOperand + secondOperand;
             break;
-        case ARM::ARMOpcodes::RSC: // Reversed Sub with Carry
-            result = secondOperand - firstOperand + _cpu->GetCurrentStatusFlags().C - 1;
+        case ARM::DataProcessingOperation::ADC: // Add with carry
+            result = firstOperand + secondOperand + carryIn;
             break;
-        case ARM::ARMOpcodes::ORR:
-            result = firstOperand | secondOperand;
+        case ARM::DataProcessingOperation::SUB:
+        case ARM::DataProcessingOperation::CMP:
+            result = firstOperand - secondOperand;
             break;
-        case ARM::ARMOpcodes::MOV:
-            result = secondOperand;
+        case ARM::DataProcessingOperation::RSB: // Reversed Subtract
+            result = secondOperand - firstOperand;
             break;
-        case ARM::ARMOpcodes::BIC:
-            result = firstOperand & ~secondOperand;
+        case ARM::DataProcessingOperation::SBC: // Sub with carry
+            result = firstOperand - secondOperand - !carryIn;
             break;
-        case ARM::ARMOpcodes::MVN:
-            result = ~secondOperand;
+        case ARM::DataProcessingOperation::RSC: // Reversed Sub with Carry
+            result = secondOperand - firstOperand - !carryIn;
             break;
     }
 
-    if (dataproc->SetConditionCodes())
+    // The comparison opcodes only update the flags
+    bool const hasDestinationRegister = Operation < ARM::DataProcessingOperation::TST || Operation > ARM::DataProcessingOperation::CMN;
+
+    if (SetConditionCodes)
     {
-        if (dataproc->GetDestinationRegister() == PC)
+        if (instruction.Rd == PC && hasDestinationRegister)
         {
-            Utilities::Assert(false, "Loading SPSR into CPSR is not yet implemented");
+            // Returning from an exception, the flags and the mode come back from the SPSR
+            _cpu->GetRegister(PC) = result;
+            _cpu->SetCurrentStatusRegister(_cpu->GetSavedStatusRegister().Full);
             return;
         }
 
-        _cpu->GetCurrentStatusFlags().N = MathHelper::CheckBit(uint32_t(result), 31);
-        _cpu->GetCurrentStatusFlags().Z = result == 0;
-
-        if (dataproc->AffectsOverflow())
+        // The flags are computed later from the operands, if something actually reads them
+        switch (Operation)
         {
-            // For these opcodes, the carry is set based on the result of the shift operation
-            if (dataproc->IsImmediate() && dataproc->GetShiftImmediate() != 0)
-                _cpu->GetCurrentStatusFlags().C = MathHelper::CheckBit(dataproc->GetShiftedSecondOperandImmediate(), 31);
-            else
-                _cpu->GetCurrentStatusFlags().C = carryOut;
-        }
-        else
-        {
-            // The carry depends on the value of the result for these opcodes
-
-            // For these opcodes, the Carry flag is actually a NOT(Borrow)
-            if (dataproc->GetOpcode() == ARM::ARMOpcodes::CMP || dataproc->GetOpcode() == ARM::ARMOpcodes::SUB || dataproc->GetOpcode() == ARM::ARMOpcodes::SBC || dataproc->GetOpcode() == ARM::ARMOpcodes::RSC || dataproc->GetOpcode() == ARM::ARMOpcodes::RSB)
-                _cpu->GetCurrentStatusFlags().C = result >= 0;
-
-            _cpu->GetCurrentStatusFlags().C = MathHelper::CheckBit(result, 32); // Check the 32th bit of the result, it's set only if the operation had a carry
+            case ARM::DataProcessingOperation::ADD:
+            case ARM::DataProcessingOperation::CMN:
+                _cpu->SetArithmeticFlags(LazyFlags::Addition, firstOperand, secondOperand, false, result);
+                break;
+            case ARM::DataProcessingOperation::ADC:
+                _cpu->SetArithmeticFlags(LazyFlags::Addition, firstOperand, secondOperand, carryIn, result);
+                break;
+            case ARM::DataProcessingOperation::SUB:
+            case ARM::DataProcessingOperation::CMP:
+                _cpu->SetArithmeticFlags(LazyFlags::Subtraction, firstOperand, secondOperand, true, result);
+                break;
+            case ARM::DataProcessingOperation::RSB:
+                _cpu->SetArithmeticFlags(LazyFlags::Subtraction, secondOperand, firstOperand, true, result);
+                break;
+            case ARM::DataProcessingOperation::SBC:
+                _cpu->SetArithmeticFlags(LazyFlags::Subtraction, firstOperand, secondOperand, carryIn, result);
+                break;
+            case ARM::DataProcessingOperation::RSC:
+                _cpu->SetArithmeticFlags(LazyFlags::Subtraction, secondOperand, firstOperand, carryIn, result);
+                break;
+            default:
+                _cpu->SetLogicalFlags(result, shifterCarry);
+                break;
         }
-
-        // Now that the carry is set, we can compute the overflow
-        if (dataproc->AffectsOverflow())
-            _cpu->GetCurrentStatusFlags().V = _cpu->GetCurrentStatusFlags().C ^ _cpu->GetCurrentStatusFlags().N;
     }
 
-    if (dataproc->HasDestinationRegister())
-        _cpu->GetRegister(dataproc->GetDestinationRegister()) = int32_t(result);
+    if (hasDestinationRegister)
+        _cpu->GetRegister(instruction.Rd) = result;
 }
 
-void Interpreter::HandleARMLoadStoreInstruction(std::shared_ptr<ARMInstruction> instr)
+void Interpreter::HandleARMLoadStoreInstruction(DecodedInstruction const& instruction)
 {
-    auto instruction = std::static_pointer_cast<ARM::LoadStoreInstruction>(instr);
+    if (!_cpu->ConditionPasses(instruction.Condition))
+        return;
 
-    uint32_t address = _cpu->GetRegister(instruction->GetBaseRegister());
+    uint32_t address = _cpu->GetRegister(instruction.Rn);
 
     // Account for CPU prefetch, the code expects the PC to be at <CurrentInstruction> + 8, but we're currently at <CurrentInstruction> + 4
-    if (instruction->GetBaseRegister() == PC)
+    if (instruction.Rn == PC)
         address += 4;
 
     uint32_t secondAddressValue = 0;
 
-    if (instruction->IsImmediate())
-        secondAddressValue = instruction->GetImmediateOffset();
+    if (instruction.IsImmediate())
+        secondAddressValue = instruction.Immediate;
     else
     {
-        int32_t registerValue = _cpu->GetRegister(instruction->GetIndexRegister());
+        int32_t registerValue = _cpu->GetRegister(instruction.Rm);
 
         // Account for CPU prefetch, the code expects the PC to be at <CurrentInstruction> + 8, but we're currently at <CurrentInstruction> + 4
-        if (instruction->GetIndexRegister() == PC)
+        if (instruction.Rm == PC)
             registerValue += 4;
 
-        uint32_t shiftValue = instruction->GetShiftImmediate();
+        uint32_t shiftValue = instruction.ShiftAmount;
 
-        switch (instruction->GetShiftType())
+        switch (instruction.Shift)
         {
             case ARM::ShiftType::LSL:
                 secondAddressValue = registerValue << shiftValue;
@@ -279,46 +348,46 @@ void Interpreter::HandleARMLoadStoreInstruction(std::shared_ptr<ARMInstruction>
         }
     }
 
-    if (instruction->IsPreIndexed())
+    if (instruction.IsPreIndexed())
     {
-        if (instruction->IsBaseAdded())
+        if (instruction.IsBaseAdded())
             address += secondAddressValue;
         else
             address -= secondAddressValue;
 
-        if (instruction->WriteBack() && _cpu->ConditionPasses(instruction->GetCondition()))
-            _cpu->GetRegister(instruction->GetBaseRegister()) = address;
+        if (instruction.WriteBack())
+            _cpu->GetRegister(instruction.Rn) = address;
     }
     else
     {
-        if (instruction->WriteBack() && _cpu->ConditionPasses(instruction->GetCondition()))
+        if (instruction.WriteBack())
         {
-            if (instruction->IsBaseAdded())
-                _cpu->GetRegister(instruction->GetBaseRegister()) += secondAddressValue;
+            if (instruction.IsBaseAdded())
+                _cpu->GetRegister(instruction.Rn) += secondAddressValue;
             else
-                _cpu->GetRegister(instruction->GetBaseRegister()) -= secondAddressValue;
+                _cpu->GetRegister(instruction.Rn) -= secondAddressValue;
         }
     }
 
-    switch (instruction->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case ARM::ARMOpcodes::LDR:
         case ARM::ARMOpcodes::LDRB:
         case ARM::ARMOpcodes::LDRBT:
-            if (instruction->IsUnsignedByte())
-                _cpu->GetRegister(instruction->GetRegister()) = _cpu->GetMemory()->ReadUInt8(address);
+            if (instruction.IsByte())
+                _cpu->GetRegister(instruction.Rd) = _cpu->GetMemory()->ReadUInt8(address);
             else
-                _cpu->GetRegister(instruction->GetRegister()) = _cpu->GetMemory()->ReadUInt32(address);
+                _cpu->GetRegister(instruction.Rd) = _cpu->GetMemory()->ReadUInt32(address);
             break;
         case ARM::ARMOpcodes::STR:
         case ARM::ARMOpcodes::STRB:
         case ARM::ARMOpcodes::STRBT:
         {
-            uint32_t writeVal = _cpu->GetRegister(instruction->GetRegister());
-            if (instruction->GetRegister() == PC)
+            uint32_t writeVal = _cpu->GetRegister(instruction.Rd);
+            if (instruction.Rd == PC)
                 writeVal += 4;
 
-            if (instruction->IsUnsignedByte())
+            if (instruction.IsByte())
                 _cpu->GetMemory()->WriteUInt8(address, writeVal & 0xFF);
             else
                 _cpu->GetMemory()->WriteUInt32(address, writeVal);
@@ -330,66 +399,67 @@ void Interpreter::HandleARMLoadStoreInstruction(std::shared_ptr<ARMInstruction>
     }
 }
 
-void Interpreter::HandleARMMiscellaneousLoadStoreInstruction(std::shared_ptr<ARMInstruction> instr)
+void Interpreter::HandleARMMiscellaneousLoadStoreInstruction(DecodedInstruction const& instruction)
 {
-    auto instruction = std::static_pointer_cast<ARM::MiscellaneousLoadStoreInstruction>(instr);
+    if (!_cpu->ConditionPasses(instruction.Condition))
+        return;
 
-    uint32_t address = _cpu->GetRegister(instruction->GetBaseRegister());
+    uint32_t address = _cpu->GetRegister(instruction.Rn);
 
     // Account for CPU prefetch, the code expects the PC to be at <CurrentInstruction> + 8, but we're currently at <CurrentInstruction> + 4
-    if (instruction->GetBaseRegister() == PC)
+    if (instruction.Rn == PC)
         address += 4;
 
     uint32_t secondAddressValue = 0;
 
-    if (instruction->IsImmediate())
-        secondAddressValue = instruction->GetImmediateOffset();
+    if (instruction.IsImmediate())
+        secondAddressValue = instruction.Immediate;
     else
     {
-        secondAddressValue = _cpu->GetRegister(instruction->GetRegisterOffset());
-        if (instruction->GetRegisterOffset() == PC)
+        secondAddressValue = _cpu->GetRegister(instruction.Rm);
+        if (instruction.Rm == PC)
             secondAddressValue += 4;
     }
 
-    if (instruction->IsPreIndexed())
+    if (instruction.IsPreIndexed())
     {
-        if (instruction->IsBaseAdded())
+        if (instruction.IsBaseAdded())
             address += secondAddressValue;
         else
             address -= secondAddressValue;
 
-        if (instruction->WriteBack() && _cpu->ConditionPasses(instruction->GetCondition()))
-            _cpu->GetRegister(instruction->GetBaseRegister()) = address;
+        if (instruction.WriteBack())
+            _cpu->GetRegister(instruction.Rn) = address;
     }
     else
     {
-        if (_cpu->ConditionPasses(instruction->GetCondition()))
+        if (instruction.WriteBack())
         {
-            if (instruction->IsBaseAdded())
-                _cpu->GetRegister(instruction->GetBaseRegister()) += secondAddressValue;
+            if (instruction.IsBaseAdded())
+                _cpu->GetRegister(instruction.Rn) += secondAddressValue;
             else
-                _cpu->GetRegister(instruction->GetBaseRegister()) -= secondAddressValue;
+                _cpu->GetRegister(instruction.Rn) -= secondAddressValue;
         }
     }
 
-    switch (instruction->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case ARM::ARMOpcodes::STRH:
         {
-            uint32_t writeVal = _cpu->GetRegister(instruction->GetRegister());
-            if (instruction->GetRegister() == PC)
+            uint32_t writeVal = _cpu->GetRegister(instruction.Rd);
+            if (instruction.Rd == PC)
                 writeVal += 4;
             _cpu->GetMemory()->WriteUInt16(address, writeVal & 0xFFFF);
             break;
         }
         case ARM::ARMOpcodes::LDRH:
-            _cpu->GetRegister(instruction->GetRegister()) = _cpu->GetMemory()->ReadUInt16(address);
+            _cpu->GetRegister(instruction.Rd) = _cpu->GetMemory()->LoadHalfword(address);
             break;
         case ARM::ARMOpcodes::LDRSH:
-            _cpu->GetRegister(instruction->GetRegister()) = (int16_t)_cpu->GetMemory()->ReadUInt16(address);
+            _cpu->GetRegister(instruction.Rd) = _cpu->GetMemory()->LoadSignedHalfword(address);
             break;
         case ARM::ARMOpcodes::LDRSB:
-            _cpu->GetRegister(instruction->GetRegister()) = (int8_t)_cpu->GetMemory()->ReadUInt8(address);
+            _cpu->GetRegister(instruction.Rd) = (int8_t)_cpu->GetMemory()->ReadUInt8(address);
             break;
         default:
             Utilities::Assert(false, "Load/Store instruction is not yet supported");
@@ -397,41 +467,31 @@ void Interpreter::HandleARMMiscellaneousLoadStoreInstruction(std::shared_ptr<ARM
     }
 }
 
-void Interpreter::HandleARMPSROperationInstruction(std::shared_ptr<ARMInstruction> instruction)
+void Interpreter::HandleARMPSROperationInstruction(DecodedInstruction const& instruction)
 {
-    if (!_cpu->ConditionPasses(instruction->GetCondition()))
+    if (!_cpu->ConditionPasses(instruction.Condition))
         return;
 
-    if (instruction->GetOpcode() == ARM::ARMOpcodes::MRS)
+    if (instruction.GetOpcode() == ARM::ARMOpcodes::MRS)
     {
-        auto mrs = std::static_pointer_cast<ARM::MovePSRToRegisterInstruction>(instruction);
-
-        if (mrs->GetPSRType() == ARM::PSRType::CPSR)
-            _cpu->GetRegister(mrs->GetDestinationRegister()) = _cpu->GetCurrentStatusRegister().Full;
+        if (!instruction.UsesSavedPSR())
+            _cpu->GetRegister(instruction.Rd) = _cpu->GetCurrentStatusRegister().Full;
         else
-            _cpu->GetRegister(mrs->GetDestinationRegister()) = _cpu->GetSavedStatusRegister().Full;
+            _cpu->GetRegister(instruction.Rd) = _cpu->GetSavedStatusRegister().Full;
     }
     else
     {
         uint32_t operand = 0;
-        uint8_t fieldMask = 0;
-        ARM::PSRType psr;
+        // The decoder stores the fields mask of MSR in Rn
+        uint8_t fieldMask = instruction.Rn;
 
-        if (instruction->IsImmediate())
-        {
-            auto msr = std::static_pointer_cast<ARM::MoveRegisterToPSRImmediateInstruction>(instruction);
-            operand = MathHelper::RotateRight(uint32_t(msr->GetImmediateValue()), msr->GetImmediateShift() << 1);
-            fieldMask = msr->GetFieldsMask();
-            psr = msr->GetPSRType();
-        }
+        if (instruction.IsImmediate())
+            operand = instruction.Immediate;
         else
         {
-            auto msr = std::static_pointer_cast<ARM::MoveRegisterToPSRRegisterInstruction>(instruction);
-            operand = _cpu->GetRegister(msr->GetSourceRegister());
-            fieldMask = msr->GetFieldsMask();
-            psr = msr->GetPSRType();
+            operand = _cpu->GetRegister(instruction.Rm);
 
-            if (msr->GetSourceRegister() == PC)
+            if (instruction.Rm == PC)
                 operand += 4;
         }
 
@@ -449,7 +509,7 @@ void Interpreter::HandleARMPSROperationInstruction(std::shared_ptr<ARMInstructio
 
         uint32_t mask = 0;
 
-        if (psr == ARM::PSRType::CPSR)
+        if (!instruction.UsesSavedPSR())
         {
             if (_cpu->IsInPrivilegedMode())
             {
@@ -464,7 +524,7 @@ void Interpreter::HandleARMPSROperationInstruction(std::shared_ptr<ARMInstructio
             else
                 mask = byteMask & BitMaskConstants::UserMask;
 
-            _cpu->GetCurrentStatusRegister().Full = (_cpu->GetCurrentStatusRegister().Full & ~mask) | (operand & mask);
+            _cpu->SetCurrentStatusRegister((_cpu->GetCurrentStatusRegister().Full & ~mask) | (operand & mask));
         }
         else
         {
@@ -475,44 +535,43 @@ void Interpreter::HandleARMPSROperationInstruction(std::shared_ptr<ARMInstructio
     }
 }
 
-void Interpreter::HandleARMMultiplyInstruction(std::shared_ptr<ARMInstruction> instruction)
+void Interpreter::HandleARMMultiplyInstruction(DecodedInstruction const& instruction)
 {
-    if (!_cpu->ConditionPasses(instruction->GetCondition()))
+    if (!_cpu->ConditionPasses(instruction.Condition))
         return;
 
-    auto mul = std::static_pointer_cast<ARM::MultiplyAccumulateInstruction>(instruction);
-    GeneralPurposeRegister& firstOp = _cpu->GetRegister(mul->GetFirstOperand());
-    GeneralPurposeRegister& secondOp = _cpu->GetRegister(mul->GetSecondOperand());
+    GeneralPurposeRegister& firstOp = _cpu->GetRegister(instruction.Rm);
+    GeneralPurposeRegister& secondOp = _cpu->GetRegister(instruction.Rs);
 
     int64_t result = firstOp * secondOp;
 
-    if (!mul->IsSigned())
+    if (!instruction.IsSigned())
         result = std::abs(result);
 
     int64_t added = 0;
 
-    if (mul->IsLong())
-        added = (_cpu->GetRegister(mul->GetDestinationRegisterHigh()) << 31) | _cpu->GetRegister(mul->GetDestinationRegisterLow());
+    if (instruction.IsLong())
+        added = (_cpu->GetRegister(instruction.Rd) << 31) | _cpu->GetRegister(instruction.Rn);
     else
-        added = _cpu->GetRegister(mul->GetThirdOperand());
+        added = _cpu->GetRegister(instruction.Rn);
 
-    if (mul->Accumulate())
+    if (instruction.Accumulate())
         result += added;
 
     uint32_t lower = MathHelper::GetBits(result, 0, 32);
     uint32_t higher = MathHelper::GetBits(result, 32, 32);
 
-    if (!mul->IsLong())
-        _cpu->GetRegister(mul->GetDestinationRegisterHigh()) = lower;
+    if (!instruction.IsLong())
+        _cpu->GetRegister(instruction.Rd) = lower;
     else
     {
-        _cpu->GetRegister(mul->GetDestinationRegisterLow()) = lower;
-        _cpu->GetRegister(mul->GetDestinationRegisterHigh()) = higher;
+        _cpu->GetRegister(instruction.Rn) = lower;
+        _cpu->GetRegister(instruction.Rd) = higher;
     }
 
-    if (mul->SetConditionCodes())
+    if (instruction.SetConditionCodes())
     {
-        if (mul->IsLong())
+        if (instruction.IsLong())
         {
             _cpu->GetCurrentStatusFlags().Z = lower == 0 && higher == 0;
             _cpu->GetCurrentStatusFlags().N = MathHelper::CheckBit(higher, 31);
@@ -526,39 +585,40 @@ void Interpreter::HandleARMMultiplyInstruction(std::shared_ptr<ARMInstruction> i
     }
 }
 
-void Interpreter::HandleARMLoadStoreMultipleInstruction(std::shared_ptr<ARMInstruction> instr)
+void Interpreter::HandleARMLoadStoreMultipleInstruction(DecodedInstruction const& instruction)
 {
-    auto instruction = std::static_pointer_cast<ARM::LoadStoreInstruction>(instr);
+    if (!_cpu->ConditionPasses(instruction.Condition))
+        return;
 
-    uint16_t registers = instruction->GetRegistersList();
+    uint16_t registers = instruction.Immediate;
     uint32_t startAddress = 0;
     uint32_t endAddress = 0;
 
     // Indicates how the memory will be loaded
-    if (instruction->IsBaseAdded())
+    if (instruction.IsBaseAdded())
     {
-        startAddress = _cpu->GetRegister(instruction->GetBaseRegister());
+        startAddress = _cpu->GetRegister(instruction.Rn);
 
-        if (instruction->GetBaseRegister() == PC)
+        if (instruction.Rn == PC)
             startAddress += 4;
 
         endAddress = startAddress + MathHelper::NumberOfSetBits(registers) * 4;
 
-        if (!instruction->IsPreIndexed())
+        if (!instruction.IsPreIndexed())
             endAddress -= 4;
         else
             startAddress += 4;
     }
     else
     {
-        endAddress = _cpu->GetRegister(instruction->GetBaseRegister());
+        endAddress = _cpu->GetRegister(instruction.Rn);
 
-        if (instruction->GetBaseRegister() == PC)
+        if (instruction.Rn == PC)
             endAddress += 4;
 
         startAddress = endAddress - MathHelper::NumberOfSetBits(registers) * 4;
 
-        if (!instruction->IsPreIndexed())
+        if (!instruction.IsPreIndexed())
             startAddress += 4;
         else
             endAddress -= 4;
@@ -570,8 +630,9 @@ void Interpreter::HandleARMLoadStoreMultipleInstruction(std::shared_ptr<ARMInstr
         // If the bit is set, load the data into the register
         if (MathHelper::CheckBit(registers, i))
         {
-            if (instruction->IsLoad())
-                _cpu->GetRegister(i) = _cpu->GetMemory()->ReadUInt32(currentAddress);
+            // Block transfers ignore the low bits of the address instead of rotating like LDR
+            if (instruction.IsLoad())
+                _cpu->GetRegister(i) = _cpu->GetMemory()->ReadUInt32(currentAddress & ~3);
             else
             {
                 uint32_t val = _cpu->GetRegister(i);
@@ -583,11 +644,11 @@ void Interpreter::HandleARMLoadStoreMultipleInstruction(std::shared_ptr<ARMInstr
         }
     }
 
-    if (instruction->WriteBack() && _cpu->ConditionPasses(instruction->GetCondition()))
+    if (instruction.WriteBack())
     {
-        if (instruction->IsBaseAdded())
-            _cpu->GetRegister(instruction->GetBaseRegister()) += MathHelper::NumberOfSetBits(registers) * 4;
+        if (instruction.IsBaseAdded())
+            _cpu->GetRegister(instruction.Rn) += MathHelper::NumberOfSetBits(registers) * 4;
         else
-            _cpu->GetRegister(instruction->GetBaseRegister()) -= MathHelper::NumberOfSetBits(registers) * 4;
+            _cpu->GetRegister(instruction.Rn) -= MathHelper::NumberOfSetBits(registers) * 4;
     }
 }
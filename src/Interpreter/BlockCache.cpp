@@ -0,0 +1,169 @@
+#include "BlockCache.hpp"
+#include "CPU/CPU.hpp"
+#include "Decoder/InstructionCache.hpp"
+#include "Common/MathHelper.hpp"
+
+BlockCache::BlockCache(CPU* cpu) : _cpu(cpu)
+{
+}
+
+bool BlockCache::IsCacheable(uint32_t address)
+{
+    // The BIOS can't be written, every other region is kept up to date by the InstructionCache invalidations
+    return (address & 0x0F000000) == 0 || InstructionCache::IsCacheable(address);
+}
+
+bool BlockCache::EndsBlock(DecodedInstruction const& instruction)
+{
+    switch (instruction.Format)
+    {
+        case InstructionFormat::ARMBranch:
+        case InstructionFormat::ARMBranchLinkExchangeImmediate:
+        case InstructionFormat::ARMBranchLinkExchangeRegister:
+        case InstructionFormat::ARMMoveRegisterToPSRImmediate: // Can change the CPU mode
+        case InstructionFormat::ARMMoveRegisterToPSRRegister:
+        case InstructionFormat::ThumbBranchExchange:
+        case InstructionFormat::ThumbConditionalBranch:
+        case InstructionFormat::ThumbUnconditionalBranch:
+        case InstructionFormat::ARMSoftwareInterrupt: // Enters the BIOS or halts the CPU
+        case InstructionFormat::ThumbSoftwareInterrupt:
+            return true;
+        case InstructionFormat::ARMDataProcessing:
+            return instruction.Rd == PC;
+        case InstructionFormat::ARMLoadStore:
+            if (instruction.Handler == InstructionHandler::ARMLoadStoreMultiple)
+                return (instruction.IsLoad() && MathHelper::CheckBit(instruction.Immediate, PC)) || MathHelper::CheckBit(instruction.Encoding, 22); // S bit
+            return (instruction.IsLoad() && instruction.Rd == PC) || (instruction.WriteBack() && instruction.Rn == PC);
+        case InstructionFormat::ARMMiscellaneousLoadStore:
+            return (instruction.IsLoad() && instruction.Rd == PC) || (instruction.WriteBack() && instruction.Rn == PC);
+        case InstructionFormat::ThumbSpecialDataProcessing:
+            return instruction.Rd == PC;
+        case InstructionFormat::ThumbStackOperation:
+            return instruction.IsLoad() && MathHelper::CheckBit(instruction.Immediate, 8); // POP {PC}
+        case InstructionFormat::ThumbLongBranchLink:
+            return instruction.Link(); // Only the second half jumps
+        default:
+            break;
+    }
+
+    return false;
+}
+
+BlockCache::Page* BlockCache::GetPage(uint32_t address, bool create)
+{
+    std::vector<std::unique_ptr<Page>>& region = _regions[(address & 0x0F000000) >> 24];
+
+    if (region.empty())
+    {
+        if (!create)
+            return nullptr;
+
+        region.resize(PAGES_PER_REGION);
+    }
+
+    std::unique_ptr<Page>& page = region[(address & 0x00FFFFFF) >> PAGE_SHIFT];
+
+    if (!page && create)
+        page = std::unique_ptr<Page>(new Page());
+
+    return page.get();
+}
+
+std::unique_ptr<Block> BlockCache::Build(InstructionSet set, uint32_t address)
+{
+    std::unique_ptr<Block> block(new Block());
+    block->Address = address;
+    block->Set = set;
+    block->Valid = true;
+
+    uint32_t size = set == InstructionSet::ARM ? 4 : 2;
+    uint32_t pageEnd = (address & ~uint32_t(PAGE_SIZE - 1)) + PAGE_SIZE;
+
+    for (uint32_t current = address; current < pageEnd && block->Instructions.size() < MAX_BLOCK_SIZE; current += size)
+    {
+        DecodedInstruction instruction = _cpu->GetInstructionCache()->Fetch(set, current);
+
+        // Unknown instructions are left to the single stepping path, which reports them
+        if (!instruction.IsValid())
+            break;
+
+        Block::Entry entry = { instruction, _cpu->GetInterpreter()->GetHandler(instruction) };
+        block->Instructions.push_back(entry);
+
+        if (EndsBlock(instruction))
+            break;
+    }
+
+    if (block->Instructions.empty())
+        return nullptr;
+
+    return block;
+}
+
+Block* BlockCache::Lookup(InstructionSet set, uint32_t address)
+{
+    // None of the retired blocks can be running anymore
+    _retired.clear();
+
+    if (!IsCacheable(address))
+        return nullptr;
+
+    // A block runs the same from any mirror of the work RAMs, the PC is only advanced
+    address = MMU::GetCanonicalAddress(address);
+    Page* page = GetPage(address, true);
+    uint32_t offset = address & (PAGE_SIZE - 1);
+
+    std::unique_ptr<Block>& entry = set == InstructionSet::ARM ? page->ARM[offset >> 2] : page->Thumb[offset >> 1];
+
+    if (entry)
+    {
+        ++_statistics.Hits;
+        return entry.get();
+    }
+
+    ++_statistics.Misses;
+    entry = Build(set, address);
+    return entry.get();
+}
+
+void BlockCache::Retire(std::unique_ptr<Page>& page)
+{
+    ++_statistics.Invalidations;
+
+    // Tell the CPU to stop running any of these blocks
+    for (auto& block : page->ARM)
+        if (block)
+            block->Valid = false;
+
+    for (auto& block : page->Thumb)
+        if (block)
+            block->Valid = false;
+
+    _retired.push_back(std::move(page));
+}
+
+void BlockCache::Invalidate(uint32_t address)
+{
+    address = MMU::GetCanonicalAddress(address);
+    std::vector<std::unique_ptr<Page>>& region = _regions[(address & 0x0F000000) >> 24];
+
+    if (region.empty())
+        return;
+
+    std::unique_ptr<Page>& page = region[(address & 0x00FFFFFF) >> PAGE_SHIFT];
+
+    if (page)
+        Retire(page);
+}
+
+void BlockCache::Flush()
+{
+    for (auto& region : _regions)
+    {
+        for (auto& page : region)
+            if (page)
+                Retire(page);
+
+        region.clear();
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include "Common/Instructions/DecodedInstruction.hpp"
+#include "Interpreter/Interpreter.hpp"
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class CPU;
+
+// A run of instructions that ends at the first one that may write the PC.
+// Every instruction is stored along with its interpreter handler, so running the block needs no decoding nor dispatching.
+struct Block
+{
+    struct Entry
+    {
+        DecodedInstruction Instruction;
+        Interpreter::HandlerFunction Handler; // nullptr if the instruction is not implemented yet
+    };
+
+    uint32_t Address;
+    InstructionSet Set;
+    bool Valid; // Cleared when the code of the block is overwritten
+    std::vector<Entry> Instructions;
+};
+
+struct BlockCacheStatistics
+{
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+    uint64_t Invalidations = 0;
+};
+
+// Keeps the basic blocks used by the cached interpreter, indexed by their start address and instruction set.
+// Blocks never cross a page, when the InstructionCache sees a write to cached code it drops every block of that page.
+class BlockCache final
+{
+public:
+    BlockCache(CPU* cpu);
+
+    // Returns the block starting at the specified address, building it the first time.
+    // Returns nullptr if the code there can't be cached, the caller must run it one instruction at a time
+    Block* Lookup(InstructionSet set, uint32_t address);
+
+    void Invalidate(uint32_t address);
+    void Flush();
+
+    static bool IsCacheable(uint32_t address);
+
+    // Whether the instruction may change the PC, the instruction set or the CPU mode
+    static bool EndsBlock(DecodedInstruction const& instruction);
+
+    BlockCacheStatistics const& GetStatistics() const { return _statistics; }
+
+private:
+    enum CacheData
+    {
+        PAGE_SHIFT = 12,
+        PAGE_SIZE = 1 << PAGE_SHIFT, // 4 KBytes
+        PAGES_PER_REGION = 0x1000000 >> PAGE_SHIFT,
+        NUM_REGIONS = 0x10,
+        MAX_BLOCK_SIZE = 64 // Keeps the peripherals from falling too far behind in long straight runs of code
+    };
+
+    struct Page
+    {
+        std::array<std::unique_ptr<Block>, PAGE_SIZE / 4> ARM;
+        std::array<std::unique_ptr<Block>, PAGE_SIZE / 2> Thumb;
+    };
+
+    Page* GetPage(uint32_t address, bool create);
+    std::unique_ptr<Block> Build(InstructionSet set, uint32_t address);
+    void Retire(std::unique_ptr<Page>& page);
+
+    CPU* _cpu;
+    std::array<std::vector<std::unique_ptr<Page>>, NUM_REGIONS> _regions;
+    // Pages invalidated by a store, the CPU may still be running one of their blocks so they are only freed on the next lookup
+    std::vector<std::unique_ptr<Page>> _retired;
+    BlockCacheStatistics _statistics;
+};
+
+#endif
@@ -2,12 +2,6 @@
 
 #include "CPU/CPU.hpp"
 
-#include "Common/Instructions/ARMInstruction.hpp"
-#include "Common/Instructions/ThumbInstruction.hpp"
-
-#include "Common/Instructions/Thumb/MiscInstructions.hpp"
-#include "Common/Instructions/Thumb/DataProcessingInstructions.hpp"
-
 #include "Common/MathHelper.hpp"
 #include "Common/Utilities.hpp"
 
@@ -16,34 +10,56 @@ Interpreter::Interpreter(CPU* arm) : _cpu(arm)
     InitializeHandlers();
 }
 
-void Interpreter::RunInstruction(std::shared_ptr<Instruction> instruction)
+void Interpreter::RunInstruction(DecodedInstruction const& instruction)
 {
-    if (instruction->GetInstructionSet() == InstructionSet::ARM)
-        HandleARM(std::static_pointer_cast<ARMInstruction>(instruction));
-    else if (instruction->GetInstructionSet() == InstructionSet::Thumb)
-        HandleThumb(std::static_pointer_cast<ThumbInstruction>(instruction));
+    if (instruction.GetInstructionSet() == InstructionSet::ARM)
+        HandleARM(instruction);
+    else if (instruction.GetInstructionSet() == InstructionSet::Thumb)
+        HandleThumb(instruction);
     else
         Utilities::Assert(false, "Invalid instruction set");
 }
 
-void Interpreter::HandleARM(std::shared_ptr<ARMInstruction> instruction)
+void Interpreter::HandleARM(DecodedInstruction const& instruction)
 {
-    auto handler = _armHandlers.find(ARM::ARMOpcodes(instruction->GetOpcode()));
+    // The decoder already picked the specialized handler for data processing instructions
+    if (instruction.Handler == InstructionHandler::ARMDataProcessing)
+    {
+        (this->*DataProcessingHandlers[instruction.Variant])(instruction);
+        return;
+    }
+
+    HandlerFunction handler = _armHandlers[instruction.GetOpcode()];
 
-    if (handler != _armHandlers.end())
-        handler->second(instruction);
+    if (handler != nullptr)
+        (this->*handler)(instruction);
 }
 
-void Interpreter::HandleThumb(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumb(DecodedInstruction const& instruction)
 {
-    auto handler = _thumbHandlers.find(Thumb::ThumbOpcodes(instruction->GetOpcode()));
+    HandlerFunction handler = _thumbHandlers[instruction.GetOpcode()];
 
-    if (handler != _thumbHandlers.end())
-        handler->second(instruction);
+    if (handler != nullptr)
+        (this->*handler)(instruction);
+}
+
+Interpreter::HandlerFunction Interpreter::GetHandler(DecodedInstruction const& instruction) const
+{
+    if (instruction.GetInstructionSet() == InstructionSet::Thumb)
+        return _thumbHandlers[instruction.GetOpcode()];
+
+    if (instruction.Handler == InstructionHandler::ARMDataProcessing)
+        return DataProcessingHandlers[instruction.Variant];
+
+    return _armHandlers[instruction.GetOpcode()];
 }
 
 void Interpreter::InitializeHandlers()
 {
+    // Opcodes without a handler are ignored
+    _armHandlers.fill(nullptr);
+    _thumbHandlers.fill(nullptr);
+
     InitializeArm();
     InitializeThumb();
 }
@@ -51,140 +67,131 @@ void Interpreter::InitializeHandlers()
 void Interpreter::InitializeArm()
 {
     // Branch Instructions
-    _armHandlers[ARM::ARMOpcodes::B] = std::bind(&Interpreter::HandleARMBranchInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::BL] = std::bind(&Interpreter::HandleARMBranchInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::BX] = std::bind(&Interpreter::HandleARMBranchInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::BLX] = std::bind(&Interpreter::HandleARMBranchInstruction, this, std::placeholders::_1);
-
-    // Data Processing Instructions
-    _armHandlers[ARM::ARMOpcodes::AND] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::EOR] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::SUB] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::RSB] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::ADD] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::ADC] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::SBC] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::RSC] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::TST] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::TEQ] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::CMP] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::CMN] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::ORR] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::MOV] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::BIC] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::MVN] = std::bind(&Interpreter::HandleARMDataProcessingInstruction, this, std::placeholders::_1);
+    _armHandlers[ARM::ARMOpcodes::B] = &Interpreter::HandleARMBranchInstruction;
+    _armHandlers[ARM::ARMOpcodes::BL] = &Interpreter::HandleARMBranchInstruction;
+    _armHandlers[ARM::ARMOpcodes::BX] = &Interpreter::HandleARMBranchInstruction;
+    _armHandlers[ARM::ARMOpcodes::BLX] = &Interpreter::HandleARMBranchInstruction;
+
+    // Data Processing Instructions are not in this table, they are dispatched through DataProcessingHandlers
 
     // Load / Store instructions
-    _armHandlers[ARM::ARMOpcodes::LDR] = std::bind(&Interpreter::HandleARMLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::LDRB] = std::bind(&Interpreter::HandleARMLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::LDRBT] = std::bind(&Interpreter::HandleARMLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::STR] = std::bind(&Interpreter::HandleARMLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::STRB] = std::bind(&Interpreter::HandleARMLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::STRBT] = std::bind(&Interpreter::HandleARMLoadStoreInstruction, this, std::placeholders::_1);
+    _armHandlers[ARM::ARMOpcodes::LDR] = &Interpreter::HandleARMLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::LDRB] = &Interpreter::HandleARMLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::LDRBT] = &Interpreter::HandleARMLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::STR] = &Interpreter::HandleARMLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::STRB] = &Interpreter::HandleARMLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::STRBT] = &Interpreter::HandleARMLoadStoreInstruction;
 
     // Miscellaneous Load / Store instructions
-    _armHandlers[ARM::ARMOpcodes::STRH] = std::bind(&Interpreter::HandleARMMiscellaneousLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::LDRH] = std::bind(&Interpreter::HandleARMMiscellaneousLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::LDRSH] = std::bind(&Interpreter::HandleARMMiscellaneousLoadStoreInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::LDRSB] = std::bind(&Interpreter::HandleARMMiscellaneousLoadStoreInstruction, this, std::placeholders::_1);
+    _armHandlers[ARM::ARMOpcodes::STRH] = &Interpreter::HandleARMMiscellaneousLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::LDRH] = &Interpreter::HandleARMMiscellaneousLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::LDRSH] = &Interpreter::HandleARMMiscellaneousLoadStoreInstruction;
+    _armHandlers[ARM::ARMOpcodes::LDRSB] = &Interpreter::HandleARMMiscellaneousLoadStoreInstruction;
 
     // Not Yet Implemented
-    _armHandlers[ARM::ARMOpcodes::LDM] = std::bind(&Interpreter::HandleARMLoadStoreMultipleInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::STM] = std::bind(&Interpreter::HandleARMLoadStoreMultipleInstruction, this, std::placeholders::_1);
+    _armHandlers[ARM::ARMOpcodes::LDM] = &Interpreter::HandleARMLoadStoreMultipleInstruction;
+    _armHandlers[ARM::ARMOpcodes::STM] = &Interpreter::HandleARMLoadStoreMultipleInstruction;
 
     // PSR Operations
-    _armHandlers[ARM::ARMOpcodes::MRS] = std::bind(&Interpreter::HandleARMPSROperationInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::MSR] = std::bind(&Interpreter::HandleARMPSROperationInstruction, this, std::placeholders::_1);
+    _armHandlers[ARM::ARMOpcodes::MRS] = &Interpreter::HandleARMPSROperationInstruction;
+    _armHandlers[ARM::ARMOpcodes::MSR] = &Interpreter::HandleARMPSROperationInstruction;
 
     // Multiply and Multiply Accumulate
-    _armHandlers[ARM::ARMOpcodes::MUL] = std::bind(&Interpreter::HandleARMMultiplyInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::MLA] = std::bind(&Interpreter::HandleARMMultiplyInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::SMLAL] = std::bind(&Interpreter::HandleARMMultiplyInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::SMULL] = std::bind(&Interpreter::HandleARMMultiplyInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::UMLAL] = std::bind(&Interpreter::HandleARMMultiplyInstruction, this, std::placeholders::_1);
-    _armHandlers[ARM::ARMOpcodes::UMULL] = std::bind(&Interpreter::HandleARMMultiplyInstruction, this, std::placeholders::_1);
+    _armHandlers[ARM::ARMOpcodes::MUL] = &Interpreter::HandleARMMultiplyInstruction;
+    _armHandlers[ARM::ARMOpcodes::MLA] = &Interpreter::HandleARMMultiplyInstruction;
+    _armHandlers[ARM::ARMOpcodes::SMLAL] = &Interpreter::HandleARMMultiplyInstruction;
+    _armHandlers[ARM::ARMOpcodes::SMULL] = &Interpreter::HandleARMMultiplyInstruction;
+    _armHandlers[ARM::ARMOpcodes::UMLAL] = &Interpreter::HandleARMMultiplyInstruction;
+    _armHandlers[ARM::ARMOpcodes::UMULL] = &Interpreter::HandleARMMultiplyInstruction;
+
+    // Software Interrupt
+    _armHandlers[ARM::ARMOpcodes::SWI] = &Interpreter::HandleARMSoftwareInterruptInstruction;
 }
 
 void Interpreter::InitializeThumb()
 {
     // Stack operations
-    _thumbHandlers[Thumb::ThumbOpcodes::PUSH] = std::bind(&Interpreter::HandleThumbStackOperationInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::POP] = std::bind(&Interpreter::HandleThumbStackOperationInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::PUSH] = &Interpreter::HandleThumbStackOperationInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::POP] = &Interpreter::HandleThumbStackOperationInstruction;
 
     // Immediate Shift operations
-    _thumbHandlers[Thumb::ThumbOpcodes::LSL_1] = std::bind(&Interpreter::HandleThumbImmediateShiftInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LSR_1] = std::bind(&Interpreter::HandleThumbImmediateShiftInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::ASR_1] = std::bind(&Interpreter::HandleThumbImmediateShiftInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::LSL_1] = &Interpreter::HandleThumbImmediateShiftInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LSR_1] = &Interpreter::HandleThumbImmediateShiftInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::ASR_1] = &Interpreter::HandleThumbImmediateShiftInstruction;
 
     // Add/Substract Register/Immediate operations
-    _thumbHandlers[Thumb::ThumbOpcodes::ADD_1] = std::bind(&Interpreter::HandleThumbAddSubImmRegInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::ADD_3] = std::bind(&Interpreter::HandleThumbAddSubImmRegInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::SUB_1] = std::bind(&Interpreter::HandleThumbAddSubImmRegInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::SUB_3] = std::bind(&Interpreter::HandleThumbAddSubImmRegInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::ADD_1] = &Interpreter::HandleThumbAddSubImmRegInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::ADD_3] = &Interpreter::HandleThumbAddSubImmRegInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::SUB_1] = &Interpreter::HandleThumbAddSubImmRegInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::SUB_3] = &Interpreter::HandleThumbAddSubImmRegInstruction;
 
     // Add/Sub/Cmp/Mov Immediate operations
-    _thumbHandlers[Thumb::ThumbOpcodes::ADD_2] = std::bind(&Interpreter::HandleThumbAddCmpMovSubImmediateInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::SUB_2] = std::bind(&Interpreter::HandleThumbAddCmpMovSubImmediateInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::MOV_1] = std::bind(&Interpreter::HandleThumbAddCmpMovSubImmediateInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::CMP_1] = std::bind(&Interpreter::HandleThumbAddCmpMovSubImmediateInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::ADD_2] = &Interpreter::HandleThumbAddCmpMovSubImmediateInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::SUB_2] = &Interpreter::HandleThumbAddCmpMovSubImmediateInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::MOV_1] = &Interpreter::HandleThumbAddCmpMovSubImmediateInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::CMP_1] = &Interpreter::HandleThumbAddCmpMovSubImmediateInstruction;
 
     // Data Processing Register operations
-    _thumbHandlers[Thumb::ThumbOpcodes::AND] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::EOR] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LSL_2] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LSR_2] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::ASR_2] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::ADC] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::SBC] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::ROR] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::TST] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::NEG] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::CMP_2] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::CMN] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::ORR] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::MUL] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::BIC] = std::bind(&Interpreter::HandleThumbDataProcessingInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::AND] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::EOR] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LSL_2] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LSR_2] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::ASR_2] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::ADC] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::SBC] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::ROR] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::TST] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::NEG] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::CMP_2] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::CMN] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::ORR] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::MUL] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::BIC] = &Interpreter::HandleThumbDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::MVN] = &Interpreter::HandleThumbDataProcessingInstruction;
 
     // Special Data Processing Register operations
-    _thumbHandlers[Thumb::ThumbOpcodes::ADD_4] = std::bind(&Interpreter::HandleThumbSpecialDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::CMP_3] = std::bind(&Interpreter::HandleThumbSpecialDataProcessingInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::MOV_3] = std::bind(&Interpreter::HandleThumbSpecialDataProcessingInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::ADD_4] = &Interpreter::HandleThumbSpecialDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::CMP_3] = &Interpreter::HandleThumbSpecialDataProcessingInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::MOV_3] = &Interpreter::HandleThumbSpecialDataProcessingInstruction;
 
     // Branch/Exchange Instruction operations
-    _thumbHandlers[Thumb::ThumbOpcodes::BX] = std::bind(&Interpreter::HandleThumbBranchExchangeInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::BLX_2] = std::bind(&Interpreter::HandleThumbBranchExchangeInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::B_CONDITIONAL] = std::bind(&Interpreter::HandleThumbBranchInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::B_UNCONDITIONAL] = std::bind(&Interpreter::HandleThumbBranchInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::BX] = &Interpreter::HandleThumbBranchExchangeInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::BLX_2] = &Interpreter::HandleThumbBranchExchangeInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::B_CONDITIONAL] = &Interpreter::HandleThumbBranchInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::B_UNCONDITIONAL] = &Interpreter::HandleThumbBranchInstruction;
 
     // Long Branch operation
-    _thumbHandlers[Thumb::ThumbOpcodes::BL] = std::bind(&Interpreter::HandleThumbBranchLinkInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::BL] = &Interpreter::HandleThumbBranchLinkInstruction;
 
     // Load from literal pool operation
-    _thumbHandlers[Thumb::ThumbOpcodes::LDR_3] = std::bind(&Interpreter::HandleThumbLiteralPoolLoadInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::LDR_3] = &Interpreter::HandleThumbLiteralPoolLoadInstruction;
 
     // Load/Store Register Offset operation
-    _thumbHandlers[Thumb::ThumbOpcodes::LDR_2] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDRSB] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDRSH] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDRH_2] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDRB_2] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STR_2] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STRB_2] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STRH_2] = std::bind(&Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::LDR_2] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDRSB] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDRSH] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDRH_2] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDRB_2] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STR_2] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STRB_2] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STRH_2] = &Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction;
 
     // Load/Store Immediate Offset operation
-    _thumbHandlers[Thumb::ThumbOpcodes::LDRB_1] = std::bind(&Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDR_1] = std::bind(&Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STRB_1] = std::bind(&Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STR_1] = std::bind(&Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDRH_1] = std::bind(&Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STRH_1] = std::bind(&Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::LDRB_1] = &Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDR_1] = &Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STRB_1] = &Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STR_1] = &Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDRH_1] = &Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STRH_1] = &Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction;
 
     // Load/Store Word/Byte/Halfword Immediate Offset operation
-    _thumbHandlers[Thumb::ThumbOpcodes::LDR_4] = std::bind(&Interpreter::HandleThumbLoadStoreStackInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::STR_3] = std::bind(&Interpreter::HandleThumbLoadStoreStackInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::LDR_4] = &Interpreter::HandleThumbLoadStoreStackInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::STR_3] = &Interpreter::HandleThumbLoadStoreStackInstruction;
 
     // Load/Store Multiple operation
-    _thumbHandlers[Thumb::ThumbOpcodes::STMIA] = std::bind(&Interpreter::HandleThumbLoadStoreMultipleInstruction, this, std::placeholders::_1);
-    _thumbHandlers[Thumb::ThumbOpcodes::LDMIA] = std::bind(&Interpreter::HandleThumbLoadStoreMultipleInstruction, this, std::placeholders::_1);
+    _thumbHandlers[Thumb::ThumbOpcodes::STMIA] = &Interpreter::HandleThumbLoadStoreMultipleInstruction;
+    _thumbHandlers[Thumb::ThumbOpcodes::LDMIA] = &Interpreter::HandleThumbLoadStoreMultipleInstruction;
+
+    // Software Interrupt
+    _thumbHandlers[Thumb::ThumbOpcodes::SWI] = &Interpreter::HandleThumbSoftwareInterruptInstruction;
 }
\ No newline at end of file
@@ -1,54 +1,70 @@
 #ifndef INTERPRETER_HPP
 #define INTERPRETER_HPP
 
-#include "Common/Instructions/ARMInstruction.hpp"
-#include "Common/Instructions/ThumbInstruction.hpp"
+#include "Common/Instructions/DecodedInstruction.hpp"
+#include "Common/Utilities.hpp"
 
-#include <memory>
-#include <functional>
-#include <unordered_map>
+#include <array>
 
 class CPU;
 
 class Interpreter
 {
 public:
+    typedef void (Interpreter::*HandlerFunction)(DecodedInstruction const&);
+
     Interpreter(CPU* arm);
 
-    void RunInstruction(std::shared_ptr<Instruction> instruction);
+    void RunInstruction(DecodedInstruction const& instruction);
     
-    void HandleARM(std::shared_ptr<ARMInstruction> instruction);
-    void HandleThumb(std::shared_ptr<ThumbInstruction> instruction);
+    void HandleARM(DecodedInstruction const& instruction);
+    void HandleThumb(DecodedInstruction const& instruction);
+
+    // The handler RunInstruction would call for the instruction, nullptr if it is not implemented
+    HandlerFunction GetHandler(DecodedInstruction const& instruction) const;
     
     // ARM Instruction handlers
-    void HandleARMBranchInstruction(std::shared_ptr<ARMInstruction> instruction);
-    void HandleARMDataProcessingInstruction(std::shared_ptr<ARMInstruction> instruction);
-    void HandleARMLoadStoreInstruction(std::shared_ptr<ARMInstruction> instruction);
-    void HandleARMMiscellaneousLoadStoreInstruction(std::shared_ptr<ARMInstruction> instruction);
-    void HandleARMPSROperationInstruction(std::shared_ptr<ARMInstruction> instruction);
-    void HandleARMMultiplyInstruction(std::shared_ptr<ARMInstruction> instruction);
-    void HandleARMLoadStoreMultipleInstruction(std::shared_ptr<ARMInstruction> instruction);
+    void HandleARMBranchInstruction(DecodedInstruction const& instruction);
+    void HandleARMDataProcessingInstruction(DecodedInstruction const& instruction); // Forwards to the specialized handler in instruction.Variant
+    void HandleARMLoadStoreInstruction(DecodedInstruction const& instruction);
+    void HandleARMMiscellaneousLoadStoreInstruction(DecodedInstruction const& instruction);
+    void HandleARMPSROperationInstruction(DecodedInstruction const& instruction);
+    void HandleARMMultiplyInstruction(DecodedInstruction const& instruction);
+    void HandleARMLoadStoreMultipleInstruction(DecodedInstruction const& instruction);
+    void HandleARMSoftwareInterruptInstruction(DecodedInstruction const& instruction);
 
     // Thumb Instruction handlers
-    void HandleThumbStackOperationInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbImmediateShiftInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbAddSubImmRegInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbAddCmpMovSubImmediateInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbDataProcessingInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbSpecialDataProcessingInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbBranchExchangeInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbBranchLinkInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbBranchInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbLiteralPoolLoadInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbLoadStoreRegisterOffsetInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbLoadStoreImmediateOffsetInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbLoadStoreStackInstruction(std::shared_ptr<ThumbInstruction> instruction);
-    void HandleThumbLoadStoreMultipleInstruction(std::shared_ptr<ThumbInstruction> instruction);
+    void HandleThumbStackOperationInstruction(DecodedInstruction const& instruction);
+    void HandleThumbImmediateShiftInstruction(DecodedInstruction const& instruction);
+    void HandleThumbAddSubImmRegInstruction(DecodedInstruction const& instruction);
+    void HandleThumbAddCmpMovSubImmediateInstruction(DecodedInstruction const& instruction);
+    void HandleThumbDataProcessingInstruction(DecodedInstruction const& instruction);
+    void HandleThumbSpecialDataProcessingInstruction(DecodedInstruction const& instruction);
+    void HandleThumbBranchExchangeInstruction(DecodedInstruction const& instruction);
+    void HandleThumbBranchLinkInstruction(DecodedInstruction const& instruction);
+    void HandleThumbBranchInstruction(DecodedInstruction const& instruction);
+    void HandleThumbLiteralPoolLoadInstruction(DecodedInstruction const& instruction);
+    void HandleThumbLoadStoreRegisterOffsetInstruction(DecodedInstruction const& instruction);
+    void HandleThumbLoadStoreImmediateOffsetInstruction(DecodedInstruction const& instruction);
+    void HandleThumbLoadStoreStackInstruction(DecodedInstruction const& instruction);
+    void HandleThumbLoadStoreMultipleInstruction(DecodedInstruction const& instruction);
+    void HandleThumbSoftwareInterruptInstruction(DecodedInstruction const& instruction);
 
 private:
+    // One of these is generated for every data processing variant, so the common paths have no runtime checks left
+    template <ARM::DataProcessingOperation Operation, OperandForm Form, ARM::ShiftType Shift, bool SetConditionCodes>
+    void HandleARMDataProcessing(DecodedInstruction const& instruction);
+
+    template <std::size_t... Variants>
+    static std::array<HandlerFunction, ARM::DATA_PROCESSING_VARIANTS> MakeDataProcessingHandlers(Utilities::IndexSequence<Variants...>);
+
+    static std::array<HandlerFunction, ARM::DATA_PROCESSING_VARIANTS> const DataProcessingHandlers;
+
     CPU* _cpu;
-    std::unordered_map<ARM::ARMOpcodes, std::function<void(std::shared_ptr<ARMInstruction>)>, std::hash<int>> _armHandlers;
-    std::unordered_map<Thumb::ThumbOpcodes, std::function<void(std::shared_ptr<ThumbInstruction>)>, std::hash<int>> _thumbHandlers;
+
+    // Indexed directly by the opcode, so dispatching an instruction is a single load and an indirect call
+    std::array<HandlerFunction, ARM::OPCODE_COUNT> _armHandlers;
+    std::array<HandlerFunction, Thumb::OPCODE_COUNT> _thumbHandlers;
     void InitializeHandlers();
     void InitializeArm();
     void InitializeThumb();
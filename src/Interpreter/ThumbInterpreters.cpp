@@ -3,24 +3,15 @@
 #include "CPU/CPU.hpp"
 #include "Memory/Memory.hpp"
 
-#include "Common/Instructions/ThumbInstruction.hpp"
-
-#include "Common/Instructions/Thumb/MiscInstructions.hpp"
-#include "Common/Instructions/Thumb/DataProcessingInstructions.hpp"
-#include "Common/Instructions/Thumb/BranchExchangeInstruction.hpp"
-#include "Common/Instructions/Thumb/LoadStoreInstructions.hpp"
-
 #include "Common/MathHelper.hpp"
 #include "Common/Utilities.hpp"
 
 // Sections: A7.1.49, A7.1.50
 //! TODO: CP15_reg1_Ubit vodoo - what is that?
-void Interpreter::HandleThumbStackOperationInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbStackOperationInstruction(DecodedInstruction const& instruction)
 {
-    auto stackOperation = std::static_pointer_cast<Thumb::StackOperation>(instruction);
-
-    uint32_t registersSet = stackOperation->GetRegisterMask(); // Includes R (bit 7)
-    if (stackOperation->IsPopOperand())
+    uint32_t registersSet = instruction.Immediate; // Includes R (bit 7)
+    if (instruction.IsLoad())
     {
         // MemoryAccess(B-bit, E-bit)
         uint32_t startAddress = _cpu->GetRegister(SP);
@@ -31,13 +22,14 @@ void Interpreter::HandleThumbStackOperationInstruction(std::shared_ptr<ThumbInst
         {
             if ((registersSet & (1 << i)) == 0)
                 continue;
-            _cpu->GetRegister(i) = _cpu->GetMemory()->ReadUInt32(address);
+            // Block transfers ignore the low bits of the address instead of rotating like LDR
+            _cpu->GetRegister(i) = _cpu->GetMemory()->ReadUInt32(address & ~3);
             address += 4;
         }
 
         if ((registersSet & (1 << 8)) != 0)
         {
-            uint32_t value = _cpu->GetMemory()->ReadUInt32(address);
+            uint32_t value = _cpu->GetMemory()->ReadUInt32(address & ~3);
             _cpu->GetRegister(PC) = value & 0xFFFFFFFE;
             address += 4;
         }
@@ -75,338 +67,277 @@ void Interpreter::HandleThumbStackOperationInstruction(std::shared_ptr<ThumbInst
 }
 
 // Sections: A7.1.38, A7.1.40, A7.1.12
-void Interpreter::HandleThumbImmediateShiftInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbImmediateShiftInstruction(DecodedInstruction const& instruction)
 {
-    auto shiftInstr = std::static_pointer_cast<Thumb::ImmediateShiftInstruction>(instruction);
-
-    GeneralPurposeRegister Rm = _cpu->GetRegister(shiftInstr->GetSourceRegister());
+    uint32_t Rm = _cpu->GetRegister(instruction.Rm);
     
     // Account for prefetching
-    if (shiftInstr->GetSourceRegister() == PC)
+    if (instruction.Rm == PC)
         Rm += 2;
 
-    GeneralPurposeRegister& Rd = _cpu->GetRegister(shiftInstr->GetDestinationRegister());
-    uint32_t Imm = shiftInstr->GetOffset();
+    uint32_t Imm = instruction.Immediate;
+    bool carry = _cpu->GetCarryFlag();
+    uint32_t result = Rm;
 
-    switch (shiftInstr->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::LSL_1:
         {
-            Rd = Rm << Imm;
-            if (shiftInstr->GetOffset() != 0)
-                _cpu->GetCurrentStatusFlags().C = Rm[32 - Imm];
+            if (Imm != 0)
+            {
+                carry = MathHelper::CheckBit(Rm, 32 - Imm);
+                result = Rm << Imm;
+            }
             break;
         }
         case Thumb::ThumbOpcodes::LSR_1:
         {
-            _cpu->GetCurrentStatusFlags().C = Rm[Imm == 0 ? 31 : (Imm - 1)];
-            Rd = Imm == 0 ? 0 : (Rm << Imm);
+            // An immediate of 0 encodes a shift by 32
+            carry = MathHelper::CheckBit(Rm, Imm == 0 ? 31 : (Imm - 1));
+            result = Imm == 0 ? 0 : (Rm >> Imm);
             break;
         }
         case Thumb::ThumbOpcodes::ASR_1:
         {
-            _cpu->GetCurrentStatusFlags().C = Rm[Imm == 0 ? 31 : (Imm - 1)];
-            Rd = (Imm == 0) ? (Rm[31] == 0 ? 0 : 0xFFFFFFFF) : (int32_t(uint32_t(Rm)) >> Imm);
+            carry = MathHelper::CheckBit(Rm, Imm == 0 ? 31 : (Imm - 1));
+            result = (Imm == 0) ? (carry ? 0xFFFFFFFF : 0) : uint32_t(int32_t(Rm) >> Imm);
             break;
         }
     }
-    _cpu->GetCurrentStatusFlags().N = Rd[31];
-    _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+
+    _cpu->SetLogicalFlags(result, carry);
+    _cpu->GetRegister(instruction.Rd) = result;
 }
 
 // Sections: A7.1.3, A7.1.5, A7.1.65, A7.1.67
-void Interpreter::HandleThumbAddSubImmRegInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbAddSubImmRegInstruction(DecodedInstruction const& instruction)
 {
-    auto instr = std::static_pointer_cast<Thumb::AddSubInstruction>(instruction);
-    GeneralPurposeRegister& Rd = _cpu->GetRegister(instr->GetDestinationRegister());
-    GeneralPurposeRegister Rn = _cpu->GetRegister(instr->GetSourceRegister());
+    uint32_t Rn = _cpu->GetRegister(instruction.Rn);
     
-    if (instr->GetSourceRegister() == PC)
+    if (instruction.Rn == PC)
         Rn += 2;
 
-    uint32_t Rm = instr->IsImmediate() ?
-                instr->GetThirdOperand() : // Imm
-                _cpu->GetRegister(instr->GetThirdOperand()); // Rm
+    uint32_t Rm = instruction.IsImmediate() ?
+                instruction.Immediate : // Imm
+                _cpu->GetRegister(instruction.Rm); // Rm
 
-    if (!instr->IsImmediate() && instr->GetThirdOperand() == PC)
+    if (!instruction.IsImmediate() && instruction.Rm == PC)
         Rm += 2;
 
-    switch (instr->GetOpcode())
+    uint32_t result = 0;
+
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::ADD_1:
         case Thumb::ThumbOpcodes::ADD_3:
-            Rd = Rn + Rm;
-            _cpu->GetCurrentStatusFlags().C = Rd.Carry;
+            result = Rn + Rm;
+            _cpu->SetArithmeticFlags(LazyFlags::Addition, Rn, Rm, false, result);
             break;
         case Thumb::ThumbOpcodes::SUB_1:
         case Thumb::ThumbOpcodes::SUB_3:
-            Rd = Rn - Rm;
-            _cpu->GetCurrentStatusFlags().C = !Rd.Borrow;
+            result = Rn - Rm;
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, Rn, Rm, true, result);
             break;
-
     }
-    _cpu->GetCurrentStatusFlags().V = Rd.Overflow;
-    _cpu->GetCurrentStatusFlags().N = Rd[31];
-    _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+
+    _cpu->GetRegister(instruction.Rd) = result;
 }
 
 // Sections: A7.1.42, A7.1.21, A7.1.4, A7.1.66
-void Interpreter::HandleThumbAddCmpMovSubImmediateInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbAddCmpMovSubImmediateInstruction(DecodedInstruction const& instruction)
 {
-    auto realInstr = std::static_pointer_cast<Thumb::AddSubCmpMovImmInstruction>(instruction);
-
-    GeneralPurposeRegister Rd = _cpu->GetRegister(realInstr->GetDestinationRegister());
-    if (realInstr->GetDestinationRegister() == PC)
+    uint32_t Rd = _cpu->GetRegister(instruction.Rd);
+    if (instruction.Rd == PC)
         Rd += 2;
 
-    uint32_t Imm = realInstr->GetImmediate();
+    uint32_t Imm = instruction.Immediate;
+    uint32_t result = 0;
 
-    switch (realInstr->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::MOV_1:
-            Rd = Imm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            result = Imm;
+            _cpu->SetLogicalFlags(result, _cpu->GetCarryFlag());
             break;
         case Thumb::ThumbOpcodes::CMP_1: // Rd is actually Rn here
-        {
-            int64_t aluOut = int64_t(uint32_t(Rd)) - Imm;
-            _cpu->GetCurrentStatusFlags().N = (aluOut >> 31) & 1;
-            _cpu->GetCurrentStatusFlags().Z = aluOut == 0;
-            _cpu->GetCurrentStatusFlags().C = !MathHelper::BorrowFrom(Rd, Imm);
-            _cpu->GetCurrentStatusFlags().V = MathHelper::Overflow<uint32_t>(aluOut);
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, Rd, Imm, true, Rd - Imm);
             return; // Don't update Rd
-        }
         case Thumb::ThumbOpcodes::ADD_2:
-            Rd += Imm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
-            _cpu->GetCurrentStatusFlags().C = Rd.Carry;
-            _cpu->GetCurrentStatusFlags().V = Rd.Overflow;
+            result = Rd + Imm;
+            _cpu->SetArithmeticFlags(LazyFlags::Addition, Rd, Imm, false, result);
             break;
         case Thumb::ThumbOpcodes::SUB_2:
-            Rd -= Imm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
-            _cpu->GetCurrentStatusFlags().C = !Rd.Borrow;
-            _cpu->GetCurrentStatusFlags().V = Rd.Overflow;
+            result = Rd - Imm;
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, Rd, Imm, true, result);
             break;
     }
 
-    _cpu->GetRegister(realInstr->GetDestinationRegister()) = Rd;
+    _cpu->GetRegister(instruction.Rd) = result;
 }
 
 // Sections: A7.1.10, A7.1.26, A7.1.39, A7.1.41, A7.1.12, A7.1.2, A7.1.55
-//           A7.1.54, A7.1.72, A7.1.20, A7.1.22, A7.1.48, A7.1.45, A7.1.15
-void Interpreter::HandleThumbDataProcessingInstruction(std::shared_ptr<ThumbInstruction> instruction)
+//           A7.1.54, A7.1.72, A7.1.20, A7.1.22, A7.1.48, A7.1.45, A7.1.15, A7.1.47
+void Interpreter::HandleThumbDataProcessingInstruction(DecodedInstruction const& instruction)
 {
-    auto realInstr = std::static_pointer_cast<Thumb::DataProcessingInstruction>(instruction);
-    GeneralPurposeRegister Rd = _cpu->GetRegister(realInstr->GetFirstOperand());
-    GeneralPurposeRegister Rm = _cpu->GetRegister(realInstr->GetSecondOperand());
+    uint32_t Rd = _cpu->GetRegister(instruction.Rd);
+    uint32_t Rm = _cpu->GetRegister(instruction.Rm);
     
-    if (realInstr->GetFirstOperand() == PC)
+    if (instruction.Rd == PC)
         Rd += 2;
-    if (realInstr->GetSecondOperand() == PC)
+    if (instruction.Rm == PC)
         Rm += 2;
 
-    uint32_t opcode = realInstr->GetOpcode();
+    // The logical operations leave the carry flag alone unless they shift
+    bool carry = _cpu->GetCarryFlag();
+    uint32_t result = 0;
 
-    switch (opcode)
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::AND:
-            Rd &= Rm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            result = Rd & Rm;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         case Thumb::ThumbOpcodes::EOR:
-            Rd ^= Rm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            result = Rd ^ Rm;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         case Thumb::ThumbOpcodes::LSL_2: // Rm = Rs here
         {
-            uint8_t RsLoByte = Rm.GetBits(0, 8);
+            uint32_t RsLoByte = Rm & 0xFF;
+            result = Rd;
             if (RsLoByte != 0)
             {
-               if (RsLoByte <= 32)
-                   _cpu->GetCurrentStatusFlags().C = Rd[32 - RsLoByte];
-               else // if (RsLoByte > 32)
-                    _cpu->GetCurrentStatusFlags().C = 0;
-               Rd = RsLoByte < 32 ? (Rd << RsLoByte) : 0;
+                carry = RsLoByte <= 32 ? MathHelper::CheckBit(Rd, 32 - RsLoByte) : false;
+                result = RsLoByte < 32 ? (Rd << RsLoByte) : 0;
             }
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         }
         case Thumb::ThumbOpcodes::LSR_2: // Rm = Rs here
         {
-            uint8_t RsLoByte = Rm.GetBits(0, 8);
+            uint32_t RsLoByte = Rm & 0xFF;
+            result = Rd;
             if (RsLoByte != 0)
             {
-               if (RsLoByte < 32)
-                   _cpu->GetCurrentStatusFlags().C = Rd[RsLoByte - 1];
-               else // if (RsLoByte >= 32)
-                    _cpu->GetCurrentStatusFlags().C = (RsLoByte == 32) ? Rd[31] : 0;
-               Rd = RsLoByte < 32 ? (Rd >> RsLoByte) : 0;
+                if (RsLoByte < 32)
+                    carry = MathHelper::CheckBit(Rd, RsLoByte - 1);
+                else
+                    carry = RsLoByte == 32 ? MathHelper::CheckBit(Rd, 31) : false;
+                result = RsLoByte < 32 ? (Rd >> RsLoByte) : 0;
             }
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         }
         case Thumb::ThumbOpcodes::ASR_2: // Rm = Rs here
         {
-            uint8_t RsLoByte = Rm.GetBits(0, 8);
+            uint32_t RsLoByte = Rm & 0xFF;
+            result = Rd;
             if (RsLoByte != 0)
             {
-               if (RsLoByte < 32)
-               {
-                   _cpu->GetCurrentStatusFlags().C = Rd[RsLoByte - 1];
-                   Rd = (int32_t(Rd) >> RsLoByte);
-               }
-               else // if (RsLoByte >= 32)
-               {
-                    _cpu->GetCurrentStatusFlags().C = Rd[31];
-                    Rd = Rd[31] == 0 ? 0 : 0xFFFFFFFF;
-               }
+                if (RsLoByte < 32)
+                {
+                    carry = MathHelper::CheckBit(Rd, RsLoByte - 1);
+                    result = uint32_t(int32_t(Rd) >> RsLoByte);
+                }
+                else
+                {
+                    carry = MathHelper::CheckBit(Rd, 31);
+                    result = carry ? 0xFFFFFFFF : 0;
+                }
             }
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         }
         case Thumb::ThumbOpcodes::ADC:
-        {
-            uint64_t dirtySum = Rd;
-            if (!_cpu->GetCurrentStatusFlags().C)
-            {
-                dirtySum += Rm;
-                _cpu->GetCurrentStatusFlags().C = dirtySum < Rm;
-            }
-            else
-            {
-                dirtySum += Rm + 1;
-                _cpu->GetCurrentStatusFlags().C = dirtySum <= Rm;
-            }
-            Rd = dirtySum;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
-            _cpu->GetCurrentStatusFlags().V = MathHelper::Overflow<uint32_t>(dirtySum);
+            result = Rd + Rm + carry;
+            _cpu->SetArithmeticFlags(LazyFlags::Addition, Rd, Rm, carry, result);
             break;
-        }
         case Thumb::ThumbOpcodes::SBC:
-        {
-            Rd -= Rm + !_cpu->GetCurrentStatusFlags().C;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
-            _cpu->GetCurrentStatusFlags().C = !Rd.Borrow;
-            _cpu->GetCurrentStatusFlags().V = Rd.Overflow;
+            result = Rd - Rm - !carry;
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, Rd, Rm, carry, result);
             break;
-        }
         case Thumb::ThumbOpcodes::ROR: // Rm = Rs here
         {
-            uint8_t RsLoByte = Rm.GetBits(0, 8);
+            uint32_t RsLoByte = Rm & 0xFF;
+            uint32_t rotation = Rm & 0x1F;
+            result = Rd;
             if (RsLoByte != 0)
             {
-                if (Rm.GetBits(0, 5) == 0)
-                    _cpu->GetCurrentStatusFlags().C = Rd[31];
-                else // if (Rm.GetBits(0, 5) > 0) { Rs[4:0] }
+                if (rotation == 0)
+                    carry = MathHelper::CheckBit(Rd, 31);
+                else
                 {
-                    // ROR is stored in the LSB.
-                    _cpu->GetCurrentStatusFlags().C = Rd[Rm.GetBits(0, 4) - 1];
-                    Rd = MathHelper::RotateRight(Rd, Rm.GetBits(0, 4));
+                    carry = MathHelper::CheckBit(Rd, rotation - 1);
+                    result = MathHelper::RotateRight(Rd, rotation);
                 }
             }
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         }
         case Thumb::ThumbOpcodes::TST:
-        {
-            int32_t aluOut = Rd & Rm;
-            _cpu->GetCurrentStatusFlags().N = aluOut & (1 << 31);
-            _cpu->GetCurrentStatusFlags().Z = aluOut == 0;
-            // Don't update the Rn register
-            return;
-        }
+            _cpu->SetLogicalFlags(Rd & Rm, carry);
+            return; // Don't update the Rn register
         case Thumb::ThumbOpcodes::NEG:
-        {
-            Rd = 0 - Rm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
-            _cpu->GetCurrentStatusFlags().C = !Rd.Borrow; //! TODO Doublecheck
-            _cpu->GetCurrentStatusFlags().Z = Rd.Overflow;
+            result = 0 - Rm;
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, 0, Rm, true, result);
             break;
-        }
-        case Thumb::ThumbOpcodes::CMN: // Rd is actually Rn here
         case Thumb::ThumbOpcodes::CMP_2: // Rd is actually Rn here
-        {
-            int32_t aluOut = (opcode == Thumb::ThumbOpcodes::CMN) ? (Rd + Rm) : (Rd - Rm);
-            _cpu->GetCurrentStatusFlags().N = aluOut & (1 << 31);
-            _cpu->GetCurrentStatusFlags().Z = aluOut == 0;
-            _cpu->GetCurrentStatusFlags().V = MathHelper::Overflow<uint32_t>(aluOut);
-            if (opcode == Thumb::ThumbOpcodes::CMP_2)
-                _cpu->GetCurrentStatusFlags().C = !MathHelper::BorrowFrom(Rd, Rm);
-            else
-                _cpu->GetCurrentStatusFlags().C = MathHelper::CarryFrom(Rd, Rm);
-            // Don't update the Rn register
-            return;
-        }
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, Rd, Rm, true, Rd - Rm);
+            return; // Don't update the Rn register
+        case Thumb::ThumbOpcodes::CMN: // Rd is actually Rn here
+            _cpu->SetArithmeticFlags(LazyFlags::Addition, Rd, Rm, false, Rd + Rm);
+            return; // Don't update the Rn register
         case Thumb::ThumbOpcodes::ORR:
-            Rd |= Rm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            result = Rd | Rm;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         case Thumb::ThumbOpcodes::MUL:
-            Rd *= Rm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            // C is UNPREDICTABLE on ARMv4, we leave it as it was
+            result = Rd * Rm;
+            _cpu->SetLogicalFlags(result, carry);
             break;
         case Thumb::ThumbOpcodes::BIC:
-            Rd &= ~Rm;
-            _cpu->GetCurrentStatusFlags().N = Rd[31];
-            _cpu->GetCurrentStatusFlags().Z = Rd == 0;
+            result = Rd & ~Rm;
+            _cpu->SetLogicalFlags(result, carry);
+            break;
+        case Thumb::ThumbOpcodes::MVN:
+            result = ~Rm;
+            _cpu->SetLogicalFlags(result, carry);
             break;
     }
 
-    _cpu->GetRegister(realInstr->GetFirstOperand()) = Rd;
+    _cpu->GetRegister(instruction.Rd) = result;
 }
 
 // Sections: A7.1.6, A7.1.23, A7.1.44
 //! TODO: UNPREDICTABLE if MOV and both lo registers.
-void Interpreter::HandleThumbSpecialDataProcessingInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbSpecialDataProcessingInstruction(DecodedInstruction const& instruction)
 {
-    auto realInstr = std::static_pointer_cast<Thumb::SpecialDataProcessingInstruction>(instruction);
-
-    GeneralPurposeRegister Rd = _cpu->GetRegister(realInstr->GetDestinationRegister());
-    GeneralPurposeRegister Rm = _cpu->GetRegister(realInstr->GetFirstDataRegister());
+    GeneralPurposeRegister Rd = _cpu->GetRegister(instruction.Rd);
+    GeneralPurposeRegister Rm = _cpu->GetRegister(instruction.Rm);
 
-    if (realInstr->GetDestinationRegister() == PC)
+    if (instruction.Rd == PC)
         Rd += 2;
 
-    if (realInstr->GetFirstDataRegister() == PC)
+    if (instruction.Rm == PC)
         Rm += 2;
 
-    switch (realInstr->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::ADD_4:
-            if (realInstr->HiOperandFlagDestination() == 0
-                && realInstr->HiOperandFlagSource() == 0) // UNPREDICTABLE
+            if (instruction.Rd < 8
+                && instruction.Rm < 8) // UNPREDICTABLE
             {
                 // Fsck.
             }
             Rd += Rm;
             break;
         case Thumb::ThumbOpcodes::CMP_3:
-        {
-            uint32_t aluOut = Rd - Rm;
-            _cpu->GetCurrentStatusFlags().N = aluOut & (1 << 31);
-            _cpu->GetCurrentStatusFlags().Z = aluOut == 0;
-            _cpu->GetCurrentStatusFlags().C = !MathHelper::BorrowFrom(Rd, Rm);
-            _cpu->GetCurrentStatusFlags().V = MathHelper::Overflow<uint32_t>(aluOut);
-            break;
-        }
+            _cpu->SetArithmeticFlags(LazyFlags::Subtraction, Rd, Rm, true, Rd - Rm);
+            return; // Don't update Rd
         case Thumb::ThumbOpcodes::MOV_3:
-            if (realInstr->HiOperandFlagDestination() == 0
-                && realInstr->HiOperandFlagSource() == 0) // UNPREDICTABLE
+            if (instruction.Rd < 8
+                && instruction.Rm < 8) // UNPREDICTABLE
             {
                 // Fsck.
             }
@@ -416,16 +347,14 @@ void Interpreter::HandleThumbSpecialDataProcessingInstruction(std::shared_ptr<Th
             break;
     }
 
-    _cpu->GetRegister(realInstr->GetDestinationRegister()) = Rd;
+    _cpu->GetRegister(instruction.Rd) = Rd;
 }
 
 // Sections: A7.1.19, A7.1.18
 //! TODO Fix BX (special case if Rm == R15!)
-void Interpreter::HandleThumbBranchExchangeInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbBranchExchangeInstruction(DecodedInstruction const& instruction)
 {
-    auto realInstr = std::static_pointer_cast<Thumb::BranchExchangeInstruction>(instruction);
-
-    GeneralPurposeRegister Rm = _cpu->GetRegister(realInstr->GetTargetAddressRegister());
+    GeneralPurposeRegister Rm = _cpu->GetRegister(instruction.Rm);
 
     // Register 15 can be specified for <Rm>. If this is done, R15
     // is read as normal for Thumb code, that is, it is the address
@@ -435,7 +364,7 @@ void Interpreter::HandleThumbBranchExchangeInstruction(std::shared_ptr<ThumbInst
     // BX instruction is not at a word-aligned address, this means
     // that the results of the instruction are UNPREDICTABLE
     // (because the value read for R15 has bits[1:0]==0b10).
-    if (realInstr->GetTargetAddressRegister() == PC)
+    if (instruction.Rm == PC)
     {
         // Increment the PC register value by 2 because the real GBA CPU uses Pre-fetching
         Rm += 2;
@@ -454,32 +383,29 @@ void Interpreter::HandleThumbBranchExchangeInstruction(std::shared_ptr<ThumbInst
 }
 
 // Section: A7.1.30
-void Interpreter::HandleThumbLiteralPoolLoadInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbLiteralPoolLoadInstruction(DecodedInstruction const& instruction)
 {
-    auto instr = std::static_pointer_cast<Thumb::LoadFromLiteralStoreInstruction>(instruction);
-    uint32_t address = ((_cpu->GetRegister(PC) + 2) & 0xFFFFFFFC) + instr->GetImmediate();
-    _cpu->GetRegister(instr->GetDestinationRegister()) = _cpu->GetMemory()->ReadUInt32(address);
+    uint32_t address = ((_cpu->GetRegister(PC) + 2) & 0xFFFFFFFC) + instruction.Immediate;
+    _cpu->GetRegister(instruction.Rd) = _cpu->GetMemory()->ReadUInt32(address);
 }
 
 // Sections: A7.1.29, A7.1.36, A7.1.37, A7.1.59, A7.1.62, A7.1.64, A7.1.35, A7.1.33
 //! TODO: Some of those have CP15_reg1_Ubit vodoo - Again, no idea what this is
 //! Also get rid of SignExtend - it just needs signed memory Read...
-void Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction(DecodedInstruction const& instruction)
 {
-    auto instr = std::static_pointer_cast<Thumb::LoadStoreRegisterOffsetInstruction>(instruction);
-
-    GeneralPurposeRegister Rd = _cpu->GetRegister(instr->GetDestinationRegister());
-    GeneralPurposeRegister Rn = _cpu->GetRegister(instr->GetFirstOperand());
-    GeneralPurposeRegister Rm = _cpu->GetRegister(instr->GetSecondOperand());
+    GeneralPurposeRegister Rd = _cpu->GetRegister(instruction.Rd);
+    GeneralPurposeRegister Rn = _cpu->GetRegister(instruction.Rn);
+    GeneralPurposeRegister Rm = _cpu->GetRegister(instruction.Rm);
     
-    if (instr->GetDestinationRegister() == PC)
+    if (instruction.Rd == PC)
         Rd += 2;
-    if (instr->GetFirstOperand() == PC)
+    if (instruction.Rn == PC)
         Rn += 2;
-    if (instr->GetSecondOperand() == PC)
+    if (instruction.Rm == PC)
         Rm += 2;
 
-    switch (instr->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::LDR_2:
             Rd = _cpu->GetMemory()->ReadUInt32(Rn + Rm);
@@ -488,7 +414,7 @@ void Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction(std::shared_ptr<
             Rd = SignExtend(_cpu->GetMemory()->ReadUInt8(Rn + Rm));
             break;
         case Thumb::ThumbOpcodes::LDRSH:
-            Rd = SignExtend(_cpu->GetMemory()->ReadUInt16(Rn + Rm));
+            Rd = _cpu->GetMemory()->LoadSignedHalfword(Rn + Rm);
             break;
         case Thumb::ThumbOpcodes::STR_2:
             _cpu->GetMemory()->WriteUInt32(Rn + Rm, Rd);
@@ -500,7 +426,7 @@ void Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction(std::shared_ptr<
             _cpu->GetMemory()->WriteUInt16(Rn + Rm, Rd.GetBits(0, 16));
             break;
         case Thumb::ThumbOpcodes::LDRH_2:
-            Rd = _cpu->GetMemory()->ReadUInt16(Rn + Rm); // ZeroPromote
+            Rd = _cpu->GetMemory()->LoadHalfword(Rn + Rm); // ZeroPromote
             break;
         case Thumb::ThumbOpcodes::LDRB_2:
             Rd = _cpu->GetMemory()->ReadUInt8(Rn + Rm); // ZeroPromote
@@ -509,76 +435,70 @@ void Interpreter::HandleThumbLoadStoreRegisterOffsetInstruction(std::shared_ptr<
             break;
     }
 
-    _cpu->GetRegister(instr->GetDestinationRegister()) = Rd;
+    _cpu->GetRegister(instruction.Rd) = Rd;
 }
 
 // Not verified
-void Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbLoadStoreImmediateOffsetInstruction(DecodedInstruction const& instruction)
 {
-    auto instr = std::static_pointer_cast<Thumb::LoadStoreImmediateInstruction>(instruction);
+    GeneralPurposeRegister Rd = _cpu->GetRegister(instruction.Rd);
+    GeneralPurposeRegister Rn = _cpu->GetRegister(instruction.Rn);
 
-    GeneralPurposeRegister Rd = _cpu->GetRegister(instr->GetDestinationRegister());
-    GeneralPurposeRegister Rn = _cpu->GetRegister(instr->GetBaseAddressRegister());
-
-    if (instr->GetDestinationRegister() == PC)
+    if (instruction.Rd == PC)
         Rd += 2;
-    if (instr->GetBaseAddressRegister() == PC)
+    if (instruction.Rn == PC)
         Rn += 2;
 
-    switch (instr->GetOpcode())
+    switch (instruction.GetOpcode())
     {
         case Thumb::ThumbOpcodes::LDRB_1:
-            Rd = _cpu->GetMemory()->ReadUInt8(Rn + instr->GetImmediate());
+            Rd = _cpu->GetMemory()->ReadUInt8(Rn + instruction.Immediate);
             break;
         case Thumb::ThumbOpcodes::LDR_1:
-            Rd = _cpu->GetMemory()->ReadUInt32(Rn + instr->GetImmediate());
+            Rd = _cpu->GetMemory()->ReadUInt32(Rn + instruction.Immediate);
             break;
         case Thumb::ThumbOpcodes::STRB_1:
-            _cpu->GetMemory()->WriteUInt8(Rn + instr->GetImmediate(), Rd);
+            _cpu->GetMemory()->WriteUInt8(Rn + instruction.Immediate, Rd);
             return; // Don't update the Rd register
         case Thumb::ThumbOpcodes::STR_1:
-            _cpu->GetMemory()->WriteUInt32(Rn + instr->GetImmediate(), Rd);
+            _cpu->GetMemory()->WriteUInt32(Rn + instruction.Immediate, Rd);
             return; // Don't update the Rd register
         case Thumb::ThumbOpcodes::LDRH_1:
-            Rd = _cpu->GetMemory()->ReadUInt16(Rn + instr->GetImmediate());
+            Rd = _cpu->GetMemory()->LoadHalfword(Rn + instruction.Immediate);
             break;
         case Thumb::ThumbOpcodes::STRH_1:
-            _cpu->GetMemory()->WriteUInt16(Rn + instr->GetImmediate(), Rd);
+            _cpu->GetMemory()->WriteUInt16(Rn + instruction.Immediate, Rd);
             return; // Don't update the Rd register
         default:
             break;
     }
 
-    _cpu->GetRegister(instr->GetDestinationRegister()) = Rd;
+    _cpu->GetRegister(instruction.Rd) = Rd;
 }
 
 // Sections: A7.1.31, A7.1.60
-void Interpreter::HandleThumbLoadStoreStackInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbLoadStoreStackInstruction(DecodedInstruction const& instruction)
 {
-    auto instr = std::static_pointer_cast<Thumb::LoadStoreStackInstruction>(instruction);
-
-    GeneralPurposeRegister& Rd = _cpu->GetRegister(instr->GetDestinationRegister());
+    GeneralPurposeRegister& Rd = _cpu->GetRegister(instruction.Rd);
 
-    if (instr->IsLoadOperation())
-        Rd = _cpu->GetMemory()->ReadUInt32(_cpu->GetRegister(SP) + instr->GetRelativeOffset());
+    if (instruction.IsLoad())
+        Rd = _cpu->GetMemory()->ReadUInt32(_cpu->GetRegister(SP) + instruction.Immediate);
     else
-        _cpu->GetMemory()->WriteUInt32(_cpu->GetRegister(SP) + instr->GetRelativeOffset(), Rd + (instr->GetDestinationRegister() == PC ? 2 : 0));
+        _cpu->GetMemory()->WriteUInt32(_cpu->GetRegister(SP) + instruction.Immediate, Rd + (instruction.Rd == PC ? 2 : 0));
 }
 
 // Section: A7.1.27, A7.1.57
-void Interpreter::HandleThumbLoadStoreMultipleInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbLoadStoreMultipleInstruction(DecodedInstruction const& instruction)
 {
-    auto instr = std::static_pointer_cast<Thumb::LoadStoreMultipleInstruction>(instruction);
-
-    if (instr->GetOpcode() == Thumb::ThumbOpcodes::LDMIA)
+    if (instruction.GetOpcode() == Thumb::ThumbOpcodes::LDMIA)
     {
-        uint32_t loadAddress = _cpu->GetRegister(instr->GetRegister());
-        if (instr->GetRegister() == PC)
+        uint32_t loadAddress = _cpu->GetRegister(instruction.Rn);
+        if (instruction.Rn == PC)
             loadAddress += 2;
 
         uint32_t address = loadAddress;
 
-        uint32_t registersMask = instr->GetRegisterList();
+        uint32_t registersMask = instruction.Immediate;
 
         bool writeBack = true;
 
@@ -591,10 +511,10 @@ void Interpreter::HandleThumbLoadStoreMultipleInstruction(std::shared_ptr<ThumbI
         {
             if ((registersMask & (1 << i)) == 1)
             {
-                _cpu->GetRegister(i) = _cpu->GetMemory()->ReadUInt32(address);
+                _cpu->GetRegister(i) = _cpu->GetMemory()->ReadUInt32(address & ~3);
                 address += 4;
 
-                if (i == instr->GetRegister())
+                if (i == instruction.Rn)
                     writeBack = false;
             }
         }
@@ -602,17 +522,17 @@ void Interpreter::HandleThumbLoadStoreMultipleInstruction(std::shared_ptr<ThumbI
         // the final value of <Rn> is the loaded value (not the written-back value).
 
         if (writeBack)
-            _cpu->GetRegister(instr->GetRegister()) = loadAddress + (MathHelper::NumberOfSetBits(registersMask) * 4);
+            _cpu->GetRegister(instruction.Rn) = loadAddress + (MathHelper::NumberOfSetBits(registersMask) * 4);
     }
-    else // if (instr->GetOpcode() == Thumb::ThumbOpcodes::STMIA)
+    else // if (instruction.GetOpcode() == Thumb::ThumbOpcodes::STMIA)
     {
-        uint32_t loadAddress = _cpu->GetRegister(instr->GetRegister());
-        if (instr->GetRegister() == PC)
+        uint32_t loadAddress = _cpu->GetRegister(instruction.Rn);
+        if (instruction.Rn == PC)
             loadAddress += 2;
 
         uint32_t address = loadAddress;
 
-        uint32_t registersMask = instr->GetRegisterList();
+        uint32_t registersMask = instruction.Immediate;
 
         bool writeBack = true;
 
@@ -628,7 +548,7 @@ void Interpreter::HandleThumbLoadStoreMultipleInstruction(std::shared_ptr<ThumbI
                 _cpu->GetMemory()->WriteUInt32(address, _cpu->GetRegister(i));
                 address += 4;
                 
-                if (i == instr->GetRegister())
+                if (i == instruction.Rn)
                 {
                     // Only if this register is the lowest-numbered one
                     if (loadAddress == address - 4)
@@ -642,31 +562,34 @@ void Interpreter::HandleThumbLoadStoreMultipleInstruction(std::shared_ptr<ThumbI
         }
 
         if (writeBack)
-            _cpu->GetRegister(instr->GetRegister()) = loadAddress + (MathHelper::NumberOfSetBits(registersMask) * 4);
+            _cpu->GetRegister(instruction.Rn) = loadAddress + (MathHelper::NumberOfSetBits(registersMask) * 4);
     }
 }
 
-void Interpreter::HandleThumbBranchLinkInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbBranchLinkInstruction(DecodedInstruction const& instruction)
 {
-    auto branch = std::static_pointer_cast<Thumb::LongBranchLinkInstruction>(instruction);
-    
     // If this is just the high part of the instruction, update the LR
-    if (!branch->IsTriggeringSubroutineCall())
-        _cpu->GetRegister(LR) = _cpu->GetRegister(PC) + 2 + (MathHelper::IntegerSignExtend<11, 32>(branch->GetOffset()) << 12);
+    // The decoder already sign extended and shifted the offset of both halves
+    if (!instruction.Link())
+        _cpu->GetRegister(LR) = _cpu->GetRegister(PC) + 2 + instruction.Immediate;
     else
     {
         uint32_t oldPC = _cpu->GetRegister(PC);
-        _cpu->GetRegister(PC) = _cpu->GetRegister(LR) + ((branch->GetOffset() & 0x7FF) << 1);
+        _cpu->GetRegister(PC) = _cpu->GetRegister(LR) + instruction.Immediate;
         _cpu->GetRegister(LR) = oldPC | 1;
     }
 }
 
-void Interpreter::HandleThumbBranchInstruction(std::shared_ptr<ThumbInstruction> instruction)
+void Interpreter::HandleThumbBranchInstruction(DecodedInstruction const& instruction)
 {
-    auto branch = std::static_pointer_cast<Thumb::BranchInstruction>(instruction);
-
-    if (branch->IsConditionalBranch() && !_cpu->ConditionPasses(InstructionCondition(branch->GetCondition())))
+    // Unconditional branches are decoded with the Always condition
+    if (!_cpu->ConditionPasses(instruction.Condition))
         return;
 
-    _cpu->GetRegister(PC) += branch->GetBranchOffset() + 2;
-}
\ No newline at end of file
+    _cpu->GetRegister(PC) += instruction.Immediate + 2;
+}
+
+void Interpreter::HandleThumbSoftwareInterruptInstruction(DecodedInstruction const& instruction)
+{
+    _cpu->SoftwareInterrupt(uint8_t(instruction.Immediate));
+}
@@ -0,0 +1,296 @@
+#include "JIT.hpp"
+
+#include "CPU/CPU.hpp"
+
+using namespace X64;
+
+bool JIT::IsARMCompiledNatively(DecodedInstruction const& instruction)
+{
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ARMBranch:
+            return instruction.Format == InstructionFormat::ARMBranch &&
+                (instruction.GetOpcode() == ARM::ARMOpcodes::B || instruction.GetOpcode() == ARM::ARMOpcodes::BL);
+        case InstructionHandler::ARMDataProcessing:
+            // Writing the PC ends the block and may return from an exception
+            return ARM::GetVariantForm(instruction.Variant) != OperandForm::RegisterShift && instruction.Rd != PC;
+        case InstructionHandler::ARMLoadStore:
+        {
+            switch (instruction.GetOpcode())
+            {
+                case ARM::ARMOpcodes::LDR:
+                case ARM::ARMOpcodes::LDRB:
+                case ARM::ARMOpcodes::LDRBT:
+                case ARM::ARMOpcodes::STR:
+                case ARM::ARMOpcodes::STRB:
+                case ARM::ARMOpcodes::STRBT:
+                    break;
+                default:
+                    return false;
+            }
+
+            if (instruction.Rd == PC || (instruction.WriteBack() && instruction.Rn == PC))
+                return false;
+
+            // Only plain and LSL scaled register offsets, the other shifts are rare in address computations
+            return instruction.IsImmediate() || (instruction.Shift == ARM::ShiftType::LSL && instruction.Rm != PC);
+        }
+        default:
+            break;
+    }
+
+    return false;
+}
+
+void JIT::CompileARM(DecodedInstruction const& instruction)
+{
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ARMBranch:
+        {
+            uint8_t* skip = CheckCondition(instruction.Condition);
+
+            if (instruction.Link())
+                StoreRegister(LR, _address + 4);
+
+            ExitBlock(_address + 8 + instruction.Immediate);
+
+            if (skip)
+                _emitter->SetJumpTarget(skip);
+            else
+                _ended = true;
+            break;
+        }
+        case InstructionHandler::ARMDataProcessing:
+            CompileARMDataProcessing(instruction);
+            break;
+        case InstructionHandler::ARMLoadStore:
+            CompileARMLoadStore(instruction);
+            break;
+        default:
+            Utilities::Assert(false, "The JIT can't compile this ARM instruction");
+            break;
+    }
+}
+
+void JIT::CompileARMDataProcessing(DecodedInstruction const& instruction)
+{
+    ARM::DataProcessingOperation operation = ARM::GetVariantOperation(instruction.Variant);
+    OperandForm form = ARM::GetVariantForm(instruction.Variant);
+    bool setFlags = ARM::GetVariantSetConditionCodes(instruction.Variant) && _flagsLive[_index];
+
+    bool logical = operation == ARM::DataProcessingOperation::AND || operation == ARM::DataProcessingOperation::EOR ||
+        operation == ARM::DataProcessingOperation::TST || operation == ARM::DataProcessingOperation::TEQ ||
+        operation == ARM::DataProcessingOperation::ORR || operation == ARM::DataProcessingOperation::MOV ||
+        operation == ARM::DataProcessingOperation::BIC || operation == ARM::DataProcessingOperation::MVN;
+
+    uint8_t* skip = CheckCondition(instruction.Condition);
+
+    // The second operand goes in R11, the shifter carry in R9
+    CarrySource carry = CarrySource::Unchanged;
+
+    if (form == OperandForm::Immediate)
+    {
+        _emitter->MOV(R11, instruction.Immediate);
+
+        // Rotated immediates set the carry to their highest bit
+        if (instruction.ShiftAmount)
+            carry = (instruction.Immediate >> 31) ? CarrySource::Set : CarrySource::Cleared;
+    }
+    else
+    {
+        LoadRegister(R11, instruction.Rm);
+
+        uint8_t amount = instruction.ShiftAmount;
+
+        switch (instruction.Shift)
+        {
+            case ARM::ShiftType::LSL:
+                if (amount != 0)
+                {
+                    _emitter->Shift(SHL, R11, amount);
+                    _emitter->SETcc(Carry, R9);
+                    carry = CarrySource::Shifter;
+                }
+                break;
+            case ARM::ShiftType::LSR:
+                if (amount == 0)
+                {
+                    // LSR #32, the carry is the highest bit
+                    _emitter->Shift(SHL, R11, 1);
+                    _emitter->SETcc(Carry, R9);
+                    _emitter->MOV(R11, uint32_t(0));
+                }
+                else
+                {
+                    _emitter->Shift(SHR, R11, amount);
+                    _emitter->SETcc(Carry, R9);
+                }
+                carry = CarrySource::Shifter;
+                break;
+            case ARM::ShiftType::ASR:
+                if (amount == 0)
+                {
+                    // ASR #32, every bit and the carry are copies of the sign
+                    _emitter->Shift(SAR, R11, 31);
+                    _emitter->TEST(R11, R11);
+                    _emitter->SETcc(Sign, R9);
+                }
+                else
+                {
+                    _emitter->Shift(SAR, R11, amount);
+                    _emitter->SETcc(Carry, R9);
+                }
+                carry = CarrySource::Shifter;
+                break;
+            case ARM::ShiftType::ROR:
+                if (amount == 0)
+                {
+                    // RRX, rotates the carry in
+                    LoadCarry(false);
+                    _emitter->Shift(RCR, R11, 1);
+                }
+                else
+                    _emitter->Shift(ROR, R11, amount);
+
+                _emitter->SETcc(Carry, R9);
+                carry = CarrySource::Shifter;
+                break;
+        }
+    }
+
+    if (operation != ARM::DataProcessingOperation::MOV && operation != ARM::DataProcessingOperation::MVN)
+        LoadRegister(R10, instruction.Rn);
+
+    // The result ends up in R10
+    bool invertCarry = false;
+
+    switch (operation)
+    {
+        case ARM::DataProcessingOperation::AND:
+        case ARM::DataProcessingOperation::TST:
+            _emitter->ALU(AND, R10, R11);
+            break;
+        case ARM::DataProcessingOperation::EOR:
+        case ARM::DataProcessingOperation::TEQ:
+            _emitter->ALU(XOR, R10, R11);
+            break;
+        case ARM::DataProcessingOperation::ORR:
+            _emitter->ALU(OR, R10, R11);
+            break;
+        case ARM::DataProcessingOperation::MOV:
+            _emitter->MOV(R10, R11);
+            break;
+        case ARM::DataProcessingOperation::BIC:
+            _emitter->NOT(R11);
+            _emitter->ALU(AND, R10, R11);
+            break;
+        case ARM::DataProcessingOperation::MVN:
+            _emitter->MOV(R10, R11);
+            _emitter->NOT(R10);
+            break;
+        case ARM::DataProcessingOperation::ADD:
+        case ARM::DataProcessingOperation::CMN:
+            _emitter->ALU(ADD, R10, R11);
+            break;
+        case ARM::DataProcessingOperation::ADC:
+            LoadCarry(false);
+            _emitter->ALU(ADC, R10, R11);
+            break;
+        case ARM::DataProcessingOperation::SUB:
+        case ARM::DataProcessingOperation::CMP:
+            _emitter->ALU(SUB, R10, R11);
+            invertCarry = true;
+            break;
+        case ARM::DataProcessingOperation::SBC:
+            LoadCarry(true);
+            _emitter->ALU(SBB, R10, R11);
+            invertCarry = true;
+            break;
+        case ARM::DataProcessingOperation::RSB:
+            _emitter->ALU(SUB, R11, R10);
+            _emitter->MOV(R10, R11);
+            invertCarry = true;
+            break;
+        case ARM::DataProcessingOperation::RSC:
+            LoadCarry(true);
+            _emitter->ALU(SBB, R11, R10);
+            _emitter->MOV(R10, R11);
+            invertCarry = true;
+            break;
+    }
+
+    if (setFlags)
+    {
+        if (logical)
+            StoreLogicalFlags(R10, carry);
+        else
+            StoreArithmeticFlags(invertCarry);
+    }
+
+    // The comparison opcodes only update the flags
+    if (operation < ARM::DataProcessingOperation::TST || operation > ARM::DataProcessingOperation::CMN)
+        StoreRegister(instruction.Rd, R10);
+
+    if (skip)
+        _emitter->SetJumpTarget(skip);
+}
+
+void JIT::CompileARMLoadStore(DecodedInstruction const& instruction)
+{
+    uint8_t* skip = CheckCondition(instruction.Condition);
+
+    AluOperation offsetOperation = instruction.IsBaseAdded() ? ADD : SUB;
+
+    // The base goes in R10, the register offset in R11
+    LoadRegister(R10, instruction.Rn);
+
+    if (!instruction.IsImmediate())
+    {
+        LoadRegister(R11, instruction.Rm);
+
+        if (instruction.ShiftAmount != 0)
+            _emitter->Shift(SHL, R11, instruction.ShiftAmount);
+    }
+
+    // Same order as the interpreter, the base is written back before the transfer
+    if (instruction.IsPreIndexed())
+    {
+        if (instruction.IsImmediate())
+            _emitter->ALU(offsetOperation, R10, instruction.Immediate);
+        else
+            _emitter->ALU(offsetOperation, R10, R11);
+
+        if (instruction.WriteBack())
+            StoreRegister(instruction.Rn, R10);
+    }
+    else if (instruction.WriteBack())
+    {
+        _emitter->MOV(RCX, R10);
+
+        if (instruction.IsImmediate())
+            _emitter->ALU(offsetOperation, RCX, instruction.Immediate);
+        else
+            _emitter->ALU(offsetOperation, RCX, R11);
+
+        StoreRegister(instruction.Rn, RCX);
+    }
+
+    _emitter->MOV(RSI, R10);
+
+    uint8_t size = instruction.IsByte() ? 1 : 4;
+
+    if (instruction.IsLoad())
+    {
+        CallMemoryRead(size, false);
+        StoreRegister(instruction.Rd, RAX);
+    }
+    else
+    {
+        LoadRegister(RDX, instruction.Rd);
+        CallMemoryWrite(size);
+    }
+
+    if (skip)
+        _emitter->SetJumpTarget(skip);
+}
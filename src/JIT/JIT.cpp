@@ -0,0 +1,823 @@
+#include "JIT.hpp"
+
+#include "CPU/CPU.hpp"
+#include "Memory/Memory.hpp"
+#include "Common/Utilities.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+using namespace X64;
+
+namespace
+{
+    // The generated code keeps these two pointers around, they are callee saved so calls into C++ preserve them
+    Register const STATE = R15;
+    Register const CONTEXT = R14;
+
+    // The ARM registers that live in host registers during a block, all of them callee saved as well
+    Register const AllocatableRegisters[] = { RBX, RBP, R12, R13 };
+
+    int32_t RegisterOffset(uint8_t reg)
+    {
+        return int32_t(offsetof(CPUState, Registers) + reg * sizeof(uint32_t));
+    }
+
+    int32_t const CPSR_OFFSET = int32_t(offsetof(CPUState, CPSR));
+    int32_t const DOWNCOUNT_OFFSET = int32_t(offsetof(JITContext, Downcount));
+    int32_t const PENDING_OFFSET = int32_t(offsetof(JITContext, Pending));
+    int32_t const INVALIDATED_OFFSET = int32_t(offsetof(JITContext, Invalidated));
+}
+
+JIT::JIT(CPU* cpu) : _cpu(cpu), _slice(0), _synced(0), _code(nullptr), _blockCode(nullptr), _enter(nullptr), _exit(nullptr), _block(nullptr)
+{
+    _context.Downcount = 0;
+    _context.Pending = 0;
+    _context.Invalidated = 0;
+    _context.Processor = cpu;
+    _context.Owner = this;
+
+#if JIT_SUPPORTED
+    void* code = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    Utilities::Assert(code != MAP_FAILED, "Could not allocate the JIT code buffer");
+
+    _code = static_cast<uint8_t*>(code);
+    _emitter = std::unique_ptr<X64Emitter>(new X64Emitter(_code, CODE_SIZE));
+
+    GenerateDispatcher();
+#endif
+}
+
+JIT::~JIT()
+{
+#if JIT_SUPPORTED
+    if (_code)
+        munmap(_code, CODE_SIZE);
+#endif
+}
+
+bool JIT::IsSupported()
+{
+    return JIT_SUPPORTED != 0;
+}
+
+void JIT::GenerateDispatcher()
+{
+    // void Enter(CPUState* state, JITContext* context, uint8_t const* code)
+    _enter = reinterpret_cast<EntryFunction>(_emitter->GetCode());
+
+    _emitter->PUSH(RBX);
+    _emitter->PUSH(RBP);
+    _emitter->PUSH(R12);
+    _emitter->PUSH(R13);
+    _emitter->PUSH(R14);
+    _emitter->PUSH(R15);
+    // Keep the stack 16 byte aligned for the calls into C++
+    _emitter->ALU64(SUB, RSP, 8);
+
+    _emitter->MOV64(STATE, RDI);
+    _emitter->MOV64(CONTEXT, RSI);
+    _emitter->JMP(RDX);
+
+    // Every block leaves through here, the PC is already stored
+    _exit = _emitter->GetCode();
+
+    _emitter->ALU64(ADD, RSP, 8);
+    _emitter->POP(R15);
+    _emitter->POP(R14);
+    _emitter->POP(R13);
+    _emitter->POP(R12);
+    _emitter->POP(RBP);
+    _emitter->POP(RBX);
+    _emitter->RET();
+
+    _blockCode = _emitter->GetCode();
+}
+
+uint32_t JIT::Run(uint32_t cycles)
+{
+    if (!_code)
+        return 0;
+
+    // The generated code reads and writes the flags straight from the CPSR
+    _cpu->MaterializeFlags();
+
+    _slice = cycles;
+    _synced = 0;
+    _context.Downcount = int32_t(cycles);
+    _context.Pending = 0;
+
+    while (_context.Downcount > 0 && !_cpu->IsHalted())
+    {
+        CompiledBlock* block = Lookup(_cpu->GetCurrentInstructionSet(), _cpu->GetRegister(PC));
+
+        if (!block)
+            break;
+
+        _context.Invalidated = 0;
+        _enter(&_cpu->GetState(), &_context, block->Entry);
+
+        // Blocks that loop on themselves come back here on every iteration, see ExitBlock
+        uint32_t last = block->Address + uint32_t(block->Instructions.size() - 1) * (block->Set == InstructionSet::ARM ? 4 : 2);
+        uint32_t target = _cpu->GetRegister(PC);
+
+        if (target <= last && _context.Downcount > 0 && !_cpu->IsHalted())
+        {
+            uint64_t now = _cpu->GetCycles() + (GetUsedCycles() - _synced);
+            uint64_t skip = _cpu->GetIdleLoopDetector()->Check(last, target, now, now + uint32_t(_context.Downcount));
+
+            _context.Downcount -= int32_t(skip);
+        }
+    }
+
+    // The memory accesses already added the cycles before them
+    uint32_t used = GetUsedCycles();
+    _cpu->AddCycles(used - _synced);
+
+    return used;
+}
+
+void JIT::SyncCycles()
+{
+    uint32_t elapsed = GetUsedCycles() - _context.Pending;
+
+    _cpu->AddCycles(elapsed - _synced);
+    _synced = elapsed;
+}
+
+void JIT::CheckEvents()
+{
+    // Like an immediate DMA, or an interrupt that got enabled
+    uint64_t now = _cpu->GetCycles();
+    uint64_t next = std::max(_cpu->GetScheduler()->GetNextEventTime(), now);
+
+    // Cycles until the end of the slice, a block can go past it
+    int64_t remaining = int64_t(_context.Pending) + _context.Downcount;
+
+    if (next - now >= uint64_t(std::max<int64_t>(remaining, _context.Pending)))
+        return;
+
+    // Leave the block after this instruction, and the slice at the time of the event
+    _context.Invalidated = 1;
+
+    if (int64_t(next - now) < remaining)
+    {
+        uint32_t early = uint32_t(remaining - int64_t(next - now));
+
+        _slice -= early;
+        _context.Downcount -= int32_t(early);
+    }
+}
+
+CompiledBlock* JIT::Lookup(InstructionSet set, uint32_t address)
+{
+    // The compiled code has its address built in, so each mirror of the work RAMs gets its own blocks.
+    // They are all kept in the page of the first mirror, a store through any of them invalidates every one
+    auto block = _blockMap.find(GetKey(set, address));
+
+    if (block != _blockMap.end())
+        return block->second;
+
+    if (!BlockCache::IsCacheable(address))
+        return nullptr;
+
+    // Start over when the buffer is almost full, nothing is running at this point
+    if (_emitter->GetRemaining() < MAX_BLOCK_CODE_SIZE)
+        Flush();
+
+    return Compile(set, address);
+}
+
+void JIT::Link(uint32_t key, uint8_t const* target)
+{
+    auto sites = _links.find(key);
+
+    if (sites == _links.end())
+        return;
+
+    // The jumps of invalidated blocks are never taken again, forget about them
+    std::vector<LinkSite>& list = sites->second;
+    list.erase(std::remove_if(list.begin(), list.end(), [](LinkSite const& site) { return !site.Owner->Valid; }), list.end());
+
+    for (LinkSite const& site : list)
+        X64Emitter::SetJumpTarget(site.Jump, target);
+}
+
+void JIT::Invalidate(uint32_t address)
+{
+    auto page = _pages.find(MMU::GetCanonicalAddress(address) >> PAGE_SHIFT);
+
+    if (page == _pages.end())
+        return;
+
+    ++_statistics.Invalidations;
+
+    for (CompiledBlock* block : page->second)
+    {
+        block->Valid = false;
+
+        uint32_t key = GetKey(block->Set, block->Address);
+        _blockMap.erase(key);
+
+        // The blocks that jump here go back through the dispatcher, which compiles the new code
+        Link(key, _exit);
+    }
+
+    _pages.erase(page);
+
+    // Stops the running block after the store, its code might have been overwritten
+    _context.Invalidated = 1;
+}
+
+void JIT::Flush()
+{
+    if (!_code)
+        return;
+
+    ++_statistics.Flushes;
+
+    _blockMap.clear();
+    _pages.clear();
+    _links.clear();
+    _blocks.clear();
+
+    _emitter = std::unique_ptr<X64Emitter>(new X64Emitter(_blockCode, CODE_SIZE - std::size_t(_blockCode - _code)));
+}
+
+CompiledBlock* JIT::Compile(InstructionSet set, uint32_t address)
+{
+    std::unique_ptr<CompiledBlock> block(new CompiledBlock());
+    block->Address = address;
+    block->Set = set;
+    block->Valid = true;
+
+    // Blocks end at the same places as the ones of the cached interpreter
+    uint32_t size = set == InstructionSet::ARM ? 4 : 2;
+    uint32_t pageEnd = (address & ~uint32_t((1 << PAGE_SHIFT) - 1)) + (1 << PAGE_SHIFT);
+    uint32_t cycles = 0;
+
+    for (uint32_t current = address; current < pageEnd && block->Instructions.size() < MAX_BLOCK_INSTRUCTIONS; current += size)
+    {
+        DecodedInstruction instruction = _cpu->GetInstructionCache()->Fetch(set, current);
+
+        if (!instruction.IsValid())
+            break;
+
+        Block::Entry entry = { instruction, _cpu->GetInterpreter()->GetHandler(instruction) };
+        block->Instructions.push_back(entry);
+        cycles += instruction.GetTiming();
+
+        if (BlockCache::EndsBlock(instruction))
+            break;
+    }
+
+    if (block->Instructions.empty())
+        return nullptr;
+
+    _block = block.get();
+    _instructionSize = size;
+
+    AllocateRegisters();
+    ComputeFlagLiveness();
+
+    block->Entry = _emitter->GetCode();
+
+    // Leave when the time slice is over, the dispatcher comes back here on the next one
+    _emitter->ALU(CMP, CONTEXT, DOWNCOUNT_OFFSET, 0);
+    uint8_t* run = _emitter->Jcc(Greater);
+    _emitter->Store(STATE, RegisterOffset(PC), address);
+    _emitter->JMP(_exit);
+    _emitter->SetJumpTarget(run);
+
+    _emitter->ALU(SUB, CONTEXT, DOWNCOUNT_OFFSET, std::max<uint32_t>(cycles, 1));
+
+    LoadAllocatedRegisters();
+    _dirty.reset();
+    _hasLinkRegister = false;
+    _ended = false;
+    _loads = false;
+    _stores = false;
+
+    for (std::size_t i = 0; i < block->Instructions.size(); ++i)
+        CompileInstruction(i);
+
+    // Fall through to the next instruction
+    if (!_ended)
+        ExitBlock(address + uint32_t(block->Instructions.size()) * size);
+
+    _statistics.CompiledBlocks++;
+
+    uint32_t key = GetKey(set, address);
+    _blockMap[key] = block.get();
+    _pages[MMU::GetCanonicalAddress(address) >> PAGE_SHIFT].push_back(block.get());
+    _blocks.push_back(std::move(block));
+
+    // Now the blocks that were waiting for this one can jump straight to it
+    Link(key, _blocks.back()->Entry);
+
+    _block = nullptr;
+    return _blocks.back().get();
+}
+
+void JIT::CompileInstruction(std::size_t index)
+{
+    DecodedInstruction const& instruction = _block->Instructions[index].Instruction;
+
+    _index = index;
+    _address = _block->Address + uint32_t(index) * _instructionSize;
+
+    // Only the instruction right after a BL prefix can use the value it left in LR
+    bool hadLinkRegister = _hasLinkRegister;
+
+    if (!IsCompiledNatively(instruction))
+        CompileInterpreterCall(index);
+    else if (_block->Set == InstructionSet::ARM)
+        CompileARM(instruction);
+    else
+        CompileThumb(instruction);
+
+    if (hadLinkRegister)
+        _hasLinkRegister = false;
+
+    _statistics.CompiledInstructions++;
+}
+
+void JIT::CompileInterpreterCall(std::size_t index)
+{
+    Block::Entry const& entry = _block->Instructions[index];
+
+    _statistics.InterpretedInstructions++;
+
+    // Only loads are known not to change anything but registers
+    if (entry.Instruction.IsLoad())
+        _loads = true;
+    else
+        _stores = true;
+
+    // The handler works on the registers in memory and expects the PC to point to the next instruction, like CPU::Step leaves it
+    WriteBackRegisters();
+    _dirty.reset();
+
+    _emitter->Store(STATE, RegisterOffset(PC), _address + _instructionSize);
+    StorePendingCycles();
+
+    _emitter->MOV64(RDI, CONTEXT);
+    _emitter->MOV64(RSI, uint64_t(&entry));
+    _emitter->MOV64(RAX, uint64_t(&JIT::RunInterpreter));
+    _emitter->CALL(RAX);
+
+    // The handler already set the PC
+    if (BlockCache::EndsBlock(entry.Instruction))
+    {
+        _emitter->JMP(_exit);
+        _ended = true;
+        return;
+    }
+
+    // Block transfers can overwrite code or schedule events too
+    _emitter->Load(RAX, CONTEXT, INVALIDATED_OFFSET);
+    _emitter->TEST(RAX, RAX);
+    uint8_t* valid = _emitter->Jcc(Zero);
+    RefundCycles();
+    _emitter->JMP(_exit);
+    _emitter->SetJumpTarget(valid);
+
+    LoadAllocatedRegisters();
+}
+
+bool JIT::IsCompiledNatively(DecodedInstruction const& instruction)
+{
+    if (instruction.GetInstructionSet() == InstructionSet::ARM)
+        return IsARMCompiledNatively(instruction);
+
+    return IsThumbCompiledNatively(instruction);
+}
+
+void JIT::AllocateRegisters()
+{
+    // Count how often each register shows up in the block, the most used ones get a host register
+    std::array<uint32_t, 16> uses = { };
+
+    for (Block::Entry const& entry : _block->Instructions)
+    {
+        DecodedInstruction const& instruction = entry.Instruction;
+
+        if (!IsCompiledNatively(instruction))
+            continue;
+
+        uses[instruction.Rd]++;
+        uses[instruction.Rn]++;
+        uses[instruction.Rm]++;
+    }
+
+    // The PC is always a constant
+    uses[PC] = 0;
+
+    _allocation.fill(-1);
+
+    for (int8_t host = 0; host < ALLOCATABLE_REGISTERS; ++host)
+    {
+        auto best = std::max_element(uses.begin(), uses.end());
+
+        // Loading and storing a register used only once costs more than it saves
+        if (*best < 2)
+            break;
+
+        _allocation[best - uses.begin()] = host;
+        *best = 0;
+    }
+}
+
+bool JIT::ReadsFlags(DecodedInstruction const& instruction)
+{
+    // The interpreter handlers and the exits after stores need the flags in the CPSR
+    if (!IsCompiledNatively(instruction) || instruction.Condition < InstructionCondition::Always)
+        return true;
+
+    if (instruction.Handler == InstructionHandler::ARMDataProcessing)
+    {
+        ARM::DataProcessingOperation operation = ARM::GetVariantOperation(instruction.Variant);
+
+        if (operation == ARM::DataProcessingOperation::ADC || operation == ARM::DataProcessingOperation::SBC || operation == ARM::DataProcessingOperation::RSC)
+            return true;
+
+        // RRX
+        if (ARM::GetVariantForm(instruction.Variant) == OperandForm::ImmediateShift && instruction.Shift == ARM::ShiftType::ROR && instruction.ShiftAmount == 0)
+            return true;
+
+        // Logical operations keep some of the flags
+        return ARM::GetVariantSetConditionCodes(instruction.Variant) && !OverwritesFlags(instruction);
+    }
+
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ARMLoadStore:
+            return !instruction.IsLoad();
+        case InstructionHandler::ThumbLoadStoreRegisterOffset:
+        case InstructionHandler::ThumbLoadStoreImmediateOffset:
+        case InstructionHandler::ThumbLoadStoreStack:
+            return instruction.GetOpcode() == Thumb::ThumbOpcodes::STR_1 || instruction.GetOpcode() == Thumb::ThumbOpcodes::STR_2 ||
+                instruction.GetOpcode() == Thumb::ThumbOpcodes::STR_3 || instruction.GetOpcode() == Thumb::ThumbOpcodes::STRB_1 ||
+                instruction.GetOpcode() == Thumb::ThumbOpcodes::STRB_2 || instruction.GetOpcode() == Thumb::ThumbOpcodes::STRH_1 ||
+                instruction.GetOpcode() == Thumb::ThumbOpcodes::STRH_2;
+        case InstructionHandler::ThumbImmediateShift:
+        case InstructionHandler::ThumbDataProcessing:
+            return !OverwritesFlags(instruction);
+        case InstructionHandler::ThumbAddCmpMovSubImmediate:
+            return instruction.GetOpcode() == Thumb::ThumbOpcodes::MOV_1;
+        default:
+            break;
+    }
+
+    return false;
+}
+
+bool JIT::OverwritesFlags(DecodedInstruction const& instruction)
+{
+    // Only the arithmetic operations that don't read the carry write all of N Z C and V
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ARMDataProcessing:
+        {
+            if (!ARM::GetVariantSetConditionCodes(instruction.Variant))
+                return false;
+
+            switch (ARM::GetVariantOperation(instruction.Variant))
+            {
+                case ARM::DataProcessingOperation::ADD:
+                case ARM::DataProcessingOperation::SUB:
+                case ARM::DataProcessingOperation::RSB:
+                case ARM::DataProcessingOperation::CMP:
+                case ARM::DataProcessingOperation::CMN:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        case InstructionHandler::ThumbAddSubImmReg:
+            return true;
+        case InstructionHandler::ThumbAddCmpMovSubImmediate:
+            return instruction.GetOpcode() != Thumb::ThumbOpcodes::MOV_1;
+        case InstructionHandler::ThumbDataProcessing:
+            return instruction.GetOpcode() == Thumb::ThumbOpcodes::NEG || instruction.GetOpcode() == Thumb::ThumbOpcodes::CMP_2 ||
+                instruction.GetOpcode() == Thumb::ThumbOpcodes::CMN;
+        case InstructionHandler::ThumbSpecialDataProcessing:
+            return instruction.GetOpcode() == Thumb::ThumbOpcodes::CMP_3;
+        default:
+            break;
+    }
+
+    return false;
+}
+
+void JIT::ComputeFlagLiveness()
+{
+    // Walk the block backwards, the flags are always needed once the block ends
+    std::size_t count = _block->Instructions.size();
+    bool live = true;
+
+    _flagsLive.assign(count, true);
+
+    for (std::size_t i = count; i-- > 0;)
+    {
+        DecodedInstruction const& instruction = _block->Instructions[i].Instruction;
+
+        _flagsLive[i] = live;
+
+        if (ReadsFlags(instruction))
+            live = true;
+        else if (OverwritesFlags(instruction))
+            live = false;
+    }
+}
+
+void JIT::LoadRegister(Register destination, uint8_t reg)
+{
+    if (reg == PC)
+        _emitter->MOV(destination, _address + _instructionSize * 2);
+    else if (_allocation[reg] >= 0)
+        _emitter->MOV(destination, AllocatableRegisters[_allocation[reg]]);
+    else
+        _emitter->Load(destination, STATE, RegisterOffset(reg));
+}
+
+void JIT::StoreRegister(uint8_t reg, Register source)
+{
+    Utilities::Assert(reg != PC, "The JIT can't write the PC in the middle of a block");
+
+    if (_allocation[reg] >= 0)
+    {
+        _emitter->MOV(AllocatableRegisters[_allocation[reg]], source);
+        _dirty.set(reg);
+    }
+    else
+        _emitter->Store(STATE, RegisterOffset(reg), source);
+}
+
+void JIT::StoreRegister(uint8_t reg, uint32_t value)
+{
+    Utilities::Assert(reg != PC, "The JIT can't write the PC in the middle of a block");
+
+    if (_allocation[reg] >= 0)
+    {
+        _emitter->MOV(AllocatableRegisters[_allocation[reg]], value);
+        _dirty.set(reg);
+    }
+    else
+        _emitter->Store(STATE, RegisterOffset(reg), value);
+}
+
+void JIT::StoreProgramCounter(Register source)
+{
+    _emitter->Store(STATE, RegisterOffset(PC), source);
+}
+
+void JIT::LoadAllocatedRegisters()
+{
+    for (uint8_t reg = 0; reg < PC; ++reg)
+        if (_allocation[reg] >= 0)
+            _emitter->Load(AllocatableRegisters[_allocation[reg]], STATE, RegisterOffset(reg));
+}
+
+void JIT::WriteBackRegisters()
+{
+    for (uint8_t reg = 0; reg < PC; ++reg)
+        if (_allocation[reg] >= 0 && _dirty[reg])
+            _emitter->Store(STATE, RegisterOffset(reg), AllocatableRegisters[_allocation[reg]]);
+}
+
+uint8_t* JIT::CheckCondition(InstructionCondition condition)
+{
+    if (condition >= InstructionCondition::Always)
+        return nullptr;
+
+    // Same lookup as CPU::ConditionPasses, bit NZCV of the mask tells whether the condition passes
+    _emitter->Load(RAX, STATE, CPSR_OFFSET);
+    _emitter->Shift(SHR, RAX, 28);
+    _emitter->MOV(RCX, uint32_t(ConditionTable::Masks[uint8_t(condition)]));
+    _emitter->BT(RCX, RAX);
+    return _emitter->Jcc(NotCarry);
+}
+
+void JIT::LoadCarry(bool inverted)
+{
+    _emitter->BT(STATE, CPSR_OFFSET, 29);
+
+    if (inverted)
+        _emitter->CMC();
+}
+
+void JIT::StoreArithmeticFlags(bool invertCarry)
+{
+    _emitter->SETcc(Sign, RAX);
+    _emitter->SETcc(Zero, RCX);
+    _emitter->SETcc(invertCarry ? NotCarry : Carry, RDX);
+    _emitter->SETcc(Overflow, R8);
+
+    // EAX = N << 31 | Z << 30 | C << 29 | V << 28
+    _emitter->MOVZX8(RAX, RAX);
+    _emitter->Shift(SHL, RAX, 31);
+    _emitter->MOVZX8(RCX, RCX);
+    _emitter->Shift(SHL, RCX, 30);
+    _emitter->ALU(OR, RAX, RCX);
+    _emitter->MOVZX8(RCX, RDX);
+    _emitter->Shift(SHL, RCX, 29);
+    _emitter->ALU(OR, RAX, RCX);
+    _emitter->MOVZX8(RCX, R8);
+    _emitter->Shift(SHL, RCX, 28);
+    _emitter->ALU(OR, RAX, RCX);
+
+    _emitter->ALU(AND, STATE, CPSR_OFFSET, 0x0FFFFFFF);
+    _emitter->ALU(OR, STATE, CPSR_OFFSET, RAX);
+}
+
+void JIT::StoreLogicalFlags(Register value, CarrySource carry)
+{
+    _emitter->TEST(value, value);
+    _emitter->SETcc(Sign, RAX);
+    _emitter->SETcc(Zero, RCX);
+
+    _emitter->MOVZX8(RAX, RAX);
+    _emitter->Shift(SHL, RAX, 31);
+    _emitter->MOVZX8(RCX, RCX);
+    _emitter->Shift(SHL, RCX, 30);
+    _emitter->ALU(OR, RAX, RCX);
+
+    if (carry == CarrySource::Shifter)
+    {
+        _emitter->MOVZX8(RCX, R9);
+        _emitter->Shift(SHL, RCX, 29);
+        _emitter->ALU(OR, RAX, RCX);
+    }
+    else if (carry == CarrySource::Set)
+        _emitter->ALU(OR, RAX, uint32_t(1) << 29);
+
+    // V is always kept
+    _emitter->ALU(AND, STATE, CPSR_OFFSET, carry == CarrySource::Unchanged ? 0x3FFFFFFF : 0x1FFFFFFF);
+    _emitter->ALU(OR, STATE, CPSR_OFFSET, RAX);
+}
+
+void JIT::CallMemoryRead(uint8_t size, bool signExtend)
+{
+    uint64_t function = uint64_t(&JIT::ReadMemory8);
+
+    if (size == 4)
+        function = uint64_t(&JIT::ReadMemory32);
+    else if (size == 2)
+        function = signExtend ? uint64_t(&JIT::ReadMemorySigned16) : uint64_t(&JIT::ReadMemory16);
+
+    _loads = true;
+
+    StorePendingCycles();
+    _emitter->MOV64(RDI, CONTEXT);
+    _emitter->MOV64(RAX, function);
+    _emitter->CALL(RAX);
+
+    // Halfwords come back already extended, a misaligned LDRSH only extends a byte
+    if (signExtend && size == 1)
+        _emitter->MOVSX8(RAX, RAX);
+}
+
+void JIT::CallMemoryWrite(uint8_t size)
+{
+    uint64_t function = size == 4 ? uint64_t(&JIT::WriteMemory32) : (size == 2 ? uint64_t(&JIT::WriteMemory16) : uint64_t(&JIT::WriteMemory8));
+
+    _stores = true;
+
+    StorePendingCycles();
+    _emitter->MOV64(RDI, CONTEXT);
+    _emitter->MOV64(RAX, function);
+    _emitter->CALL(RAX);
+
+    // The store overwrote compiled code, which might be the rest of this block, or scheduled an event
+    _emitter->TEST(RAX, RAX);
+    uint8_t* valid = _emitter->Jcc(Zero);
+    WriteBackRegisters();
+    _emitter->Store(STATE, RegisterOffset(PC), _address + _instructionSize);
+    RefundCycles();
+    _emitter->JMP(_exit);
+    _emitter->SetJumpTarget(valid);
+}
+
+void JIT::RefundCycles()
+{
+    uint32_t cycles = 0;
+
+    for (std::size_t i = _index + 1; i < _block->Instructions.size(); ++i)
+        cycles += _block->Instructions[i].Instruction.GetTiming();
+
+    if (cycles)
+        _emitter->ALU(ADD, CONTEXT, DOWNCOUNT_OFFSET, cycles);
+}
+
+void JIT::StorePendingCycles()
+{
+    uint32_t cycles = 0;
+
+    for (std::size_t i = _index; i < _block->Instructions.size(); ++i)
+        cycles += _block->Instructions[i].Instruction.GetTiming();
+
+    _emitter->Store(CONTEXT, PENDING_OFFSET, cycles);
+}
+
+void JIT::ExitBlock(uint32_t target)
+{
+    WriteBackRegisters();
+    _emitter->Store(STATE, RegisterOffset(PC), target);
+
+    // A block that jumps to itself without storing anything may be waiting for an event, like a B . or a loop reading
+    // VCOUNT. It goes back through the dispatcher, where the idle loop detector can fast-forward it
+    bool polling = _loads || _block->Instructions.size() == 1;
+
+    if (target == _block->Address && polling && !_stores && _cpu->GetIdleLoopDetector()->IsEnabled())
+    {
+        _emitter->JMP(_exit);
+        return;
+    }
+
+    uint32_t key = GetKey(_block->Set, target);
+    uint8_t* jump = _emitter->JMP();
+
+    // Jump straight into the target if it is already compiled, otherwise go through the dispatcher until it is
+    auto block = _blockMap.find(key);
+    X64Emitter::SetJumpTarget(jump, block != _blockMap.end() ? block->second->Entry : _exit);
+
+    LinkSite site = { jump, _block };
+    _links[key].push_back(site);
+}
+
+void JIT::ExitBlock()
+{
+    WriteBackRegisters();
+    _emitter->JMP(_exit);
+}
+
+uint32_t JIT::ReadMemory32(JITContext* context, uint32_t address)
+{
+    context->Owner->SyncCycles();
+    return context->Processor->GetMemory()->ReadUInt32(address);
+}
+
+uint32_t JIT::ReadMemory16(JITContext* context, uint32_t address)
+{
+    context->Owner->SyncCycles();
+    return context->Processor->GetMemory()->LoadHalfword(address);
+}
+
+uint32_t JIT::ReadMemorySigned16(JITContext* context, uint32_t address)
+{
+    context->Owner->SyncCycles();
+    return context->Processor->GetMemory()->LoadSignedHalfword(address);
+}
+
+uint32_t JIT::ReadMemory8(JITContext* context, uint32_t address)
+{
+    context->Owner->SyncCycles();
+    return context->Processor->GetMemory()->ReadUInt8(address);
+}
+
+uint32_t JIT::WriteMemory32(JITContext* context, uint32_t address, uint32_t value)
+{
+    context->Owner->SyncCycles();
+    context->Processor->GetMemory()->WriteUInt32(address, value);
+    context->Owner->CheckEvents();
+    return context->Invalidated;
+}
+
+uint32_t JIT::WriteMemory16(JITContext* context, uint32_t address, uint32_t value)
+{
+    context->Owner->SyncCycles();
+    context->Processor->GetMemory()->WriteUInt16(address, uint16_t(value));
+    context->Owner->CheckEvents();
+    return context->Invalidated;
+}
+
+uint32_t JIT::WriteMemory8(JITContext* context, uint32_t address, uint32_t value)
+{
+    context->Owner->SyncCycles();
+    context->Processor->GetMemory()->WriteUInt8(address, uint8_t(value));
+    context->Owner->CheckEvents();
+    return context->Invalidated;
+}
+
+void JIT::RunInterpreter(JITContext* context, Block::Entry const* entry)
+{
+    CPU* cpu = context->Processor;
+
+    context->Owner->SyncCycles();
+
+    if (entry->Handler != nullptr)
+        (cpu->GetInterpreter().get()->*entry->Handler)(entry->Instruction);
+
+    context->Owner->CheckEvents();
+
+    // The generated code doesn't know about the lazy flags
+    cpu->MaterializeFlags();
+}
@@ -0,0 +1,211 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include "Common/Instructions/DecodedInstruction.hpp"
+#include "Interpreter/BlockCache.hpp"
+#include "JIT/X64Emitter.hpp"
+
+#include <array>
+#include <bitset>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+class CPU;
+struct CPUState;
+class JIT;
+
+// Shared with the generated code, which keeps a pointer to it in R14
+struct JITContext
+{
+    int32_t Downcount; // Cycles left in the current time slice
+    uint32_t Pending; // Cycles of the current instruction and the rest of the block, charged on entry but not run yet
+    uint32_t Invalidated; // Set when a store overwrites compiled code, halts the CPU or schedules an event, the block stops after it
+    CPU* Processor;
+    JIT* Owner;
+};
+
+struct CompiledBlock
+{
+    uint32_t Address;
+    InstructionSet Set;
+    uint8_t* Entry;
+    bool Valid;
+    // Kept for the instructions that are handed to the interpreter, the generated code points into this
+    std::vector<Block::Entry> Instructions;
+};
+
+struct JITStatistics
+{
+    uint64_t CompiledBlocks = 0;
+    uint64_t CompiledInstructions = 0;
+    uint64_t InterpretedInstructions = 0; // Instructions compiled as calls to the interpreter
+    uint64_t Invalidations = 0;
+    uint64_t Flushes = 0;
+};
+
+// Translates basic blocks of ARM and Thumb code into x86-64 code.
+// The most used ARM registers of a block live in host registers while it runs, the flags are kept in the CPSR.
+// Direct branches jump straight into the target block once it is compiled, every block checks the cycle budget on entry.
+// Instructions without a native translation call their interpreter handler.
+class JIT final
+{
+public:
+    enum JITTiming
+    {
+        MAX_TIME_SLICE = 0x10000 // Compiled code otherwise runs until the next event of the scheduler
+    };
+
+    JIT(CPU* cpu);
+    ~JIT();
+
+    // Whether the generated code can run on this machine, only x86-64 with POSIX memory mappings is supported
+    static bool IsSupported();
+
+    // Runs compiled code for about the specified number of cycles, returns how many cycles were actually run.
+    // The cycles are added to the CPU as they go by, so the memory accesses see the current time.
+    // The slice ends early when a store schedules an event before its end.
+    // Returns 0 if the code at the PC can't be compiled, the caller has to run it with the interpreter.
+    uint32_t Run(uint32_t cycles);
+
+    // Drops the blocks of the page that contains the address
+    void Invalidate(uint32_t address);
+    void Flush();
+
+    // Leaves the running block after the current instruction
+    void StopBlock() { _context.Invalidated = 1; }
+
+    JITStatistics const& GetStatistics() const { return _statistics; }
+
+private:
+    enum JITData
+    {
+        CODE_SIZE = 32 * 1024 * 1024,
+        MAX_BLOCK_CODE_SIZE = 128 * 1024, // Space that must be left in the code buffer before compiling a block
+        MAX_BLOCK_INSTRUCTIONS = 64,
+        PAGE_SHIFT = 12,
+        ALLOCATABLE_REGISTERS = 4
+    };
+
+    typedef void (*EntryFunction)(CPUState* state, JITContext* context, uint8_t const* code);
+
+    struct LinkSite
+    {
+        uint8_t* Jump;
+        CompiledBlock* Owner;
+    };
+
+    CompiledBlock* Lookup(InstructionSet set, uint32_t address);
+    CompiledBlock* Compile(InstructionSet set, uint32_t address);
+    void GenerateDispatcher();
+    void Link(uint32_t key, uint8_t const* target);
+
+    static uint32_t GetKey(InstructionSet set, uint32_t address) { return address | uint32_t(set); }
+
+    // Where the C flag of a logical operation comes from
+    enum class CarrySource
+    {
+        Unchanged,
+        Shifter, // Left in R9 by the shift
+        Set,
+        Cleared
+    };
+
+    // Block compilation, the state below only lives while a block is being compiled
+    void CompileInstruction(std::size_t index);
+    void CompileARM(DecodedInstruction const& instruction);
+    void CompileThumb(DecodedInstruction const& instruction);
+    void CompileARMDataProcessing(DecodedInstruction const& instruction);
+    void CompileARMLoadStore(DecodedInstruction const& instruction);
+    void CompileThumbDataProcessing(DecodedInstruction const& instruction);
+    void CompileThumbLoadStore(DecodedInstruction const& instruction);
+    void CompileThumbBranchLink(DecodedInstruction const& instruction);
+    void CompileInterpreterCall(std::size_t index);
+
+    // Every instruction these don't accept is compiled as a call to its interpreter handler
+    static bool IsCompiledNatively(DecodedInstruction const& instruction);
+    static bool IsARMCompiledNatively(DecodedInstruction const& instruction);
+    static bool IsThumbCompiledNatively(DecodedInstruction const& instruction);
+
+    // Used to skip the flags nothing reads before they are overwritten
+    static bool ReadsFlags(DecodedInstruction const& instruction);
+    static bool OverwritesFlags(DecodedInstruction const& instruction);
+
+    void AllocateRegisters();
+    void ComputeFlagLiveness();
+
+    // Guest register access, the PC reads as the address of the instruction plus the pipeline offset
+    void LoadRegister(X64::Register destination, uint8_t reg);
+    void StoreRegister(uint8_t reg, X64::Register source);
+    void StoreRegister(uint8_t reg, uint32_t value);
+    void StoreProgramCounter(X64::Register source); // For the exits with a target only known at runtime
+    void LoadAllocatedRegisters();
+    void WriteBackRegisters(); // Stores the modified allocated registers, they stay allocated
+
+    // Returns the jump taken when the condition fails, nullptr for unconditional instructions
+    uint8_t* CheckCondition(InstructionCondition condition);
+    void LoadCarry(bool inverted); // CF = C, or NOT C
+    void StoreArithmeticFlags(bool invertCarry); // Right after the x86 operation, borrows are inverted carries in ARM
+    void StoreLogicalFlags(X64::Register value, CarrySource carry); // Also keeps V
+
+    void CallMemoryRead(uint8_t size, bool signExtend); // Address in ESI, result in EAX
+    void CallMemoryWrite(uint8_t size); // Address in ESI, value in EDX
+
+    void ExitBlock(uint32_t target); // Static exit, linked to the target block
+    void ExitBlock(); // The PC is already set
+    // Gives back the cycles of the instructions after the current one when the block is left early, like the cached interpreter only counts what ran
+    void RefundCycles();
+    // Tells the C++ code called by the current instruction which cycles haven't gone by yet
+    void StorePendingCycles();
+
+    // Cycles of the slice the generated code used, the whole block is counted as soon as it is entered
+    uint32_t GetUsedCycles() const { return uint32_t(int32_t(_slice) - _context.Downcount); }
+    // Adds the cycles before the current instruction to the CPU
+    void SyncCycles();
+    // Ends the slice at the next event if a store scheduled it earlier, and the block after the current instruction
+    void CheckEvents();
+
+    static uint32_t ReadMemory32(JITContext* context, uint32_t address);
+    static uint32_t ReadMemory16(JITContext* context, uint32_t address);
+    static uint32_t ReadMemorySigned16(JITContext* context, uint32_t address);
+    static uint32_t ReadMemory8(JITContext* context, uint32_t address);
+    static uint32_t WriteMemory32(JITContext* context, uint32_t address, uint32_t value);
+    static uint32_t WriteMemory16(JITContext* context, uint32_t address, uint32_t value);
+    static uint32_t WriteMemory8(JITContext* context, uint32_t address, uint32_t value);
+    static void RunInterpreter(JITContext* context, Block::Entry const* entry);
+
+    CPU* _cpu;
+    JITContext _context;
+    uint32_t _slice; // Cycles in the current time slice
+    uint32_t _synced; // Cycles of the slice already added to the CPU
+
+    uint8_t* _code;
+    uint8_t* _blockCode; // Start of the blocks, right after the dispatcher
+    std::unique_ptr<X64Emitter> _emitter;
+    EntryFunction _enter;
+    uint8_t* _exit; // Returns from the generated code to Run
+
+    std::vector<std::unique_ptr<CompiledBlock>> _blocks; // Every block since the last flush, invalidated ones included
+    std::unordered_map<uint32_t, CompiledBlock*> _blockMap;
+    std::unordered_map<uint32_t, std::vector<CompiledBlock*>> _pages;
+    std::unordered_map<uint32_t, std::vector<LinkSite>> _links; // Jumps to each block, linked or waiting for it to be compiled
+
+    // Compilation state
+    CompiledBlock* _block;
+    uint32_t _address; // Of the instruction being compiled
+    uint32_t _instructionSize;
+    std::size_t _index;
+    bool _ended; // The last instruction left the block on every path
+    bool _loads; // The block reads memory, it might be polling a register
+    bool _stores; // The block writes memory or calls the interpreter for anything but a load
+    std::array<int8_t, 16> _allocation; // Host register index of each ARM register, -1 if it lives in memory
+    std::bitset<16> _dirty;
+    std::vector<bool> _flagsLive; // Whether anything reads the flags set by each instruction
+    uint32_t _linkRegister; // The value a Thumb BL prefix left in LR, if the previous instruction was one
+    bool _hasLinkRegister;
+
+    JITStatistics _statistics;
+};
+
+#endif
@@ -0,0 +1,385 @@
+#include "JIT.hpp"
+
+#include "CPU/CPU.hpp"
+
+using namespace X64;
+
+bool JIT::IsThumbCompiledNatively(DecodedInstruction const& instruction)
+{
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ThumbImmediateShift:
+        case InstructionHandler::ThumbAddSubImmReg:
+        case InstructionHandler::ThumbAddCmpMovSubImmediate:
+        case InstructionHandler::ThumbBranch:
+        case InstructionHandler::ThumbBranchLink:
+        case InstructionHandler::ThumbLiteralPoolLoad:
+        case InstructionHandler::ThumbLoadStoreRegisterOffset:
+        case InstructionHandler::ThumbLoadStoreImmediateOffset:
+        case InstructionHandler::ThumbLoadStoreStack:
+            return true;
+        case InstructionHandler::ThumbDataProcessing:
+            // Shifts by a register need the special cases of amounts of 32 and above
+            switch (instruction.GetOpcode())
+            {
+                case Thumb::ThumbOpcodes::LSL_2:
+                case Thumb::ThumbOpcodes::LSR_2:
+                case Thumb::ThumbOpcodes::ASR_2:
+                case Thumb::ThumbOpcodes::ROR:
+                    return false;
+                default:
+                    return true;
+            }
+        case InstructionHandler::ThumbSpecialDataProcessing:
+            return instruction.Rd != PC && (instruction.GetOpcode() == Thumb::ThumbOpcodes::ADD_4 ||
+                instruction.GetOpcode() == Thumb::ThumbOpcodes::CMP_3 || instruction.GetOpcode() == Thumb::ThumbOpcodes::MOV_3);
+        default:
+            break;
+    }
+
+    return false;
+}
+
+void JIT::CompileThumb(DecodedInstruction const& instruction)
+{
+    bool setFlags = _flagsLive[_index];
+
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ThumbImmediateShift:
+        {
+            uint32_t amount = instruction.Immediate;
+            CarrySource carry = CarrySource::Shifter;
+
+            LoadRegister(R10, instruction.Rm);
+
+            switch (instruction.GetOpcode())
+            {
+                case Thumb::ThumbOpcodes::LSL_1:
+                    if (amount != 0)
+                    {
+                        _emitter->Shift(SHL, R10, uint8_t(amount));
+                        _emitter->SETcc(Carry, R9);
+                    }
+                    else
+                        carry = CarrySource::Unchanged;
+                    break;
+                case Thumb::ThumbOpcodes::LSR_1:
+                    if (amount == 0)
+                    {
+                        // LSR #32
+                        _emitter->Shift(SHL, R10, 1);
+                        _emitter->SETcc(Carry, R9);
+                        _emitter->MOV(R10, uint32_t(0));
+                    }
+                    else
+                    {
+                        _emitter->Shift(SHR, R10, uint8_t(amount));
+                        _emitter->SETcc(Carry, R9);
+                    }
+                    break;
+                case Thumb::ThumbOpcodes::ASR_1:
+                    if (amount == 0)
+                    {
+                        // ASR #32
+                        _emitter->Shift(SAR, R10, 31);
+                        _emitter->TEST(R10, R10);
+                        _emitter->SETcc(Sign, R9);
+                    }
+                    else
+                    {
+                        _emitter->Shift(SAR, R10, uint8_t(amount));
+                        _emitter->SETcc(Carry, R9);
+                    }
+                    break;
+            }
+
+            if (setFlags)
+                StoreLogicalFlags(R10, carry);
+
+            StoreRegister(instruction.Rd, R10);
+            break;
+        }
+        case InstructionHandler::ThumbAddSubImmReg:
+        {
+            bool add = instruction.GetOpcode() == Thumb::ThumbOpcodes::ADD_1 || instruction.GetOpcode() == Thumb::ThumbOpcodes::ADD_3;
+
+            LoadRegister(R10, instruction.Rn);
+
+            if (instruction.IsImmediate())
+                _emitter->ALU(add ? ADD : SUB, R10, instruction.Immediate);
+            else
+            {
+                LoadRegister(R11, instruction.Rm);
+                _emitter->ALU(add ? ADD : SUB, R10, R11);
+            }
+
+            if (setFlags)
+                StoreArithmeticFlags(!add);
+
+            StoreRegister(instruction.Rd, R10);
+            break;
+        }
+        case InstructionHandler::ThumbAddCmpMovSubImmediate:
+        {
+            switch (instruction.GetOpcode())
+            {
+                case Thumb::ThumbOpcodes::MOV_1:
+                    _emitter->MOV(R10, instruction.Immediate);
+                    if (setFlags)
+                        StoreLogicalFlags(R10, CarrySource::Unchanged);
+                    break;
+                case Thumb::ThumbOpcodes::CMP_1:
+                    // Rd is actually Rn here
+                    if (setFlags)
+                    {
+                        LoadRegister(R10, instruction.Rd);
+                        _emitter->ALU(CMP, R10, instruction.Immediate);
+                        StoreArithmeticFlags(true);
+                    }
+                    return;
+                case Thumb::ThumbOpcodes::ADD_2:
+                    LoadRegister(R10, instruction.Rd);
+                    _emitter->ALU(ADD, R10, instruction.Immediate);
+                    if (setFlags)
+                        StoreArithmeticFlags(false);
+                    break;
+                case Thumb::ThumbOpcodes::SUB_2:
+                    LoadRegister(R10, instruction.Rd);
+                    _emitter->ALU(SUB, R10, instruction.Immediate);
+                    if (setFlags)
+                        StoreArithmeticFlags(true);
+                    break;
+            }
+
+            StoreRegister(instruction.Rd, R10);
+            break;
+        }
+        case InstructionHandler::ThumbDataProcessing:
+            CompileThumbDataProcessing(instruction);
+            break;
+        case InstructionHandler::ThumbSpecialDataProcessing:
+        {
+            LoadRegister(R11, instruction.Rm);
+
+            switch (instruction.GetOpcode())
+            {
+                case Thumb::ThumbOpcodes::ADD_4:
+                    LoadRegister(R10, instruction.Rd);
+                    _emitter->ALU(ADD, R10, R11);
+                    StoreRegister(instruction.Rd, R10);
+                    break;
+                case Thumb::ThumbOpcodes::CMP_3:
+                    if (setFlags)
+                    {
+                        LoadRegister(R10, instruction.Rd);
+                        _emitter->ALU(CMP, R10, R11);
+                        StoreArithmeticFlags(true);
+                    }
+                    break;
+                case Thumb::ThumbOpcodes::MOV_3:
+                    StoreRegister(instruction.Rd, R11);
+                    break;
+            }
+            break;
+        }
+        case InstructionHandler::ThumbBranch:
+        {
+            // Unconditional branches are decoded with the Always condition
+            uint8_t* skip = CheckCondition(instruction.Condition);
+
+            ExitBlock(_address + 4 + instruction.Immediate);
+
+            if (skip)
+                _emitter->SetJumpTarget(skip);
+            else
+                _ended = true;
+            break;
+        }
+        case InstructionHandler::ThumbBranchLink:
+            CompileThumbBranchLink(instruction);
+            break;
+        case InstructionHandler::ThumbLiteralPoolLoad:
+        case InstructionHandler::ThumbLoadStoreRegisterOffset:
+        case InstructionHandler::ThumbLoadStoreImmediateOffset:
+        case InstructionHandler::ThumbLoadStoreStack:
+            CompileThumbLoadStore(instruction);
+            break;
+        default:
+            Utilities::Assert(false, "The JIT can't compile this Thumb instruction");
+            break;
+    }
+}
+
+void JIT::CompileThumbDataProcessing(DecodedInstruction const& instruction)
+{
+    bool setFlags = _flagsLive[_index];
+    bool writeResult = true;
+
+    LoadRegister(R10, instruction.Rd);
+    LoadRegister(R11, instruction.Rm);
+
+    // The result ends up in R10, the logical operations leave the carry alone
+    switch (instruction.GetOpcode())
+    {
+        case Thumb::ThumbOpcodes::AND:
+            _emitter->ALU(AND, R10, R11);
+            break;
+        case Thumb::ThumbOpcodes::TST:
+            _emitter->ALU(AND, R10, R11);
+            writeResult = false;
+            break;
+        case Thumb::ThumbOpcodes::EOR:
+            _emitter->ALU(XOR, R10, R11);
+            break;
+        case Thumb::ThumbOpcodes::ORR:
+            _emitter->ALU(OR, R10, R11);
+            break;
+        case Thumb::ThumbOpcodes::BIC:
+            _emitter->NOT(R11);
+            _emitter->ALU(AND, R10, R11);
+            break;
+        case Thumb::ThumbOpcodes::MVN:
+            _emitter->MOV(R10, R11);
+            _emitter->NOT(R10);
+            break;
+        case Thumb::ThumbOpcodes::MUL:
+            _emitter->IMUL(R10, R11);
+            break;
+        case Thumb::ThumbOpcodes::ADC:
+            LoadCarry(false);
+            _emitter->ALU(ADC, R10, R11);
+            if (setFlags)
+                StoreArithmeticFlags(false);
+            StoreRegister(instruction.Rd, R10);
+            return;
+        case Thumb::ThumbOpcodes::SBC:
+            LoadCarry(true);
+            _emitter->ALU(SBB, R10, R11);
+            if (setFlags)
+                StoreArithmeticFlags(true);
+            StoreRegister(instruction.Rd, R10);
+            return;
+        case Thumb::ThumbOpcodes::NEG:
+            _emitter->MOV(R10, uint32_t(0));
+            _emitter->ALU(SUB, R10, R11);
+            if (setFlags)
+                StoreArithmeticFlags(true);
+            StoreRegister(instruction.Rd, R10);
+            return;
+        case Thumb::ThumbOpcodes::CMP_2:
+            _emitter->ALU(CMP, R10, R11);
+            if (setFlags)
+                StoreArithmeticFlags(true);
+            return;
+        case Thumb::ThumbOpcodes::CMN:
+            _emitter->ALU(ADD, R10, R11);
+            if (setFlags)
+                StoreArithmeticFlags(false);
+            return;
+        default:
+            Utilities::Assert(false, "The JIT can't compile this Thumb data processing instruction");
+            break;
+    }
+
+    if (setFlags)
+        StoreLogicalFlags(R10, CarrySource::Unchanged);
+
+    if (writeResult)
+        StoreRegister(instruction.Rd, R10);
+}
+
+void JIT::CompileThumbBranchLink(DecodedInstruction const& instruction)
+{
+    // The first half only sets LR, remember it so the second half can jump to a known address
+    if (!instruction.Link())
+    {
+        _linkRegister = _address + 4 + instruction.Immediate;
+        _hasLinkRegister = true;
+        StoreRegister(LR, _linkRegister);
+        return;
+    }
+
+    uint32_t returnAddress = (_address + 2) | 1;
+
+    if (_hasLinkRegister)
+    {
+        StoreRegister(LR, returnAddress);
+        ExitBlock(_linkRegister + instruction.Immediate);
+    }
+    else
+    {
+        // The first half is in another block
+        LoadRegister(R10, LR);
+        _emitter->ALU(ADD, R10, instruction.Immediate);
+        StoreProgramCounter(R10);
+        StoreRegister(LR, returnAddress);
+        ExitBlock();
+    }
+
+    _ended = true;
+}
+
+void JIT::CompileThumbLoadStore(DecodedInstruction const& instruction)
+{
+    // The address goes in ESI, the value to store in EDX
+    uint8_t size = 4;
+    bool load = true;
+    bool signExtend = false;
+
+    switch (instruction.Handler)
+    {
+        case InstructionHandler::ThumbLiteralPoolLoad:
+            _emitter->MOV(RSI, ((_address + 4) & 0xFFFFFFFC) + instruction.Immediate);
+            break;
+        case InstructionHandler::ThumbLoadStoreStack:
+            LoadRegister(RSI, SP);
+            _emitter->ALU(ADD, RSI, instruction.Immediate);
+            load = instruction.IsLoad();
+            break;
+        case InstructionHandler::ThumbLoadStoreImmediateOffset:
+            LoadRegister(RSI, instruction.Rn);
+            _emitter->ALU(ADD, RSI, instruction.Immediate);
+
+            switch (instruction.GetOpcode())
+            {
+                case Thumb::ThumbOpcodes::LDRB_1: size = 1; break;
+                case Thumb::ThumbOpcodes::LDRH_1: size = 2; break;
+                case Thumb::ThumbOpcodes::STR_1: load = false; break;
+                case Thumb::ThumbOpcodes::STRB_1: size = 1; load = false; break;
+                case Thumb::ThumbOpcodes::STRH_1: size = 2; load = false; break;
+                default: break;
+            }
+            break;
+        case InstructionHandler::ThumbLoadStoreRegisterOffset:
+            LoadRegister(RSI, instruction.Rn);
+            LoadRegister(RCX, instruction.Rm);
+            _emitter->ALU(ADD, RSI, RCX);
+
+            switch (instruction.GetOpcode())
+            {
+                case Thumb::ThumbOpcodes::LDRB_2: size = 1; break;
+                case Thumb::ThumbOpcodes::LDRH_2: size = 2; break;
+                case Thumb::ThumbOpcodes::LDRSB: size = 1; signExtend = true; break;
+                case Thumb::ThumbOpcodes::LDRSH: size = 2; signExtend = true; break;
+                case Thumb::ThumbOpcodes::STR_2: load = false; break;
+                case Thumb::ThumbOpcodes::STRB_2: size = 1; load = false; break;
+                case Thumb::ThumbOpcodes::STRH_2: size = 2; load = false; break;
+                default: break;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (load)
+    {
+        CallMemoryRead(size, signExtend);
+        StoreRegister(instruction.Rd, RAX);
+    }
+    else
+    {
+        LoadRegister(RDX, instruction.Rd);
+        CallMemoryWrite(size);
+    }
+}
@@ -0,0 +1,323 @@
+#include "X64Emitter.hpp"
+
+#include "Common/Utilities.hpp"
+
+#include <cstring>
+
+using namespace X64;
+
+void X64Emitter::Write8(uint8_t value)
+{
+    Utilities::Assert(_code < _end, "The JIT code buffer overflowed");
+    *_code++ = value;
+}
+
+void X64Emitter::Write32(uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        Write8(uint8_t(value >> (i * 8)));
+}
+
+void X64Emitter::Write64(uint64_t value)
+{
+    Write32(uint32_t(value));
+    Write32(uint32_t(value >> 32));
+}
+
+void X64Emitter::WriteREX(bool wide, uint8_t reg, uint8_t rm, bool forceREX)
+{
+    uint8_t rex = 0x40 | (wide ? 0x8 : 0) | ((reg & 8) ? 0x4 : 0) | ((rm & 8) ? 0x1 : 0);
+
+    if (rex != 0x40 || forceREX)
+        Write8(rex);
+}
+
+void X64Emitter::WriteModRM(uint8_t reg, Register rm)
+{
+    Write8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void X64Emitter::WriteModRM(uint8_t reg, Register base, int32_t displacement)
+{
+    bool shortDisplacement = displacement >= -128 && displacement <= 127;
+
+    // RBP and R13 can't be used as a base without a displacement, that encoding means RIP relative
+    uint8_t mod = (displacement == 0 && (base & 7) != RBP) ? 0 : (shortDisplacement ? 1 : 2);
+
+    Write8((mod << 6) | ((reg & 7) << 3) | (base & 7));
+
+    // RSP and R12 as a base need a SIB byte
+    if ((base & 7) == RSP)
+        Write8(0x24);
+
+    if (mod == 1)
+        Write8(uint8_t(displacement));
+    else if (mod == 2)
+        Write32(uint32_t(displacement));
+}
+
+void X64Emitter::MOV(Register destination, Register source)
+{
+    WriteREX(false, source, destination);
+    Write8(0x89);
+    WriteModRM(source, destination);
+}
+
+void X64Emitter::MOV(Register destination, uint32_t immediate)
+{
+    // Zero is loaded this way too, XOR would clobber the flags
+    WriteREX(false, 0, destination);
+    Write8(0xB8 + (destination & 7));
+    Write32(immediate);
+}
+
+void X64Emitter::MOV64(Register destination, Register source)
+{
+    WriteREX(true, source, destination);
+    Write8(0x89);
+    WriteModRM(source, destination);
+}
+
+void X64Emitter::MOV64(Register destination, uint64_t immediate)
+{
+    WriteREX(true, 0, destination);
+    Write8(0xB8 + (destination & 7));
+    Write64(immediate);
+}
+
+void X64Emitter::Load(Register destination, Register base, int32_t displacement)
+{
+    WriteREX(false, destination, base);
+    Write8(0x8B);
+    WriteModRM(destination, base, displacement);
+}
+
+void X64Emitter::Store(Register base, int32_t displacement, Register source)
+{
+    WriteREX(false, source, base);
+    Write8(0x89);
+    WriteModRM(source, base, displacement);
+}
+
+void X64Emitter::Store(Register base, int32_t displacement, uint32_t immediate)
+{
+    WriteREX(false, 0, base);
+    Write8(0xC7);
+    WriteModRM(0, base, displacement);
+    Write32(immediate);
+}
+
+void X64Emitter::ALU(AluOperation operation, Register destination, Register source)
+{
+    WriteREX(false, source, destination);
+    Write8((operation << 3) | 1);
+    WriteModRM(source, destination);
+}
+
+void X64Emitter::ALU(AluOperation operation, Register destination, uint32_t immediate)
+{
+    WriteREX(false, 0, destination);
+
+    if (int32_t(immediate) >= -128 && int32_t(immediate) <= 127)
+    {
+        Write8(0x83);
+        WriteModRM(operation, destination);
+        Write8(uint8_t(immediate));
+        return;
+    }
+
+    Write8(0x81);
+    WriteModRM(operation, destination);
+    Write32(immediate);
+}
+
+void X64Emitter::ALU(AluOperation operation, Register base, int32_t displacement, uint32_t immediate)
+{
+    WriteREX(false, 0, base);
+
+    if (int32_t(immediate) >= -128 && int32_t(immediate) <= 127)
+    {
+        Write8(0x83);
+        WriteModRM(operation, base, displacement);
+        Write8(uint8_t(immediate));
+        return;
+    }
+
+    Write8(0x81);
+    WriteModRM(operation, base, displacement);
+    Write32(immediate);
+}
+
+void X64Emitter::ALU(AluOperation operation, Register base, int32_t displacement, Register source)
+{
+    WriteREX(false, source, base);
+    Write8((operation << 3) | 1);
+    WriteModRM(source, base, displacement);
+}
+
+void X64Emitter::ALU64(AluOperation operation, Register destination, int8_t immediate)
+{
+    WriteREX(true, 0, destination);
+    Write8(0x83);
+    WriteModRM(operation, destination);
+    Write8(uint8_t(immediate));
+}
+
+void X64Emitter::TEST(Register first, Register second)
+{
+    WriteREX(false, second, first);
+    Write8(0x85);
+    WriteModRM(second, first);
+}
+
+void X64Emitter::Shift(ShiftOperation operation, Register destination, uint8_t amount)
+{
+    WriteREX(false, 0, destination);
+    Write8(0xC1);
+    WriteModRM(operation, destination);
+    Write8(amount);
+}
+
+void X64Emitter::NOT(Register destination)
+{
+    WriteREX(false, 0, destination);
+    Write8(0xF7);
+    WriteModRM(2, destination);
+}
+
+void X64Emitter::NEG(Register destination)
+{
+    WriteREX(false, 0, destination);
+    Write8(0xF7);
+    WriteModRM(3, destination);
+}
+
+void X64Emitter::IMUL(Register destination, Register source)
+{
+    WriteREX(false, destination, source);
+    Write8(0x0F);
+    Write8(0xAF);
+    WriteModRM(destination, source);
+}
+
+void X64Emitter::SETcc(Condition condition, Register destination)
+{
+    WriteREX(false, 0, destination, destination >= RSP && destination <= RDI);
+    Write8(0x0F);
+    Write8(0x90 | condition);
+    WriteModRM(0, destination);
+}
+
+void X64Emitter::MOVZX8(Register destination, Register source)
+{
+    WriteREX(false, destination, source, source >= RSP && source <= RDI);
+    Write8(0x0F);
+    Write8(0xB6);
+    WriteModRM(destination, source);
+}
+
+void X64Emitter::MOVZX16(Register destination, Register source)
+{
+    WriteREX(false, destination, source);
+    Write8(0x0F);
+    Write8(0xB7);
+    WriteModRM(destination, source);
+}
+
+void X64Emitter::MOVSX8(Register destination, Register source)
+{
+    WriteREX(false, destination, source, source >= RSP && source <= RDI);
+    Write8(0x0F);
+    Write8(0xBE);
+    WriteModRM(destination, source);
+}
+
+void X64Emitter::MOVSX16(Register destination, Register source)
+{
+    WriteREX(false, destination, source);
+    Write8(0x0F);
+    Write8(0xBF);
+    WriteModRM(destination, source);
+}
+
+void X64Emitter::BT(Register base, Register bit)
+{
+    WriteREX(false, bit, base);
+    Write8(0x0F);
+    Write8(0xA3);
+    WriteModRM(bit, base);
+}
+
+void X64Emitter::BT(Register base, int32_t displacement, uint8_t bit)
+{
+    WriteREX(false, 0, base);
+    Write8(0x0F);
+    Write8(0xBA);
+    WriteModRM(4, base, displacement);
+    Write8(bit);
+}
+
+void X64Emitter::CMC()
+{
+    Write8(0xF5);
+}
+
+void X64Emitter::PUSH(Register source)
+{
+    WriteREX(false, 0, source);
+    Write8(0x50 + (source & 7));
+}
+
+void X64Emitter::POP(Register destination)
+{
+    WriteREX(false, 0, destination);
+    Write8(0x58 + (destination & 7));
+}
+
+void X64Emitter::CALL(Register target)
+{
+    WriteREX(false, 0, target);
+    Write8(0xFF);
+    WriteModRM(2, target);
+}
+
+void X64Emitter::JMP(Register target)
+{
+    WriteREX(false, 0, target);
+    Write8(0xFF);
+    WriteModRM(4, target);
+}
+
+void X64Emitter::RET()
+{
+    Write8(0xC3);
+}
+
+uint8_t* X64Emitter::JMP()
+{
+    Write8(0xE9);
+    uint8_t* jump = _code;
+    Write32(0);
+    return jump;
+}
+
+uint8_t* X64Emitter::Jcc(Condition condition)
+{
+    Write8(0x0F);
+    Write8(0x80 | condition);
+    uint8_t* jump = _code;
+    Write32(0);
+    return jump;
+}
+
+void X64Emitter::JMP(uint8_t const* target)
+{
+    SetJumpTarget(JMP(), target);
+}
+
+void X64Emitter::SetJumpTarget(uint8_t* jump, uint8_t const* target)
+{
+    // The offset is relative to the end of the instruction, which is right after the offset itself
+    int32_t offset = int32_t(target - (jump + 4));
+    std::memcpy(jump, &offset, sizeof(offset));
+}
@@ -0,0 +1,130 @@
+#ifndef X64_EMITTER_HPP
+#define X64_EMITTER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace X64
+{
+    enum Register : uint8_t
+    {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15
+    };
+
+    // The low nibble of the Jcc and SETcc opcodes
+    enum Condition : uint8_t
+    {
+        Overflow = 0x0,
+        NotOverflow = 0x1,
+        Carry = 0x2, // Below
+        NotCarry = 0x3, // Above or equal
+        Zero = 0x4,
+        NotZero = 0x5,
+        BelowOrEqual = 0x6,
+        Above = 0x7,
+        Sign = 0x8,
+        NotSign = 0x9,
+        Less = 0xC,
+        GreaterOrEqual = 0xD,
+        LessOrEqual = 0xE,
+        Greater = 0xF
+    };
+
+    // The opcode extension of the 0x81 group, the register forms are (Operation << 3) | 1
+    enum AluOperation : uint8_t
+    {
+        ADD = 0,
+        OR = 1,
+        ADC = 2,
+        SBB = 3,
+        AND = 4,
+        SUB = 5,
+        XOR = 6,
+        CMP = 7
+    };
+
+    // The opcode extension of the 0xC1 group
+    enum ShiftOperation : uint8_t
+    {
+        ROL = 0,
+        ROR = 1,
+        RCL = 2,
+        RCR = 3,
+        SHL = 4,
+        SHR = 5,
+        SAR = 7
+    };
+}
+
+// Writes x86-64 machine code into a buffer, only the handful of instructions the JIT needs.
+// Unless the name says otherwise every operation works on the 32 bit registers, and memory operands are [base + displacement].
+class X64Emitter final
+{
+public:
+    X64Emitter(uint8_t* code, std::size_t size) : _start(code), _code(code), _end(code + size) { }
+
+    uint8_t* GetCode() const { return _code; }
+    std::size_t GetSize() const { return std::size_t(_code - _start); }
+    std::size_t GetRemaining() const { return std::size_t(_end - _code); }
+
+    void MOV(X64::Register destination, X64::Register source);
+    void MOV(X64::Register destination, uint32_t immediate);
+    void MOV64(X64::Register destination, X64::Register source);
+    void MOV64(X64::Register destination, uint64_t immediate);
+    void Load(X64::Register destination, X64::Register base, int32_t displacement);
+    void Store(X64::Register base, int32_t displacement, X64::Register source);
+    void Store(X64::Register base, int32_t displacement, uint32_t immediate);
+
+    void ALU(X64::AluOperation operation, X64::Register destination, X64::Register source);
+    void ALU(X64::AluOperation operation, X64::Register destination, uint32_t immediate);
+    void ALU(X64::AluOperation operation, X64::Register base, int32_t displacement, uint32_t immediate);
+    void ALU(X64::AluOperation operation, X64::Register base, int32_t displacement, X64::Register source);
+    void ALU64(X64::AluOperation operation, X64::Register destination, int8_t immediate);
+    void TEST(X64::Register first, X64::Register second);
+    void Shift(X64::ShiftOperation operation, X64::Register destination, uint8_t amount);
+    void NOT(X64::Register destination);
+    void NEG(X64::Register destination);
+    void IMUL(X64::Register destination, X64::Register source);
+
+    void SETcc(X64::Condition condition, X64::Register destination); // Writes the low byte of destination
+    void MOVZX8(X64::Register destination, X64::Register source);
+    void MOVZX16(X64::Register destination, X64::Register source);
+    void MOVSX8(X64::Register destination, X64::Register source);
+    void MOVSX16(X64::Register destination, X64::Register source);
+
+    void BT(X64::Register base, X64::Register bit); // CF = bit of base
+    void BT(X64::Register base, int32_t displacement, uint8_t bit); // CF = bit of the 32 bit value in memory
+    void CMC();
+
+    void PUSH(X64::Register source);
+    void POP(X64::Register destination);
+    void CALL(X64::Register target);
+    void JMP(X64::Register target);
+    void RET();
+
+    // Relative jumps return the location of their 32 bit offset, so the target can be set once it is known
+    uint8_t* JMP();
+    uint8_t* Jcc(X64::Condition condition);
+    void JMP(uint8_t const* target);
+
+    // Points a jump returned by JMP or Jcc at the current location
+    void SetJumpTarget(uint8_t* jump) { SetJumpTarget(jump, _code); }
+    static void SetJumpTarget(uint8_t* jump, uint8_t const* target);
+
+private:
+    void Write8(uint8_t value);
+    void Write32(uint32_t value);
+    void Write64(uint64_t value);
+
+    // forceREX is needed to address SPL, BPL, SIL and DIL instead of AH, CH, DH and BH
+    void WriteREX(bool wide, uint8_t reg, uint8_t rm, bool forceREX = false);
+    void WriteModRM(uint8_t reg, X64::Register rm);
+    void WriteModRM(uint8_t reg, X64::Register base, int32_t displacement);
+
+    uint8_t* _start;
+    uint8_t* _code;
+    uint8_t* _end;
+};
+
+#endif
@@ -1,183 +1,353 @@
 #include "Common/GBA.hpp"
-#include "Common/Files.hpp"
+#include "Common/MathHelper.hpp"
 #include "Common/Utilities.hpp"
 #include "Memory.hpp"
 #include "CPU/CPU.hpp"
 #include "GPU/GPU.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <cstring>
 #include <memory>
 #include <cstdint>
 
-MMU::MMU(CPU* arm) : _cpu(arm)
+namespace
 {
+    // The GBA is little endian like the hosts we run on, so the backing arrays hold the values in the right order already
+    template <typename T>
+    T Load(uint8_t const* data)
+    {
+        T value;
+        memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void Store(uint8_t* data, T value)
+    {
+        memcpy(data, &value, sizeof(T));
+    }
+
+    // Past the end of the ROM the Game Pak bus still holds the lower bits of the address, each halfword reads as its address / 2
+    uint8_t OpenBusByte(uint32_t address)
+    {
+        return uint8_t((address >> 1) >> ((address & 1) * 8));
+    }
 }
 
-void MMU::LoadROM(GBAHeader& header, FILE* rom, FILE* bios)
+MMU::MMU(CPU* arm) : _cpu(arm), _writes(0)
 {
-    // Zero out all 3 wait states
-    for (int i = 0; i < NUM_WAIT_STATES; ++i)
-        memset(&_pakROM[i], 0, sizeof(_pakROM[i]));
+    std::unique_ptr<MemoryArena>& arena = _cpu->GetMemoryArena();
+
+    _bios = arena->Get(MemoryRegion::BIOS);
+    _ewram = arena->Get(MemoryRegion::EWRAM);
+    _iwram = arena->Get(MemoryRegion::IWRAM);
+    _sram = arena->Get(MemoryRegion::SRAM);
+    _romTail = arena->Get(MemoryRegion::ROMTail);
+
+    MapMemory();
+}
+
+void MMU::MapMemory()
+{
+    MemoryPage unmapped = { nullptr, 0, MemoryHandler::Unmapped, false };
+
+    std::fill(std::begin(_readPages), std::end(_readPages), unmapped);
+    std::fill(std::begin(_writePages), std::end(_writePages), unmapped);
 
-    // Copy the ROM to the GamePak memory
-    uint32_t size = Files::GetFileSize(rom) - sizeof(header);
+    // Reading the BIOS depends on the PC, and it can't be written at all
+    _readPages[0].Handler = MemoryHandler::BIOS;
+    _writePages[0].Handler = MemoryHandler::BIOS;
 
-    // Copy the header to the wait state
-    memcpy(&_pakROM[0], &header, sizeof(GBAHeader));
+    // Every region is mirrored over its whole 16 MBytes
+    MapMirrored(0x02000000, 0x01000000, _ewram, EWRAM_SIZE, true);
+    MapMirrored(0x03000000, 0x01000000, _iwram, IWRAM_SIZE, true);
 
-    // Read the data from the file into the first wait state
-    fread(&_pakROM[0][sizeof(GBAHeader)], sizeof(uint8_t), size, rom);
+    _readPages[0x04000000 >> PAGE_SHIFT].Handler = MemoryHandler::IO;
+    _writePages[0x04000000 >> PAGE_SHIFT].Handler = MemoryHandler::IO;
 
-    // Now mirror it into the other wait states
-    for (int i = 1; i < NUM_WAIT_STATES; ++i)
-        memcpy(&_pakROM[i], _pakROM[0], size + sizeof(GBAHeader));
+    std::unique_ptr<MemoryArena>& arena = _cpu->GetMemoryArena();
+
+    MapMirrored(0x05000000, 0x01000000, arena->Get(MemoryRegion::Palette), PALETTE_SIZE, false);
+    MapMirrored(0x07000000, 0x01000000, arena->Get(MemoryRegion::OAM), OAM_SIZE, false);
+
+    // VRAM is mirrored every 128 KBytes, the last 32 KBytes of each mirror repeat the OBJ tiles at 06010000
+    for (uint32_t address = 0x06000000; address < 0x07000000; address += PAGE_SIZE)
+    {
+        uint32_t offset = address % 0x20000;
+
+        if (offset >= 0x18000)
+            offset -= 0x8000;
+
+        MemoryPage page = { arena->Get(MemoryRegion::VRAM) + offset, PAGE_SIZE - 1, MemoryHandler::Unmapped, false };
+        _readPages[address >> PAGE_SHIFT] = page;
+        _writePages[address >> PAGE_SHIFT] = page;
+    }
+
+    MapGamePak();
+
+    MapMirrored(0x0E000000, 0x01000000, _sram, SRAM_SIZE, false);
+}
+
+void MMU::MapMirrored(uint32_t address, uint32_t size, uint8_t* memory, uint32_t memorySize, bool code)
+{
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE)
+    {
+        MemoryPage page = { memory, memorySize - 1, MemoryHandler::Unmapped, code };
+
+        // Memory smaller than a page is mirrored within it through the mask
+        if (memorySize >= PAGE_SIZE)
+        {
+            page.Memory = memory + offset % memorySize;
+            page.Mask = PAGE_SIZE - 1;
+        }
+
+        _readPages[(address + offset) >> PAGE_SHIFT] = page;
+        _writePages[(address + offset) >> PAGE_SHIFT] = page;
+    }
+}
+
+void MMU::MapGamePak()
+{
+    uint32_t size = std::min<uint32_t>(_rom.GetSize(), GAME_PAK_SIZE);
+    uint32_t pages = size & ~uint32_t(PAGE_SIZE - 1);
+
+    // The last partial page is copied, the open bus after the end of the ROM goes in its padding
+    for (uint32_t offset = pages; offset < pages + PAGE_SIZE; ++offset)
+        _romTail[offset - pages] = offset < size ? _rom.GetData()[offset] : OpenBusByte(offset);
+
+    // The three wait state regions are mirrors of the same ROM, it can't be written
+    for (uint32_t i = 0; i < NUM_WAIT_STATES; ++i)
+    {
+        uint32_t region = 0x08000000 + i * GAME_PAK_SIZE;
+
+        for (uint32_t offset = 0; offset < GAME_PAK_SIZE; offset += PAGE_SIZE)
+        {
+            MemoryPage page = { nullptr, PAGE_SIZE - 1, MemoryHandler::GamePak, false };
+            _writePages[(region + offset) >> PAGE_SHIFT] = page;
+
+            // The read pages never write through their pointer
+            if (offset < pages)
+                page.Memory = const_cast<uint8_t*>(_rom.GetData()) + offset;
+            else if (offset < size)
+                page.Memory = _romTail;
+
+            _readPages[(region + offset) >> PAGE_SHIFT] = page;
+        }
+    }
+}
+
+void MMU::LoadROM(GBAHeader& header, FILE* rom, FILE* bios)
+{
+    // Served straight from the file when it can be mapped
+    _rom.Load(header, rom);
+
+    MapGamePak();
 
     // Cleanup memory
-    memset(_ioram, 0, sizeof(_ioram) / sizeof(uint8_t));
-    memset(_bios, 0, sizeof(_bios) / sizeof(uint8_t));
-    memset(_ewram, 0, sizeof(_ewram) / sizeof(uint8_t));
-    memset(_iwram, 0, sizeof(_iwram) / sizeof(uint8_t));
-    memset(_vram, 0, sizeof(_vram) / sizeof(uint8_t));
-    memset(_sram, 0, sizeof(_sram) / sizeof(uint8_t));
+    std::unique_ptr<MemoryArena>& arena = _cpu->GetMemoryArena();
+
+    arena->Clear(MemoryRegion::BIOS);
+    arena->Clear(MemoryRegion::EWRAM);
+    arena->Clear(MemoryRegion::IWRAM);
+    arena->Clear(MemoryRegion::VRAM);
+    arena->Clear(MemoryRegion::SRAM);
+
+    _cpu->GetIO()->Reset();
 
-    // Load BIOS
-    fread(&_bios, sizeof(uint8_t), sizeof(_bios) / sizeof(uint8_t), bios);
+    // Load BIOS, without one the CPU emulates its calls
+    if (bios)
+        fread(_bios, sizeof(uint8_t), BIOS_SIZE, bios);
+
+    // Everything that was decoded before belongs to the previous contents of the memory
+    _cpu->GetInstructionCache()->Flush();
 }
 
-uint32_t MMU::ReadUInt32(uint32_t offset)
+uint32_t MMU::ReadUInt32(uint32_t address)
 {
-    return ReadUInt16(offset) | (ReadUInt16(offset + 2) << 16);
+    uint32_t value = Read<uint32_t>(address & ~3);
+    uint8_t rotation = (address & 3) * 8;
+
+    return rotation ? MathHelper::RotateRight(value, rotation) : value;
 }
 
 uint16_t MMU::ReadUInt16(uint32_t address)
 {
-    return ReadUInt8(address) | (ReadUInt8(address + 1) << 8);
+    return Read<uint16_t>(address & ~1);
+}
+
+uint32_t MMU::LoadHalfword(uint32_t address)
+{
+    uint32_t value = Read<uint16_t>(address & ~1);
+
+    return (address & 1) ? MathHelper::RotateRight(value, 8) : value;
+}
+
+uint32_t MMU::LoadSignedHalfword(uint32_t address)
+{
+    if (address & 1)
+        return uint32_t(int32_t(int8_t(ReadUInt8(address))));
+
+    return uint32_t(int32_t(int16_t(Read<uint16_t>(address))));
 }
 
 uint8_t MMU::ReadUInt8(uint32_t address)
 {
-    switch ((address & 0x0F000000) >> 24)
+    return Read<uint8_t>(address);
+}
+
+template <typename T>
+T MMU::Read(uint32_t address)
+{
+    MemoryPage const& page = _readPages[(address & 0x0FFFFFFF) >> PAGE_SHIFT];
+
+    if (page.Memory)
+        return Load<T>(page.Memory + (address & page.Mask));
+
+    switch (page.Handler)
     {
-        case 0x0: // Bios - System ROM
-            // (00004000-01FFFFFF)
-            Utilities::Assert(address <= 0x3FFF, "Trying to read in unused BIOS memory");
-            if (_cpu->GetRegister(PC) < 0x400) // Reading here is allowed.
-                return _bios[address];
+        case MemoryHandler::BIOS:
             // Reading from the BIOS is allowed IFF the Program Counter is located inside
             // the BIOS. If not, reading will return the most recent successfully fetched
             // BIOS opcode (eg. the opcode at [00DCh+8] after startup and SoftReset, the
             // opcode at [0134h+8] during IRQ execution, and opcode at [013Ch+8] after IRQ
             // execution, and opcode at [0188h+8] after SWI execution).
+            if (_cpu->GetRegister(PC) < 0x400)
+                return Load<T>(&_bios[address & (BIOS_SIZE - 1)]);
             return 0;
-        case 0x2: // On-Board WRAM
-            // (02040000-02FFFFFF)
-            Utilities::Assert(address <= 0x0203FFFF, "Trying to read in unused EWRAM memory");
-            // Accessing unused memory returns the recently pre-fetched opcode, ie. the
-            // 32bit opcode at $+8 in ARM state, or the 16bit-opcode at $+4 in THUMB state,
-            // in the later case the 16bit opcode is mirrored across both upper/lower 16bits
-            // of the returned 32bit data.
-            return _ewram[address - 0x02000000];
-        case 0x3: // On-Chip WRAM
-            Utilities::Assert(address <= 0x03007FFF, "Trying to read in unused IWRAM memory");
-            return _iwram[address - 0x03000000];
-        case 0x4: // I/O Registers
-            Utilities::Assert(address <= 0x040003FF, "Trying to read in unused IOMAP memory");
-            return _ioram[(address & 0xFFF) % 0x400];
-        case 0x5: // BG/OBJ Palette RAM
-            Utilities::Assert(address <= 0x050003FF, "Trying to read in unused palette memory");
-            return _cpu->GetGPU()->ReadInt8(address);
-        case 0x6: // VRAM
-            Utilities::Assert(address <= 0x06017FFF, "Trying to read in unused VRAM memory");
-            return _cpu->GetGPU()->ReadInt8(address);
-        case 0x7: // OAM - OBJ Attributes
-            Utilities::Assert(address <= 0x070003FF, "Trying to read in unused OBJ memory");
-            return _cpu->GetGPU()->ReadInt8(address);
-        case 0x8: // Game Pak, State 0
-        case 0x9: // Game Pak, State 0
-        case 0xA: // Game Pak, State 1
-        case 0xB: // Game Pak, State 1
-        case 0xC: // Game Pak, State 2
-        case 0xD: // Game Pak, State 2
-            // ((0x8, 0x9) - 0x8) >> 1 = 0
-            // ((0xA, 0xB) - 0x8) >> 1 = 1
-            // ((0xC, 0xD) - 0x8) >> 1 = 2
-            return _pakROM[(address - 0x08000000) >> 25][address % 0x02000000];
-        case 0xE: // Game Pak SRAM
-            Utilities::Assert(address <= 0x0E00FFFF, "Trying to read in unused SRAM memory");
-            return _sram[address - 0x0E000000];
+        case MemoryHandler::IO:
+            Utilities::Assert((address & 0x00FFFFFF) < IO_SIZE, "Trying to read in unused IOMAP memory");
+            return _cpu->GetIO()->Read<T>(address);
+        case MemoryHandler::GamePak:
+        {
+            T value = 0;
+
+            for (uint32_t i = 0; i < sizeof(T); ++i)
+                value |= T(OpenBusByte(address + i)) << (i * 8);
+
+            return value;
+        }
+        default:
+            break;
     }
+
+    Utilities::Assert(false, "Trying to read in unused memory");
     return 0;
 }
 
+uint8_t* MMU::GetPointer(MemoryPage const* pages, uint32_t address, uint32_t size)
+{
+    uint32_t last = address + size - 1;
+
+    if (!size || last < address || (address & 0xF0000000) != (last & 0xF0000000))
+        return nullptr;
+
+    MemoryPage const& first = pages[(address & 0x0FFFFFFF) >> PAGE_SHIFT];
+
+    if (!first.Memory)
+        return nullptr;
+
+    uint8_t* start = first.Memory + (address & first.Mask);
+
+    // Each page has to continue the memory where the previous one left off, both at its first and its last byte in the range
+    for (uint32_t current = address; ; )
+    {
+        MemoryPage const& page = pages[(current & 0x0FFFFFFF) >> PAGE_SHIFT];
+        uint32_t end = std::min(last, current | (PAGE_SIZE - 1));
+
+        if (!page.Memory || page.Memory + (current & page.Mask) != start + (current - address) ||
+            page.Memory + (end & page.Mask) != start + (end - address))
+            return nullptr;
+
+        if (end == last)
+            return start;
+
+        current = end + 1;
+    }
+}
+
+uint32_t MMU::GetCanonicalAddress(uint32_t address)
+{
+    switch ((address & 0x0F000000) >> 24)
+    {
+        case 0x2:
+            return 0x02000000 | (address & (EWRAM_SIZE - 1));
+        case 0x3:
+            return 0x03000000 | (address & (IWRAM_SIZE - 1));
+        default:
+            return address;
+    }
+}
+
+uint8_t const* MMU::GetReadPointer(uint32_t address, uint32_t size) const
+{
+    return GetPointer(_readPages, address, size);
+}
+
+uint8_t* MMU::GetWritePointer(uint32_t address, uint32_t size)
+{
+    return GetPointer(_writePages, address, size);
+}
+
+void MMU::NotifyWrite(uint32_t address, uint32_t size)
+{
+    ++_writes;
+
+    if (size && _writePages[(address & 0x0FFFFFFF) >> PAGE_SHIFT].Code)
+        _cpu->GetInstructionCache()->Invalidate(GetCanonicalAddress(address), size);
+}
+
 void MMU::WriteUInt32(uint32_t address, uint32_t value)
 {
-    WriteUInt16(address, value & 0xFFFF);
-    WriteUInt16(address + 2, (value >> 16) & 0xFFFF);
+    Write<uint32_t>(address & ~3, value);
 }
 
 void MMU::WriteUInt16(uint32_t address, uint16_t value)
 {
-    WriteUInt8(address, value & 0xFF);
-    WriteUInt8(address + 1, (value >> 8) & 0xFF);
+    Write<uint16_t>(address & ~1, value);
 }
 
 void MMU::WriteUInt8(uint32_t address, uint8_t value)
 {
-    switch ((address & 0x0F000000) >> 24)
+    Write<uint8_t>(address, value);
+}
+
+template <typename T>
+void MMU::Write(uint32_t address, T value)
+{
+    MemoryPage const& page = _writePages[(address & 0x0FFFFFFF) >> PAGE_SHIFT];
+    ++_writes;
+
+    if (page.Memory)
     {
-        case 0x0: // Bios - System ROM
-            // (00004000-01FFFFFF)
-            Utilities::Assert(false, "Trying to write in BIOS.");
-        case 0x2: // On-Board WRAM
-            // (02040000-02FFFFFF)
-            Utilities::Assert(address <= 0x0203FFFF, "Trying to write in unused EWRAM memory");
-            // Accessing unused memory returns the recently pre-fetched opcode, ie. the
-            // 32bit opcode at $+8 in ARM state, or the 16bit-opcode at $+4 in THUMB state,
-            // in the later case the 16bit opcode is mirrored across both upper/lower 16bits
-            // of the returned 32bit data.
-            _ewram[address - 0x02000000] = value;
-            break;
-        case 0x3: // On-Chip WRAM
-            Utilities::Assert(address <= 0x03007FFF, "Trying to write in unused IWRAM memory");
-            _iwram[address - 0x03000000] = value;
-            break;
-        case 0x4: // I/O Registers
-            Utilities::Assert(address <= 0x040003FF, "Trying to write in unused IOMAP memory");
-            
-            // The way the GBA handles the Interrupt Request Flags makes this code necessary, writing 1 to the bits in this address will both enable and disable interrupt requests
-            if (address >= InterruptRequestFlags && address < InterruptRequestFlags + 2)
-                _ioram[(address & 0xFFF) % 0x400] ^= value;
-            else
-                _ioram[(address & 0xFFF) % 0x400] = value;
+        Store<T>(page.Memory + (address & page.Mask), value);
 
+        // Each call invalidates the instructions that overlap one halfword
+        if (page.Code)
+        {
+            uint32_t canonical = GetCanonicalAddress(address);
+
+            for (uint32_t i = 0; i < sizeof(T); i += 2)
+                _cpu->GetInstructionCache()->Invalidate(canonical + i);
+        }
+
+        return;
+    }
+
+    switch (page.Handler)
+    {
+        case MemoryHandler::BIOS:
+            Utilities::Assert(false, "Trying to write in BIOS.");
             break;
-        case 0x5: // BG/OBJ Palette RAM
-            Utilities::Assert(address <= 0x050003FF, "Trying to write in unused palette memory");
-            _cpu->GetGPU()->WriteUInt8(address, value);
-            break;
-        case 0x6: // VRAM
-            Utilities::Assert(address <= 0x06017FFF, "Trying to write in unused VRAM memory");
-            _cpu->GetGPU()->WriteUInt8(address, value);
-            break;
-        case 0x7: // OAM - OBJ Attributes
-            Utilities::Assert(address <= 0x070003FF, "Trying to write in unused OBJ memory");
-            _cpu->GetGPU()->WriteUInt8(address, value);
+        case MemoryHandler::IO:
+            Utilities::Assert((address & 0x00FFFFFF) < IO_SIZE, "Trying to write in unused IOMAP memory");
+            _cpu->GetIO()->Write<T>(address, value);
             break;
-        case 0x8: // Game Pak, State 0
-        case 0x9: // Game Pak, State 0
-        case 0xA: // Game Pak, State 1
-        case 0xB: // Game Pak, State 1
-        case 0xC: // Game Pak, State 2
-        case 0xD: // Game Pak, State 2
-            // ((0x8, 0x9) - 0x8) >> 1 = 0
-            // ((0xA, 0xB) - 0x8) >> 1 = 1
-            // ((0xC, 0xD) - 0x8) >> 1 = 2
-            _pakROM[(address - 0x08000000) >> 25][address % 0x02000000] = value;
+        case MemoryHandler::GamePak:
+            // Writes to the ROM are ignored, none of the extra cartridge hardware is emulated
             break;
-        case 0xE: // Game Pak SRAM
-            Utilities::Assert(address <= 0x0E00FFFF, "Trying to write in unused SRAM memory");
-            _sram[address - 0x0E000000] = value;
+        default:
+            Utilities::Assert(false, "Trying to write in unused memory");
             break;
     }
 }
-
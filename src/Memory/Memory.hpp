@@ -1,6 +1,9 @@
 #ifndef MEMORY_HPP
 #define MEMORY_HPP
 
+#include "Memory/MemoryArena.hpp"
+#include "Memory/ROMImage.hpp"
+
 #include <memory>
 #include <cstdint>
 
@@ -15,6 +18,25 @@ enum WaitStates
     NUM_WAIT_STATES = 3
 };
 
+// How accesses to a page that isn't plain memory are handled
+enum class MemoryHandler : uint8_t
+{
+    Unmapped,
+    BIOS,   // Only readable while the PC is inside it
+    IO,     // Memory mapped registers, some of them have side effects
+    GamePak // Open bus past the end of the ROM, writes are ignored
+};
+
+// An entry of the page table, plain memory is accessed at Memory + (address & Mask).
+// Memory is null for the pages that need a handler.
+struct MemoryPage
+{
+    uint8_t* Memory;
+    uint32_t Mask;
+    MemoryHandler Handler;
+    bool Code; // Writes have to invalidate the decoded instructions
+};
+
 // Memory Management Unit
 class MMU final
 {
@@ -23,26 +45,72 @@ public:
 
     void LoadROM(GBAHeader& header, FILE* rom, FILE* bios);
 
+    // Misaligned words are rotated like LDR does, misaligned halfwords and all stores ignore the low bits of the address
     uint32_t ReadUInt32(uint32_t address);
     uint16_t ReadUInt16(uint32_t address);
     uint8_t ReadUInt8(uint32_t address);
 
+    // LDRH rotates a misaligned halfword by a byte, LDRSH only sign extends the byte at a misaligned address
+    uint32_t LoadHalfword(uint32_t address);
+    uint32_t LoadSignedHalfword(uint32_t address);
+
     void WriteUInt32(uint32_t address, uint32_t value);
     void WriteUInt16(uint32_t address, uint16_t value);
     void WriteUInt8(uint32_t address, uint8_t value);
 
+    // Stores the guest did so far, to any region
+    uint64_t GetWriteCount() const { return _writes; }
+
+    // The address of the same memory in the first mirror of EWRAM or IWRAM, the decoded and compiled code is kept by it so
+    // a store through any mirror reaches it. Other addresses are returned as they are
+    static uint32_t GetCanonicalAddress(uint32_t address);
+
+    // The host memory behind size bytes at the address, for bulk copies. Null if part of the range needs a handler or wraps
+    // around a mirror, the caller then has to go through the accessors above.
+    // Writes through the pointer bypass the decoded code, NotifyWrite has to be called afterwards.
+    uint8_t const* GetReadPointer(uint32_t address, uint32_t size) const;
+    uint8_t* GetWritePointer(uint32_t address, uint32_t size);
+    void NotifyWrite(uint32_t address, uint32_t size);
+
 private:
+    enum PageTable
+    {
+        PAGE_SHIFT = 14,
+        PAGE_SIZE = 1 << PAGE_SHIFT, // 16 KBytes
+        NUM_PAGES = 0x10000000 >> PAGE_SHIFT, // The whole 28 bit bus
+        GAME_PAK_SIZE = 0x2000000 // Each wait state region, and the largest possible ROM
+    };
+
+    static_assert(uint32_t(PAGE_SIZE) == uint32_t(ROM_TAIL_SIZE), "The copy of the end of the ROM has to fill a page");
+
+    void MapMemory();
+    void MapGamePak();
+    // Maps size bytes of the bus to the memory, repeating it if it is smaller
+    void MapMirrored(uint32_t address, uint32_t size, uint8_t* memory, uint32_t memorySize, bool code);
+
+    // Aligned accesses, a single page table lookup and a load or store for everything but the BIOS and the I/O registers
+    template <typename T>
+    T Read(uint32_t address);
+    template <typename T>
+    void Write(uint32_t address, T value);
+
+    static uint8_t* GetPointer(MemoryPage const* pages, uint32_t address, uint32_t size);
+
+    // Regions of the memory arena of the CPU
+    uint8_t* _bios;
+    uint8_t* _ewram;
+    uint8_t* _iwram;
+    uint8_t* _sram;
 
-    uint8_t _ioram[0x400];   // 04000000 - 040003FF   IORAM - Memory mapped registers (1Kb)
-    uint8_t _bios[0x4000];   // 00000000 - 00003FFF   BIOS - System ROM         (16 KBytes)
-    uint8_t _ewram[0x40000]; // 02000000 - 0203FFFF   WRAM - On-board Work RAM  (256 KBytes) 2 Wait
-    uint8_t _iwram[0x8000];  // 03000000 - 03007FFF   WRAM - On-chip Work RAM   (32 KBytes)
-    uint8_t _vram[0x18000];  // 06000000 - 06017FFF   VRAM - Video RAM          (96 KBytes)
+    ROMImage _rom;        // 08000000 - 09FFFFFF   Game Pak ROM, mirrored in the other two wait state regions
+    uint8_t* _romTail;    // Copy of the last partial page of the ROM
 
-    uint8_t _pakROM[NUM_WAIT_STATES][0x2000000];
-    uint8_t _sram[0x10000];  // 0E000000 - 0E00FFFF   Game Pak SRAM    (max 64 KBytes) - 8bit Bus width
+    // Separate tables for reads and writes, so that regions can be mapped differently for each
+    MemoryPage _readPages[NUM_PAGES];
+    MemoryPage _writePages[NUM_PAGES];
 
     CPU* _cpu;
+    uint64_t _writes;
 };
 
 #endif
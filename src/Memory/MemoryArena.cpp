@@ -0,0 +1,133 @@
+#include "MemoryArena.hpp"
+#include "Common/Utilities.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define ARENA_MAPPING_SUPPORTED 1
+#else
+#define ARENA_MAPPING_SUPPORTED 0
+#endif
+
+namespace
+{
+    enum ArenaAlignment
+    {
+        REGION_ALIGNMENT = 0x1000, // Every region starts on its own host page
+        HUGE_PAGE_SIZE = 0x200000
+    };
+
+    std::size_t AlignUp(std::size_t value, std::size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+MemoryArena::MemoryArena(MemoryArenaPages pages) : _base(nullptr), _allocation(nullptr), _capacity(GetOffset(MemoryRegion::Count)), _huge(false)
+{
+#if ARENA_MAPPING_SUPPORTED
+    // Anonymous mappings come zeroed, and their pages are only touched once the guest uses them
+#ifdef MAP_HUGETLB
+    if (pages == MemoryArenaPages::Huge)
+    {
+        std::size_t capacity = AlignUp(_capacity, HUGE_PAGE_SIZE);
+        void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (base != MAP_FAILED)
+        {
+            _allocation = base;
+            _base = static_cast<uint8_t*>(base);
+            _capacity = capacity;
+            _huge = true;
+            return;
+        }
+    }
+#endif
+
+    void* base = mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    Utilities::Assert(base != MAP_FAILED, "Could not allocate the guest memory");
+
+    _allocation = base;
+    _base = static_cast<uint8_t*>(base);
+
+#ifdef MADV_HUGEPAGE
+    // Without reserved huge pages, ask for transparent ones
+    if (pages == MemoryArenaPages::Huge)
+        madvise(base, _capacity, MADV_HUGEPAGE);
+#endif
+#else
+    (void)pages;
+
+    // The extra page makes room to align the start
+    _allocation = calloc(_capacity + REGION_ALIGNMENT, sizeof(uint8_t));
+    Utilities::Assert(_allocation != nullptr, "Could not allocate the guest memory");
+    _base = reinterpret_cast<uint8_t*>(AlignUp(reinterpret_cast<std::size_t>(_allocation), REGION_ALIGNMENT));
+#endif
+}
+
+MemoryArena::~MemoryArena()
+{
+#if ARENA_MAPPING_SUPPORTED
+    munmap(_allocation, _capacity);
+#else
+    free(_allocation);
+#endif
+}
+
+uint32_t MemoryArena::GetSize(MemoryRegion region)
+{
+    switch (region)
+    {
+        case MemoryRegion::BIOS:
+            return BIOS_SIZE;
+        case MemoryRegion::EWRAM:
+            return EWRAM_SIZE;
+        case MemoryRegion::IWRAM:
+            return IWRAM_SIZE;
+        case MemoryRegion::IO:
+            return IO_SIZE;
+        case MemoryRegion::Palette:
+            return PALETTE_SIZE;
+        case MemoryRegion::VRAM:
+            return VRAM_SIZE;
+        case MemoryRegion::OAM:
+            return OAM_SIZE;
+        case MemoryRegion::SRAM:
+            return SRAM_SIZE;
+        case MemoryRegion::ROMTail:
+            return ROM_TAIL_SIZE;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+uint32_t MemoryArena::GetOffset(MemoryRegion region)
+{
+    // The regions follow each other, the offset of Count is the size of the whole arena
+    uint32_t offset = 0;
+
+    for (uint8_t i = 0; i < uint8_t(region); ++i)
+        offset += uint32_t(AlignUp(GetSize(MemoryRegion(i)), REGION_ALIGNMENT));
+
+    return offset;
+}
+
+void MemoryArena::Clear(MemoryRegion region)
+{
+    memset(Get(region), 0, GetSize(region));
+}
+
+void MemoryArena::Clear()
+{
+#if defined(__linux__) && ARENA_MAPPING_SUPPORTED
+    // Dropping the pages zeroes them without touching them, they are faulted back in as the guest uses them
+    if (!_huge && madvise(_base, _capacity, MADV_DONTNEED) == 0)
+        return;
+#endif
+
+    memset(_base, 0, GetOffset(MemoryRegion::Count));
+}
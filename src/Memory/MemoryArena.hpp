@@ -0,0 +1,72 @@
+#ifndef MEMORY_ARENA_HPP
+#define MEMORY_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Every block of memory the guest can address, in the order they are laid out in the arena
+enum class MemoryRegion : uint8_t
+{
+    BIOS,
+    EWRAM,
+    IWRAM,
+    IO,
+    Palette,
+    VRAM,
+    OAM,
+    SRAM,
+    ROMTail, // Copy of the last partial page of the ROM, the rest of it is mapped from the file
+    Count
+};
+
+enum MemoryRegionSizes
+{
+    BIOS_SIZE = 0x4000,     // 00000000 - 00003FFF   BIOS - System ROM         (16 KBytes)
+    EWRAM_SIZE = 0x40000,   // 02000000 - 0203FFFF   WRAM - On-board Work RAM  (256 KBytes) 2 Wait
+    IWRAM_SIZE = 0x8000,    // 03000000 - 03007FFF   WRAM - On-chip Work RAM   (32 KBytes)
+    IO_SIZE = 0x400,        // 04000000 - 040003FF   IORAM - Memory mapped registers (1Kb)
+    PALETTE_SIZE = 0x400,   // 05000000 - 050003FF   BG/OBJ Palette RAM        (1 Kbyte)
+    VRAM_SIZE = 0x18000,    // 06000000 - 06017FFF   VRAM - Video RAM          (96 KBytes)
+    OAM_SIZE = 0x400,       // 07000000 - 070003FF   OAM - OBJ Attributes      (1 Kbyte)
+    SRAM_SIZE = 0x10000,    // 0E000000 - 0E00FFFF   Game Pak SRAM    (max 64 KBytes) - 8bit Bus width
+    ROM_TAIL_SIZE = 0x4000  // A page of the page table of the MMU
+};
+
+// How the arena is backed by the host
+enum class MemoryArenaPages
+{
+    Normal,
+    Huge // Falls back to normal pages when the host has none to spare
+};
+
+// All the guest memory of a machine in a single zeroed, page aligned allocation. The MMU and the GPU only keep pointers
+// into it, so a CPU stays small and many of them fit in one process.
+class MemoryArena final
+{
+public:
+    MemoryArena(MemoryArenaPages pages);
+    ~MemoryArena();
+
+    MemoryArena(MemoryArena const&) = delete;
+    MemoryArena& operator=(MemoryArena const&) = delete;
+
+    uint8_t* Get(MemoryRegion region) { return _base + GetOffset(region); }
+    static uint32_t GetSize(MemoryRegion region);
+
+    // Zeroes a region, or all of them
+    void Clear(MemoryRegion region);
+    void Clear();
+
+    std::size_t GetCapacity() const { return _capacity; }
+    bool UsesHugePages() const { return _huge; }
+
+private:
+    static uint32_t GetOffset(MemoryRegion region);
+
+    uint8_t* _base;
+    void* _allocation; // Where _base was carved from
+    std::size_t _capacity; // What was allocated, rounded up to whole pages
+    bool _huge;
+};
+
+#endif
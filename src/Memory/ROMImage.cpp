@@ -0,0 +1,70 @@
+#include "ROMImage.hpp"
+#include "Common/GBA.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define ROM_MAPPING_SUPPORTED 1
+#else
+#define ROM_MAPPING_SUPPORTED 0
+#endif
+
+ROMImage::ROMImage() : _data(nullptr), _size(0), _mappedSize(0)
+{
+}
+
+ROMImage::~ROMImage()
+{
+    Release();
+}
+
+void ROMImage::Load(GBAHeader const& header, FILE* file)
+{
+    Release();
+
+#if ROM_MAPPING_SUPPORTED
+    // The mapping starts at the beginning of the file, so it includes the header
+    struct stat status;
+    int descriptor = fileno(file);
+
+    if (descriptor >= 0 && fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && std::size_t(status.st_size) >= sizeof(GBAHeader))
+    {
+        void* data = mmap(nullptr, std::size_t(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+
+        if (data != MAP_FAILED)
+        {
+            _data = static_cast<uint8_t const*>(data);
+            _size = uint32_t(status.st_size);
+            _mappedSize = std::size_t(status.st_size);
+            return;
+        }
+    }
+#endif
+
+    uint8_t const* headerData = reinterpret_cast<uint8_t const*>(&header);
+    _buffer.assign(headerData, headerData + sizeof(GBAHeader));
+
+    // The size of a pipe isn't known up front
+    uint8_t chunk[0x4000];
+    std::size_t read;
+
+    while ((read = fread(chunk, sizeof(uint8_t), sizeof(chunk), file)) != 0)
+        _buffer.insert(_buffer.end(), chunk, chunk + read);
+
+    _data = _buffer.data();
+    _size = uint32_t(_buffer.size());
+}
+
+void ROMImage::Release()
+{
+#if ROM_MAPPING_SUPPORTED
+    if (_mappedSize)
+        munmap(const_cast<uint8_t*>(_data), _mappedSize);
+#endif
+
+    _data = nullptr;
+    _size = 0;
+    _mappedSize = 0;
+    _buffer.clear();
+    _buffer.shrink_to_fit();
+}
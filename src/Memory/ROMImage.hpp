@@ -0,0 +1,38 @@
+#ifndef ROM_IMAGE_HPP
+#define ROM_IMAGE_HPP
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct GBAHeader;
+
+// The contents of a cartridge. Regular files are mapped read-only instead of copied, so loading doesn't depend on the
+// size of the ROM and every process running the same game shares its pages. Pipes and the like are read into a buffer.
+class ROMImage final
+{
+public:
+    ROMImage();
+    ~ROMImage();
+
+    ROMImage(ROMImage const&) = delete;
+    ROMImage& operator=(ROMImage const&) = delete;
+
+    // The header was already read from the file, the rest of it is still to be read
+    void Load(GBAHeader const& header, FILE* file);
+
+    uint8_t const* GetData() const { return _data; }
+    uint32_t GetSize() const { return _size; }
+    bool IsMapped() const { return _mappedSize != 0; }
+
+private:
+    void Release();
+
+    uint8_t const* _data;
+    uint32_t _size;
+    std::size_t _mappedSize; // Zero when the ROM was read into the buffer
+    std::vector<uint8_t> _buffer;
+};
+
+#endif
@@ -70,19 +70,19 @@ void MainWindow::open()
         return;
     }
 
+    // The BIOS calls are emulated without a BIOS file
     FILE* bios = fopen("./gba_bios.bin", "rb");
     if (!bios)
-    {
-        std::cout << "Could not load the GBA Bios." << std::endl;
-        return;
-    }
+        std::cout << "Could not load the GBA Bios, its functions will be emulated." << std::endl;
 
     _cpu = std::shared_ptr<CPU>(new CPU(CPUExecutionMode::Interpreter));
     RegisterCPUCallbacks();
 
     _cpu->LoadROM(_header, rom, bios);
 
-    fclose(bios);
+    if (bios)
+        fclose(bios);
+
     fclose(rom);
 
     auto checkbox = findChild<QCheckBox*>("runOnLoad");
@@ -110,9 +110,9 @@ void MainWindow::RegisterCPUCallbacks()
     if (!_cpu)
         return;
 
-    _cpu->RegisterInstructionCallback(InstructionCallbackTypes::InstructionExecuted, [&](std::shared_ptr<Instruction> instruction)
+    _cpu->RegisterInstructionCallback(InstructionCallbackTypes::InstructionExecuted, [&](DecodedInstruction const& instruction)
     {
-        QString message = QString::fromUtf8(("Set: " + std::string(instruction->GetInstructionSet() == InstructionSet::ARM ? "ARM" : "Thumb") + ". Instruction: " + instruction->ToString()).c_str());
+        QString message = QString::fromUtf8(("Set: " + std::string(instruction.GetInstructionSet() == InstructionSet::ARM ? "ARM" : "Thumb") + ". Instruction: " + instruction.ToString()).c_str());
 
         if (_cpu->GetRegister(PC) == 0x08000346)
             _cpu->Stop();
@@ -2,6 +2,8 @@
 #include "Common/GBA.hpp"
 
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 NoGUI::NoGUI(int argc, char* argv[])
 {
@@ -32,28 +34,113 @@ NoGUI::NoGUI(int argc, char* argv[])
         return;
     }
 
+    // The BIOS calls are emulated without a BIOS file
     FILE* bios = fopen("./gba_bios.bin", "rb");
     if (!bios)
+        std::cout << "Could not load the GBA Bios, its functions will be emulated." << std::endl;
+
+    // --cached runs the ROM with the cached interpreter, --jit compiles it
+    CPUExecutionMode mode = CPUExecutionMode::Interpreter;
+
+    if (argc > 3 && !strcmp(argv[3], "--cached"))
+        mode = CPUExecutionMode::CachedInterpreter;
+    else if (argc > 3 && !strcmp(argv[3], "--jit"))
+        mode = CPUExecutionMode::JIT;
+
+    // --lockstep <cached|jit> [interval] runs that engine next to the interpreter and stops where they disagree
+    if (argc > 4 && !strcmp(argv[3], "--lockstep"))
     {
-        std::cout << "Could not load the GBA Bios." << std::endl;
+        mode = !strcmp(argv[4], "jit") ? CPUExecutionMode::JIT : CPUExecutionMode::CachedInterpreter;
+        uint32_t interval = argc > 5 ? uint32_t(strtoul(argv[5], nullptr, 10)) : 1000;
+
+        _lockstep = std::unique_ptr<LockstepRunner>(new LockstepRunner(mode, interval));
+        _lockstep->LoadROM(header, rom, bios);
+
+        if (bios)
+            fclose(bios);
+
+        fclose(rom);
         return;
     }
 
-    _cpu = std::unique_ptr<CPU>(new CPU(CPUExecutionMode::Interpreter));
+    // --huge-pages, anywhere after the ROM, backs the guest memory with huge pages.
+    // --no-idle-skip runs every iteration of the loops that wait for an event.
+    // --hle-bios emulates the BIOS calls even when the BIOS file was loaded
+    MemoryArenaPages pages = MemoryArenaPages::Normal;
+    bool idleSkip = true;
+    bool hle = false;
+
+    for (int i = 3; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--huge-pages"))
+            pages = MemoryArenaPages::Huge;
+        else if (!strcmp(argv[i], "--no-idle-skip"))
+            idleSkip = false;
+        else if (!strcmp(argv[i], "--hle-bios"))
+            hle = true;
+    }
+
+    _cpu = std::unique_ptr<CPU>(new CPU(mode, pages));
+    _cpu->GetIdleLoopDetector()->SetEnabled(idleSkip);
+    _cpu->GetHLEBIOS()->SetEnabled(hle);
 
     RegisterCPUCallbacks();
 
     _cpu->LoadROM(header, rom, bios);
 
-    fclose(bios);
+    if (bios)
+        fclose(bios);
+
     fclose(rom);
 }
 
+void NoGUI::Run()
+{
+    if (_lockstep)
+    {
+        while (_lockstep->Step());
+
+        std::cout << _lockstep->GetDivergence().ToString();
+        return;
+    }
+
+    if (!_cpu)
+        return;
+
+    _cpu->Run();
+
+    InstructionCacheStatistics const& statistics = _cpu->GetInstructionCache()->GetStatistics();
+    std::cout << "Instruction cache: " << statistics.Hits << " hits, " << statistics.Misses << " misses, " << statistics.Invalidations << " invalidations" << std::endl;
+
+    BlockCacheStatistics const& blocks = _cpu->GetBlockCache()->GetStatistics();
+    std::cout << "Block cache: " << blocks.Hits << " hits, " << blocks.Misses << " misses, " << blocks.Invalidations << " invalidations" << std::endl;
+
+    if (_cpu->GetJIT())
+    {
+        JITStatistics const& jit = _cpu->GetJIT()->GetStatistics();
+        std::cout << "JIT: " << jit.CompiledBlocks << " blocks, " << jit.CompiledInstructions << " instructions (" << jit.InterpretedInstructions << " interpreted), "
+            << jit.Invalidations << " invalidations, " << jit.Flushes << " flushes" << std::endl;
+    }
+
+    IdleLoopStatistics const& idle = _cpu->GetIdleLoopDetector()->GetStatistics();
+    std::cout << "Idle loops: " << idle.SpinLoops << " spinning, " << idle.PollingLoops << " polling, " << idle.SkippedCycles << " of "
+        << _cpu->GetCycles() << " cycles skipped" << std::endl;
+
+    DMAStatistics const& dma = _cpu->GetDMA()->GetStatistics();
+    std::cout << "DMA: " << dma.Transfers << " transfers (" << dma.FastTransfers << " copied at once), " << dma.Cycles << " cycles" << std::endl;
+
+    if (_cpu->GetHLEBIOS()->IsEnabled())
+    {
+        HLEBIOSStatistics const& hle = _cpu->GetHLEBIOS()->GetStatistics();
+        std::cout << "HLE BIOS: " << hle.Calls << " calls emulated, " << hle.Fallbacks << " left to the BIOS" << std::endl;
+    }
+}
+
 void NoGUI::RegisterCPUCallbacks()
 {
-    _cpu->RegisterInstructionCallback(InstructionCallbackTypes::InstructionExecuted, [&](std::shared_ptr<Instruction> instruction)
+    _cpu->RegisterInstructionCallback(InstructionCallbackTypes::InstructionExecuted, [&](DecodedInstruction const& instruction)
     {
-        //std::cout << "Set: " << (instruction->GetInstructionSet() == InstructionSet::ARM ? "ARM" : "Thumb") << ". Instruction: " << instruction->ToString() << std::endl;
+        //std::cout << "Set: " << (instruction.GetInstructionSet() == InstructionSet::ARM ? "ARM" : "Thumb") << ". Instruction: " << instruction.ToString() << std::endl;
     });
 }
 
@@ -2,6 +2,7 @@
 #define NO_GUI_HPP
 
 #include "CPU/CPU.hpp"
+#include "CPU/LockstepRunner.hpp"
 
 #include <memory>
 
@@ -10,10 +11,11 @@ class NoGUI
 public:
     NoGUI(int argc, char* argv[]);
 
-    void Run() { _cpu->Run(); }
+    void Run();
     void RegisterCPUCallbacks();
 
 private:
     std::unique_ptr<CPU> _cpu;
+    std::unique_ptr<LockstepRunner> _lockstep; // Only in the lockstep mode
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "Scheduler.hpp"
+
+#include <algorithm>
+
+Scheduler::Scheduler() : _sequence(0), _eventsRun(0), _scheduled(), _times(), _generations()
+{
+    _heap.reserve(MAX_HEAP_SIZE);
+}
+
+void Scheduler::RegisterHandler(EventType type, EventHandler const& handler)
+{
+    _handlers[uint8_t(type)] = handler;
+}
+
+void Scheduler::Schedule(EventType type, uint64_t time)
+{
+    uint8_t index = uint8_t(type);
+
+    // The previous entry of this type, if any, becomes stale
+    ++_generations[index];
+    _scheduled[index] = true;
+    _times[index] = time;
+
+    // Events that keep moving would fill the heap with their old entries
+    if (_heap.size() >= MAX_HEAP_SIZE)
+        Compact();
+
+    Event event = { time, _sequence++, _generations[index], type };
+    _heap.push_back(event);
+    std::push_heap(_heap.begin(), _heap.end(), Later);
+
+    DropStale();
+}
+
+void Scheduler::Cancel(EventType type)
+{
+    uint8_t index = uint8_t(type);
+
+    ++_generations[index];
+    _scheduled[index] = false;
+
+    DropStale();
+}
+
+void Scheduler::RunEvents(uint64_t time)
+{
+    while (!_heap.empty() && _heap.front().Time <= time)
+    {
+        Event event = _heap.front();
+        std::pop_heap(_heap.begin(), _heap.end(), Later);
+        _heap.pop_back();
+
+        _scheduled[uint8_t(event.Type)] = false;
+        ++_eventsRun;
+
+        // The handler may schedule the same event again
+        if (_handlers[uint8_t(event.Type)])
+            _handlers[uint8_t(event.Type)](event.Time);
+
+        DropStale();
+    }
+}
+
+bool Scheduler::Later(Event const& first, Event const& second)
+{
+    if (first.Time != second.Time)
+        return first.Time > second.Time;
+
+    return first.Sequence > second.Sequence;
+}
+
+void Scheduler::DropStale()
+{
+    while (!_heap.empty() && IsStale(_heap.front()))
+    {
+        std::pop_heap(_heap.begin(), _heap.end(), Later);
+        _heap.pop_back();
+    }
+}
+
+void Scheduler::Compact()
+{
+    _heap.erase(std::remove_if(_heap.begin(), _heap.end(), [this](Event const& event) { return IsStale(event); }), _heap.end());
+    std::make_heap(_heap.begin(), _heap.end(), Later);
+}
+
+bool Scheduler::IsStale(Event const& event) const
+{
+    uint8_t index = uint8_t(event.Type);
+    return !_scheduled[index] || event.Generation != _generations[index];
+}
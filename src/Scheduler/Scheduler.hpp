@@ -0,0 +1,85 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Everything that happens at a known time instead of as the result of an instruction
+enum class EventType : uint8_t
+{
+    HBlank,         // The GPU finished drawing a line
+    HBlankEnd,      // The next line starts
+    Timer0Overflow,
+    Timer1Overflow,
+    Timer2Overflow,
+    Timer3Overflow,
+    DMA,            // A transfer was started by writing its control register
+    Interrupt,      // The interrupt flags or enables changed, the CPU has to check them
+    Count
+};
+
+// Keeps the upcoming events in a min-heap keyed on the cycle count of the CPU. The CPU runs instructions until the
+// time of the first one, then lets the handlers of every event that is due catch the hardware up.
+// Each type of event is scheduled at most once, scheduling it again moves it.
+class Scheduler final
+{
+public:
+    typedef std::function<void(uint64_t time)> EventHandler; // Gets the time the event was scheduled for
+
+    enum SchedulerTimes : uint64_t
+    {
+        NO_EVENT = UINT64_MAX
+    };
+
+    Scheduler();
+
+    void RegisterHandler(EventType type, EventHandler const& handler);
+
+    void Schedule(EventType type, uint64_t time);
+    void Cancel(EventType type);
+    bool IsScheduled(EventType type) const { return _scheduled[uint8_t(type)]; }
+    uint64_t GetScheduledTime(EventType type) const { return _times[uint8_t(type)]; }
+
+    uint64_t GetNextEventTime() const { return _heap.empty() ? uint64_t(NO_EVENT) : _heap.front().Time; }
+    bool IsDue(uint64_t time) const { return time >= GetNextEventTime(); }
+
+    // Runs every event scheduled at or before time in order, including the ones the handlers schedule
+    void RunEvents(uint64_t time);
+
+    // Events that ran so far
+    uint64_t GetEventsRun() const { return _eventsRun; }
+
+private:
+    enum SchedulerLimits
+    {
+        MAX_HEAP_SIZE = 64
+    };
+
+    struct Event
+    {
+        uint64_t Time;
+        uint64_t Sequence; // Events at the same time run in the order they were scheduled
+        uint32_t Generation;
+        EventType Type;
+    };
+
+    // Orders the heap so the earliest event is at the front
+    static bool Later(Event const& first, Event const& second);
+
+    // Moved and cancelled events stay in the heap until they reach the front
+    void DropStale();
+    void Compact();
+    bool IsStale(Event const& event) const;
+
+    std::vector<Event> _heap;
+    uint64_t _sequence;
+    uint64_t _eventsRun;
+
+    bool _scheduled[uint8_t(EventType::Count)];
+    uint64_t _times[uint8_t(EventType::Count)];
+    uint32_t _generations[uint8_t(EventType::Count)];
+    EventHandler _handlers[uint8_t(EventType::Count)];
+};
+
+#endif
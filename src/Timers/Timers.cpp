@@ -0,0 +1,109 @@
+#include "Timers.hpp"
+#include "CPU/CPU.hpp"
+
+// http://problemkaputt.de/gbatek.htm#gbatimers
+
+Timers::Timers(CPU* cpu) : _cpu(cpu)
+{
+    for (uint8_t timer = 0; timer < NUM_TIMERS; ++timer)
+    {
+        // Writes to TMxCNT_L only set the reload value, it stays in the register for the hardware to pick up
+        _cpu->GetIO()->RegisterReadHandler(GetCounterAddress(timer), [this, timer]()
+        {
+            return GetCounter(timer);
+        });
+
+        _cpu->GetIO()->RegisterWriteHandler(GetControlAddress(timer), [this, timer](uint16_t previous, uint16_t value)
+        {
+            WriteControl(timer, TimerControl(previous), TimerControl(value));
+        });
+
+        _cpu->GetScheduler()->RegisterHandler(EventType(uint8_t(EventType::Timer0Overflow) + timer), [this, timer](uint64_t time)
+        {
+            Overflow(timer, time);
+        });
+    }
+}
+
+uint16_t Timers::GetCounter(uint8_t timer) const
+{
+    return GetCounter(timer, _cpu->GetCycles());
+}
+
+uint16_t Timers::GetCounter(uint8_t timer, uint64_t time) const
+{
+    Timer const& state = _timers[timer];
+
+    if (!IsCounting(timer))
+        return state.Counter;
+
+    return uint16_t(state.Counter + ((time - state.Start) >> GetPrescalerShift(state.Control)));
+}
+
+void Timers::WriteControl(uint8_t timer, TimerControl previous, TimerControl value)
+{
+    Timer& state = _timers[timer];
+    uint64_t now = _cpu->GetCycles();
+
+    // Keep what the timer counted with the old settings
+    state.Counter = previous.Data.Enabled ? GetCounter(timer, now) : state.Counter;
+    state.Start = now;
+    state.Control = value;
+
+    // Starting the timer loads the reload value
+    if (value.Data.Enabled && !previous.Data.Enabled)
+        state.Counter = _cpu->GetIO()->Get(GetCounterAddress(timer));
+
+    ScheduleOverflow(timer);
+}
+
+void Timers::Overflow(uint8_t timer, uint64_t time)
+{
+    Timer& state = _timers[timer];
+
+    state.Counter = _cpu->GetIO()->Get(GetCounterAddress(timer));
+    state.Start = time;
+
+    if (state.Control.Data.IRQ)
+        _cpu->RequestInterrupt(InterruptTypes(uint8_t(InterruptTypes::Timer0Overflow) + timer));
+
+    ScheduleOverflow(timer);
+
+    // The next timer may count the overflows of this one
+    uint8_t next = timer + 1;
+
+    if (next < NUM_TIMERS && _timers[next].Control.Data.Enabled && _timers[next].Control.Data.CountUp)
+    {
+        if (++_timers[next].Counter == 0)
+            Overflow(next, time);
+    }
+}
+
+void Timers::ScheduleOverflow(uint8_t timer)
+{
+    Timer const& state = _timers[timer];
+    EventType type = EventType(uint8_t(EventType::Timer0Overflow) + timer);
+
+    if (!IsCounting(timer))
+    {
+        _cpu->GetScheduler()->Cancel(type);
+        return;
+    }
+
+    uint64_t ticks = COUNTER_RANGE - state.Counter;
+    _cpu->GetScheduler()->Schedule(type, state.Start + (ticks << GetPrescalerShift(state.Control)));
+}
+
+bool Timers::IsCounting(uint8_t timer) const
+{
+    TimerControl control = _timers[timer].Control;
+
+    // Timer 0 has no previous timer, the count-up bit is ignored
+    return control.Data.Enabled && (!control.Data.CountUp || timer == 0);
+}
+
+uint32_t Timers::GetPrescalerShift(TimerControl control)
+{
+    static uint32_t const Shifts[] = { 0, 6, 8, 10 };
+    return Shifts[control.Data.Prescaler];
+}
@@ -0,0 +1,70 @@
+#ifndef TIMERS_HPP
+#define TIMERS_HPP
+
+#include <cstdint>
+
+class CPU;
+
+#define TM0CNT_L 0x4000100 // Timer 0 Counter/Reload
+#define TM0CNT_H 0x4000102 // Timer 0 Control
+
+union TimerControl
+{
+    struct
+    {
+        uint16_t Prescaler : 2; // 1, 64, 256 or 1024 cycles per tick
+        uint16_t CountUp : 1;   // Ticks when the previous timer overflows instead, not for timer 0
+        uint16_t Unused : 3;
+        uint16_t IRQ : 1;
+        uint16_t Enabled : 1;
+        uint16_t Unused2 : 8;
+    } Data;
+
+    uint16_t Full;
+
+    TimerControl(uint16_t info) : Full(info) { }
+};
+
+// The four hardware timers. A running timer isn't stepped, only its overflow is scheduled, the counter is computed
+// from the time when the guest reads it.
+class Timers final
+{
+public:
+    enum TimerData
+    {
+        NUM_TIMERS = 4,
+        COUNTER_RANGE = 0x10000
+    };
+
+    Timers(CPU* cpu);
+
+    // What the guest reads from TMxCNT_L right now
+    uint16_t GetCounter(uint8_t timer) const;
+
+private:
+    struct Timer
+    {
+        uint16_t Counter; // Value at Start, count-up timers only keep this
+        uint64_t Start;
+        TimerControl Control;
+
+        Timer() : Counter(0), Start(0), Control(0) { }
+    };
+
+    void WriteControl(uint8_t timer, TimerControl previous, TimerControl value);
+    void Overflow(uint8_t timer, uint64_t time);
+    void ScheduleOverflow(uint8_t timer);
+
+    // Timers that tick on their own, not the stopped ones or the ones that count overflows
+    bool IsCounting(uint8_t timer) const;
+    uint16_t GetCounter(uint8_t timer, uint64_t time) const;
+    static uint32_t GetPrescalerShift(TimerControl control);
+
+    static uint32_t GetCounterAddress(uint8_t timer) { return TM0CNT_L + timer * 4; }
+    static uint32_t GetControlAddress(uint8_t timer) { return TM0CNT_H + timer * 4; }
+
+    CPU* _cpu;
+    Timer _timers[NUM_TIMERS];
+};
+
+#endif
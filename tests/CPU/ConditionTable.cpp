@@ -0,0 +1,34 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+TEST_CASE("Condition Table", "Compares the condition lookup table against the definitions of every condition code")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+
+    for (uint32_t nzcv = 0; nzcv < 16; ++nzcv)
+    {
+        cpu->SetCurrentStatusRegister((cpu->GetCurrentStatusRegister().Full & 0x0FFFFFFF) | (nzcv << 28));
+        ProgramStatusRegisters::FlagsStruct flags = cpu->GetCurrentStatusFlags();
+
+        REQUIRE(cpu->GetConditionFlags() == nzcv);
+
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::Equal) == (flags.Z == 1));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::NotEqual) == (flags.Z == 0));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::CarrySet) == (flags.C == 1));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::CarryCleared) == (flags.C == 0));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::Negative) == (flags.N == 1));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::PositiveOrZero) == (flags.N == 0));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::Overflow) == (flags.V == 1));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::NotOverflow) == (flags.V == 0));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::UnsignedHigher) == (flags.C && !flags.Z));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::UnsignedLowerOrSame) == (!flags.C || flags.Z));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::GreaterEqual) == (flags.N == flags.V));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::LessThan) == (flags.N != flags.V));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::GreaterThan) == (!flags.Z && flags.N == flags.V));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::LessOrEqual) == (flags.Z || flags.N != flags.V));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::Always));
+        REQUIRE(cpu->ConditionPasses(InstructionCondition::Unused));
+    }
+
+    delete cpu;
+}
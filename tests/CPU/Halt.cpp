@@ -0,0 +1,174 @@
+#include "catch/catch.hpp"
+#include "CPU/LockstepRunner.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    uint32_t const CODE_ADDRESS = 0x03000000;
+    uint32_t const HANDLER_ADDRESS = 0x03000100;
+    uint64_t const VBLANK_START = 160 * 1232;
+
+    // Halts through HALTCNT, then counts in r2
+    std::vector<uint32_t> const HaltProgram =
+    {
+        0xE3A00301, // MOV r0, #0x04000000
+        0xE3A01000, // MOV r1, #0
+        0xE5C01301, // STRB r1, [r0, #0x301]
+        0xE2822001, // count: ADD r2, r2, #1
+        0xEAFFFFFD  // B count
+    };
+
+    // Counts the VBlanks in r2
+    std::vector<uint16_t> const WaitProgram =
+    {
+        0xDF05, // loop: SWI 5
+        0x3201, // ADD r2, #1
+        0xE7FC  // B loop
+    };
+
+    // The IRQ handler of the BIOS, calls the one of the game at 03007FFC
+    std::vector<uint32_t> const BIOSHandler =
+    {
+        0xE92D500F, // STMFD sp!, {r0-r3, r12, lr}
+        0xE3A00301, // MOV r0, #0x04000000
+        0xE28FE000, // ADD lr, pc, #0
+        0xE510F004, // LDR pc, [r0, #-4]
+        0xE8BD500F, // LDMFD sp!, {r0-r3, r12, lr}
+        0xE25EF004  // SUBS pc, lr, #4
+    };
+
+    // Acknowledges the interrupt in IF and in the flags of the BIOS
+    std::vector<uint32_t> const GameHandler =
+    {
+        0xE3A01001, // MOV r1, #1
+        0xE2802C02, // ADD r2, r0, #0x200
+        0xE1C210B2, // STRH r1, [r2, #2]
+        0xE15020B8, // LDRH r2, [r0, #-8]
+        0xE1822001, // ORR r2, r2, r1
+        0xE14020B8, // STRH r2, [r0, #-8]
+        0xE12FFF1E  // BX lr
+    };
+
+    void LoadHalt(CPU& cpu)
+    {
+        for (uint32_t i = 0; i < HaltProgram.size(); ++i)
+            cpu.GetMemory()->WriteUInt32(CODE_ADDRESS + i * 4, HaltProgram[i]);
+
+        // The VBlank wakes the CPU up, IME keeps it from being taken
+        cpu.GetMemory()->WriteUInt16(DISPSTAT, 0x0008);
+        cpu.GetMemory()->WriteUInt16(InterruptEnableRegister, 0x0001);
+
+        cpu.SetCurrentStatusRegister(uint32_t(CPUMode::System));
+        cpu.GetRegister(PC) = CODE_ADDRESS;
+    }
+
+    void LoadWait(CPU& cpu)
+    {
+        for (uint32_t i = 0; i < WaitProgram.size(); ++i)
+            cpu.GetMemory()->WriteUInt16(CODE_ADDRESS + i * 2, WaitProgram[i]);
+
+        for (uint32_t i = 0; i < GameHandler.size(); ++i)
+            cpu.GetMemory()->WriteUInt32(HANDLER_ADDRESS + i * 4, GameHandler[i]);
+
+        // The BIOS can't be written by the guest
+        uint8_t* bios = cpu.GetMemoryArena()->Get(MemoryRegion::BIOS);
+        memcpy(&bios[0x18], BIOSHandler.data(), BIOSHandler.size() * sizeof(uint32_t));
+
+        cpu.GetMemory()->WriteUInt32(0x03007FFC, HANDLER_ADDRESS);
+        cpu.GetMemory()->WriteUInt16(DISPSTAT, 0x0008);
+        cpu.GetMemory()->WriteUInt16(InterruptEnableRegister, 0x0001);
+
+        cpu.GetRegisterForMode(CPUMode::IRQ, SP) = 0x03007FA0;
+        cpu.SetCurrentStatusRegister(uint32_t(CPUMode::System) | 0x20);
+        cpu.GetRegister(SP) = 0x03007F00;
+        cpu.GetRegister(PC) = CODE_ADDRESS;
+    }
+}
+
+TEST_CASE("Halt", "Checks that a halted CPU skips to the next interrupt and that the BIOS waits are emulated")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    LoadHalt(*cpu);
+
+    for (int i = 0; i < 3; ++i)
+        cpu->Step();
+
+    REQUIRE(cpu->IsHalted());
+
+    // Only the events run until the VBlank, two per line
+    int steps = 0;
+
+    while (cpu->IsHalted() && steps < 1000)
+    {
+        cpu->StepUntilEvent();
+        ++steps;
+    }
+
+    REQUIRE(!cpu->IsHalted());
+    REQUIRE(steps <= 2 * 160);
+    REQUIRE(cpu->GetCycles() == VBLANK_START);
+    REQUIRE(cpu->GetMemory()->ReadUInt16(VCOUNT) == 160);
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 0);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+
+    cpu->Step();
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 1);
+
+    delete cpu;
+
+    // VBlankIntrWait halts until the IRQ handler acknowledged a VBlank, then returns after the SWI
+    cpu = new CPU(CPUExecutionMode::Interpreter);
+    LoadWait(*cpu);
+
+    cpu->Step();
+    REQUIRE(cpu->IsHalted());
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == CODE_ADDRESS);
+    REQUIRE(cpu->GetMemory()->ReadUInt16(InterruptMasterEnableRegister) == 1);
+
+    uint64_t vblanks[3] = { };
+
+    while (uint32_t(cpu->GetRegister(2)) < 3 && cpu->GetCycles() < 4 * 280896)
+    {
+        uint32_t count = cpu->GetRegister(2);
+        cpu->StepUntilEvent();
+
+        if (uint32_t(cpu->GetRegister(2)) != count)
+            vblanks[count] = cpu->GetCycles();
+    }
+
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 3);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+    REQUIRE(cpu->GetCurrentInstructionSet() == InstructionSet::Thumb);
+    REQUIRE(cpu->GetMemory()->ReadUInt16(BIOSInterruptFlags) == 0);
+
+    // One count per frame, right after the VBlank
+    for (uint64_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(vblanks[i] >= VBLANK_START + i * 280896);
+        REQUIRE(vblanks[i] < VBLANK_START + i * 280896 + 1232);
+    }
+
+    delete cpu;
+
+    // The block based engines stop the block at the halt and skip the same time
+    LockstepRunner* cached = new LockstepRunner(CPUExecutionMode::CachedInterpreter, 1);
+    cached->Setup(LoadWait);
+
+    REQUIRE(cached->Run(5000));
+    REQUIRE(uint32_t(cached->GetTested()->GetRegister(2)) >= 3);
+
+    delete cached;
+
+    if (JIT::IsSupported())
+    {
+        LockstepRunner* jit = new LockstepRunner(CPUExecutionMode::JIT, 1);
+        jit->Setup(LoadHalt);
+
+        REQUIRE(jit->Run(5000));
+        REQUIRE(uint32_t(jit->GetTested()->GetRegister(2)) > 0);
+
+        delete jit;
+    }
+}
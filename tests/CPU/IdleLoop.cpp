@@ -0,0 +1,126 @@
+#include "catch/catch.hpp"
+#include "CPU/LockstepRunner.hpp"
+
+#include <vector>
+
+namespace
+{
+    uint32_t const CODE_ADDRESS = 0x03000000;
+    uint32_t const WAIT_ADDRESS = 0x0300000C;
+    uint16_t const WAITED_LINE = 100;
+
+    // Waits for VCOUNT to reach a line, then spins forever
+    std::vector<uint32_t> const Program =
+    {
+        0xE1D100B0, // loop: LDRH r0, [r1]
+        0xE3500064, // CMP r0, #100
+        0x1AFFFFFC, // BNE loop
+        0xEAFFFFFE  // B .
+    };
+
+    // Counts r2 down to 0 then counts r3 up, every iteration is different
+    std::vector<uint32_t> const Delay =
+    {
+        0xE2522001, // loop: SUBS r2, r2, #1
+        0x1AFFFFFD, // BNE loop
+        0xE2833001, // count: ADD r3, r3, #1
+        0xEAFFFFFD  // B count
+    };
+
+    void Load(CPU& cpu, std::vector<uint32_t> const& program)
+    {
+        for (uint32_t i = 0; i < program.size(); ++i)
+            cpu.GetMemory()->WriteUInt32(CODE_ADDRESS + i * 4, program[i]);
+
+        cpu.GetRegister(1) = 0x04000006; // VCOUNT
+        cpu.GetRegister(2) = 50000;
+        cpu.SetCurrentStatusRegister(uint32_t(CPUMode::System));
+        cpu.GetRegister(PC) = CODE_ADDRESS;
+    }
+
+    void LoadProgram(CPU& cpu)
+    {
+        Load(cpu, Program);
+    }
+}
+
+TEST_CASE("Idle Loops", "Checks that the loops waiting for an event are fast-forwarded without changing the outcome")
+{
+    CPU* fast = new CPU(CPUExecutionMode::Interpreter);
+    CPU* slow = new CPU(CPUExecutionMode::Interpreter);
+    slow->GetIdleLoopDetector()->SetEnabled(false);
+
+    LoadProgram(*fast);
+    LoadProgram(*slow);
+
+    // Both reach every event at the same time and in the same state
+    bool same = true;
+
+    while (same && uint32_t(fast->GetRegister(PC)) != WAIT_ADDRESS)
+    {
+        fast->StepUntilEvent();
+        slow->StepUntilEvent();
+
+        same = fast->GetCycles() == slow->GetCycles();
+
+        for (uint8_t i = 0; i <= PC; ++i)
+            same = same && uint32_t(fast->GetRegister(i)) == uint32_t(slow->GetRegister(i));
+    }
+
+    REQUIRE(same);
+    REQUIRE(uint32_t(fast->GetRegister(0)) == WAITED_LINE);
+
+    IdleLoopStatistics polled = fast->GetIdleLoopDetector()->GetStatistics();
+    REQUIRE(polled.PollingLoops > 0);
+    REQUIRE(polled.SkippedCycles > 0);
+    REQUIRE(polled.SkippedCycles < fast->GetCycles());
+    REQUIRE(slow->GetIdleLoopDetector()->GetStatistics().SkippedCycles == 0);
+
+    // The B . doesn't read anything
+    for (int i = 0; i < 10; ++i)
+        fast->StepUntilEvent();
+
+    REQUIRE(fast->GetIdleLoopDetector()->GetStatistics().SpinLoops > 0);
+    REQUIRE(fast->GetIdleLoopDetector()->GetStatistics().PollingLoops == polled.PollingLoops);
+
+    delete fast;
+    delete slow;
+
+    // A delay loop changes its counter every time around
+    CPU* delay = new CPU(CPUExecutionMode::Interpreter);
+    Load(*delay, Delay);
+
+    while (uint32_t(delay->GetRegister(3)) < 1000)
+        delay->StepUntilEvent();
+
+    REQUIRE(uint32_t(delay->GetRegister(2)) == 0);
+    REQUIRE(delay->GetIdleLoopDetector()->GetStatistics().SkippedCycles == 0);
+
+    delete delay;
+
+    // The block based engines skip the same loops, the interpreter next to them runs every iteration
+    LockstepRunner* cached = new LockstepRunner(CPUExecutionMode::CachedInterpreter, 16);
+    cached->SetCompareMemory(false);
+    cached->Setup(LoadProgram);
+
+    REQUIRE(cached->Run(4000));
+    REQUIRE(cached->Check());
+    REQUIRE(uint32_t(cached->GetTested()->GetRegister(0)) == WAITED_LINE);
+    REQUIRE(cached->GetTested()->GetIdleLoopDetector()->GetStatistics().PollingLoops > 0);
+
+    delete cached;
+
+    if (JIT::IsSupported())
+    {
+        LockstepRunner* jit = new LockstepRunner(CPUExecutionMode::JIT, 1);
+        jit->SetCompareMemory(false);
+        jit->Setup(LoadProgram);
+
+        REQUIRE(jit->Run(400));
+        REQUIRE(uint32_t(jit->GetTested()->GetRegister(0)) == WAITED_LINE);
+        REQUIRE(jit->GetTested()->GetIdleLoopDetector()->GetStatistics().PollingLoops > 0);
+        REQUIRE(jit->GetTested()->GetIdleLoopDetector()->GetStatistics().SpinLoops > 0);
+
+        delete jit;
+    }
+}
@@ -0,0 +1,46 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+TEST_CASE("Lazy Flags", "Checks that pending flag operations are computed correctly when read")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+
+    // 0x7FFFFFFF + 1 overflows without carrying
+    cpu->SetArithmeticFlags(LazyFlags::Addition, 0x7FFFFFFF, 1, false, 0x80000000);
+    REQUIRE(cpu->GetCarryFlag() == false);
+    REQUIRE(cpu->ConditionPasses(InstructionCondition::Overflow));
+    REQUIRE(cpu->ConditionPasses(InstructionCondition::Negative));
+    REQUIRE(!cpu->ConditionPasses(InstructionCondition::Equal));
+
+    // 5 - 5 sets Z and C (no borrow)
+    cpu->SetArithmeticFlags(LazyFlags::Subtraction, 5, 5, true, 0);
+    REQUIRE(cpu->GetCarryFlag() == true);
+    REQUIRE(cpu->ConditionPasses(InstructionCondition::Equal));
+    REQUIRE(cpu->ConditionPasses(InstructionCondition::CarrySet));
+    REQUIRE(cpu->ConditionPasses(InstructionCondition::GreaterEqual));
+    REQUIRE(!cpu->ConditionPasses(InstructionCondition::UnsignedHigher));
+
+    // 0 - 1 - NOT(0) borrows
+    cpu->SetArithmeticFlags(LazyFlags::Subtraction, 0, 1, false, 0xFFFFFFFE);
+    REQUIRE(cpu->GetCarryFlag() == false);
+    REQUIRE(cpu->ConditionPasses(InstructionCondition::LessThan));
+
+    // A logical operation keeps the overflow from the previous arithmetic one
+    cpu->SetArithmeticFlags(LazyFlags::Addition, 0x80000000, 0x80000000, false, 0);
+    cpu->SetLogicalFlags(0x10, false);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 0);
+
+    // Reading the whole register applies the pending flags
+    cpu->SetArithmeticFlags(LazyFlags::Addition, 0xFFFFFFFF, 1, false, 0);
+    REQUIRE((cpu->GetCurrentStatusRegister().Full >> 28) == 0x6); // Z and C
+
+    // Writes through the accessors are not overwritten by an older pending operation
+    cpu->SetArithmeticFlags(LazyFlags::Addition, 0xFFFFFFFF, 1, false, 0);
+    cpu->GetCurrentStatusFlags().Z = 0;
+    REQUIRE(!cpu->ConditionPasses(InstructionCondition::Equal));
+
+    delete cpu;
+}
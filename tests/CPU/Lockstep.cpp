@@ -0,0 +1,95 @@
+#include "catch/catch.hpp"
+#include "CPU/LockstepRunner.hpp"
+
+#include <vector>
+
+namespace
+{
+    uint32_t const CODE_ADDRESS = 0x03000000;
+    uint32_t const DATA_ADDRESS = 0x03002000;
+
+    // Sums 1 to 100 and stores every partial sum
+    std::vector<uint32_t> const Program =
+    {
+        0xE3A00000, // MOV r0, #0
+        0xE3A01000, // MOV r1, #0
+        0xE2811001, // loop: ADD r1, r1, #1
+        0xE0800001, // ADD r0, r0, r1
+        0xE4820004, // STR r0, [r2], #4
+        0xE3510064, // CMP r1, #100
+        0x1AFFFFFA, // BNE loop
+        0xEAFFFFFE  // B .
+    };
+
+    void LoadProgram(CPU& cpu)
+    {
+        for (uint32_t i = 0; i < Program.size(); ++i)
+            cpu.GetMemory()->WriteUInt32(CODE_ADDRESS + i * 4, Program[i]);
+
+        cpu.GetRegister(2) = DATA_ADDRESS;
+        cpu.SetCurrentStatusRegister(uint32_t(CPUMode::System));
+        cpu.GetRegister(PC) = CODE_ADDRESS;
+    }
+}
+
+TEST_CASE("Lockstep", "Runs the block based engines next to the interpreter and checks that divergences are found")
+{
+    // The cached interpreter agrees with the interpreter, comparing after every block
+    LockstepRunner* cached = new LockstepRunner(CPUExecutionMode::CachedInterpreter, 1);
+    cached->Setup(LoadProgram);
+
+    REQUIRE(cached->Run(200));
+    REQUIRE(!cached->HasDiverged());
+    REQUIRE(uint32_t(cached->GetTested()->GetRegister(0)) == 5050);
+    REQUIRE(uint32_t(cached->GetReference()->GetRegister(0)) == 5050);
+    REQUIRE(cached->GetReference()->GetCycles() == cached->GetTested()->GetCycles());
+
+    delete cached;
+
+    if (JIT::IsSupported())
+    {
+        // Each step of the JIT is a whole time slice
+        LockstepRunner* jit = new LockstepRunner(CPUExecutionMode::JIT, 3);
+        jit->Setup(LoadProgram);
+
+        REQUIRE(jit->Run(10));
+        REQUIRE(uint32_t(jit->GetTested()->GetRegister(0)) == 5050);
+        REQUIRE(jit->GetTested()->GetMemory()->ReadUInt32(DATA_ADDRESS + 99 * 4) == 5050);
+
+        delete jit;
+    }
+
+    // Only the tested CPU adds 2 to the counter, the ADD gets the blame
+    LockstepRunner* broken = new LockstepRunner(CPUExecutionMode::CachedInterpreter, 1);
+    broken->Setup(LoadProgram);
+    broken->GetTested()->GetMemory()->WriteUInt32(CODE_ADDRESS + 8, 0xE2811002);
+
+    REQUIRE(!broken->Run(10));
+    REQUIRE(broken->HasDiverged());
+
+    LockstepDivergence const& divergence = broken->GetDivergence();
+    REQUIRE(divergence.Step == 1);
+    REQUIRE(divergence.Located);
+    REQUIRE(divergence.Address == CODE_ADDRESS + 8);
+    REQUIRE(divergence.Instruction.Encoding == 0xE2811001);
+    REQUIRE(divergence.Differences.find("R1: 0x1 != 0x2") != std::string::npos);
+    REQUIRE(divergence.Differences.find("IWRAM") != std::string::npos);
+
+    // Nothing runs anymore once the engines diverged
+    REQUIRE(!broken->Step());
+    REQUIRE(broken->GetSteps() == 1);
+
+    delete broken;
+
+    // A divergence in memory alone is blamed on the first store of the interval
+    LockstepRunner* store = new LockstepRunner(CPUExecutionMode::CachedInterpreter, 4);
+    store->Setup(LoadProgram);
+    store->GetTested()->GetMemory()->WriteUInt32(CODE_ADDRESS + 16, 0xE4820004 | (3 << 12)); // STR r3, [r2], #4
+
+    REQUIRE(!store->Run(8));
+    REQUIRE(store->GetDivergence().Located);
+    REQUIRE(store->GetDivergence().Address == CODE_ADDRESS + 16);
+    REQUIRE(store->GetDivergence().Differences == "IWRAM contents differ\n");
+
+    delete store;
+}
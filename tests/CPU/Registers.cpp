@@ -0,0 +1,58 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+TEST_CASE("Banked Registers", "Checks that the banked registers are swapped in and out on mode changes")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+
+    // The GBA boots in System mode
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+
+    for (uint8_t reg = 0; reg < PC; ++reg)
+        cpu->GetRegister(reg) = 0x100 + reg;
+
+    // IRQ mode only banks R13 and R14
+    cpu->SetCurrentCPUMode(CPUMode::IRQ);
+    REQUIRE(uint32_t(cpu->GetRegister(12)) == 0x10C);
+    REQUIRE(uint32_t(cpu->GetRegister(SP)) == 0);
+    cpu->GetRegister(SP) = 0x3007FA0;
+    cpu->GetRegister(LR) = 0x1234;
+
+    // The other modes can still be reached through GetRegisterForMode
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::User, SP)) == 0x10D);
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::System, LR)) == 0x10E);
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::IRQ, SP)) == 0x3007FA0);
+
+    // FIQ mode banks R8 through R14
+    cpu->SetCurrentCPUMode(CPUMode::FIQ);
+    REQUIRE(uint32_t(cpu->GetRegister(7)) == 0x107);
+    REQUIRE(uint32_t(cpu->GetRegister(8)) == 0);
+    cpu->GetRegister(8) = 0x888;
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::System, 8)) == 0x108);
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::IRQ, LR)) == 0x1234);
+
+    // Going back restores everything
+    cpu->SetCurrentCPUMode(CPUMode::System);
+    REQUIRE(uint32_t(cpu->GetRegister(8)) == 0x108);
+    REQUIRE(uint32_t(cpu->GetRegister(SP)) == 0x10D);
+    REQUIRE(uint32_t(cpu->GetRegister(LR)) == 0x10E);
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::FIQ, 8)) == 0x888);
+
+    // Writing the mode through the whole CPSR swaps the registers as well
+    cpu->SetCurrentStatusRegister((cpu->GetCurrentStatusRegister().Full & ~0x1F) | uint32_t(CPUMode::IRQ));
+    REQUIRE(uint32_t(cpu->GetRegister(SP)) == 0x3007FA0);
+
+    // SUBS PC, LR, #4 returns from the interrupt and restores the CPSR from the SPSR
+    cpu->GetSavedStatusRegister().Full = 0x20000000 | uint32_t(CPUMode::System); // C set
+    Interpreter* interpreter = new Interpreter(cpu);
+    interpreter->RunInstruction(cpu->GetDecoder()->DecodeARM(0xE25EF004));
+
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == 0x1230);
+    REQUIRE(uint32_t(cpu->GetRegister(SP)) == 0x10D);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 0);
+
+    delete interpreter;
+    delete cpu;
+}
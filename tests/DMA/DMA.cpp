@@ -0,0 +1,140 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+namespace
+{
+    uint32_t const EWRAM_ADDRESS = 0x02000000;
+    uint32_t const VRAM_ADDRESS = 0x06000000;
+
+    enum DMA3Control : uint16_t
+    {
+        ENABLED = 0x8000,
+        IRQ = 0x4000,
+        START_VBLANK = 0x1000,
+        WORDS = 0x0400,
+        REPEAT = 0x0200,
+        SOURCE_FIXED = 0x0100,
+        DESTINATION_DECREMENT = 0x0020,
+        DESTINATION_FIXED = 0x0040,
+        DESTINATION_RELOAD = 0x0060
+    };
+
+    // Sets up DMA 3 and enables it, immediate transfers run on the next step
+    void Start(CPU& cpu, uint32_t source, uint32_t destination, uint16_t count, uint16_t control)
+    {
+        cpu.GetMemory()->WriteUInt32(0x040000D4, source);
+        cpu.GetMemory()->WriteUInt32(0x040000D8, destination);
+        cpu.GetMemory()->WriteUInt16(0x040000DC, count);
+        cpu.GetMemory()->WriteUInt16(0x040000DE, control);
+    }
+
+    // Enables DMA 3 from code and reads the destination right after, every engine has to run the transfer in between
+    uint32_t ReadAfterTransfer(CPUExecutionMode mode)
+    {
+        CPU* cpu = new CPU(mode);
+        uint32_t const code = 0x03000000;
+
+        cpu->GetMemory()->WriteUInt32(code, 0xE880000E);     // STMIA r0, {r1-r3}
+        cpu->GetMemory()->WriteUInt32(code + 4, 0xE5924000); // LDR r4, [r2]
+        cpu->GetMemory()->WriteUInt32(code + 8, 0xEAFFFFFE); // B .
+        cpu->GetMemory()->WriteUInt32(EWRAM_ADDRESS, 0xDEADBEEF);
+
+        cpu->GetRegister(0) = 0x040000D4;
+        cpu->GetRegister(1) = EWRAM_ADDRESS;
+        cpu->GetRegister(2) = EWRAM_ADDRESS + 0x100;
+        cpu->GetRegister(3) = uint32_t(ENABLED | WORDS) << 16 | 1;
+        cpu->SetCurrentStatusRegister(uint32_t(CPUMode::System));
+        cpu->GetRegister(PC) = code;
+
+        while (uint32_t(cpu->GetRegister(PC)) != code + 8)
+        {
+            if (mode == CPUExecutionMode::JIT)
+                cpu->StepJIT();
+            else if (mode == CPUExecutionMode::CachedInterpreter)
+                cpu->StepBlock();
+            else
+                cpu->StepUntilEvent();
+        }
+
+        uint32_t value = cpu->GetRegister(4);
+        delete cpu;
+
+        return value;
+    }
+}
+
+TEST_CASE("DMA", "Checks that the transfers move the data, at once when they can, and stall the CPU")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+    std::unique_ptr<DMA>& dma = cpu->GetDMA();
+
+    for (uint32_t i = 0; i < 0x100; ++i)
+        memory->WriteUInt32(EWRAM_ADDRESS + i * 4, 0x01010101 * i);
+
+    // Words from EWRAM to VRAM are a single copy, each takes a 6 cycle read and a 2 cycle write
+    Start(*cpu, EWRAM_ADDRESS, VRAM_ADDRESS, 0x100, ENABLED | WORDS | IRQ);
+
+    uint64_t cycles = cpu->GetCycles();
+    dma->Step();
+
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS) == 0x00000000);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x3FC) == 0xFFFFFFFF);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x400) == 0x00000000);
+    REQUIRE(cpu->GetCycles() == cycles + 0x100 * 8 + 2);
+    REQUIRE(memory->ReadUInt16(0x040000DE) == (WORDS | IRQ));
+    REQUIRE((memory->ReadUInt16(InterruptRequestFlags) & (1 << uint8_t(InterruptTypes::DMA3))) != 0);
+    REQUIRE(dma->GetStatistics().FastTransfers == 1);
+
+    // A fixed source fills the destination with its unit
+    memory->WriteUInt16(EWRAM_ADDRESS + 0x1000, 0x1234);
+    Start(*cpu, EWRAM_ADDRESS + 0x1000, VRAM_ADDRESS, 0x11, ENABLED | SOURCE_FIXED);
+    dma->Step();
+
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS) == 0x12341234);
+    REQUIRE(memory->ReadUInt16(VRAM_ADDRESS + 0x20) == 0x1234);
+    REQUIRE(memory->ReadUInt16(VRAM_ADDRESS + 0x22) == 0x0808);
+    REQUIRE(dma->GetStatistics().FastTransfers == 2);
+
+    // A decrementing destination goes a unit at a time
+    Start(*cpu, EWRAM_ADDRESS + 4, VRAM_ADDRESS + 0x80C, 4, ENABLED | WORDS | DESTINATION_DECREMENT);
+    dma->Step();
+
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x80C) == 0x01010101);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x800) == 0x04040404);
+    REQUIRE(dma->GetStatistics().FastTransfers == 2);
+    REQUIRE(dma->GetStatistics().Transfers == 3);
+
+    // A destination right after the source copies the units that were just written
+    Start(*cpu, EWRAM_ADDRESS + 4, EWRAM_ADDRESS + 8, 4, ENABLED | WORDS);
+    dma->Step();
+
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 8) == 0x01010101);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 20) == 0x01010101);
+    REQUIRE(dma->GetStatistics().FastTransfers == 2);
+
+    // The I/O registers take each unit through their handlers, the last one stays
+    memory->WriteUInt32(EWRAM_ADDRESS + 0x1000, 0x01450123);
+    Start(*cpu, EWRAM_ADDRESS + 0x1000, 0x04000010, 2, ENABLED | DESTINATION_FIXED);
+    dma->Step();
+
+    REQUIRE(cpu->GetIO()->Get(0x04000010) == 0x0145);
+    REQUIRE(dma->GetStatistics().FastTransfers == 2);
+
+    // A repeating transfer goes on with the source where it stopped, the destination goes back
+    Start(*cpu, EWRAM_ADDRESS + 0x100, VRAM_ADDRESS + 0x1000, 2, ENABLED | START_VBLANK | REPEAT | WORDS | DESTINATION_RELOAD);
+
+    dma->ProcessInterrupt(InterruptTypes::VBlank);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x1000) == 0x40404040);
+
+    dma->ProcessInterrupt(InterruptTypes::VBlank);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x1000) == 0x42424242);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 0x1004) == 0x43434343);
+    REQUIRE((memory->ReadUInt16(0x040000DE) & ENABLED) != 0);
+
+    delete cpu;
+
+    REQUIRE(ReadAfterTransfer(CPUExecutionMode::Interpreter) == 0xDEADBEEF);
+    REQUIRE(ReadAfterTransfer(CPUExecutionMode::CachedInterpreter) == 0xDEADBEEF);
+    REQUIRE(ReadAfterTransfer(CPUExecutionMode::JIT) == 0xDEADBEEF);
+}
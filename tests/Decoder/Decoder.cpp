@@ -1,152 +1,401 @@
 #include "catch/catch.hpp"
 #include "Decoder/Decoder.hpp"
-#include "Common/Instructions/ARM/BranchInstructions.hpp"
-#include "Common/Instructions/ARM/DataProcessingInstructions.hpp"
-#include "Common/Instructions/ARM/PSRTransferInstructions.hpp"
+#include "Common/MathHelper.hpp"
+
+#include <cstdint>
+
+namespace
+{
+    // The rules the decoder used to test one after the other before the lookup tables were introduced,
+    // the tables must classify every opcode exactly like these do.
+    InstructionFormat ClassifyARMSequentially(uint32_t opcode)
+    {
+        if (MathHelper::CheckBits(opcode, 8, 20, 0x12FFF))
+            return InstructionFormat::ARMBranchLinkExchangeRegister;
+
+        if (MathHelper::CheckBits(opcode, 25, 3, 0x5))
+        {
+            if (MathHelper::CheckBits(opcode, 28, 4, 0xF))
+                return InstructionFormat::ARMBranchLinkExchangeImmediate;
+
+            return InstructionFormat::ARMBranch;
+        }
+
+        if (MathHelper::CheckBits(opcode, 23, 5, 0x2) && MathHelper::CheckBits(opcode, 16, 6, 0xF) && MathHelper::CheckBits(opcode, 0, 12, 0))
+            return InstructionFormat::ARMMovePSRToRegister;
+
+        if (MathHelper::CheckBits(opcode, 20, 2, 0x2) && MathHelper::CheckBits(opcode, 12, 4, 0xF))
+        {
+            if (MathHelper::CheckBits(opcode, 23, 5, 0x6))
+                return InstructionFormat::ARMMoveRegisterToPSRImmediate;
+
+            if (MathHelper::CheckBits(opcode, 23, 5, 0x2) && MathHelper::CheckBits(opcode, 4, 8, 0))
+                return InstructionFormat::ARMMoveRegisterToPSRRegister;
+        }
+
+        if (MathHelper::CheckBits(opcode, 24, 4, 0) && MathHelper::CheckBits(opcode, 4, 4, 9))
+            return InstructionFormat::ARMMultiplyAccumulate;
+
+        if (MathHelper::CheckBits(opcode, 25, 3, 0) && MathHelper::CheckBit(opcode, 7) && MathHelper::CheckBit(opcode, 4))
+        {
+            if (MathHelper::CheckBits(opcode, 5, 2, 0))
+                return InstructionFormat::Unknown;
+
+            return InstructionFormat::ARMMiscellaneousLoadStore;
+        }
+
+        if (MathHelper::CheckBits(opcode, 26, 2, 0))
+            return InstructionFormat::ARMDataProcessing;
+
+        if (MathHelper::CheckBits(opcode, 26, 2, 1) || MathHelper::CheckBits(opcode, 25, 3, 4))
+            return InstructionFormat::ARMLoadStore;
+
+        if (MathHelper::CheckBits(opcode, 24, 4, 0xF))
+            return InstructionFormat::ARMSoftwareInterrupt;
+
+        return InstructionFormat::Unknown;
+    }
+
+    InstructionFormat ClassifyThumbSequentially(uint16_t opcode)
+    {
+        if (MathHelper::GetBits(opcode, 13, 3) == 0)
+            return MathHelper::GetBits(opcode, 11, 2) <= 2 ? InstructionFormat::ThumbImmediateShift : InstructionFormat::ThumbAddSub;
+
+        if (MathHelper::GetBits(opcode, 13, 3) == 1)
+            return InstructionFormat::ThumbAddSubCmpMovImmediate;
+
+        if (MathHelper::GetBits(opcode, 10, 6) == 16)
+            return InstructionFormat::ThumbDataProcessing;
+
+        if (MathHelper::GetBits(opcode, 10, 6) == 17)
+            return MathHelper::GetBits(opcode, 8, 2) == 3 ? InstructionFormat::ThumbBranchExchange : InstructionFormat::ThumbSpecialDataProcessing;
+
+        if (MathHelper::GetBits(opcode, 11, 5) == 9)
+            return InstructionFormat::ThumbLoadFromLiteralPool;
+
+        if (MathHelper::GetBits(opcode, 12, 4) == 5)
+            return InstructionFormat::ThumbLoadStoreRegisterOffset;
+
+        if (MathHelper::GetBits(opcode, 13, 3) == 3 || MathHelper::GetBits(opcode, 12, 4) == 8)
+            return InstructionFormat::ThumbLoadStoreImmediate;
+
+        if (MathHelper::GetBits(opcode, 12, 4) == 9)
+            return InstructionFormat::ThumbLoadStoreStack;
+
+        if (MathHelper::GetBits(opcode, 12, 4) == 11)
+        {
+            if (MathHelper::GetBits(opcode, 8, 4) == 0)
+                return InstructionFormat::Unknown;
+
+            if (MathHelper::GetBits(opcode, 9, 2) == 2)
+                return InstructionFormat::ThumbStackOperation;
+        }
+
+        if (MathHelper::GetBits(opcode, 12, 4) == 12)
+            return InstructionFormat::ThumbLoadStoreMultiple;
+
+        if (MathHelper::GetBits(opcode, 12, 4) == 13)
+        {
+            if (MathHelper::GetBits(opcode, 8, 4) == 15)
+                return InstructionFormat::ThumbSoftwareInterrupt;
+
+            if (MathHelper::GetBits(opcode, 8, 4) == 14)
+                return InstructionFormat::Unknown;
+
+            return InstructionFormat::ThumbConditionalBranch;
+        }
+
+        if (MathHelper::GetBits(opcode, 11, 5) == 28)
+            return InstructionFormat::ThumbUnconditionalBranch;
+
+        if (MathHelper::GetBits(opcode, 11, 5) >= 30)
+            return InstructionFormat::ThumbLongBranchLink;
+
+        return InstructionFormat::Unknown;
+    }
+}
 
 TEST_CASE("Decoder", "Tests that the decoder is correctly identifying instructions")
 {
     Decoder* decoder = new Decoder();
 
-    std::shared_ptr<Instruction> instruction = decoder->DecodeARM(0xEA00002E);
-    REQUIRE(std::dynamic_pointer_cast<ARM::BranchInstruction>(instruction));
+    DecodedInstruction instruction = decoder->DecodeARM(0xEA00002E);
+    REQUIRE(instruction.Format == InstructionFormat::ARMBranch);
 
     // BL label1
     instruction = decoder->DecodeARM(0xEBFFFFFE);
-    REQUIRE(std::dynamic_pointer_cast<ARM::BranchInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMBranch);
     
     // BX r1
     instruction = decoder->DecodeARM(0xE12FFF11);
-    REQUIRE(std::dynamic_pointer_cast<ARM::BranchLinkExchangeRegisterInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMBranchLinkExchangeRegister);
 
     // BLX r3
     instruction = decoder->DecodeARM(0xE12FFF33);
-    REQUIRE(std::dynamic_pointer_cast<ARM::BranchLinkExchangeRegisterInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMBranchLinkExchangeRegister);
 
     // B label2
     instruction = decoder->DecodeARM(0xEAFFFFFD);
-    REQUIRE(std::dynamic_pointer_cast<ARM::BranchInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMBranch);
 
     // AND r0, r1, #10
     instruction = decoder->DecodeARM(0xE201000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // AND r0, r1, r2
     instruction = decoder->DecodeARM(0xE0010002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     
     // EOR r0, r1, #10
     instruction = decoder->DecodeARM(0xE221000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // EOR r0, r1, #10
     instruction = decoder->DecodeARM(0xE021000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // SUB r0, r1, #10
     instruction = decoder->DecodeARM(0xE241000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // SUB r0, r1, #10
     instruction = decoder->DecodeARM(0xE041000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // RSB r0, r1, #10
     instruction = decoder->DecodeARM(0xE261000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // RSB r0, r1, #10
     instruction = decoder->DecodeARM(0xE061000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // ADD r0, r1, #10
     instruction = decoder->DecodeARM(0xE281000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // ADD r0, r1, #10
     instruction = decoder->DecodeARM(0xE081000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // ADC r0, r1, #10
     instruction = decoder->DecodeARM(0xE2A1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // ADC r0, r1, #10
     instruction = decoder->DecodeARM(0xE0A1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // SBC r0, r1, #10
     instruction = decoder->DecodeARM(0xE2C1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // SBC r0, r1, #10
     instruction = decoder->DecodeARM(0xE0C1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // RSC r0, r1, #10
     instruction = decoder->DecodeARM(0xE2E1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // RSC r0, r1, #10
     instruction = decoder->DecodeARM(0xE0E1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // TST r0, r1, #10
     instruction = decoder->DecodeARM(0xE311000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // TST r0, r1, r2
     instruction = decoder->DecodeARM(0xE1110002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // TEQ r0, r1, #10
     instruction = decoder->DecodeARM(0xE331000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // TEQ r0, r1, r2
     instruction = decoder->DecodeARM(0xE1310002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // CMP r0, r1, #10
     instruction = decoder->DecodeARM(0xE351000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // CMP r0, r1, r2
     instruction = decoder->DecodeARM(0xE1510002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // CMN r0, r1, #10
     instruction = decoder->DecodeARM(0xE371000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // CMN r0, r1, r2
     instruction = decoder->DecodeARM(0xE1710002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // ORR r0, r1, #10
     instruction = decoder->DecodeARM(0xE381000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // ORR r0, r1, r2
     instruction = decoder->DecodeARM(0xE1810002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // MOV r0, #10
     instruction = decoder->DecodeARM(0xE3A0000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // MOV r0, r2
     instruction = decoder->DecodeARM(0xE1A00002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // BIC r0, r1, #10
     instruction = decoder->DecodeARM(0xE3C1000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // BIC r0, r1, r2
     instruction = decoder->DecodeARM(0xE1C10002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     // MVN r0, #10
     instruction = decoder->DecodeARM(0xE3E0000A);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
     // MVN r0, r2
     instruction = decoder->DecodeARM(0xE1E00002);
-    REQUIRE(std::dynamic_pointer_cast<ARM::DataProcessingInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMDataProcessing);
 
     instruction = decoder->DecodeARM(0xE10F3000);
-    REQUIRE(std::dynamic_pointer_cast<ARM::MovePSRToRegisterInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMMovePSRToRegister);
 
     instruction = decoder->DecodeARM(0xE328F001);
-    REQUIRE(std::dynamic_pointer_cast<ARM::MoveRegisterToPSRImmediateInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMMoveRegisterToPSRImmediate);
 
     instruction = decoder->DecodeARM(0xE128F003);
-    REQUIRE(std::dynamic_pointer_cast<ARM::MoveRegisterToPSRRegisterInstruction>(instruction));
+    REQUIRE(instruction.Format == InstructionFormat::ARMMoveRegisterToPSRRegister);
+
+    delete decoder;
+}
+
+TEST_CASE("Decoded Instruction Operands", "Checks that the decoder extracts the operands of the instructions")
+{
+    Decoder* decoder = new Decoder();
+
+    // B label2, branches backwards
+    DecodedInstruction instruction = decoder->DecodeARM(0xEAFFFFFD);
+    REQUIRE(instruction.Condition == InstructionCondition::Always);
+    REQUIRE(int32_t(instruction.Immediate) == -12);
+    REQUIRE(!instruction.Link());
+
+    // BLX label, the only ARM instruction with the 0b1111 condition
+    instruction = decoder->DecodeARM(0xFB000002);
+    REQUIRE(instruction.Format == InstructionFormat::ARMBranchLinkExchangeImmediate);
+    REQUIRE(instruction.Immediate == 10);
+    REQUIRE(instruction.Link());
+
+    // ADDNES r3, r1, r2, LSL #4
+    instruction = decoder->DecodeARM(0x10913202);
+    REQUIRE(instruction.GetOpcode() == ARM::ARMOpcodes::ADD);
+    REQUIRE(instruction.Condition == InstructionCondition::NotEqual);
+    REQUIRE(instruction.SetConditionCodes());
+    REQUIRE(!instruction.IsImmediate());
+    REQUIRE(instruction.Rd == 3);
+    REQUIRE(instruction.Rn == 1);
+    REQUIRE(instruction.Rm == 2);
+    REQUIRE(instruction.Shift == ARM::ShiftType::LSL);
+    REQUIRE(instruction.ShiftAmount == 4);
+
+    // MOV r0, #0x3F0, the immediate is already rotated
+    instruction = decoder->DecodeARM(0xE3A00E3F);
+    REQUIRE(instruction.IsImmediate());
+    REQUIRE(instruction.Immediate == 0x3F0);
+
+    // MSR CPSR_f, #0xF0000000
+    instruction = decoder->DecodeARM(0xE328F20F);
+    REQUIRE(instruction.Format == InstructionFormat::ARMMoveRegisterToPSRImmediate);
+    REQUIRE(instruction.Immediate == 0xF0000000);
+    REQUIRE(instruction.Rn == 8);
+
+    // MUL r1, r2, r3 shares its encoding space with the halfword load/stores
+    instruction = decoder->DecodeARM(0xE0010392);
+    REQUIRE(instruction.Format == InstructionFormat::ARMMultiplyAccumulate);
+    REQUIRE(instruction.GetOpcode() == ARM::ARMOpcodes::MUL);
+    REQUIRE(!instruction.IsLong());
+    REQUIRE(instruction.Rd == 1);
+    REQUIRE(instruction.Rm == 2);
+    REQUIRE(instruction.Rs == 3);
+
+    // LDRH r0, [r1, #0x12]!
+    instruction = decoder->DecodeARM(0xE1F101B2);
+    REQUIRE(instruction.Format == InstructionFormat::ARMMiscellaneousLoadStore);
+    REQUIRE(instruction.GetOpcode() == ARM::ARMOpcodes::LDRH);
+    REQUIRE(instruction.Immediate == 0x12);
+    REQUIRE(instruction.WriteBack());
+
+    // STMDB sp!, {r4, lr}
+    instruction = decoder->DecodeARM(0xE92D4010);
+    REQUIRE(instruction.Handler == InstructionHandler::ARMLoadStoreMultiple);
+    REQUIRE(instruction.Immediate == 0x4010);
+    REQUIRE(instruction.Rn == 13);
+    REQUIRE(instruction.WriteBack());
+    REQUIRE(!instruction.IsLoad());
+
+    // BNE label, Thumb
+    instruction = decoder->DecodeThumb(0xD1FC);
+    REQUIRE(instruction.Format == InstructionFormat::ThumbConditionalBranch);
+    REQUIRE(instruction.GetInstructionSet() == InstructionSet::Thumb);
+    REQUIRE(instruction.Condition == InstructionCondition::NotEqual);
+    REQUIRE(int32_t(instruction.Immediate) == -8);
+
+    // SWI #0x50000
+    instruction = decoder->DecodeARM(0xEF050000);
+    REQUIRE(instruction.Format == InstructionFormat::ARMSoftwareInterrupt);
+    REQUIRE(instruction.Immediate == 0x50000);
+    REQUIRE(instruction.ToString() == "SWI #0x50000");
+
+    // SWI #0x2, Thumb
+    instruction = decoder->DecodeThumb(0xDF02);
+    REQUIRE(instruction.Format == InstructionFormat::ThumbSoftwareInterrupt);
+    REQUIRE(instruction.Immediate == 0x2);
+    REQUIRE(instruction.ToString() == "SWI #0x2");
+
+    // Undefined Thumb instruction
+    instruction = decoder->DecodeThumb(0xDE00);
+    REQUIRE(!instruction.IsValid());
+
+    // The tables must classify opcodes exactly like the sequential rules.
+    // The 2^32 ARM opcodes can't all be checked, only the 12 index bits are exhaustive. The rules compare the other
+    // nibbles (the condition, bits 19-8 and 3-0) with 0 or F only, so each one takes 0, F and one other value,
+    // plus a few random values for bits 19-8 and 3-0. Only the 0xE and 0xF conditions are checked
+    int mismatches = 0;
+    uint32_t const nibbles[] = { 0x0, 0xF, 0x5 };
+    uint32_t const conditions[] = { 0xE, 0xF };
+    uint32_t seed = 0x12345678;
+
+    for (uint32_t index = 0; index < 4096; ++index)
+    {
+        uint32_t indexBits = ((index & 0xFF0) << 16) | ((index & 0xF) << 4);
+
+        for (uint32_t condition : conditions)
+        {
+            for (uint32_t combination = 0; combination < 81; ++combination)
+            {
+                uint32_t opcode = (condition << 28) | indexBits;
+
+                // Bits 19-16, 15-12, 11-8 and 3-0
+                opcode |= nibbles[combination % 3] << 16;
+                opcode |= nibbles[combination / 3 % 3] << 12;
+                opcode |= nibbles[combination / 9 % 3] << 8;
+                opcode |= nibbles[combination / 27 % 3];
+
+                if (Decoder::ClassifyARM(opcode) != ClassifyARMSequentially(opcode))
+                    ++mismatches;
+            }
+
+            for (int i = 0; i < 8; ++i)
+            {
+                seed = seed * 1103515245 + 12345;
+                uint32_t opcode = (condition << 28) | indexBits | (seed & 0x000FFF0F);
+
+                if (Decoder::ClassifyARM(opcode) != ClassifyARMSequentially(opcode))
+                    ++mismatches;
+            }
+        }
+    }
+
+    REQUIRE(mismatches == 0);
+
+    // Thumb opcodes are small enough to check them all
+    for (uint32_t opcode = 0; opcode < 0x10000; ++opcode)
+        if (Decoder::ClassifyThumb(uint16_t(opcode)) != ClassifyThumbSequentially(uint16_t(opcode)))
+            ++mismatches;
+
+    REQUIRE(mismatches == 0);
 
     delete decoder;
 }
@@ -0,0 +1,93 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+namespace
+{
+    // Runs a few steps the way the engine of the CPU does
+    void Run(CPU& cpu, CPUExecutionMode mode)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            if (mode == CPUExecutionMode::JIT)
+                cpu.StepJIT();
+            else if (mode == CPUExecutionMode::CachedInterpreter)
+                cpu.StepBlock();
+            else
+                cpu.Step();
+        }
+    }
+}
+
+TEST_CASE("Instruction Cache", "Checks that decoded instructions are reused and invalidated on writes")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<InstructionCache>& cache = cpu->GetInstructionCache();
+
+    // MOV r0, #10
+    cpu->GetMemory()->WriteUInt32(0x03000000, 0xE3A0000A);
+
+    DecodedInstruction first = cache->Fetch(InstructionSet::ARM, 0x03000000);
+    DecodedInstruction second = cache->Fetch(InstructionSet::ARM, 0x03000000);
+
+    REQUIRE(first.Encoding == second.Encoding);
+    REQUIRE(first.GetOpcode() == ARM::ARMOpcodes::MOV);
+    REQUIRE(cache->GetStatistics().Misses == 1);
+    REQUIRE(cache->GetStatistics().Hits == 1);
+
+    // Overwriting a single byte of the instruction turns it into MVN r0, #10
+    cpu->GetMemory()->WriteUInt8(0x03000002, 0xE0);
+    REQUIRE(cache->GetStatistics().Invalidations == 1);
+
+    DecodedInstruction modified = cache->Fetch(InstructionSet::ARM, 0x03000000);
+    REQUIRE(modified.GetOpcode() == ARM::ARMOpcodes::MVN);
+    REQUIRE(cache->GetStatistics().Misses == 2);
+
+    // The same address is cached separately for each instruction set
+    // 010000 0000 001 100 ; 0x400C: AND R4, R1
+    cpu->GetMemory()->WriteUInt16(0x02000000, 0x400C);
+    REQUIRE(cache->Fetch(InstructionSet::Thumb, 0x02000000).GetOpcode() == Thumb::ThumbOpcodes::AND);
+    REQUIRE(cache->Fetch(InstructionSet::Thumb, 0x02000000).GetInstructionSet() == InstructionSet::Thumb);
+    REQUIRE(cache->GetStatistics().Hits == 2);
+
+    // Writes to memory that has never run code don't count as invalidations
+    cpu->GetMemory()->WriteUInt32(0x02001000, 0);
+    REQUIRE(cache->GetStatistics().Invalidations == 1);
+
+    delete cpu;
+
+    // IWRAM repeats every 32 KBytes, code written through one mirror replaces the code that ran from any other
+    for (CPUExecutionMode mode : { CPUExecutionMode::Interpreter, CPUExecutionMode::CachedInterpreter, CPUExecutionMode::JIT })
+    {
+        if (mode == CPUExecutionMode::JIT && !JIT::IsSupported())
+            continue;
+
+        cpu = new CPU(mode);
+        std::unique_ptr<MMU>& memory = cpu->GetMemory();
+
+        memory->WriteUInt32(0x03000000, 0xE3A0000A); // loop: MOV r0, #10
+        memory->WriteUInt32(0x03000004, 0xEAFFFFFD); // B loop
+        cpu->GetRegister(PC) = 0x03000000;
+
+        Run(*cpu, mode);
+        REQUIRE(uint32_t(cpu->GetRegister(0)) == 10);
+
+        memory->WriteUInt32(0x03008000, 0xE3A00014); // MOV r0, #20
+        REQUIRE(memory->ReadUInt32(0x03000000) == 0xE3A00014);
+
+        Run(*cpu, mode);
+        REQUIRE(uint32_t(cpu->GetRegister(0)) == 20);
+
+        // The other way around, the code runs from a mirror and the first one is written
+        cpu->GetRegister(PC) = 0x03008000;
+        Run(*cpu, mode);
+        REQUIRE(uint32_t(cpu->GetRegister(0)) == 20);
+
+        memory->WriteUInt32(0x03000000, 0xE3A0001E); // MOV r0, #30
+
+        Run(*cpu, mode);
+        REQUIRE(uint32_t(cpu->GetRegister(0)) == 30);
+        REQUIRE(uint32_t(cpu->GetRegister(PC)) >= 0x03008000);
+
+        delete cpu;
+    }
+}
@@ -0,0 +1,68 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+#include "GPU/GPU.hpp"
+
+#include <vector>
+
+namespace
+{
+    class RecordingAdapter final : public LCDAdapter
+    {
+    public:
+        void DrawHorizontal(uint8_t line) override { Lines.push_back(line); }
+        void EndFrame() override { }
+
+        std::vector<uint8_t> Lines;
+    };
+}
+
+TEST_CASE("GPU", "Checks that the GPU shares the video memory and the LCD registers with the bus")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+    std::unique_ptr<GPU>& gpu = cpu->GetGPU();
+
+    std::shared_ptr<RecordingAdapter> adapter = std::make_shared<RecordingAdapter>();
+    gpu->SetLCDAdapter(adapter);
+
+    // Mode 3 with a pixel at the start and the end of the second line
+    memory->WriteUInt16(DISPCNT, 0x0403);
+    memory->WriteUInt16(0x06000000 + HORIZONTAL_PIXELS * 2, 0x001F);
+    memory->WriteUInt16(0x06000000 + HORIZONTAL_PIXELS * 4 - 2, 0x7C00);
+
+    REQUIRE(gpu->GetVideoMode() == VideoMode::MODE_3);
+    REQUIRE(gpu->IsBackgroundActive(2));
+    REQUIRE(!gpu->IsBackgroundActive(0));
+
+    // The HBlank flag of DISPSTAT is visible on the bus as soon as the GPU sets it
+    cpu->GetScheduler()->RunEvents(HDRAW_LENGTH);
+    REQUIRE(gpu->InHBlank());
+    REQUIRE(memory->ReadUInt16(DISPSTAT) == 0x0002);
+
+    // The end of the HBlank moves to the next line and draws it
+    cpu->GetScheduler()->RunEvents(HORIZONTAL_LENGTH);
+    REQUIRE(!gpu->InHBlank());
+    REQUIRE(memory->ReadUInt8(VCOUNT) == 1);
+    REQUIRE(adapter->Lines == std::vector<uint8_t>{ 1 });
+    REQUIRE(adapter->GetDataArray()[HORIZONTAL_PIXELS] == 0x001F);
+    REQUIRE(adapter->GetDataArray()[HORIZONTAL_PIXELS * 2 - 1] == 0x7C00);
+    REQUIRE(adapter->GetDataArray()[HORIZONTAL_PIXELS * 2] == 0);
+
+    // The V-counter flag is only set on the line that matches bits 8-15 of DISPSTAT
+    memory->WriteUInt16(DISPSTAT, 0x0300);
+
+    cpu->GetScheduler()->RunEvents(HORIZONTAL_LENGTH * 3);
+    REQUIRE(memory->ReadUInt8(VCOUNT) == 3);
+    REQUIRE(memory->ReadUInt16(DISPSTAT) == 0x0304);
+
+    cpu->GetScheduler()->RunEvents(HORIZONTAL_LENGTH * 4);
+    REQUIRE(memory->ReadUInt8(VCOUNT) == 4);
+    REQUIRE(memory->ReadUInt16(DISPSTAT) == 0x0300);
+
+    // Writes from the GPU land in the same I/O memory the bus reads
+    gpu->WriteRegister16(DISPCNT, 0x0100);
+    REQUIRE(memory->ReadUInt16(DISPCNT) == 0x0100);
+    REQUIRE(gpu->GetVideoMode() == VideoMode::MODE_0);
+
+    delete cpu;
+}
@@ -0,0 +1,250 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+#include "Common/GBA.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    uint32_t const CODE_ADDRESS = 0x03000000;
+    uint32_t const DATA_ADDRESS = 0x03001000;
+    uint32_t const HANDLER_ADDRESS = 0x03000100;
+    uint32_t const EWRAM_ADDRESS = 0x02000000;
+    uint32_t const VRAM_ADDRESS = 0x06000000;
+
+    // Runs a single SWI with the arguments in r0-r3
+    void Call(CPU& cpu, BIOSFunction function, uint32_t r0, uint32_t r1 = 0, uint32_t r2 = 0, uint32_t r3 = 0)
+    {
+        cpu.GetMemory()->WriteUInt32(CODE_ADDRESS, 0xEF000000 | (uint32_t(function) << 16));
+
+        cpu.GetRegister(0) = r0;
+        cpu.GetRegister(1) = r1;
+        cpu.GetRegister(2) = r2;
+        cpu.GetRegister(3) = r3;
+        cpu.GetRegister(PC) = CODE_ADDRESS;
+
+        cpu.Step();
+    }
+
+    void WriteData(CPU& cpu, uint32_t address, std::vector<uint8_t> const& data)
+    {
+        for (uint32_t i = 0; i < data.size(); ++i)
+            cpu.GetMemory()->WriteUInt8(address + i, data[i]);
+    }
+}
+
+TEST_CASE("HLE BIOS", "Checks the natively emulated BIOS calls and booting without a BIOS file")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+
+    cpu->GetHLEBIOS()->SetEnabled(true);
+    cpu->SetCurrentStatusRegister(uint32_t(CPUMode::System));
+
+    // The results stay in the registers, the CPU doesn't enter the BIOS
+    Call(*cpu, BIOSFunction::Div, uint32_t(-7), 2);
+    REQUIRE(int32_t(uint32_t(cpu->GetRegister(0))) == -3);
+    REQUIRE(int32_t(uint32_t(cpu->GetRegister(1))) == -1);
+    REQUIRE(uint32_t(cpu->GetRegister(3)) == 3);
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == CODE_ADDRESS + 4);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+
+    Call(*cpu, BIOSFunction::DivArm, 2, uint32_t(-7));
+    REQUIRE(int32_t(uint32_t(cpu->GetRegister(0))) == -3);
+
+    Call(*cpu, BIOSFunction::Div, 0x80000000, uint32_t(-1));
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 0x80000000);
+
+    Call(*cpu, BIOSFunction::Sqrt, 99);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 9);
+    Call(*cpu, BIOSFunction::Sqrt, 0xFFFFFFFF);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 0xFFFF);
+
+    // A full turn is 0x10000
+    Call(*cpu, BIOSFunction::ArcTan2, 0x4000, 0);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 0x0000);
+    Call(*cpu, BIOSFunction::ArcTan2, 0, 0x4000);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 0x4000);
+    Call(*cpu, BIOSFunction::ArcTan2, uint32_t(-0x4000), 0);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 0x8000);
+    Call(*cpu, BIOSFunction::ArcTan2, 0x4000, 0x4000);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) >= 0x1FF0);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) <= 0x2010);
+    Call(*cpu, BIOSFunction::ArcTan2, uint32_t(-0x4000), uint32_t(-0x4000));
+    REQUIRE(uint32_t(cpu->GetRegister(0)) >= 0x9FF0);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) <= 0xA010);
+
+    // CpuSet copies halfwords or fills words
+    for (uint32_t i = 0; i < 4; ++i)
+        memory->WriteUInt16(DATA_ADDRESS + i * 2, uint16_t(0x1111 * (i + 1)));
+
+    Call(*cpu, BIOSFunction::CpuSet, DATA_ADDRESS, EWRAM_ADDRESS, 3);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 4) == 0x3333);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 6) == 0x0000);
+
+    Call(*cpu, BIOSFunction::CpuSet, DATA_ADDRESS, EWRAM_ADDRESS, 0x05000004);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 12) == 0x22221111);
+
+    // CpuFastSet works on blocks of 8 words
+    Call(*cpu, BIOSFunction::CpuFastSet, DATA_ADDRESS + 4, EWRAM_ADDRESS, 0x01000003);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 28) == 0x44443333);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 32) == 0x00000000);
+
+    // LZ77: two bytes, then a reference to them 8 bytes long
+    WriteData(*cpu, DATA_ADDRESS, { 0x10, 0x0A, 0x00, 0x00, 0x20, 'A', 'B', 0x50, 0x01 });
+
+    Call(*cpu, BIOSFunction::LZ77UnCompWram, DATA_ADDRESS, EWRAM_ADDRESS);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS) == 0x42414241);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 8) == 0x4241);
+
+    Call(*cpu, BIOSFunction::LZ77UnCompVram, DATA_ADDRESS, VRAM_ADDRESS);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS + 4) == 0x42414241);
+    REQUIRE(memory->ReadUInt16(VRAM_ADDRESS + 8) == 0x4241);
+
+    // The second half of the sprite VRAM mirrors the first one, the output goes through the bus
+    REQUIRE(memory->GetWritePointer(0x06017FFC, 10) == nullptr);
+    REQUIRE(memory->GetWritePointer(EWRAM_ADDRESS, 10) != nullptr);
+
+    Call(*cpu, BIOSFunction::LZ77UnCompVram, DATA_ADDRESS, 0x06017FFC);
+    REQUIRE(memory->ReadUInt32(0x06017FFC) == 0x42414241);
+    REQUIRE(memory->ReadUInt32(0x06010000) == 0x42414241);
+
+    // A reference to the byte right before overlaps what it writes. In VRAM that byte isn't written yet, the old one is read
+    WriteData(*cpu, DATA_ADDRESS, { 0x10, 0x06, 0x00, 0x00, 0x40, 'A', 0x20, 0x00 });
+
+    Call(*cpu, BIOSFunction::LZ77UnCompWram, DATA_ADDRESS, EWRAM_ADDRESS);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS) == 0x41414141);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 4) == 0x4141);
+
+    memory->WriteUInt32(VRAM_ADDRESS, 0x5A5A5A5A);
+    memory->WriteUInt16(VRAM_ADDRESS + 4, 0x5A5A);
+    Call(*cpu, BIOSFunction::LZ77UnCompVram, DATA_ADDRESS, VRAM_ADDRESS);
+    REQUIRE(memory->ReadUInt32(VRAM_ADDRESS) == 0x5A5A5A41);
+    REQUIRE(memory->ReadUInt16(VRAM_ADDRESS + 4) == 0x5A5A);
+
+    // Decompressing over code that already ran replaces it
+    memory->WriteUInt32(CODE_ADDRESS + 4, 0xE3A05001); // MOV r5, #1
+    Call(*cpu, BIOSFunction::Sqrt, 4);
+    cpu->Step();
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 1);
+
+    WriteData(*cpu, DATA_ADDRESS, { 0x30, 0x04, 0x00, 0x00, 0x03, 0x07, 0x50, 0xA0, 0xE3 }); // MOV r5, #7
+    Call(*cpu, BIOSFunction::RLUnCompWram, DATA_ADDRESS, CODE_ADDRESS + 4);
+    cpu->Step();
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 7);
+
+    // Run length: a run of 4, then 3 bytes as they are
+    WriteData(*cpu, DATA_ADDRESS, { 0x30, 0x07, 0x00, 0x00, 0x81, 'x', 0x02, 'a', 'b', 'c' });
+
+    Call(*cpu, BIOSFunction::RLUnCompWram, DATA_ADDRESS, EWRAM_ADDRESS + 0x100);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x100) == 0x78787878);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x104) == 0x00636261);
+
+    // Huffman with 8 bit data, the root has two leaves
+    WriteData(*cpu, DATA_ADDRESS, { 0x28, 0x04, 0x00, 0x00, 0x01, 0xC0, 'A', 'B', 0x00, 0x00, 0x00, 0x60 });
+
+    Call(*cpu, BIOSFunction::HuffUnComp, DATA_ADDRESS, EWRAM_ADDRESS + 0x200);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x200) == 0x41424241);
+
+    // 2 bit data, the bits alternate between the leaves 1 and 2
+    WriteData(*cpu, DATA_ADDRESS, { 0x22, 0x04, 0x00, 0x00, 0x01, 0xC0, 0x01, 0x02, 0x00, 0x00, 0xAA, 0xAA });
+
+    Call(*cpu, BIOSFunction::HuffUnComp, DATA_ADDRESS, EWRAM_ADDRESS + 0x200);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x200) == 0x66666666);
+
+    // The formats that aren't handled are left to the BIOS code, nothing is written
+    WriteData(*cpu, DATA_ADDRESS, { 0x23, 0x04, 0x00, 0x00 });
+    cpu->GetRegister(0) = DATA_ADDRESS;
+    cpu->GetRegister(1) = EWRAM_ADDRESS + 0x200;
+
+    REQUIRE(!cpu->GetHLEBIOS()->Call(uint8_t(BIOSFunction::HuffUnComp)));
+    REQUIRE(!cpu->GetHLEBIOS()->Call(uint8_t(BIOSFunction::LZ77UnCompWram)));
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x200) == 0x66666666);
+
+    // A background turned by 90 degrees, the display center is at the top left
+    WriteData(*cpu, DATA_ADDRESS, { 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0, 0, 0, 0, 0x00, 0x01, 0x00, 0x01, 0x00, 0x40, 0, 0 });
+
+    Call(*cpu, BIOSFunction::BgAffineSet, DATA_ADDRESS, EWRAM_ADDRESS + 0x300, 1);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 0x300) == 0x0000);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 0x302) == 0xFF00);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 0x304) == 0x0100);
+    REQUIRE(memory->ReadUInt16(EWRAM_ADDRESS + 0x306) == 0x0000);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x308) == 0x100);
+    REQUIRE(memory->ReadUInt32(EWRAM_ADDRESS + 0x30C) == 0x200);
+
+    // The parameters of a sprite go every 8 bytes in OAM
+    WriteData(*cpu, DATA_ADDRESS, { 0x00, 0x02, 0x00, 0x01, 0x00, 0x00, 0, 0 });
+
+    Call(*cpu, BIOSFunction::ObjAffineSet, DATA_ADDRESS, 0x07000006, 1, 8);
+    REQUIRE(memory->ReadUInt16(0x07000006) == 0x0200);
+    REQUIRE(memory->ReadUInt16(0x0700000E) == 0x0000);
+    REQUIRE(memory->ReadUInt16(0x07000016) == 0x0000);
+    REQUIRE(memory->ReadUInt16(0x0700001E) == 0x0100);
+
+    REQUIRE(cpu->GetHLEBIOS()->GetStatistics().Calls == 25);
+    REQUIRE(cpu->GetHLEBIOS()->GetStatistics().Fallbacks == 2);
+
+    delete cpu;
+
+    // Without a BIOS file the calls are emulated and the interrupts go through a stub
+    cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& booted = cpu->GetMemory();
+
+    GBAHeader header = { };
+    FILE* rom = tmpfile();
+    fwrite(&header, sizeof(header), 1, rom);
+    fflush(rom);
+    fseek(rom, sizeof(header), SEEK_SET);
+
+    cpu->LoadROM(header, rom, nullptr);
+    fclose(rom);
+
+    REQUIRE(cpu->GetHLEBIOS()->IsEnabled());
+    REQUIRE(uint32_t(cpu->GetRegister(SP)) == 0x03007F00);
+    REQUIRE(uint32_t(cpu->GetRegisterForMode(CPUMode::IRQ, SP)) == 0x03007FA0);
+
+    // The calls that aren't emulated return from the SWI vector
+    Call(*cpu, BIOSFunction::GetBiosChecksum, 0);
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == 0x08);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::Supervisor);
+
+    cpu->Step();
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == CODE_ADDRESS + 4);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+    REQUIRE(cpu->GetHLEBIOS()->GetStatistics().Fallbacks == 1);
+
+    // VBlankIntrWait in a loop counts the frames, the handler of the game acknowledges the VBlank
+    std::vector<uint32_t> const handler =
+    {
+        0xE3A01001, // MOV r1, #1
+        0xE2802C02, // ADD r2, r0, #0x200
+        0xE1C210B2, // STRH r1, [r2, #2]
+        0xE15020B8, // LDRH r2, [r0, #-8]
+        0xE1822001, // ORR r2, r2, r1
+        0xE14020B8, // STRH r2, [r0, #-8]
+        0xE12FFF1E  // BX lr
+    };
+
+    for (uint32_t i = 0; i < handler.size(); ++i)
+        booted->WriteUInt32(HANDLER_ADDRESS + i * 4, handler[i]);
+
+    booted->WriteUInt32(0x03007FFC, HANDLER_ADDRESS);
+    booted->WriteUInt32(CODE_ADDRESS, 0xEF050000);     // loop: SWI 0x50000
+    booted->WriteUInt32(CODE_ADDRESS + 4, 0xE2844001); // ADD r4, r4, #1
+    booted->WriteUInt32(CODE_ADDRESS + 8, 0xEAFFFFFC); // B loop
+    booted->WriteUInt16(DISPSTAT, 0x0008);
+    booted->WriteUInt16(InterruptEnableRegister, 0x0001);
+
+    cpu->GetRegister(4) = 0;
+    cpu->GetRegister(PC) = CODE_ADDRESS;
+
+    while (uint32_t(cpu->GetRegister(4)) < 2 && cpu->GetCycles() < 3 * 280896)
+        cpu->StepUntilEvent();
+
+    REQUIRE(uint32_t(cpu->GetRegister(4)) == 2);
+    REQUIRE(uint32_t(cpu->GetRegister(SP)) == 0x03007F00);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::System);
+
+    delete cpu;
+}
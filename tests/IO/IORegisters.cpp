@@ -0,0 +1,61 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+#include "GPU/GPU.hpp"
+
+#include <vector>
+
+TEST_CASE("IO Registers", "Checks the masks of the I/O registers and that peripherals are told about the writes")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+    std::unique_ptr<IORegisters>& io = cpu->GetIO();
+
+    // No key is pressed, and KEYINPUT can't be written
+    REQUIRE(memory->ReadUInt16(0x04000130) == 0x03FF);
+    memory->WriteUInt16(0x04000130, 0);
+    REQUIRE(memory->ReadUInt16(0x04000130) == 0x03FF);
+
+    // VCOUNT and the flags of DISPSTAT belong to the GPU
+    io->Set(VCOUNT, 0x0055);
+    io->Set(DISPSTAT, 0x0003);
+    memory->WriteUInt32(DISPSTAT, 0x12340000 | 0xFF00 | 0x0038);
+    REQUIRE(memory->ReadUInt16(DISPSTAT) == 0xFF3B);
+    REQUIRE(memory->ReadUInt8(VCOUNT) == 0x55);
+
+    // Write only registers read as 0 but keep what was written for the hardware
+    memory->WriteUInt32(0x040000D4, 0x02000000);
+    REQUIRE(memory->ReadUInt32(0x040000D4) == 0);
+    REQUIRE(io->Get32(0x040000D4) == 0x02000000);
+
+    // Byte writes to the interrupt request flags only clear the bits of their byte
+    io->Set(InterruptRequestFlags, 0x0101);
+    memory->WriteUInt8(InterruptRequestFlags + 1, 0xFF);
+    REQUIRE(memory->ReadUInt16(InterruptRequestFlags) == 0x0001);
+
+    // The handler runs for the writes that change the register, with the masks applied
+    std::vector<std::pair<uint16_t, uint16_t>> writes;
+
+    io->RegisterWriteHandler(InterruptEnableRegister, [&writes](uint16_t previous, uint16_t value)
+    {
+        writes.push_back(std::make_pair(previous, value));
+    });
+
+    memory->WriteUInt16(InterruptEnableRegister, 0xFFFF);
+    memory->WriteUInt16(InterruptEnableRegister, 0x3FFF);
+    memory->WriteUInt8(InterruptEnableRegister + 1, 0x00);
+
+    REQUIRE(writes.size() == 2);
+    REQUIRE(writes[0] == std::make_pair(uint16_t(0x0000), uint16_t(0x3FFF)));
+    REQUIRE(writes[1] == std::make_pair(uint16_t(0x3FFF), uint16_t(0x00FF)));
+
+    // Enabling an immediate DMA transfer starts it on the next step, then the channel disables itself
+    memory->WriteUInt32(0x040000D8, 0x02000100);
+    memory->WriteUInt16(0x040000DC, 4);
+    memory->WriteUInt16(0x040000DE, 0x8000);
+    REQUIRE(memory->ReadUInt16(0x040000DE) == 0x8000);
+
+    cpu->GetDMA()->Step();
+    REQUIRE(memory->ReadUInt16(0x040000DE) == 0x0000);
+
+    delete cpu;
+}
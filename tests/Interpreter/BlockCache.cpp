@@ -0,0 +1,70 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+TEST_CASE("Block Cache", "Runs code through the cached interpreter and checks the blocks are rebuilt when the code changes")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::CachedInterpreter);
+    std::unique_ptr<BlockCache>& cache = cpu->GetBlockCache();
+
+    // Adds 10 + 9 + ... + 1 into r0
+    uint32_t const program[] =
+    {
+        0xE3A00000, // MOV r0, #0
+        0xE3A0100A, // MOV r1, #10
+        0xE0800001, // loop: ADD r0, r0, r1
+        0xE2511001, // SUBS r1, r1, #1
+        0x1AFFFFFC, // BNE loop
+        0xEAFFFFFE  // B .
+    };
+
+    for (uint32_t i = 0; i < 6; ++i)
+        cpu->GetMemory()->WriteUInt32(0x03000000 + i * 4, program[i]);
+
+    // The first block ends at the branch
+    Block* block = cache->Lookup(InstructionSet::ARM, 0x03000000);
+    REQUIRE(block != nullptr);
+    REQUIRE(block->Instructions.size() == 5);
+    REQUIRE(block->Instructions.back().Instruction.GetOpcode() == ARM::ARMOpcodes::B);
+
+    cpu->GetRegister(PC) = 0x03000000;
+    while (uint32_t(cpu->GetRegister(PC)) != 0x03000014)
+        cpu->StepBlock();
+
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 55);
+    REQUIRE(uint32_t(cpu->GetRegister(1)) == 0);
+
+    // The block at the start and the loop body, the loop body is reused for every iteration
+    REQUIRE(cache->GetStatistics().Misses == 2);
+    REQUIRE(cache->GetStatistics().Hits == 9);
+
+    // Overwriting the code drops the blocks of that page, MOV r1, #10 becomes MOV r1, #4
+    cpu->GetMemory()->WriteUInt32(0x03000004, 0xE3A01004);
+    REQUIRE(cache->GetStatistics().Invalidations == 1);
+
+    cpu->GetRegister(PC) = 0x03000000;
+    while (uint32_t(cpu->GetRegister(PC)) != 0x03000014)
+        cpu->StepBlock();
+
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 10);
+
+    // A store to the next instruction of the running block stops the block right after the store
+    cpu->GetMemory()->WriteUInt32(0x03001000, 0xE5843000); // STR r3, [r4]
+    cpu->GetMemory()->WriteUInt32(0x03001004, 0xE3A05001); // MOV r5, #1
+    cpu->GetMemory()->WriteUInt32(0x03001008, 0xEAFFFFFE); // B .
+
+    cpu->GetRegister(3) = 0xE3A05002; // MOV r5, #2
+    cpu->GetRegister(4) = 0x03001004;
+    cpu->GetRegister(PC) = 0x03001000;
+
+    cpu->StepBlock();
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == 0x03001004);
+
+    cpu->StepBlock();
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 2);
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == 0x03001008);
+
+    // Code outside of the cacheable regions runs one instruction at a time
+    REQUIRE(cache->Lookup(InstructionSet::ARM, 0x06000000) == nullptr);
+
+    delete cpu;
+}
@@ -0,0 +1,160 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+TEST_CASE("ARM Data Processing Execution", "Runs ARM data processing instructions through the specialized handlers")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    Interpreter* interpreter = new Interpreter(cpu);
+
+    auto run = [&](uint32_t opcode) { interpreter->RunInstruction(cpu->GetDecoder()->DecodeARM(opcode)); };
+
+    // The decoder picks the handler
+    // MOVS r1, #0x80000000
+    DecodedInstruction instruction = cpu->GetDecoder()->DecodeARM(0xE3B01102);
+    REQUIRE(instruction.Variant == ARM::GetDataProcessingVariant(ARM::DataProcessingOperation::MOV, OperandForm::Immediate, ARM::ShiftType::ROR, true));
+
+    // A rotated immediate sets the carry to its highest bit
+    run(0xE3B01102);
+    REQUIRE(uint32_t(cpu->GetRegister(1)) == 0x80000000);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    // MOVS r0, #0
+    run(0xE3B00000);
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1); // Not rotated, the carry is untouched
+
+    // ADDS r2, r1, r1 ; 0x80000000 + 0x80000000 both carries and overflows
+    run(0xE0912001);
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 1);
+
+    // SUBS r3, r0, #1 ; borrows, which clears the carry
+    run(0xE2503001);
+    REQUIRE(uint32_t(cpu->GetRegister(3)) == 0xFFFFFFFF);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 0);
+
+    // CMP r0, #0 ; doesn't borrow and doesn't write a register
+    run(0xE3500000);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    // ADCS r9, r0, r0 ; adds the carry in
+    run(0xE0B09000);
+    REQUIRE(uint32_t(cpu->GetRegister(9)) == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 0);
+
+    // MOVS r4, r1, LSR #32
+    run(0xE1B04021);
+    REQUIRE(uint32_t(cpu->GetRegister(4)) == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 1);
+
+    // MOVS r5, r6, RRX
+    cpu->GetRegister(6) = 3;
+    cpu->GetCurrentStatusFlags().C = 0;
+    run(0xE1B05066);
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    // MOVS r8, r6, LSL r7 ; shifting by more than 32 clears both the result and the carry
+    cpu->GetRegister(7) = 33;
+    run(0xE1B08716);
+    REQUIRE(uint32_t(cpu->GetRegister(8)) == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 0);
+
+    // MOVS r8, r6, ASR r7 ; the sign fills the result
+    cpu->GetRegister(6) = 0x80000000;
+    run(0xE1B08756);
+    REQUIRE(uint32_t(cpu->GetRegister(8)) == 0xFFFFFFFF);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    // MOVS r11, #0 then MOVNE r10, #1 ; Z is set so nothing happens
+    run(0xE3B0B000);
+    run(0x13A0A001);
+    REQUIRE(uint32_t(cpu->GetRegister(10)) == 0);
+
+    // RSB r10, r9, #8
+    run(0xE269A008);
+    REQUIRE(uint32_t(cpu->GetRegister(10)) == 7);
+
+    delete interpreter;
+    delete cpu;
+}
+
+TEST_CASE("Thumb Data Processing Execution", "Checks the flags computed by the Thumb ALU instructions")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    Interpreter* interpreter = new Interpreter(cpu);
+
+    auto run = [&](uint16_t opcode) { interpreter->RunInstruction(cpu->GetDecoder()->DecodeThumb(opcode)); };
+
+    // NEG r1, r0 ; 0 - 0 doesn't borrow
+    cpu->GetRegister(0) = 0;
+    run(0x4241);
+    REQUIRE(uint32_t(cpu->GetRegister(1)) == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 0);
+
+    // NEG r1, r0 ; negating the most negative number overflows
+    cpu->GetRegister(0) = 0x80000000;
+    run(0x4241);
+    REQUIRE(uint32_t(cpu->GetRegister(1)) == 0x80000000);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().Z == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 1);
+
+    // SBC r2, r3 ; with the carry clear one more is subtracted
+    cpu->GetRegister(2) = 5;
+    cpu->GetRegister(3) = 5;
+    cpu->GetCurrentStatusFlags().C = 0;
+    run(0x419A);
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 0xFFFFFFFF);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 0);
+
+    // ADC r2, r3 ; 0xFFFFFFFF + 5 carries out
+    run(0x415A);
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 4);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 0);
+
+    // LSR r4, r5, #4 ; the last bit shifted out is the carry
+    cpu->GetRegister(5) = 0x18;
+    run(0x092C);
+    REQUIRE(uint32_t(cpu->GetRegister(4)) == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    // ROR r5, r6 ; rotating by 36 is the same as rotating by 4
+    cpu->GetRegister(5) = 0x18;
+    cpu->GetRegister(6) = 36;
+    run(0x41F5);
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 0x80000001);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    // CMN r5, r5 ; doesn't write a register
+    run(0x42ED);
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 0x80000001);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+    REQUIRE(cpu->GetCurrentStatusFlags().V == 1);
+
+    // MVN r7, r0 ; logical operations keep the carry
+    run(0x43C7);
+    REQUIRE(uint32_t(cpu->GetRegister(7)) == 0x7FFFFFFF);
+    REQUIRE(cpu->GetCurrentStatusFlags().N == 0);
+    REQUIRE(cpu->GetCurrentStatusFlags().C == 1);
+
+    delete interpreter;
+    delete cpu;
+}
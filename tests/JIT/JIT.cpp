@@ -0,0 +1,322 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+#include <vector>
+
+namespace
+{
+    uint32_t const CODE_ADDRESS = 0x03000000;
+    uint32_t const DATA_ADDRESS = 0x03002000; // Kept in r7 by the random programs
+
+    uint32_t NextRandom(uint32_t& seed)
+    {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    }
+
+    // Loads the same program, registers and data into both CPUs and runs it until it reaches the final B .
+    void RunProgram(CPU* cpu, InstructionSet set, std::vector<uint32_t> const& program, std::vector<uint32_t> const& registers,
+        std::vector<uint32_t> const& data, uint32_t flags)
+    {
+        uint32_t size = set == InstructionSet::ARM ? 4 : 2;
+
+        for (uint32_t i = 0; i < program.size(); ++i)
+        {
+            if (set == InstructionSet::ARM)
+                cpu->GetMemory()->WriteUInt32(CODE_ADDRESS + i * size, program[i]);
+            else
+                cpu->GetMemory()->WriteUInt16(CODE_ADDRESS + i * size, uint16_t(program[i]));
+        }
+
+        for (uint32_t i = 0; i < data.size(); ++i)
+            cpu->GetMemory()->WriteUInt32(DATA_ADDRESS + i * 4, data[i]);
+
+        for (uint8_t i = 0; i < 13; ++i)
+            cpu->GetRegister(i) = registers[i];
+
+        cpu->GetRegister(7) = DATA_ADDRESS;
+        cpu->SetCurrentStatusRegister((flags << 28) | uint32_t(CPUMode::System) | (set == InstructionSet::Thumb ? 0x20 : 0));
+        cpu->GetRegister(PC) = CODE_ADDRESS;
+
+        uint32_t end = CODE_ADDRESS + uint32_t(program.size() - 1) * size;
+
+        for (int steps = 0; uint32_t(cpu->GetRegister(PC)) != end && steps < 10000; ++steps)
+        {
+            if (cpu->GetJIT())
+                cpu->StepJIT();
+            else
+                cpu->Step();
+        }
+    }
+
+    // Returns the number of registers, flags and data words that differ
+    int Compare(CPU* interpreter, CPU* jit, std::size_t dataSize)
+    {
+        int mismatches = 0;
+
+        for (uint8_t i = 0; i < 16; ++i)
+            if (uint32_t(interpreter->GetRegister(i)) != uint32_t(jit->GetRegister(i)))
+                ++mismatches;
+
+        if ((interpreter->GetCurrentStatusRegister().Full >> 28) != (jit->GetCurrentStatusRegister().Full >> 28))
+            ++mismatches;
+
+        for (uint32_t i = 0; i < dataSize; ++i)
+            if (interpreter->GetMemory()->ReadUInt32(DATA_ADDRESS + i * 4) != jit->GetMemory()->ReadUInt32(DATA_ADDRESS + i * 4))
+                ++mismatches;
+
+        return mismatches;
+    }
+
+    // Any register but r7 and the PC
+    uint32_t RandomDestination(uint32_t& seed)
+    {
+        uint32_t reg = NextRandom(seed) % 12;
+        return reg >= 7 ? reg + 1 : reg;
+    }
+
+    uint32_t RandomARMInstruction(uint32_t& seed)
+    {
+        uint32_t kind = NextRandom(seed) % 8;
+        uint32_t condition = NextRandom(seed) % 4 == 0 ? NextRandom(seed) % 15 : 0xE;
+
+        // Conditional branch over the next instruction
+        if (kind == 0)
+            return (NextRandom(seed) % 15) << 28 | 0x0A000000;
+
+        // Load or store of a word or a byte from the data area
+        if (kind == 1)
+        {
+            uint32_t load = NextRandom(seed) & 1;
+            uint32_t byte = NextRandom(seed) & 1;
+            uint32_t offset = (NextRandom(seed) % 64) * 4 + (byte ? NextRandom(seed) % 4 : 0);
+            return condition << 28 | 0x05800000 | byte << 22 | load << 20 | 7 << 16 | RandomDestination(seed) << 12 | offset;
+        }
+
+        uint32_t operation = NextRandom(seed) % 16;
+        // The compares without the S bit are PSR transfers
+        uint32_t setFlags = (operation >= 8 && operation <= 11) ? 1 : NextRandom(seed) & 1;
+        uint32_t rn = NextRandom(seed) % 4 == 0 ? 15 : NextRandom(seed) % 13;
+        uint32_t rm = NextRandom(seed) % 8 == 0 ? 15 : NextRandom(seed) % 13;
+        uint32_t opcode = condition << 28 | operation << 21 | setFlags << 20 | rn << 16 | RandomDestination(seed) << 12;
+
+        switch (NextRandom(seed) % 3)
+        {
+            case 0: // Rotated immediate
+                return opcode | 0x02000000 | (NextRandom(seed) % 16) << 8 | (NextRandom(seed) & 0xFF);
+            case 1: // Shifted by an immediate
+                return opcode | (NextRandom(seed) % 32) << 7 | (NextRandom(seed) % 4) << 5 | rm;
+            default: // Shifted by a register, left to the interpreter
+                return opcode | (NextRandom(seed) % 13) << 8 | (NextRandom(seed) % 4) << 5 | 1 << 4 | rm;
+        }
+    }
+
+    uint32_t RandomThumbInstruction(uint32_t& seed)
+    {
+        uint32_t rd = NextRandom(seed) % 7; // r7 holds the data address
+        uint32_t rs = NextRandom(seed) % 8;
+        uint32_t rn = NextRandom(seed) % 8;
+
+        switch (NextRandom(seed) % 9)
+        {
+            case 0: // LSL, LSR, ASR by an immediate
+                return (NextRandom(seed) % 3) << 11 | (NextRandom(seed) % 32) << 6 | rs << 3 | rd;
+            case 1: // ADD, SUB with a register or a 3 bit immediate
+                return 0x1800 | (NextRandom(seed) % 4) << 9 | rn << 6 | rs << 3 | rd;
+            case 2: // MOV, CMP, ADD, SUB with an 8 bit immediate
+                return 0x2000 | (NextRandom(seed) % 4) << 11 | rd << 8 | (NextRandom(seed) & 0xFF);
+            case 3:
+            case 4: // ALU operations, including the register shifts left to the interpreter
+                return 0x4000 | (NextRandom(seed) % 16) << 6 | rs << 3 | rd;
+            case 5: // ADD, CMP, MOV with the high registers, the PC can only be read
+            {
+                uint32_t destination = RandomDestination(seed);
+                uint32_t source = NextRandom(seed) % 16;
+                return 0x4400 | (NextRandom(seed) % 3) << 8 | (destination >> 3) << 7 | (source >> 3) << 6 | (source & 7) << 3 | (destination & 7);
+            }
+            case 6: // Conditional branch over the next instruction
+                return 0xD000 | (NextRandom(seed) % 14) << 8;
+            default: // Load or store relative to r7
+            {
+                uint32_t const opcodes[] = { 0x6000, 0x6800, 0x7000, 0x7800, 0x8000, 0x8800 }; // STR LDR STRB LDRB STRH LDRH
+                return opcodes[NextRandom(seed) % 6] | (NextRandom(seed) % 32) << 6 | 7 << 3 | rd;
+            }
+        }
+    }
+
+    int RunRandomPrograms(InstructionSet set, uint32_t seed)
+    {
+        int mismatches = 0;
+
+        CPU* interpreter = new CPU(CPUExecutionMode::Interpreter);
+        CPU* jit = new CPU(CPUExecutionMode::JIT);
+
+        for (int program = 0; program < 100; ++program)
+        {
+            std::vector<uint32_t> code;
+            std::vector<uint32_t> registers;
+            std::vector<uint32_t> data;
+
+            for (int i = 0; i < 40; ++i)
+                code.push_back(set == InstructionSet::ARM ? RandomARMInstruction(seed) : RandomThumbInstruction(seed));
+
+            // MOV r0, r0 so that a branch over the next instruction can't skip the end, then B .
+            code.push_back(set == InstructionSet::ARM ? 0xE1A00000 : 0x4600);
+            code.push_back(set == InstructionSet::ARM ? 0xEAFFFFFE : 0xE7FE);
+
+            for (int i = 0; i < 13; ++i)
+                registers.push_back(NextRandom(seed) % 3 == 0 ? (NextRandom(seed) % 3) << 30 : NextRandom(seed) * 2654435761u);
+
+            for (int i = 0; i < 80; ++i)
+                data.push_back(NextRandom(seed) * 2654435761u);
+
+            uint32_t flags = NextRandom(seed) % 16;
+
+            RunProgram(interpreter, set, code, registers, data, flags);
+            RunProgram(jit, set, code, registers, data, flags);
+
+            mismatches += Compare(interpreter, jit, data.size());
+        }
+
+        delete interpreter;
+        delete jit;
+
+        return mismatches;
+    }
+}
+
+TEST_CASE("JIT", "Compiles ARM and Thumb blocks to native code and compares them against the interpreter")
+{
+    if (!JIT::IsSupported())
+        return;
+
+    CPU* cpu = new CPU(CPUExecutionMode::JIT);
+    REQUIRE(cpu->GetJIT() != nullptr);
+
+    // Adds 10 + 9 + ... + 1 into r0
+    std::vector<uint32_t> const program =
+    {
+        0xE3A00000, // MOV r0, #0
+        0xE3A0100A, // MOV r1, #10
+        0xE0800001, // loop: ADD r0, r0, r1
+        0xE2511001, // SUBS r1, r1, #1
+        0x1AFFFFFC, // BNE loop
+        0xEAFFFFFE  // B .
+    };
+
+    std::vector<uint32_t> registers(13, 0);
+    RunProgram(cpu, InstructionSet::ARM, program, registers, std::vector<uint32_t>(), 0);
+
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 55);
+    REQUIRE(uint32_t(cpu->GetRegister(1)) == 0);
+    REQUIRE((cpu->GetCurrentStatusRegister().Full >> 28) == 0x6); // Z and C from the last SUBS
+
+    // The block at the start, the loop body and the final B .
+    REQUIRE(cpu->GetJIT()->GetStatistics().CompiledBlocks == 3);
+    REQUIRE(cpu->GetJIT()->GetStatistics().InterpretedInstructions == 0);
+
+    // Overwriting the code drops the blocks of that page, MOV r1, #10 becomes MOV r1, #4
+    cpu->GetMemory()->WriteUInt32(0x03000004, 0xE3A01004);
+    REQUIRE(cpu->GetJIT()->GetStatistics().Invalidations == 1);
+
+    cpu->GetRegister(PC) = CODE_ADDRESS;
+    while (uint32_t(cpu->GetRegister(PC)) != 0x03000014)
+        cpu->StepJIT();
+
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 10);
+
+    // A store to the next instruction of the running block leaves the block right after the store
+    cpu->GetMemory()->WriteUInt32(0x03001000, 0xE5843000); // STR r3, [r4]
+    cpu->GetMemory()->WriteUInt32(0x03001004, 0xE3A05001); // MOV r5, #1
+    cpu->GetMemory()->WriteUInt32(0x03001008, 0xEAFFFFFE); // B .
+
+    // Compile the block before it changes
+    cpu->GetRegister(3) = 0xE3A05001;
+    cpu->GetRegister(4) = 0x03001100;
+    cpu->GetRegister(PC) = 0x03001000;
+    cpu->StepJIT();
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 1);
+
+    cpu->GetRegister(3) = 0xE3A05002; // MOV r5, #2
+    cpu->GetRegister(4) = 0x03001004;
+    cpu->GetRegister(PC) = 0x03001000;
+    cpu->StepJIT();
+
+    REQUIRE(uint32_t(cpu->GetRegister(5)) == 2);
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == 0x03001008);
+
+    // Thumb BL and the return through the interpreted BX LR
+    std::vector<uint32_t> const thumb =
+    {
+        0x2005, // MOV r0, #5
+        0xF000, // BL function
+        0xF802,
+        0x3001, // ADD r0, #1
+        0xE7FE, // B .
+        0x0040, // function: LSL r0, r0, #1
+        0x4770  // BX LR
+    };
+
+    std::vector<uint32_t> thumbProgram(thumb.begin(), thumb.begin() + 5);
+    for (uint32_t i = 5; i < thumb.size(); ++i)
+        cpu->GetMemory()->WriteUInt16(CODE_ADDRESS + i * 2, uint16_t(thumb[i]));
+
+    RunProgram(cpu, InstructionSet::Thumb, thumbProgram, registers, std::vector<uint32_t>(), 0);
+
+    REQUIRE(uint32_t(cpu->GetRegister(0)) == 11);
+    REQUIRE(uint32_t(cpu->GetRegister(LR)) == ((CODE_ADDRESS + 6) | 1));
+
+    // The compiled code reads the timer at the same time as the interpreter, not at the end of the time slice
+    std::vector<uint32_t> const timer =
+    {
+        0xE3A00301, // MOV r0, #0x04000000
+        0xE2800C01, // ADD r0, r0, #0x100
+        0xE3A01080, // MOV r1, #0x80
+        0xE1C010B2, // STRH r1, [r0, #2]
+        0xE1D040B0, // loop: LDRH r4, [r0]
+        0xE3540C01, // CMP r4, #0x100
+        0x3AFFFFFC, // BLO loop
+        0xEAFFFFFE  // B .
+    };
+
+    CPU* interpreter = new CPU(CPUExecutionMode::Interpreter);
+    RunProgram(interpreter, InstructionSet::ARM, timer, registers, std::vector<uint32_t>(), 0);
+    RunProgram(cpu, InstructionSet::ARM, timer, registers, std::vector<uint32_t>(), 0);
+
+    REQUIRE(uint32_t(interpreter->GetRegister(4)) == 0x101);
+    REQUIRE(uint32_t(cpu->GetRegister(4)) == uint32_t(interpreter->GetRegister(4)));
+    delete interpreter;
+
+    // Enabling IME with an interrupt pending takes it right after the store
+    std::vector<uint32_t> const enable =
+    {
+        0xE3A00301, // MOV r0, #0x04000000
+        0xE2800C02, // ADD r0, r0, #0x200
+        0xE3A01001, // MOV r1, #1
+        0xE1C010B8, // STRH r1, [r0, #8]
+        0xE3A02001, // MOV r2, #1
+        0xEAFFFFFE  // B .
+    };
+
+    for (uint32_t i = 0; i < enable.size(); ++i)
+        cpu->GetMemory()->WriteUInt32(CODE_ADDRESS + i * 4, enable[i]);
+
+    cpu->GetMemory()->WriteUInt16(InterruptEnableRegister, 1 << uint8_t(InterruptTypes::Timer3Overflow));
+    cpu->GetMemory()->WriteUInt16(InterruptMasterEnableRegister, 0);
+    cpu->RequestInterrupt(InterruptTypes::Timer3Overflow);
+
+    cpu->GetRegister(2) = 0;
+    cpu->SetCurrentStatusRegister(uint32_t(CPUMode::System));
+    cpu->GetRegister(PC) = CODE_ADDRESS;
+    cpu->StepJIT();
+
+    REQUIRE(uint32_t(cpu->GetRegister(PC)) == 0x18);
+    REQUIRE(uint32_t(cpu->GetRegister(LR)) == CODE_ADDRESS + 0x10 + 4);
+    REQUIRE(uint32_t(cpu->GetRegister(2)) == 0);
+
+    delete cpu;
+
+    // Random blocks must leave the registers, the flags and the memory exactly like the interpreter does
+    REQUIRE(RunRandomPrograms(InstructionSet::ARM, 0x1234567) == 0);
+    REQUIRE(RunRandomPrograms(InstructionSet::Thumb, 0x7654321) == 0);
+}
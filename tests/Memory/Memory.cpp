@@ -0,0 +1,247 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+#include "Common/GBA.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+TEST_CASE("Memory", "Checks the word and halfword accessors of the MMU, including misaligned accesses")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+
+    // Words and halfwords are little endian, in both work RAMs
+    memory->WriteUInt32(0x02000100, 0x11223344);
+    REQUIRE(memory->ReadUInt32(0x02000100) == 0x11223344);
+    REQUIRE(memory->ReadUInt16(0x02000100) == 0x3344);
+    REQUIRE(memory->ReadUInt16(0x02000102) == 0x1122);
+    REQUIRE(memory->ReadUInt8(0x02000103) == 0x11);
+
+    memory->WriteUInt16(0x03000010, 0xBEEF);
+    memory->WriteUInt8(0x03000012, 0xAD);
+    REQUIRE(memory->ReadUInt32(0x03000010) == 0x00ADBEEF);
+
+    // Misaligned words are rotated so the addressed byte ends up in the lowest bits
+    REQUIRE(memory->ReadUInt32(0x02000101) == 0x44112233);
+    REQUIRE(memory->ReadUInt32(0x02000102) == 0x33441122);
+    REQUIRE(memory->ReadUInt32(0x02000103) == 0x22334411);
+
+    // Misaligned halfwords ignore bit 0, LDRH rotates them and LDRSH only extends the byte
+    REQUIRE(memory->ReadUInt16(0x02000101) == 0x3344);
+    REQUIRE(memory->LoadHalfword(0x02000100) == 0x3344);
+    REQUIRE(memory->LoadHalfword(0x02000101) == 0x44000033);
+    memory->WriteUInt16(0x02000104, 0x80F0);
+    REQUIRE(memory->LoadSignedHalfword(0x02000104) == 0xFFFF80F0);
+    REQUIRE(memory->LoadSignedHalfword(0x02000105) == 0xFFFFFF80);
+
+    // Stores ignore the low bits of the address
+    memory->WriteUInt32(0x02000202, 0xCAFEBABE);
+    REQUIRE(memory->ReadUInt32(0x02000200) == 0xCAFEBABE);
+    memory->WriteUInt16(0x02000207, 0x1234);
+    REQUIRE(memory->ReadUInt16(0x02000206) == 0x1234);
+
+    // The I/O registers keep their side effects, writing 1 to an interrupt request flag clears it
+    cpu->GetIO()->Set(InterruptRequestFlags, 0x0003);
+    REQUIRE(memory->ReadUInt16(InterruptRequestFlags) == 0x0003);
+    memory->WriteUInt16(InterruptRequestFlags, 0x0001);
+    REQUIRE(memory->ReadUInt16(InterruptRequestFlags) == 0x0002);
+    memory->WriteUInt32(InterruptEnableRegister, 0x00020001);
+    REQUIRE(memory->ReadUInt16(InterruptEnableRegister) == 0x0001);
+    REQUIRE(memory->ReadUInt16(InterruptRequestFlags) == 0x0000);
+
+    // A word store still invalidates the decoded instructions in both of its halfwords
+    memory->WriteUInt32(0x03000100, 0xE3A00001); // MOV r0, #1
+    REQUIRE(cpu->GetInstructionCache()->Fetch(InstructionSet::ARM, 0x03000100).Encoding == 0xE3A00001);
+    REQUIRE(cpu->GetInstructionCache()->Fetch(InstructionSet::Thumb, 0x03000102).Encoding == 0xE3A0);
+
+    memory->WriteUInt32(0x03000100, 0x2001E3A0); // MOV r0, #1 in Thumb at the upper halfword
+    REQUIRE(cpu->GetInstructionCache()->Fetch(InstructionSet::ARM, 0x03000100).Encoding == 0x2001E3A0);
+    REQUIRE(cpu->GetInstructionCache()->Fetch(InstructionSet::Thumb, 0x03000102).Encoding == 0x2001);
+
+    delete cpu;
+}
+
+TEST_CASE("Memory Map", "Checks that the page table mirrors every region and maps the video memory of the GPU")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+
+    // The work RAMs repeat over their whole region
+    memory->WriteUInt32(0x02000010, 0x12345678);
+    REQUIRE(memory->ReadUInt32(0x02040010) == 0x12345678);
+    REQUIRE(memory->ReadUInt32(0x02FC0010) == 0x12345678);
+
+    memory->WriteUInt32(0x03FFFFFC, 0x89ABCDEF);
+    REQUIRE(memory->ReadUInt32(0x03007FFC) == 0x89ABCDEF);
+
+    // Palette RAM and OAM are smaller than a page but mirrored all the same
+    memory->WriteUInt16(0x05000002, 0x7FFF);
+    REQUIRE(memory->ReadUInt16(0x05000402) == 0x7FFF);
+    REQUIRE(cpu->GetGPU()->GetPaletteRAM()[2] == 0xFF);
+
+    memory->WriteUInt16(0x07000404, 0x0123);
+    REQUIRE(memory->ReadUInt16(0x07000004) == 0x0123);
+
+    // The last 32 KBytes of each 128 KBytes of VRAM repeat the OBJ tiles
+    memory->WriteUInt32(0x06010020, 0xAABBCCDD);
+    REQUIRE(memory->ReadUInt32(0x06018020) == 0xAABBCCDD);
+    REQUIRE(memory->ReadUInt32(0x06030020) == 0xAABBCCDD);
+    REQUIRE(cpu->GetGPU()->GetVRAM()[0x10020] == 0xDD);
+
+    memory->WriteUInt8(0x0E010001, 0x5A);
+    REQUIRE(memory->ReadUInt8(0x0E000001) == 0x5A);
+
+    // The top 4 bits of the address are not connected
+    REQUIRE(memory->ReadUInt32(0x12000010) == 0x12345678);
+
+    delete cpu;
+}
+
+TEST_CASE("Game Pak", "Loads a ROM and checks its mirrors and the open bus after it")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+
+    // Without a ROM the whole Game Pak reads as open bus
+    REQUIRE(memory->ReadUInt16(0x08001000) == 0x0800);
+
+    // A header followed by a page and a bit of data, so the ROM is partly mapped and partly copied
+    GBAHeader header = { };
+    header.EntryPoint = 0xEA00002E;
+
+    uint32_t const dataSize = 0x5000;
+
+    FILE* rom = tmpfile();
+    FILE* bios = tmpfile();
+    fwrite(&header, sizeof(header), 1, rom);
+
+    for (uint32_t i = 0; i < dataSize; ++i)
+        fputc(uint8_t(i * 7), rom);
+
+    fflush(rom);
+    fseek(rom, sizeof(header), SEEK_SET);
+    cpu->LoadROM(header, rom, bios);
+
+    fclose(rom);
+    fclose(bios);
+
+    uint32_t data = 0x08000000 + uint32_t(sizeof(header));
+    uint32_t end = data + dataSize;
+
+    REQUIRE(memory->ReadUInt32(0x08000000) == 0xEA00002E);
+    REQUIRE(memory->ReadUInt8(data + 0x42) == uint8_t(0x42 * 7));
+    REQUIRE(memory->ReadUInt8(0x08003FFF) == uint8_t((0x3FFF - sizeof(header)) * 7));
+    REQUIRE(memory->ReadUInt8(0x08004000) == uint8_t((0x4000 - sizeof(header)) * 7));
+    REQUIRE(memory->ReadUInt8(end - 1) == uint8_t((dataSize - 1) * 7));
+
+    // The other wait state regions show the same ROM
+    REQUIRE(memory->ReadUInt32(0x0A000000) == 0xEA00002E);
+    REQUIRE(memory->ReadUInt8(0x0C000000 + sizeof(header) + 0x4100) == uint8_t(0x4100 * 7));
+
+    // Each halfword past the end reads as its address / 2, both in the last page and in the pages after it
+    REQUIRE(memory->ReadUInt16(end) == uint16_t(end >> 1));
+    REQUIRE(memory->ReadUInt32(0x08006000) == 0x30013000);
+    REQUIRE(memory->ReadUInt32(0x09FFFFFC) == 0xFFFFFFFE);
+    REQUIRE(memory->ReadUInt32(0x0A010000) == 0x80018000);
+    REQUIRE(memory->ReadUInt8(0x08100003) == 0x00);
+    REQUIRE(memory->ReadUInt8(0x08100004) == 0x02);
+
+    // Writes to the ROM are ignored
+    memory->WriteUInt32(0x08000000, 0);
+    REQUIRE(memory->ReadUInt32(0x08000000) == 0xEA00002E);
+
+    delete cpu;
+}
+
+TEST_CASE("ROM Image", "Maps regular files and reads the ROMs that can't be mapped")
+{
+    GBAHeader header = { };
+    header.EntryPoint = 0xEA00002E;
+
+    FILE* file = tmpfile();
+    fwrite(&header, sizeof(header), 1, file);
+    fputs("ROM", file);
+    fflush(file);
+    fseek(file, sizeof(header), SEEK_SET);
+
+    ROMImage mapped;
+    mapped.Load(header, file);
+    fclose(file);
+
+#if defined(__unix__) || defined(__APPLE__)
+    REQUIRE(mapped.IsMapped());
+#endif
+
+    // The mapping stays valid after the file is closed
+    REQUIRE(mapped.GetSize() == sizeof(header) + 3);
+    REQUIRE(memcmp(mapped.GetData(), &header, sizeof(header)) == 0);
+    REQUIRE(memcmp(mapped.GetData() + sizeof(header), "ROM", 3) == 0);
+
+#if defined(__unix__) || defined(__APPLE__)
+    // A pipe only has what comes after the header left in it
+    int descriptors[2];
+    REQUIRE(pipe(descriptors) == 0);
+    REQUIRE(write(descriptors[1], "ROM", 3) == 3);
+    close(descriptors[1]);
+
+    FILE* stream = fdopen(descriptors[0], "rb");
+    ROMImage buffered;
+    buffered.Load(header, stream);
+    fclose(stream);
+
+    REQUIRE(!buffered.IsMapped());
+    REQUIRE(buffered.GetSize() == mapped.GetSize());
+    REQUIRE(memcmp(buffered.GetData(), mapped.GetData(), mapped.GetSize()) == 0);
+#endif
+}
+
+TEST_CASE("Memory Arena", "Checks that the guest memory lives in one page aligned arena per CPU")
+{
+    CPU* first = new CPU(CPUExecutionMode::Interpreter);
+    CPU* second = new CPU(CPUExecutionMode::Interpreter, MemoryArenaPages::Huge);
+
+    std::unique_ptr<MemoryArena>& arena = first->GetMemoryArena();
+
+    // Every region starts on its own host page and they don't overlap
+    uint8_t* previous = nullptr;
+
+    for (uint8_t i = 0; i < uint8_t(MemoryRegion::Count); ++i)
+    {
+        MemoryRegion region = MemoryRegion(i);
+
+        REQUIRE((reinterpret_cast<uintptr_t>(arena->Get(region)) & 0xFFF) == 0);
+        bool inside = arena->Get(region) + arena->GetSize(region) <= arena->Get(MemoryRegion::Count);
+        REQUIRE(inside);
+
+        bool ordered = !previous || arena->Get(region) > previous;
+        REQUIRE(ordered);
+
+        previous = arena->Get(region);
+    }
+
+    // The bus, the GPU and the arena are all the same memory
+    first->GetMemory()->WriteUInt32(0x02000040, 0xDEADBEEF);
+    REQUIRE(arena->Get(MemoryRegion::EWRAM)[0x40] == 0xEF);
+
+    first->GetMemory()->WriteUInt16(0x06000010, 0x1234);
+    REQUIRE(first->GetGPU()->GetVRAM() == arena->Get(MemoryRegion::VRAM));
+    REQUIRE(first->GetGPU()->GetVRAM()[0x10] == 0x34);
+
+    // Each CPU has its own memory, no matter how it is backed
+    REQUIRE(second->GetMemory()->ReadUInt32(0x02000040) == 0);
+    second->GetMemory()->WriteUInt32(0x03000000, 0x11111111);
+    REQUIRE(first->GetMemory()->ReadUInt32(0x03000000) == 0);
+
+    // Resetting clears the arena but keeps it
+    first->Reset();
+    REQUIRE(first->GetMemoryArena()->Get(MemoryRegion::EWRAM) == arena->Get(MemoryRegion::EWRAM));
+    REQUIRE(first->GetMemory()->ReadUInt32(0x02000040) == 0);
+    REQUIRE(first->GetMemory()->ReadUInt16(0x06000010) == 0);
+
+    delete first;
+    delete second;
+}
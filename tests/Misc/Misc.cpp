@@ -5,7 +5,9 @@
 
 TEST_CASE("GeneralPurposeRegister", "Executes a batch of tests on the GPRs")
 {
-    // int z = getchar();
+    // The registers are plain values, the flags are computed by the instructions that set them
+    REQUIRE(sizeof(GeneralPurposeRegister) == sizeof(uint32_t));
+
     GeneralPurposeRegister Rd;
     Rd.Value = 0;
     GeneralPurposeRegister Rn;
@@ -14,40 +16,38 @@ TEST_CASE("GeneralPurposeRegister", "Executes a batch of tests on the GPRs")
     Rm.Value = 0x00000001;
 
     Rd = Rn - Rn; // 0
-    REQUIRE(Rd.Carry    == false);
-    REQUIRE(Rd.Overflow == false);
-    REQUIRE(Rd.Borrow   == false);
-    REQUIRE(Rd          == 0);
+    REQUIRE(Rd == 0);
 
     Rd = Rn + Rm; // 0xFFFF FFFF + 0x0000 0001 = (0x1 0000 0000) = 0x0000 0000
-    REQUIRE(Rd.Carry    == true);
-    REQUIRE(Rd.Overflow == true);
-    REQUIRE(Rd.Borrow   == false);
-    REQUIRE(Rd          == 0);
+    REQUIRE(Rd == 0);
 
     Rd = Rm - Rn; // 0x0000 0001 - 0xFFFF FFFF = 0xFFFF FFFE = 2
-    REQUIRE(Rd.Borrow   == true);
-    REQUIRE(Rd.Overflow == false);
-    REQUIRE(Rd.Carry    == false);
-    REQUIRE(Rd          == 0x00000002);
+    REQUIRE(Rd == 0x00000002);
 
     // Check for symmetry
     Rd = Rn + Rm;
-    REQUIRE(Rd.Carry    == true);
-    REQUIRE(Rd.Overflow == true);
-    REQUIRE(Rd.Borrow   == false);
-    REQUIRE(Rd          == 0);
+    REQUIRE(Rd == 0);
 
     Rd = Rn - Rm;
-    REQUIRE(Rd.Borrow   == false);
-    REQUIRE(Rd.Overflow == false);
-    REQUIRE(Rd.Carry    == false);
-    REQUIRE(Rd          == 0xFFFFFFFE);
+    REQUIRE(Rd == 0xFFFFFFFE);
 
     Rd = 0 - Rm;
-    REQUIRE(Rd.Borrow   == false);
-    REQUIRE(Rd.Overflow == true);
-    REQUIRE(Rd.Carry    == false);
-    REQUIRE(Rd          == 0xFFFFFFFF);
-
+    REQUIRE(Rd == 0xFFFFFFFF);
+
+    // Assigning a wider value keeps the low 32 bits
+    Rd = uint32_t(uint64_t(0x123456789));
+    REQUIRE(Rd == 0x23456789);
+
+    Rd += 0x10;
+    REQUIRE(Rd == 0x23456799);
+    Rd -= 0x23456800;
+    REQUIRE(Rd == 0xFFFFFF99);
+
+    // Copies are independent
+    GeneralPurposeRegister copy = Rd;
+    copy[0] = false;
+    REQUIRE(copy == 0xFFFFFF98);
+    REQUIRE(Rd == 0xFFFFFF99);
+    REQUIRE(Rd[31]);
+    REQUIRE_FALSE(Rd[1]);
 }
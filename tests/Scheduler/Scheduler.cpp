@@ -0,0 +1,71 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+#include "Scheduler/Scheduler.hpp"
+
+#include <vector>
+
+TEST_CASE("Scheduler", "Checks the order of the events and that the CPU runs until the next one")
+{
+    Scheduler scheduler;
+    std::vector<std::pair<EventType, uint64_t>> ran;
+
+    for (EventType type : { EventType::HBlank, EventType::HBlankEnd, EventType::DMA, EventType::Timer0Overflow })
+    {
+        scheduler.RegisterHandler(type, [&ran, type](uint64_t time)
+        {
+            ran.push_back(std::make_pair(type, time));
+        });
+    }
+
+    REQUIRE(scheduler.GetNextEventTime() == Scheduler::NO_EVENT);
+
+    scheduler.Schedule(EventType::HBlank, 300);
+    scheduler.Schedule(EventType::HBlankEnd, 100);
+    scheduler.Schedule(EventType::DMA, 100);
+    scheduler.Schedule(EventType::Timer0Overflow, 50);
+
+    // Moving and cancelling events leave nothing behind
+    scheduler.Schedule(EventType::Timer0Overflow, 200);
+    REQUIRE(scheduler.GetNextEventTime() == 100);
+    scheduler.Cancel(EventType::HBlankEnd);
+    REQUIRE(!scheduler.IsScheduled(EventType::HBlankEnd));
+
+    // Nothing is due yet
+    scheduler.RunEvents(99);
+    REQUIRE(ran.empty());
+
+    scheduler.RunEvents(250);
+    REQUIRE(ran.size() == 2);
+    REQUIRE(ran[0] == std::make_pair(EventType::DMA, uint64_t(100)));
+    REQUIRE(ran[1] == std::make_pair(EventType::Timer0Overflow, uint64_t(200)));
+    REQUIRE(scheduler.GetNextEventTime() == 300);
+
+    // Events that a handler schedules for a time that already passed run in the same call
+    scheduler.RegisterHandler(EventType::HBlank, [&scheduler, &ran](uint64_t time)
+    {
+        ran.push_back(std::make_pair(EventType::HBlank, time));
+        scheduler.Schedule(EventType::HBlankEnd, time + 10);
+    });
+
+    scheduler.RunEvents(1000);
+    REQUIRE(ran.size() == 4);
+    REQUIRE(ran[3] == std::make_pair(EventType::HBlankEnd, uint64_t(310)));
+    REQUIRE(scheduler.GetNextEventTime() == Scheduler::NO_EVENT);
+
+    // The CPU runs a loop without stopping until the first HBlank is due
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+
+    cpu->GetMemory()->WriteUInt32(0x03000000, 0xE2800001); // loop: ADD r0, r0, #1
+    cpu->GetMemory()->WriteUInt32(0x03000004, 0xEAFFFFFD); // B loop
+    cpu->GetRegister(PC) = 0x03000000;
+
+    REQUIRE(cpu->GetScheduler()->GetNextEventTime() == HDRAW_LENGTH);
+    cpu->StepUntilEvent();
+
+    REQUIRE(cpu->GetCycles() >= HDRAW_LENGTH);
+    REQUIRE(cpu->GetCycles() < HDRAW_LENGTH + 4);
+    REQUIRE(cpu->GetGPU()->InHBlank());
+    REQUIRE(cpu->GetScheduler()->GetNextEventTime() == HORIZONTAL_LENGTH);
+
+    delete cpu;
+}
@@ -0,0 +1,57 @@
+#include "catch/catch.hpp"
+#include "CPU/CPU.hpp"
+
+TEST_CASE("Timers", "Checks the counters, the overflows and the cascade of the timers")
+{
+    CPU* cpu = new CPU(CPUExecutionMode::Interpreter);
+    std::unique_ptr<MMU>& memory = cpu->GetMemory();
+    std::unique_ptr<Scheduler>& scheduler = cpu->GetScheduler();
+
+    cpu->GetMemory()->WriteUInt32(0x03000000, 0xEAFFFFFE); // B .
+    cpu->GetRegister(PC) = 0x03000000;
+
+    // Timer 0 counts every 64 cycles from 0xFFF0, timer 1 counts its overflows
+    memory->WriteUInt16(TM0CNT_L, 0xFFF0);
+    memory->WriteUInt16(TM0CNT_L + 4, 0xFFFF);
+    memory->WriteUInt16(TM0CNT_H + 4, 0x00C4); // Enabled, IRQ, count-up
+    memory->WriteUInt16(TM0CNT_H, 0x0081);     // Enabled, prescaler 64
+
+    // The reload value isn't what the counter reads
+    REQUIRE(memory->ReadUInt16(TM0CNT_L) == 0xFFF0);
+    REQUIRE(memory->ReadUInt16(TM0CNT_L + 4) == 0xFFFF);
+    REQUIRE(scheduler->GetScheduledTime(EventType::Timer0Overflow) == 16 * 64);
+    REQUIRE(!scheduler->IsScheduled(EventType::Timer1Overflow));
+
+    while (cpu->GetCycles() < 5 * 64)
+        cpu->Step();
+
+    REQUIRE(memory->ReadUInt16(TM0CNT_L) == 0xFFF5);
+
+    // Enabling the interrupts lets the CPU take them, only timer 1 asks for one
+    memory->WriteUInt16(InterruptEnableRegister, 0x0018);
+    memory->WriteUInt16(InterruptMasterEnableRegister, 1);
+
+    while (cpu->GetCycles() < 16 * 64)
+        cpu->Step();
+
+    // Timer 0 reloaded, timer 1 overflowed and raised its interrupt
+    REQUIRE(memory->ReadUInt16(TM0CNT_L) == 0xFFF0);
+    REQUIRE(memory->ReadUInt16(TM0CNT_L + 4) == 0xFFFF);
+    REQUIRE(memory->ReadUInt16(InterruptRequestFlags) == 0x0010);
+    REQUIRE(cpu->GetCurrentCPUMode() == CPUMode::IRQ);
+    REQUIRE(scheduler->GetScheduledTime(EventType::Timer0Overflow) == 32 * 64);
+
+    // Stopping a timer freezes its counter
+    uint64_t stop = cpu->GetCycles();
+    memory->WriteUInt16(TM0CNT_H, 0x0001);
+    uint16_t frozen = memory->ReadUInt16(TM0CNT_L);
+    REQUIRE(frozen == uint16_t(0xFFF0 + (stop - 16 * 64) / 64));
+    REQUIRE(!scheduler->IsScheduled(EventType::Timer0Overflow));
+
+    for (int i = 0; i < 100; ++i)
+        cpu->Step();
+
+    REQUIRE(memory->ReadUInt16(TM0CNT_L) == frozen);
+
+    delete cpu;
+}